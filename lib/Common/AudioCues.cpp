@@ -0,0 +1,53 @@
+//
+// Which sound each pomodoro transition plays, including a warning before work ends.
+//
+
+#include "AudioCues.h"
+
+AudioCues::AudioCues(CueSink& sink, const time_t warning_seconds)
+    : sink_(sink),
+      warning_seconds_(warning_seconds),
+      warning_armed_(false)
+{
+}
+
+void AudioCues::notification(const ClockUpdate update)
+{
+    if (update.state != WORK || warning_seconds_ <= 0)
+    {
+        warning_armed_ = false;
+        return;
+    }
+    if (update.remaining_time_in_state > warning_seconds_)
+    {
+        warning_armed_ = true;
+    }
+    else if (warning_armed_ && update.remaining_time_in_state > 0)
+    {
+        warning_armed_ = false;
+        sink_.play(AudioCue::WARNING);
+    }
+}
+
+void AudioCues::notification(IdleToWork)
+{
+    sink_.play(AudioCue::START_WORK);
+}
+
+void AudioCues::notification(WorkToBreak)
+{
+    sink_.play(AudioCue::END_WORK);
+}
+
+void AudioCues::notification(BreakToIdle)
+{
+    sink_.play(AudioCue::END_BREAK);
+}
+
+void AudioCues::notification(WorkToIdle)
+{
+}
+
+void AudioCues::notification(AdditionalWork)
+{
+}
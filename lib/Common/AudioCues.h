@@ -0,0 +1,52 @@
+//
+// Which sound each pomodoro transition plays, including a warning before work ends.
+//
+
+#ifndef AUDIOCUES_H
+#define AUDIOCUES_H
+
+#include <cstdint>
+
+#include "Pomodoro.h"
+
+enum class AudioCue : uint8_t
+{
+    START_WORK = 0,
+    END_WORK = 1,
+    END_BREAK = 2,
+    WARNING = 3,
+};
+
+constexpr uint8_t AUDIO_CUES = 4;
+
+// Where cues go: the device's CuePlayer, or a recorder in tests. play() must not block.
+class CueSink
+{
+public:
+    virtual ~CueSink() = default;
+
+    virtual void play(AudioCue cue) = 0;
+};
+
+// Maps transitions to cues. The warning plays once per work period, when the remaining time
+// crosses `warning_seconds`; periods that start below the threshold do not warn, and extending
+// work past it re-arms the warning. Zero disables it.
+class AudioCues final : public PomodoroObserver
+{
+public:
+    explicit AudioCues(CueSink& sink, time_t warning_seconds = 120);
+
+    void notification(ClockUpdate update) override;
+    void notification(IdleToWork update) override;
+    void notification(WorkToBreak update) override;
+    void notification(BreakToIdle update) override;
+    void notification(WorkToIdle update) override;
+    void notification(AdditionalWork update) override;
+
+private:
+    CueSink& sink_;
+    time_t warning_seconds_;
+    bool warning_armed_;
+};
+
+#endif //AUDIOCUES_H
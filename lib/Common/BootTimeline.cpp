@@ -0,0 +1,76 @@
+//
+// Start and end of each boot phase, recorded from any task and reported over serial.
+//
+
+#include "BootTimeline.h"
+
+#include <algorithm>
+#include <cstdio>
+
+BootTimeline::BootTimeline(const uint64_t origin_us) : origin_us_(origin_us), phases_(), size_(0)
+{
+}
+
+void BootTimeline::record(const char* name, const uint64_t start_us, const uint64_t end_us, const bool ok)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (size_ < kMaxPhases)
+    {
+        phases_[size_++] = {name, start_us, end_us < start_us ? start_us : end_us, ok};
+    }
+}
+
+size_t BootTimeline::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return size_;
+}
+
+BootPhase BootTimeline::phase(const size_t index) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return phases_[index];
+}
+
+int BootTimeline::formatPhase(const BootPhase& phase, char* out, const size_t size) const
+{
+    const uint64_t start = phase.start_us > origin_us_ ? phase.start_us - origin_us_ : 0;
+    return snprintf(out, size, "boot %8.1f ms  +%8.1f ms  %s%s", static_cast<double>(start) / 1000.0,
+                    static_cast<double>(phase.end_us - phase.start_us) / 1000.0, phase.name,
+                    phase.ok ? "" : " (failed)");
+}
+
+size_t BootTimeline::format(char* out, const size_t size) const
+{
+    BootPhase sorted[kMaxPhases];
+    size_t count;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        count = size_;
+        std::copy(phases_, phases_ + count, sorted);
+    }
+    std::stable_sort(sorted, sorted + count,
+                     [](const BootPhase& a, const BootPhase& b) { return a.start_us < b.start_us; });
+    size_t written = 0;
+    if (size > 0)
+    {
+        out[0] = '\0';
+    }
+    for (size_t i = 0; i < count && written + 1 < size; i++)
+    {
+        const int length = formatPhase(sorted[i], out + written, size - written);
+        if (length < 0)
+        {
+            break;
+        }
+        written += static_cast<size_t>(length);
+        if (written + 1 >= size)
+        {
+            written = size - 1;
+            break;
+        }
+        out[written++] = '\n';
+        out[written] = '\0';
+    }
+    return written;
+}
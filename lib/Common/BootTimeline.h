@@ -0,0 +1,49 @@
+//
+// Start and end of each boot phase, recorded from any task and reported over serial.
+//
+
+#ifndef BOOTTIMELINE_H
+#define BOOTTIMELINE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+struct BootPhase
+{
+    // Static string, e.g. "config".
+    const char* name;
+    uint64_t start_us;
+    uint64_t end_us;
+    bool ok;
+};
+
+// Phases may overlap (the network comes up while the clock runs) and may be recorded in any
+// order; the report lists them by start time, relative to `origin_us`.
+class BootTimeline
+{
+public:
+    static constexpr size_t kMaxPhases = 16;
+
+    explicit BootTimeline(uint64_t origin_us = 0);
+
+    // Phases past kMaxPhases are dropped. Safe to call from any task.
+    void record(const char* name, uint64_t start_us, uint64_t end_us, bool ok = true);
+
+    size_t size() const;
+    BootPhase phase(size_t index) const;
+
+    // "boot   812.4 ms  +  35.2 ms  wifi (failed)"; returns the length, like snprintf.
+    int formatPhase(const BootPhase& phase, char* out, size_t size) const;
+
+    // Every phase, one line each, sorted by start. Returns the length written.
+    size_t format(char* out, size_t size) const;
+
+private:
+    mutable std::mutex mutex_;
+    uint64_t origin_us_;
+    BootPhase phases_[kMaxPhases];
+    size_t size_;
+};
+
+#endif //BOOTTIMELINE_H
@@ -0,0 +1,167 @@
+//
+// Shared-bus lock with two priorities and per-client wait/hold statistics.
+//
+
+#include "BusArbiter.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "FrameTiming.h"
+
+namespace
+{
+uint32_t clamp32(const uint64_t value)
+{
+    return value > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(value);
+}
+}
+
+BusClient::BusClient(BusArbiter& arbiter, const char* name, const BusPriority priority)
+    : arbiter_(arbiter), name_(name), priority_(priority), stats_(), next_(nullptr)
+{
+    arbiter_.add(this);
+}
+
+BusArbiter::BusArbiter()
+    : clients_(nullptr),
+      owner_(nullptr),
+      depth_(0),
+      acquired_at_us_(0),
+      interactive_waiting_(0),
+      interactive_waiting_since_us_(0)
+{
+}
+
+void BusArbiter::add(BusClient* client)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    BusClient** tail = &clients_;
+    while (*tail)
+    {
+        tail = &(*tail)->next_;
+    }
+    *tail = client;
+}
+
+void BusArbiter::acquire(BusClient& client)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (owner_ && owner_thread_ == std::this_thread::get_id())
+    {
+        depth_++;
+        return;
+    }
+    acquireLocked(lock, client);
+}
+
+void BusArbiter::acquireLocked(std::unique_lock<std::mutex>& lock, BusClient& client)
+{
+    const uint64_t started = monotonicMicros();
+    if (client.priority_ == BusPriority::INTERACTIVE)
+    {
+        if (interactive_waiting_++ == 0)
+        {
+            interactive_waiting_since_us_ = started;
+        }
+        released_.wait(lock, [this]() { return owner_ == nullptr; });
+        interactive_waiting_--;
+    }
+    else
+    {
+        released_.wait(lock, [this]() { return owner_ == nullptr && interactive_waiting_ == 0; });
+    }
+    const uint64_t now = monotonicMicros();
+    owner_ = &client;
+    owner_thread_ = std::this_thread::get_id();
+    depth_ = 1;
+    acquired_at_us_ = now;
+    if (interactive_waiting_ > 0)
+    {
+        // The remaining interactive waiters now wait on this client.
+        interactive_waiting_since_us_ = now;
+    }
+    BusClientStats& stats = client.stats_;
+    stats.acquisitions++;
+    stats.wait_us += now - started;
+    stats.max_wait_us = std::max(stats.max_wait_us, clamp32(now - started));
+}
+
+void BusArbiter::release()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!owner_ || --depth_ > 0)
+        {
+            return;
+        }
+        releaseLocked();
+    }
+    released_.notify_all();
+}
+
+void BusArbiter::releaseLocked()
+{
+    const uint64_t now = monotonicMicros();
+    BusClientStats& stats = owner_->stats_;
+    stats.hold_us += now - acquired_at_us_;
+    stats.max_hold_us = std::max(stats.max_hold_us, clamp32(now - acquired_at_us_));
+    if (interactive_waiting_ > 0)
+    {
+        const uint64_t since = std::max(acquired_at_us_, interactive_waiting_since_us_);
+        stats.blocked_interactive_us += now - since;
+    }
+    owner_ = nullptr;
+    owner_thread_ = std::thread::id();
+    depth_ = 0;
+}
+
+bool BusArbiter::yield()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!owner_ || owner_thread_ != std::this_thread::get_id() || depth_ != 1 || interactive_waiting_ == 0)
+    {
+        return false;
+    }
+    BusClient& client = *owner_;
+    client.stats_.yields++;
+    releaseLocked();
+    released_.notify_all();
+    acquireLocked(lock, client);
+    // The hand-over is not a new acquisition of the job's own.
+    client.stats_.acquisitions--;
+    return true;
+}
+
+BusClientStats BusArbiter::stats(const BusClient& client) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return client.stats_;
+}
+
+size_t BusArbiter::format(char* out, const size_t size) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t written = 0;
+    if (size > 0)
+    {
+        out[0] = '\0';
+    }
+    for (const BusClient* client = clients_; client && written + 1 < size; client = client->next_)
+    {
+        const BusClientStats& stats = client->stats_;
+        const int length = snprintf(
+            out + written, size - written,
+            "bus %-10s %6lu holds, wait %8.1f ms (max %6.1f), hold %8.1f ms (max %6.1f), %lu yields, "
+            "blocked UI %8.1f ms\n",
+            client->name_, static_cast<unsigned long>(stats.acquisitions), stats.wait_us / 1000.0,
+            stats.max_wait_us / 1000.0, stats.hold_us / 1000.0, stats.max_hold_us / 1000.0,
+            static_cast<unsigned long>(stats.yields), stats.blocked_interactive_us / 1000.0);
+        if (length < 0)
+        {
+            break;
+        }
+        written = std::min(size - 1, written + static_cast<size_t>(length));
+    }
+    return written;
+}
@@ -0,0 +1,134 @@
+//
+// Shared-bus lock with two priorities and per-client wait/hold statistics.
+//
+
+#ifndef BUSARBITER_H
+#define BUSARBITER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+enum class BusPriority : uint8_t
+{
+    // SD card I/O that nobody is watching.
+    BACKGROUND = 0,
+    // Display pushes: a waiting interactive client goes ahead of every background one.
+    INTERACTIVE = 1,
+};
+
+struct BusClientStats
+{
+    uint32_t acquisitions;
+    uint32_t yields;
+    uint64_t wait_us;
+    uint32_t max_wait_us;
+    uint64_t hold_us;
+    uint32_t max_hold_us;
+    // Time interactive clients spent waiting while this client held the bus.
+    uint64_t blocked_interactive_us;
+};
+
+class BusArbiter;
+
+// One user of the bus, e.g. "display" or "logger". Clients register with the arbiter on
+// construction and must outlive it or never be destroyed (they are usually statics or members
+// of long-lived objects).
+class BusClient
+{
+public:
+    BusClient(BusArbiter& arbiter, const char* name, BusPriority priority);
+
+    const char* name() const
+    {
+        return name_;
+    }
+
+    BusPriority priority() const
+    {
+        return priority_;
+    }
+
+    BusArbiter& arbiter() const
+    {
+        return arbiter_;
+    }
+
+private:
+    friend class BusArbiter;
+
+    BusArbiter& arbiter_;
+    const char* name_;
+    BusPriority priority_;
+    BusClientStats stats_;
+    BusClient* next_;
+};
+
+// Like a recursive mutex, but background clients wait while any interactive client is waiting,
+// and long background jobs can yield() between steps. A nested acquire on the owning thread is
+// free and its time is charged to the outermost client.
+class BusArbiter
+{
+public:
+    BusArbiter();
+
+    void acquire(BusClient& client);
+    void release();
+
+    // For the owner, at a safe point between bus transactions: if an interactive client is
+    // waiting and this is the outermost hold, hands the bus over and takes it back afterwards.
+    bool yield();
+
+    // Statistics of `client`, consistent with each other.
+    BusClientStats stats(const BusClient& client) const;
+
+    // One line per registered client; returns the length written.
+    size_t format(char* out, size_t size) const;
+
+private:
+    friend class BusClient;
+
+    mutable std::mutex mutex_;
+    std::condition_variable released_;
+    BusClient* clients_;
+    BusClient* owner_;
+    std::thread::id owner_thread_;
+    uint32_t depth_;
+    uint64_t acquired_at_us_;
+    uint32_t interactive_waiting_;
+    uint64_t interactive_waiting_since_us_;
+
+    void add(BusClient* client);
+    void acquireLocked(std::unique_lock<std::mutex>& lock, BusClient& client);
+    void releaseLocked();
+};
+
+// Scoped hold of the bus, the BusArbiter counterpart of std::lock_guard.
+class BusLock
+{
+public:
+    explicit BusLock(BusClient& client) : arbiter_(client.arbiter())
+    {
+        arbiter_.acquire(client);
+    }
+
+    ~BusLock()
+    {
+        arbiter_.release();
+    }
+
+    BusLock(const BusLock&) = delete;
+    BusLock& operator=(const BusLock&) = delete;
+
+    bool yield()
+    {
+        return arbiter_.yield();
+    }
+
+private:
+    BusArbiter& arbiter_;
+};
+
+#endif //BUSARBITER_H
@@ -0,0 +1,99 @@
+//
+// Little-endian integers, varints and FNV-1a, shared by the binary formats in lib/Common.
+//
+
+#ifndef BYTECODEC_H
+#define BYTECODEC_H
+
+#include <cstddef>
+#include <cstdint>
+
+inline void putUint16(uint8_t* out, const uint16_t value)
+{
+    out[0] = static_cast<uint8_t>(value);
+    out[1] = static_cast<uint8_t>(value >> 8);
+}
+
+inline void putUint32(uint8_t* out, const uint32_t value)
+{
+    out[0] = static_cast<uint8_t>(value);
+    out[1] = static_cast<uint8_t>(value >> 8);
+    out[2] = static_cast<uint8_t>(value >> 16);
+    out[3] = static_cast<uint8_t>(value >> 24);
+}
+
+inline void putUint64(uint8_t* out, const uint64_t value)
+{
+    putUint32(out, static_cast<uint32_t>(value));
+    putUint32(out + 4, static_cast<uint32_t>(value >> 32));
+}
+
+inline uint16_t getUint16(const uint8_t* data)
+{
+    return static_cast<uint16_t>(data[0] | data[1] << 8);
+}
+
+inline uint32_t getUint32(const uint8_t* data)
+{
+    return static_cast<uint32_t>(data[0]) | static_cast<uint32_t>(data[1]) << 8
+        | static_cast<uint32_t>(data[2]) << 16 | static_cast<uint32_t>(data[3]) << 24;
+}
+
+// Longest varint: a 64-bit value in 7-bit groups.
+constexpr size_t kMaxVarintBytes = 10;
+
+// Seven bits per byte, low group first, high bit set on all but the last; returns the size.
+inline size_t putVarint(uint64_t value, uint8_t* out)
+{
+    size_t size = 0;
+    while (value >= 0x80)
+    {
+        out[size++] = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    out[size++] = static_cast<uint8_t>(value);
+    return size;
+}
+
+// Reads a varint from at most `length` bytes; returns the bytes it took, or 0 if it runs past
+// the end or past kMaxVarintBytes.
+inline size_t getVarint(const uint8_t* data, const size_t length, uint64_t* value)
+{
+    uint64_t result = 0;
+    for (size_t i = 0; i < length && i < kMaxVarintBytes; i++)
+    {
+        result |= static_cast<uint64_t>(data[i] & 0x7F) << (7 * i);
+        if ((data[i] & 0x80) == 0)
+        {
+            *value = result;
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+// Small magnitudes of either sign to small unsigned values, for varints: 0, -1, 1, -2 -> 0, 1, 2, 3.
+inline uint64_t zigzag(const int64_t value)
+{
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t unzigzag(const uint64_t value)
+{
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+constexpr uint32_t kFnv1aBasis = 2166136261u;
+
+// 32-bit FNV-1a; start from kFnv1aBasis and chain calls to hash several pieces as one.
+inline uint32_t fnv1a(uint32_t hash, const void* data, const size_t length)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < length; i++)
+    {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+#endif //BYTECODEC_H
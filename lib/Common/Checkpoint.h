@@ -0,0 +1,21 @@
+//
+// Small persistent blobs that survive a reboot (NVS on the device).
+//
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cstddef>
+#include <cstdint>
+
+class CheckpointStore
+{
+public:
+    virtual ~CheckpointStore() = default;
+
+    // Reads the stored blob into `data`. Returns its size, or 0 if none is stored or it doesn't fit.
+    virtual size_t load(uint8_t* data, size_t capacity) = 0;
+    virtual bool save(const uint8_t* data, size_t size) = 0;
+};
+
+#endif //CHECKPOINT_H
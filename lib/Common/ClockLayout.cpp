@@ -0,0 +1,149 @@
+//
+// Where ClockFace puts each line of text, independent of the graphics library.
+//
+
+#include "ClockLayout.h"
+
+#include "NumeralAtlas.h"
+
+namespace
+{
+constexpr uint8_t kClockFont = numeral_atlas::kFont;
+constexpr uint8_t kLabelFont = clock_fonts::kLabel;
+constexpr uint8_t kStatsFont = clock_fonts::kStats;
+
+void addRun(FrameLayout* out, const FontMetrics& metrics, const char* text, const uint8_t font,
+            const uint16_t color, const int16_t x, const int16_t y)
+{
+    // Missing text still takes its slot, so runs keep their positions within a scene.
+    TextRun* run = out->addRun();
+    if (!run)
+    {
+        return;
+    }
+    if (!text)
+    {
+        text = "";
+    }
+    run->font = font;
+    run->color = color;
+    run->y = y;
+    run->height = metrics.height(font);
+    run->length = 0;
+    run->cell_x[0] = x;
+    for (const char* c = text; *c && run->length < TEXT_RUN_CAPACITY; c++)
+    {
+        run->text[run->length] = *c;
+        run->cell_x[run->length + 1] = static_cast<int16_t>(run->cell_x[run->length] + metrics.charWidth(font, *c));
+        run->length++;
+    }
+    run->text[run->length] = '\0';
+}
+
+int16_t textWidth(const FontMetrics& metrics, const char* text, const uint8_t font)
+{
+    int16_t width = 0;
+    size_t length = 0;
+    for (const char* c = text; *c && length < TEXT_RUN_CAPACITY; c++, length++)
+    {
+        width = static_cast<int16_t>(width + metrics.charWidth(font, *c));
+    }
+    return width;
+}
+
+void addCenteredRun(FrameLayout* out, const FontMetrics& metrics, const char* text, const uint8_t font,
+                    const uint16_t color, const int16_t center_x, const int16_t y)
+{
+    const int16_t width = text ? textWidth(metrics, text, font) : 0;
+    addRun(out, metrics, text, font, color, static_cast<int16_t>(center_x - width / 2), y);
+}
+
+// The vertical rhythm ClockFace has always used: line 0 sits one line (plus a quarter line of
+// padding) above the middle of the screen.
+void addLine(FrameLayout* out, const FontMetrics& metrics, const char* text, const uint16_t color,
+             const int line, const uint8_t font, const int16_t width, const int16_t height)
+{
+    const int16_t font_height = metrics.height(font);
+    const int16_t padding = static_cast<int16_t>(font_height / 4);
+    const int16_t y = static_cast<int16_t>(height / 2 - (font_height + padding) + (font_height + padding) * line);
+    addCenteredRun(out, metrics, text, font, color, static_cast<int16_t>(width / 2), y);
+}
+
+// Clock and countdown lines use the compile-time cell table when the text has the expected shape,
+// so the glyph cells line up with the atlas ClockFace blits from.
+void addNumeralLine(FrameLayout* out, const FontMetrics& metrics, const char* text, const uint16_t color,
+                    const int line, const int16_t width, const int16_t height)
+{
+    using namespace numeral_atlas;
+    const int16_t* cells = nullptr;
+    size_t length = 0;
+    if (text && matches(text, kClockPattern))
+    {
+        cells = kClockCells;
+        length = kClockLength;
+    }
+    else if (text && matches(text, kCountdownPattern))
+    {
+        cells = kCountdownCells;
+        length = kCountdownLength;
+    }
+    if (!cells)
+    {
+        addLine(out, metrics, text, color, line, kClockFont, width, height);
+        return;
+    }
+    TextRun* run = out->addRun();
+    if (!run)
+    {
+        return;
+    }
+
+    constexpr int16_t padding = kHeight / 4;
+    const int16_t x = static_cast<int16_t>(width / 2 - cells[length] / 2);
+    run->font = kFont;
+    run->color = color;
+    run->y = static_cast<int16_t>(height / 2 - (kHeight + padding) + (kHeight + padding) * line);
+    run->height = kHeight;
+    run->length = length;
+    for (size_t i = 0; i < length; i++)
+    {
+        run->text[i] = text[i];
+        run->cell_x[i] = static_cast<int16_t>(x + cells[i]);
+    }
+    run->cell_x[length] = static_cast<int16_t>(x + cells[length]);
+    run->text[length] = '\0';
+}
+}
+
+void layoutClockFrame(const ClockFrameText& text, const FontMetrics& metrics, const int16_t width,
+                      const int16_t height, FrameLayout* out)
+{
+    using namespace clock_colors;
+    switch (text.state)
+    {
+    case IDLE:
+    {
+        out->clear(IDLE, kBlack);
+        addNumeralLine(out, metrics, text.time, kWhite, 0, width, height);
+        addLine(out, metrics, text.date, kYellow, 1, kLabelFont, width, height);
+        addLine(out, metrics, text.weekday, kYellow, 2, kLabelFont, width, height);
+        const int16_t stats_height = metrics.height(kStatsFont);
+        addCenteredRun(out, metrics, text.stats_summary, kStatsFont, kLightGrey, static_cast<int16_t>(width / 2),
+                       static_cast<int16_t>(height - 2 * stats_height - 4));
+        addCenteredRun(out, metrics, text.stats_flavors, kStatsFont, kLightGrey, static_cast<int16_t>(width / 2),
+                       static_cast<int16_t>(height - stats_height - 2));
+        break;
+    }
+    case WORK:
+        out->clear(WORK | (static_cast<uint32_t>(text.work_flavor) << 8), text.work_color);
+        addRun(out, metrics, text.flavor_label, kLabelFont, kBlack, 10, 10);
+        addNumeralLine(out, metrics, text.time, kWhite, 0, width, height);
+        addNumeralLine(out, metrics, text.remaining, kBlack, 1, width, height);
+        break;
+    case BREAK:
+        out->clear(BREAK, kRed);
+        addNumeralLine(out, metrics, text.time, kWhite, 0, width, height);
+        addNumeralLine(out, metrics, text.remaining, kBlack, 1, width, height);
+        break;
+    }
+}
@@ -0,0 +1,59 @@
+//
+// Where ClockFace puts each line of text, independent of the graphics library.
+//
+
+#ifndef CLOCKLAYOUT_H
+#define CLOCKLAYOUT_H
+
+#include <cstdint>
+
+#include "DirtyRegion.h"
+#include "Pomodoro.h"
+
+namespace clock_colors
+{
+// RGB565, matching the M5GFX color constants ClockFace used to draw with.
+constexpr uint16_t kBlack = 0x0000;
+constexpr uint16_t kWhite = 0xFFFF;
+constexpr uint16_t kYellow = 0xFFE0;
+constexpr uint16_t kDarkGreen = 0x03E0;
+constexpr uint16_t kRed = 0xF800;
+constexpr uint16_t kLightGrey = 0xD69A;
+}
+
+namespace clock_fonts
+{
+// The flavor label, date and weekday lines, and the stats lines shown while idle.
+constexpr uint8_t kLabel = 4;
+constexpr uint8_t kStats = 2;
+}
+
+class FontMetrics
+{
+public:
+    virtual ~FontMetrics() = default;
+
+    virtual int16_t charWidth(uint8_t font, char c) const = 0;
+    virtual int16_t height(uint8_t font) const = 0;
+};
+
+// Strings for one frame. Fields not shown in the given state may be null.
+struct ClockFrameText
+{
+    PomodoroState state;
+    uint8_t work_flavor;
+    // Background while working: the flavor's color.
+    uint16_t work_color;
+    const char* time;
+    const char* date;
+    const char* weekday;
+    const char* remaining;
+    const char* flavor_label;
+    const char* stats_summary;
+    const char* stats_flavors;
+};
+
+void layoutClockFrame(const ClockFrameText& text, const FontMetrics& metrics, int16_t width, int16_t height,
+                      FrameLayout* out);
+
+#endif //CLOCKLAYOUT_H
@@ -0,0 +1,143 @@
+//
+// Parsed Settings kept as a compact blob (NVS on the device) so boots skip parsing config.ini.
+//
+
+#include "ConfigCache.h"
+
+#include <cstring>
+
+#include "ByteCodec.h"
+
+namespace
+{
+constexpr uint8_t kCacheVersion = 1;
+constexpr size_t kHeaderSize = 9;
+}
+
+uint32_t configFingerprint(const uint64_t file_size, const int64_t modified_time)
+{
+    uint8_t bytes[16];
+    putUint64(bytes, file_size);
+    putUint64(bytes + 8, static_cast<uint64_t>(modified_time));
+    return fnv1a(kFnv1aBasis, bytes, sizeof(bytes));
+}
+
+uint32_t configSchemaHash()
+{
+    static const uint32_t hash = []()
+    {
+        uint32_t result = kFnv1aBasis;
+        for (const ConfigField& field : kConfigSchema)
+        {
+            result = fnv1a(result, field.section.data(), field.section.size());
+            result = fnv1a(result, "=", 1);
+            result = fnv1a(result, field.key.data(), field.key.size());
+            const uint8_t shape[3] = {static_cast<uint8_t>(field.type), static_cast<uint8_t>(field.size),
+                                      static_cast<uint8_t>(field.size >> 8)};
+            result = fnv1a(result, shape, sizeof(shape));
+        }
+        return result;
+    }();
+    return hash;
+}
+
+bool ConfigCache::load(const uint32_t fingerprint, Settings* settings)
+{
+    uint8_t buffer[kMaxSize];
+    const size_t size = store_ ? store_->load(buffer, sizeof(buffer)) : 0;
+    return size > 0 && restore(buffer, size, fingerprint, settings);
+}
+
+bool ConfigCache::save(const uint32_t fingerprint, const Settings& settings)
+{
+    uint8_t buffer[kMaxSize];
+    const size_t size = serialize(fingerprint, settings, buffer, sizeof(buffer));
+    return store_ && size > 0 && store_->save(buffer, size);
+}
+
+size_t ConfigCache::serialize(const uint32_t fingerprint, const Settings& settings, uint8_t* out,
+                              const size_t capacity)
+{
+    if (capacity < kHeaderSize)
+    {
+        return 0;
+    }
+    out[0] = kCacheVersion;
+    putUint32(out + 1, configSchemaHash());
+    putUint32(out + 5, fingerprint);
+    size_t size = kHeaderSize;
+    const char* base = reinterpret_cast<const char*>(&settings);
+    for (const ConfigField& field : kConfigSchema)
+    {
+        if (field.type == ConfigType::STRING)
+        {
+            const size_t length = strnlen(base + field.offset, field.size - 1);
+            if (size + 1 + length > capacity)
+            {
+                return 0;
+            }
+            out[size++] = static_cast<uint8_t>(length);
+            memcpy(out + size, base + field.offset, length);
+            size += length;
+        }
+        else
+        {
+            if (size + 2 > capacity)
+            {
+                return 0;
+            }
+            uint16_t value;
+            memcpy(&value, base + field.offset, sizeof(value));
+            out[size++] = static_cast<uint8_t>(value);
+            out[size++] = static_cast<uint8_t>(value >> 8);
+        }
+    }
+    return size;
+}
+
+bool ConfigCache::restore(const uint8_t* in, const size_t size, const uint32_t fingerprint, Settings* settings)
+{
+    if (size < kHeaderSize || in[0] != kCacheVersion || getUint32(in + 1) != configSchemaHash()
+        || getUint32(in + 5) != fingerprint)
+    {
+        return false;
+    }
+    // Decode into a copy so a damaged blob leaves `settings` untouched.
+    Settings decoded = *settings;
+    char* base = reinterpret_cast<char*>(&decoded);
+    size_t offset = kHeaderSize;
+    for (const ConfigField& field : kConfigSchema)
+    {
+        if (field.type == ConfigType::STRING)
+        {
+            if (offset >= size)
+            {
+                return false;
+            }
+            const size_t length = in[offset++];
+            if (length >= field.size || offset + length > size)
+            {
+                return false;
+            }
+            memcpy(base + field.offset, in + offset, length);
+            base[field.offset + length] = '\0';
+            offset += length;
+        }
+        else
+        {
+            if (offset + 2 > size)
+            {
+                return false;
+            }
+            const uint16_t value = static_cast<uint16_t>(in[offset] | (in[offset + 1] << 8));
+            memcpy(base + field.offset, &value, sizeof(value));
+            offset += 2;
+        }
+    }
+    if (offset != size)
+    {
+        return false;
+    }
+    *settings = decoded;
+    return true;
+}
@@ -0,0 +1,43 @@
+//
+// Parsed Settings kept as a compact blob (NVS on the device) so boots skip parsing config.ini.
+//
+
+#ifndef CONFIGCACHE_H
+#define CONFIGCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Checkpoint.h"
+#include "ConfigSchema.h"
+
+// Identifies one version of config.ini from what a directory lookup returns, without reading it.
+uint32_t configFingerprint(uint64_t file_size, int64_t modified_time);
+
+// Hash of the schema's sections, keys, types and sizes: a cache written by a firmware with a
+// different schema is ignored rather than misread.
+uint32_t configSchemaHash();
+
+// Blob layout: version, schema hash, fingerprint, then every schema field in order (strings as a
+// length byte and the characters, numbers and colors as 16-bit little endian).
+class ConfigCache
+{
+public:
+    static constexpr size_t kMaxSize = 640;
+
+    explicit ConfigCache(CheckpointStore* store) : store_(store)
+    {
+    }
+
+    // Fills `settings` if the stored blob was written for `fingerprint` by this schema.
+    bool load(uint32_t fingerprint, Settings* settings);
+    bool save(uint32_t fingerprint, const Settings& settings);
+
+    static size_t serialize(uint32_t fingerprint, const Settings& settings, uint8_t* out, size_t capacity);
+    static bool restore(const uint8_t* in, size_t size, uint32_t fingerprint, Settings* settings);
+
+private:
+    CheckpointStore* store_;
+};
+
+#endif //CONFIGCACHE_H
@@ -0,0 +1,316 @@
+//
+// Typed config.ini settings, the schema that declares them, and a streaming parser that fills them.
+//
+
+#include "ConfigSchema.h"
+
+#include <cstdio>
+#include <cstring>
+
+static_assert(CONFIG_FIELDS <= 64, "ConfigParser tracks seen keys in a 64-bit mask");
+
+namespace
+{
+std::string_view trim(std::string_view text)
+{
+    const size_t first = text.find_first_not_of(" \t\r");
+    if (first == std::string_view::npos)
+    {
+        return {};
+    }
+    return text.substr(first, text.find_last_not_of(" \t\r") - first + 1);
+}
+
+bool parseUint(const std::string_view text, uint32_t* out)
+{
+    if (text.empty() || text.size() > 9)
+    {
+        return false;
+    }
+    uint32_t value = 0;
+    for (const char c : text)
+    {
+        if (c < '0' || c > '9')
+        {
+            return false;
+        }
+        value = value * 10 + static_cast<uint32_t>(c - '0');
+    }
+    *out = value;
+    return true;
+}
+
+int hexDigit(const char c)
+{
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f')
+    {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F')
+    {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+// "#rrggbb" to RGB565, dropping the low bits of each channel.
+bool parseColor(const std::string_view text, uint16_t* out)
+{
+    if (text.size() != 7 || text[0] != '#')
+    {
+        return false;
+    }
+    uint32_t rgb = 0;
+    for (size_t i = 1; i < text.size(); i++)
+    {
+        const int digit = hexDigit(text[i]);
+        if (digit < 0)
+        {
+            return false;
+        }
+        rgb = rgb << 4 | static_cast<uint32_t>(digit);
+    }
+    *out = static_cast<uint16_t>((rgb >> 19 & 0x1F) << 11 | (rgb >> 10 & 0x3F) << 5 | (rgb >> 3 & 0x1F));
+    return true;
+}
+
+const char* describe(const ConfigErrorCode code)
+{
+    switch (code)
+    {
+    case ConfigErrorCode::LINE_TOO_LONG:
+        return "line too long";
+    case ConfigErrorCode::SYNTAX:
+        return "expected [section] or key=value";
+    case ConfigErrorCode::UNKNOWN_SECTION:
+        return "unknown section";
+    case ConfigErrorCode::UNKNOWN_KEY:
+        return "unknown key";
+    case ConfigErrorCode::DUPLICATE_KEY:
+        return "duplicate key";
+    case ConfigErrorCode::VALUE_TOO_LONG:
+        return "value too long for";
+    case ConfigErrorCode::NOT_A_NUMBER:
+        return "expected a number for";
+    case ConfigErrorCode::NOT_A_COLOR:
+        return "expected #rrggbb for";
+    case ConfigErrorCode::OUT_OF_RANGE:
+        return "value out of range for";
+    case ConfigErrorCode::MISSING_KEY:
+        return "missing required key";
+    }
+    return "error";
+}
+}
+
+ConfigParser::ConfigParser(Settings* settings)
+    : settings_(settings),
+      pending_length_(0),
+      pending_overflow_(false),
+      line_number_(0),
+      section_known_(false),
+      seen_(0),
+      error_count_(0),
+      fatal_count_(0)
+{
+}
+
+void ConfigParser::feed(const char* data, const size_t size)
+{
+    const char* end = data + size;
+    while (data < end)
+    {
+        const char* newline = static_cast<const char*>(memchr(data, '\n', end - data));
+        const char* stop = newline ? newline : end;
+        const size_t length = stop - data;
+        if (pending_length_ == 0 && !pending_overflow_ && newline)
+        {
+            // The whole line is in this chunk: parse it where it is.
+            parseLine(std::string_view(data, length));
+        }
+        else
+        {
+            if (pending_length_ + length > kMaxLine)
+            {
+                pending_overflow_ = true;
+            }
+            else
+            {
+                memcpy(pending_ + pending_length_, data, length);
+                pending_length_ += length;
+            }
+            if (newline)
+            {
+                parseLine(std::string_view(pending_, pending_length_));
+                pending_length_ = 0;
+                pending_overflow_ = false;
+            }
+        }
+        data = newline ? newline + 1 : end;
+    }
+}
+
+bool ConfigParser::finish()
+{
+    if (pending_length_ > 0 || pending_overflow_)
+    {
+        parseLine(std::string_view(pending_, pending_length_));
+        pending_length_ = 0;
+        pending_overflow_ = false;
+    }
+    for (size_t i = 0; i < CONFIG_FIELDS; i++)
+    {
+        if (kConfigSchema[i].required && !(seen_ & (1ull << i)))
+        {
+            char name[32];
+            const int length = snprintf(name, sizeof(name), "%.*s.%.*s",
+                                        static_cast<int>(kConfigSchema[i].section.size()),
+                                        kConfigSchema[i].section.data(),
+                                        static_cast<int>(kConfigSchema[i].key.size()), kConfigSchema[i].key.data());
+            addError(0, ConfigErrorCode::MISSING_KEY,
+                     std::string_view(name, length < static_cast<int>(sizeof(name)) ? length : sizeof(name) - 1));
+        }
+    }
+    return fatal_count_ == 0;
+}
+
+void ConfigParser::parseLine(std::string_view line)
+{
+    line_number_++;
+    if (pending_overflow_ || line.size() > kMaxLine)
+    {
+        addError(line_number_, ConfigErrorCode::LINE_TOO_LONG, {});
+        return;
+    }
+    line = trim(line);
+    if (line.empty() || line[0] == ';' || line[0] == '#')
+    {
+        return;
+    }
+    if (line[0] == '[')
+    {
+        if (line.back() != ']')
+        {
+            addError(line_number_, ConfigErrorCode::SYNTAX, line);
+            return;
+        }
+        section_ = {};
+        section_known_ = false;
+        const std::string_view name = trim(line.substr(1, line.size() - 2));
+        for (const ConfigField& field : kConfigSchema)
+        {
+            if (field.section == name)
+            {
+                // Keep the schema's copy: `line` does not outlive this call.
+                section_ = field.section;
+                section_known_ = true;
+                return;
+            }
+        }
+        addError(line_number_, ConfigErrorCode::UNKNOWN_SECTION, name);
+        return;
+    }
+    const size_t equals = line.find('=');
+    if (equals == std::string_view::npos || equals == 0)
+    {
+        addError(line_number_, ConfigErrorCode::SYNTAX, line);
+        return;
+    }
+    if (!section_known_)
+    {
+        // Keys of an unknown section were reported with the section.
+        return;
+    }
+    const std::string_view key = trim(line.substr(0, equals));
+    for (size_t i = 0; i < CONFIG_FIELDS; i++)
+    {
+        if (kConfigSchema[i].section == section_ && kConfigSchema[i].key == key)
+        {
+            if (seen_ & (1ull << i))
+            {
+                addError(line_number_, ConfigErrorCode::DUPLICATE_KEY, key);
+                return;
+            }
+            setValue(i, trim(line.substr(equals + 1)));
+            return;
+        }
+    }
+    addError(line_number_, ConfigErrorCode::UNKNOWN_KEY, key);
+}
+
+void ConfigParser::setValue(const size_t field_index, const std::string_view value)
+{
+    const ConfigField& field = kConfigSchema[field_index];
+    char* target = reinterpret_cast<char*>(settings_) + field.offset;
+    if (field.type == ConfigType::STRING)
+    {
+        if (value.size() >= field.size)
+        {
+            addError(line_number_, ConfigErrorCode::VALUE_TOO_LONG, field.key);
+            return;
+        }
+        memcpy(target, value.data(), value.size());
+        target[value.size()] = '\0';
+    }
+    else if (field.type == ConfigType::COLOR)
+    {
+        uint16_t color;
+        if (!parseColor(value, &color))
+        {
+            addError(line_number_, ConfigErrorCode::NOT_A_COLOR, field.key);
+            return;
+        }
+        memcpy(target, &color, sizeof(color));
+    }
+    else
+    {
+        uint32_t number;
+        if (!parseUint(value, &number))
+        {
+            addError(line_number_, ConfigErrorCode::NOT_A_NUMBER, field.key);
+            return;
+        }
+        if (number < field.min || number > field.max)
+        {
+            addError(line_number_, ConfigErrorCode::OUT_OF_RANGE, field.key);
+            return;
+        }
+        const uint16_t narrow = static_cast<uint16_t>(number);
+        memcpy(target, &narrow, sizeof(narrow));
+    }
+    seen_ |= 1ull << field_index;
+}
+
+void ConfigParser::addError(const uint16_t line, const ConfigErrorCode code, const std::string_view name)
+{
+    if (error_count_ < kMaxErrors)
+    {
+        ConfigError& error = errors_[error_count_];
+        error.line = line;
+        error.code = code;
+        const size_t length = name.size() < sizeof(error.name) ? name.size() : sizeof(error.name) - 1;
+        // copy() rather than memcpy: an empty view may have a null data().
+        name.copy(error.name, length);
+        error.name[length] = '\0';
+    }
+    error_count_++;
+    fatal_count_ += configErrorIsFatal(code) ? 1 : 0;
+}
+
+int ConfigParser::formatError(const ConfigError& error, char* out, const size_t size)
+{
+    const char* what = describe(error.code);
+    if (error.line == 0)
+    {
+        return snprintf(out, size, "config.ini: %s '%s'", what, error.name);
+    }
+    if (error.name[0] == '\0')
+    {
+        return snprintf(out, size, "config.ini line %u: %s", error.line, what);
+    }
+    return snprintf(out, size, "config.ini line %u: %s '%s'", error.line, what, error.name);
+}
@@ -0,0 +1,217 @@
+//
+// Typed config.ini settings, the schema that declares them, and a streaming parser that fills them.
+//
+
+#ifndef CONFIGSCHEMA_H
+#define CONFIGSCHEMA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "Pomodoro.h"
+
+// RGB565 dark green, the work screen's background before flavors had colors of their own.
+constexpr uint16_t DEFAULT_FLAVOR_COLOR = 0x03E0;
+
+// One kind of work. Zero minutes use the [durations] ones.
+struct FlavorSettings
+{
+    char label[16];
+    // RGB565 background of the work screen.
+    uint16_t color;
+    uint16_t work_minutes;
+    uint16_t break_minutes;
+};
+
+// Everything config.ini can set, with the defaults used for keys that are absent.
+struct Settings
+{
+    char wifi_ssid[33] = "";
+    char wifi_pass[64] = "";
+    char ntp_host[64] = "pool.ntp.org";
+    char ntp_tz[64] = "CET-1CEST,M3.5.0,M10.5.0/3";
+    char http_host[64] = "";
+    uint16_t http_port = 0;
+    // Used instead of HTTP when set.
+    char mqtt_host[64] = "";
+    uint16_t mqtt_port = 1883;
+    // Flavors past the count are ignored.
+    uint16_t flavor_count = DEFAULT_WORK_FLAVORS;
+    FlavorSettings flavors[MAX_WORK_FLAVORS] = {
+        {"work", DEFAULT_FLAVOR_COLOR, 0, 0}, {"leisure", DEFAULT_FLAVOR_COLOR, 0, 0},
+        {"chores", DEFAULT_FLAVOR_COLOR, 0, 0}, {"", DEFAULT_FLAVOR_COLOR, 0, 0},
+        {"", DEFAULT_FLAVOR_COLOR, 0, 0}, {"", DEFAULT_FLAVOR_COLOR, 0, 0},
+        {"", DEFAULT_FLAVOR_COLOR, 0, 0}, {"", DEFAULT_FLAVOR_COLOR, 0, 0}};
+    uint16_t work_minutes = WORK_DEFAULT_DURATION_SECONDS / 60;
+    uint16_t break_minutes = BREAK_DEFAULT_DURATION_SECONDS / 60;
+    uint16_t warning_minutes = 2;
+    // 0 turns the on-device status server off.
+    uint16_t status_port = 80;
+    // Clocks sharing a group and port mirror one pomodoro; port 0 keeps this one to itself.
+    char sync_group[16] = "239.255.42.99";
+    uint16_t sync_port = 0;
+};
+
+enum class ConfigType : uint8_t
+{
+    STRING,
+    UINT16,
+    // "#rrggbb", stored as RGB565.
+    COLOR,
+};
+
+// One key of the schema: where its value lives in Settings and what it accepts. Strings are
+// limited by the size of their buffer, numbers by [min, max].
+struct ConfigField
+{
+    std::string_view section;
+    std::string_view key;
+    ConfigType type;
+    uint16_t offset;
+    uint16_t size;
+    uint16_t min;
+    uint16_t max;
+    bool required;
+};
+
+#define CONFIG_STRING(section, key, member, required) \
+    ConfigField{section, key, ConfigType::STRING, offsetof(Settings, member), sizeof(Settings::member), 0, 0, required}
+#define CONFIG_UINT16(section, key, member, min, max) \
+    ConfigField{section, key, ConfigType::UINT16, offsetof(Settings, member), sizeof(uint16_t), min, max, false}
+#define CONFIG_COLOR(section, key, member) \
+    ConfigField{section, key, ConfigType::COLOR, offsetof(Settings, member), sizeof(uint16_t), 0, 0, false}
+// flavorN, colorN, work_minutesN and break_minutesN in [flavors].
+#define CONFIG_FLAVOR(n) \
+    CONFIG_STRING("flavors", "flavor" #n, flavors[n].label, false), \
+    CONFIG_COLOR("flavors", "color" #n, flavors[n].color), \
+    CONFIG_UINT16("flavors", "work_minutes" #n, flavors[n].work_minutes, 0, 240), \
+    CONFIG_UINT16("flavors", "break_minutes" #n, flavors[n].break_minutes, 0, 60)
+
+inline constexpr ConfigField kConfigSchema[] = {
+    CONFIG_STRING("wifi", "ssid", wifi_ssid, true),
+    CONFIG_STRING("wifi", "pass", wifi_pass, true),
+    CONFIG_STRING("ntp", "host", ntp_host, true),
+    CONFIG_STRING("ntp", "tz", ntp_tz, false),
+    CONFIG_STRING("http", "host", http_host, false),
+    CONFIG_UINT16("http", "port", http_port, 1, 65535),
+    CONFIG_STRING("mqtt", "host", mqtt_host, false),
+    CONFIG_UINT16("mqtt", "port", mqtt_port, 1, 65535),
+    CONFIG_UINT16("flavors", "count", flavor_count, 1, MAX_WORK_FLAVORS),
+    CONFIG_FLAVOR(0),
+    CONFIG_FLAVOR(1),
+    CONFIG_FLAVOR(2),
+    CONFIG_FLAVOR(3),
+    CONFIG_FLAVOR(4),
+    CONFIG_FLAVOR(5),
+    CONFIG_FLAVOR(6),
+    CONFIG_FLAVOR(7),
+    CONFIG_UINT16("durations", "work_minutes", work_minutes, 1, 240),
+    CONFIG_UINT16("durations", "break_minutes", break_minutes, 1, 60),
+    CONFIG_UINT16("audio", "warning_minutes", warning_minutes, 0, 60),
+    CONFIG_UINT16("status", "port", status_port, 0, 65535),
+    CONFIG_STRING("sync", "group", sync_group, false),
+    CONFIG_UINT16("sync", "port", sync_port, 0, 65535),
+};
+
+#undef CONFIG_STRING
+#undef CONFIG_UINT16
+#undef CONFIG_COLOR
+#undef CONFIG_FLAVOR
+
+static_assert(MAX_WORK_FLAVORS == 8, "kConfigSchema declares eight flavors");
+
+inline constexpr size_t CONFIG_FIELDS = sizeof(kConfigSchema) / sizeof(kConfigSchema[0]);
+
+enum class ConfigErrorCode : uint8_t
+{
+    LINE_TOO_LONG,
+    SYNTAX,
+    UNKNOWN_SECTION,
+    UNKNOWN_KEY,
+    DUPLICATE_KEY,
+    VALUE_TOO_LONG,
+    NOT_A_NUMBER,
+    NOT_A_COLOR,
+    OUT_OF_RANGE,
+    MISSING_KEY,
+};
+
+// Unknown sections and keys (a typo, or a key from a newer firmware) leave every setting usable:
+// they are warnings. The other codes are errors.
+constexpr bool configErrorIsFatal(const ConfigErrorCode code)
+{
+    return code != ConfigErrorCode::UNKNOWN_SECTION && code != ConfigErrorCode::UNKNOWN_KEY;
+}
+
+// `line` is 1-based; 0 for errors about the file as a whole (missing keys). `name` holds the
+// section or key involved, truncated.
+struct ConfigError
+{
+    uint16_t line;
+    ConfigErrorCode code;
+    char name[32];
+};
+
+// Parses INI text fed in chunks of any size, in one pass and without heap allocation: complete
+// lines are parsed in place, only a line split across chunks is copied into a fixed buffer. Values
+// are validated against kConfigSchema and written straight into the Settings. Lines longer than
+// kMaxLine are rejected however they are split.
+class ConfigParser
+{
+public:
+    static constexpr size_t kMaxLine = 128;
+    static constexpr size_t kMaxErrors = 8;
+
+    explicit ConfigParser(Settings* settings);
+
+    void feed(const char* data, size_t size);
+
+    // Parses a last line without a newline and checks required keys. Returns true if there were
+    // no fatal errors; warnings alone still leave usable settings.
+    bool finish();
+
+    // Errors and warnings past kMaxErrors are counted but not kept; error() takes indices below both.
+    size_t errorCount() const
+    {
+        return error_count_;
+    }
+
+    // The errors configErrorIsFatal() counts, kept or not.
+    size_t fatalErrorCount() const
+    {
+        return fatal_count_;
+    }
+
+    const ConfigError& error(const size_t index) const
+    {
+        return errors_[index];
+    }
+
+    size_t lines() const
+    {
+        return line_number_;
+    }
+
+    // "line 7: unknown key 'colour'"; returns the length written, like snprintf.
+    static int formatError(const ConfigError& error, char* out, size_t size);
+
+private:
+    Settings* settings_;
+    char pending_[kMaxLine];
+    size_t pending_length_;
+    bool pending_overflow_;
+    uint16_t line_number_;
+    std::string_view section_;
+    bool section_known_;
+    uint64_t seen_;
+    ConfigError errors_[kMaxErrors];
+    size_t error_count_;
+    size_t fatal_count_;
+
+    void parseLine(std::string_view line);
+    void setValue(size_t field, std::string_view value);
+    void addError(uint16_t line, ConfigErrorCode code, std::string_view name);
+};
+
+#endif //CONFIGSCHEMA_H
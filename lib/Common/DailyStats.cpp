@@ -0,0 +1,231 @@
+//
+// Today's completed pomodoros and focus time per flavor, maintained incrementally from transitions.
+//
+
+#include "DailyStats.h"
+
+#include <cstdarg>
+#include <cstdio>
+
+#include "ByteCodec.h"
+#include "History.h"
+
+namespace
+{
+constexpr uint8_t kCheckpointVersion = 1;
+
+// Bounded printf-style appends into a caller-provided buffer.
+class JsonWriter
+{
+public:
+    JsonWriter(char* out, const size_t size) : out_(out), size_(size), length_(0), overflow_(size == 0)
+    {
+    }
+
+    void append(const char* format, ...)
+    {
+        if (overflow_)
+        {
+            return;
+        }
+        va_list args;
+        va_start(args, format);
+        const int written = vsnprintf(out_ + length_, size_ - length_, format, args);
+        va_end(args);
+        if (written < 0 || static_cast<size_t>(written) >= size_ - length_)
+        {
+            overflow_ = true;
+            return;
+        }
+        length_ += static_cast<size_t>(written);
+    }
+
+    // Returns 0 if the output didn't fit.
+    size_t length() const
+    {
+        return overflow_ ? 0 : length_;
+    }
+
+private:
+    char* out_;
+    size_t size_;
+    size_t length_;
+    bool overflow_;
+};
+
+time_t localMidnight(const time_t now, const int day_offset)
+{
+    struct tm timeinfo;
+    localtime_r(&now, &timeinfo);
+    timeinfo.tm_hour = 0;
+    timeinfo.tm_min = 0;
+    timeinfo.tm_sec = 0;
+    timeinfo.tm_mday += day_offset;
+    timeinfo.tm_isdst = -1;
+    return mktime(&timeinfo);
+}
+}
+
+DailyStats::DailyStats(CheckpointStore* store)
+    : store_(store), stats_(), work_flavor_(0), day_start_(0), next_midnight_(0)
+{
+    if (store_)
+    {
+        uint8_t buffer[CHECKPOINT_SIZE];
+        const size_t size = store_->load(buffer, sizeof(buffer));
+        restore(buffer, size);
+    }
+}
+
+void DailyStats::notification(const ClockUpdate update)
+{
+    if (update.state == WORK)
+    {
+        work_flavor_ = update.work_flavor;
+    }
+    if (update.now >= next_midnight_ || update.now < day_start_)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        rollover(update.now);
+    }
+}
+
+void DailyStats::notification(const IdleToWork update)
+{
+    work_flavor_ = update.work_flavor;
+}
+
+void DailyStats::notification(const WorkToBreak update)
+{
+    count(update.now, update.work_duration, true);
+}
+
+void DailyStats::notification(BreakToIdle)
+{
+}
+
+void DailyStats::notification(const WorkToIdle update)
+{
+    count(update.now, update.cancelled_work_duration, false);
+}
+
+void DailyStats::notification(const AdditionalWork update)
+{
+    work_flavor_ = update.work_flavor;
+}
+
+DailyStatsSnapshot DailyStats::snapshot() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void DailyStats::rollover(const time_t now)
+{
+    const uint16_t today = localDay(now);
+    if (today != stats_.day)
+    {
+        stats_ = DailyStatsSnapshot();
+        stats_.day = today;
+    }
+    day_start_ = localMidnight(now, 0);
+    next_midnight_ = localMidnight(now, 1);
+}
+
+void DailyStats::count(const time_t now, const time_t focus_seconds, const bool completed)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (now >= next_midnight_ || now < day_start_)
+        {
+            rollover(now);
+        }
+        const uint32_t seconds = focus_seconds > 0 ? static_cast<uint32_t>(focus_seconds) : 0;
+        stats_.focus_seconds += seconds;
+        if (completed)
+        {
+            stats_.completed++;
+        }
+        if (work_flavor_ < MAX_WORK_FLAVORS)
+        {
+            stats_.flavors[work_flavor_].focus_seconds += seconds;
+            if (completed)
+            {
+                stats_.flavors[work_flavor_].completed++;
+            }
+        }
+    }
+    checkpoint();
+}
+
+void DailyStats::checkpoint()
+{
+    if (!store_)
+    {
+        return;
+    }
+    uint8_t buffer[CHECKPOINT_SIZE];
+    const size_t size = serialize(buffer);
+    store_->save(buffer, size);
+}
+
+size_t DailyStats::serialize(uint8_t* out) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint8_t* p = out;
+    *p++ = kCheckpointVersion;
+    putUint16(p, stats_.day);
+    p += 2;
+    for (const FlavorStats& flavor : stats_.flavors)
+    {
+        putUint16(p, flavor.completed);
+        putUint32(p + 2, flavor.focus_seconds);
+        p += 6;
+    }
+    return static_cast<size_t>(p - out);
+}
+
+bool DailyStats::restore(const uint8_t* in, const size_t size)
+{
+    // One 6-byte entry per flavor, however many the firmware that wrote it had.
+    if (size < 3 + 6 || size > CHECKPOINT_SIZE || (size - 3) % 6 != 0 || in[0] != kCheckpointVersion)
+    {
+        return false;
+    }
+    DailyStatsSnapshot stats = DailyStatsSnapshot();
+    stats.day = getUint16(in + 1);
+    const uint8_t* p = in + 3;
+    for (size_t i = 0; i < (size - 3) / 6; i++)
+    {
+        FlavorStats& flavor = stats.flavors[i];
+        flavor.completed = getUint16(p);
+        flavor.focus_seconds = getUint32(p + 2);
+        p += 6;
+        stats.completed += flavor.completed;
+        stats.focus_seconds += flavor.focus_seconds;
+    }
+
+    // The day is checked against the clock on the next notification.
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_ = stats;
+    day_start_ = 0;
+    next_midnight_ = 0;
+    return true;
+}
+
+size_t formatDailyStatsJson(const DailyStatsSnapshot& snapshot, const FlavorTable& flavors, char* out,
+                            const size_t size)
+{
+    JsonWriter json(out, size);
+    json.append("{\"completed\":%u,\"focus_seconds\":%lu,\"flavors\":[", static_cast<unsigned>(snapshot.completed),
+                static_cast<unsigned long>(snapshot.focus_seconds));
+    for (uint8_t i = 0; i < flavors.size(); i++)
+    {
+        json.append("%s{\"flavor\":%u,\"label\":\"%s\",\"completed\":%u,\"focus_seconds\":%lu}", i > 0 ? "," : "",
+                    static_cast<unsigned>(i), flavors.jsonLabel(i),
+                    static_cast<unsigned>(snapshot.flavors[i].completed),
+                    static_cast<unsigned long>(snapshot.flavors[i].focus_seconds));
+    }
+    json.append("]}");
+    return json.length();
+}
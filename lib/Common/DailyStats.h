@@ -0,0 +1,75 @@
+//
+// Today's completed pomodoros and focus time per flavor, maintained incrementally from transitions.
+//
+
+#ifndef DAILYSTATS_H
+#define DAILYSTATS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include "Checkpoint.h"
+#include "FlavorTable.h"
+#include "Pomodoro.h"
+
+struct FlavorStats
+{
+    uint16_t completed;
+    uint32_t focus_seconds;
+};
+
+struct DailyStatsSnapshot
+{
+    uint16_t day;
+    uint16_t completed;
+    uint32_t focus_seconds;
+    FlavorStats flavors[MAX_WORK_FLAVORS];
+};
+
+// Counts completed pomodoros (WorkToBreak) and focus time (completed and cancelled work) for the
+// current local day, and resets at local midnight. If a CheckpointStore is given, counters are
+// restored from it at construction and saved after every counted transition.
+class DailyStats final : public PomodoroObserver
+{
+public:
+    // Checkpoints written with fewer flavors are restored too.
+    static constexpr size_t CHECKPOINT_SIZE = 3 + MAX_WORK_FLAVORS * 6;
+
+    explicit DailyStats(CheckpointStore* store = nullptr);
+
+    void notification(ClockUpdate update) override;
+    void notification(IdleToWork update) override;
+    void notification(WorkToBreak update) override;
+    void notification(BreakToIdle update) override;
+    void notification(WorkToIdle update) override;
+    void notification(AdditionalWork update) override;
+
+    // Safe to call from any task.
+    DailyStatsSnapshot snapshot() const;
+
+    size_t serialize(uint8_t* out) const;
+    bool restore(const uint8_t* in, size_t size);
+
+private:
+    CheckpointStore* store_;
+    mutable std::mutex mutex_;
+    DailyStatsSnapshot stats_;
+    uint8_t work_flavor_;
+    time_t day_start_;
+    time_t next_midnight_;
+
+    void rollover(time_t now);
+    void count(time_t now, time_t focus_seconds, bool completed);
+    void checkpoint();
+};
+
+// Room for formatDailyStatsJson with every flavor, 15-character labels escaped as \u00XX and
+// counters at their maximum.
+constexpr size_t kDailyStatsJsonBytes = 64 + MAX_WORK_FLAVORS * (72 + 15 * 6);
+
+// Writes `snapshot` as a JSON object with an entry for each of `flavors`. Returns the length
+// written, or 0 if `size` is too small.
+size_t formatDailyStatsJson(const DailyStatsSnapshot& snapshot, const FlavorTable& flavors, char* out, size_t size);
+
+#endif //DAILYSTATS_H
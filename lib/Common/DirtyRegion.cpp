@@ -0,0 +1,173 @@
+//
+// Frame layouts made of text runs, and the diff that turns two consecutive layouts into the
+// rectangles that actually need to be repainted and pushed to the panel.
+//
+
+#include "DirtyRegion.h"
+
+#include <algorithm>
+
+Rect Rect::united(const Rect& other) const
+{
+    if (empty())
+    {
+        return other;
+    }
+    if (other.empty())
+    {
+        return *this;
+    }
+    const int16_t left = std::min(x, other.x);
+    const int16_t top = std::min(y, other.y);
+    return {left, top, static_cast<int16_t>(std::max(right(), other.right()) - left),
+            static_cast<int16_t>(std::max(bottom(), other.bottom()) - top)};
+}
+
+Rect Rect::intersected(const Rect& other) const
+{
+    const int16_t left = std::max(x, other.x);
+    const int16_t top = std::max(y, other.y);
+    const int16_t w_ = static_cast<int16_t>(std::min(right(), other.right()) - left);
+    const int16_t h_ = static_cast<int16_t>(std::min(bottom(), other.bottom()) - top);
+    if (w_ <= 0 || h_ <= 0)
+    {
+        return {0, 0, 0, 0};
+    }
+    return {left, top, w_, h_};
+}
+
+bool Rect::intersects(const Rect& other) const
+{
+    return !intersected(other).empty();
+}
+
+bool Rect::touches(const Rect& other) const
+{
+    if (empty() || other.empty())
+    {
+        return false;
+    }
+    const bool x_overlap = x < other.right() && other.x < right();
+    const bool y_overlap = y < other.bottom() && other.y < bottom();
+    const bool x_adjacent = (x == other.right() || other.x == right()) && y == other.y && h == other.h;
+    const bool y_adjacent = (y == other.bottom() || other.y == bottom()) && x == other.x && w == other.w;
+    return (x_overlap && y_overlap) || x_adjacent || y_adjacent;
+}
+
+void DirtyRegion::add(const Rect& rect)
+{
+    Rect merged = bounds_.empty() ? rect : rect.intersected(bounds_);
+    if (merged.empty())
+    {
+        return;
+    }
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (size_t i = 0; i < count_; i++)
+        {
+            if (rects_[i].touches(merged))
+            {
+                merged = merged.united(rects_[i]);
+                rects_[i] = rects_[--count_];
+                changed = true;
+                break;
+            }
+        }
+    }
+    if (count_ == kMaxRects)
+    {
+        for (size_t i = 0; i < count_; i++)
+        {
+            merged = merged.united(rects_[i]);
+        }
+        count_ = 0;
+    }
+    rects_[count_++] = merged;
+}
+
+int32_t DirtyRegion::pixels() const
+{
+    int32_t total = 0;
+    for (size_t i = 0; i < count_; i++)
+    {
+        total += rects_[i].area();
+    }
+    return total;
+}
+
+DirtyRenderer::DirtyRenderer(const int16_t width, const int16_t height)
+    : screen_{0, 0, width, height}, previous_(), valid_(false), last_full_(false), dirty_(screen_)
+{
+}
+
+void DirtyRenderer::diffRun(const TextRun* before, const TextRun* after)
+{
+    if (!before || !after)
+    {
+        if (before)
+        {
+            dirty_.add(before->bounds());
+        }
+        if (after)
+        {
+            dirty_.add(after->bounds());
+        }
+        return;
+    }
+    if (before->font != after->font || before->color != after->color || before->y != after->y
+        || before->height != after->height || before->length != after->length
+        || before->cell_x[0] != after->cell_x[0] || before->cell_x[before->length] != after->cell_x[after->length])
+    {
+        dirty_.add(before->bounds());
+        dirty_.add(after->bounds());
+        return;
+    }
+    for (size_t i = 0; i < after->length; i++)
+    {
+        if (before->text[i] != after->text[i] || before->cell_x[i] != after->cell_x[i]
+            || before->cell_x[i + 1] != after->cell_x[i + 1])
+        {
+            dirty_.add(before->cell(i).united(after->cell(i)));
+        }
+    }
+}
+
+const DirtyRegion& DirtyRenderer::render(const FrameLayout& next, RenderTarget& target)
+{
+    dirty_.clear();
+    last_full_ = !valid_ || next.scene != previous_.scene || next.background != previous_.background;
+    if (last_full_)
+    {
+        target.fillRect(screen_, next.background);
+        for (size_t i = 0; i < next.runs; i++)
+        {
+            target.drawRun(next.run[i], screen_);
+        }
+        dirty_.add(screen_);
+    }
+    else
+    {
+        const size_t runs = std::max(previous_.runs, next.runs);
+        for (size_t i = 0; i < runs; i++)
+        {
+            diffRun(i < previous_.runs ? &previous_.run[i] : nullptr, i < next.runs ? &next.run[i] : nullptr);
+        }
+        for (size_t r = 0; r < dirty_.size(); r++)
+        {
+            const Rect& rect = dirty_[r];
+            target.fillRect(rect, next.background);
+            for (size_t i = 0; i < next.runs; i++)
+            {
+                if (next.run[i].bounds().intersects(rect))
+                {
+                    target.drawRun(next.run[i], rect);
+                }
+            }
+        }
+    }
+    previous_ = next;
+    valid_ = true;
+    return dirty_;
+}
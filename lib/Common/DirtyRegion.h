@@ -0,0 +1,190 @@
+//
+// Frame layouts made of text runs, and the diff that turns two consecutive layouts into the
+// rectangles that actually need to be repainted and pushed to the panel.
+//
+
+#ifndef DIRTYREGION_H
+#define DIRTYREGION_H
+
+#include <cstddef>
+#include <cstdint>
+
+struct Rect
+{
+    int16_t x;
+    int16_t y;
+    int16_t w;
+    int16_t h;
+
+    bool empty() const
+    {
+        return w <= 0 || h <= 0;
+    }
+
+    int32_t area() const
+    {
+        return empty() ? 0 : static_cast<int32_t>(w) * h;
+    }
+
+    int16_t right() const
+    {
+        return static_cast<int16_t>(x + w);
+    }
+
+    int16_t bottom() const
+    {
+        return static_cast<int16_t>(y + h);
+    }
+
+    bool operator==(const Rect& other) const
+    {
+        return x == other.x && y == other.y && w == other.w && h == other.h;
+    }
+
+    Rect united(const Rect& other) const;
+    Rect intersected(const Rect& other) const;
+    bool intersects(const Rect& other) const;
+
+    // Overlapping or sharing an edge, i.e. their union wastes no pixels along that edge.
+    bool touches(const Rect& other) const;
+};
+
+constexpr size_t TEXT_RUN_CAPACITY = 48;
+
+// A single line of text, laid out as one cell per character.
+struct TextRun
+{
+    uint8_t font;
+    uint16_t color;
+    int16_t y;
+    int16_t height;
+    uint8_t length;
+    char text[TEXT_RUN_CAPACITY + 1];
+    // cell_x[i] is the left edge of character i, cell_x[length] the right edge of the run.
+    int16_t cell_x[TEXT_RUN_CAPACITY + 1];
+
+    Rect bounds() const
+    {
+        return {cell_x[0], y, static_cast<int16_t>(cell_x[length] - cell_x[0]), height};
+    }
+
+    Rect cell(const size_t i) const
+    {
+        return {cell_x[i], y, static_cast<int16_t>(cell_x[i + 1] - cell_x[i]), height};
+    }
+};
+
+// Everything drawn in one frame. Layouts with the same scene list their runs in the same order,
+// so runs are compared slot by slot.
+struct FrameLayout
+{
+    static constexpr size_t kMaxRuns = 8;
+
+    uint32_t scene;
+    uint16_t background;
+    size_t runs;
+    TextRun run[kMaxRuns];
+
+    void clear(const uint32_t new_scene, const uint16_t new_background)
+    {
+        scene = new_scene;
+        background = new_background;
+        runs = 0;
+    }
+
+    TextRun* addRun()
+    {
+        return runs < kMaxRuns ? &run[runs++] : nullptr;
+    }
+};
+
+// A small set of disjoint-ish rectangles. Rectangles that touch are merged as they are added; if
+// the set overflows it collapses into its bounding box.
+class DirtyRegion
+{
+public:
+    static constexpr size_t kMaxRects = 12;
+
+    explicit DirtyRegion(const Rect& bounds = {0, 0, 0, 0}) : bounds_(bounds), count_(0)
+    {
+    }
+
+    void setBounds(const Rect& bounds)
+    {
+        bounds_ = bounds;
+    }
+
+    void clear()
+    {
+        count_ = 0;
+    }
+
+    void add(const Rect& rect);
+
+    bool empty() const
+    {
+        return count_ == 0;
+    }
+
+    size_t size() const
+    {
+        return count_;
+    }
+
+    const Rect& operator[](const size_t i) const
+    {
+        return rects_[i];
+    }
+
+    int32_t pixels() const;
+
+private:
+    Rect bounds_;
+    size_t count_;
+    Rect rects_[kMaxRects];
+};
+
+// Backend that owns the off-screen canvas: an M5Canvas on the device, a HostFramebuffer natively.
+class RenderTarget
+{
+public:
+    virtual ~RenderTarget() = default;
+
+    virtual void fillRect(const Rect& rect, uint16_t color) = 0;
+
+    // Draws `run` with its top-left at (cell_x[0], y), touching only pixels inside `clip`.
+    virtual void drawRun(const TextRun& run, const Rect& clip) = 0;
+};
+
+// Keeps the previous frame's layout and repaints only what changed. A scene or background change
+// repaints the whole canvas.
+class DirtyRenderer
+{
+public:
+    DirtyRenderer(int16_t width, int16_t height);
+
+    // Brings the target's canvas up to date with `next` and returns the rectangles to push.
+    const DirtyRegion& render(const FrameLayout& next, RenderTarget& target);
+
+    // Forces the next frame to repaint and push the whole screen.
+    void invalidate()
+    {
+        valid_ = false;
+    }
+
+    bool lastFrameWasFull() const
+    {
+        return last_full_;
+    }
+
+private:
+    Rect screen_;
+    FrameLayout previous_;
+    bool valid_;
+    bool last_full_;
+    DirtyRegion dirty_;
+
+    void diffRun(const TextRun* before, const TextRun* after);
+};
+
+#endif //DIRTYREGION_H
@@ -0,0 +1,107 @@
+//
+// Every flavor's label, color and durations, laid out once at boot for lookups without copies.
+//
+
+#include "FlavorTable.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+// The escaping JSON strings need: quotes, backslashes and control characters.
+size_t escapeJson(const char* text, char* out)
+{
+    size_t length = 0;
+    for (const char* c = text; *c; c++)
+    {
+        if (*c == '"' || *c == '\\')
+        {
+            out[length++] = '\\';
+            out[length++] = *c;
+        }
+        else if (static_cast<unsigned char>(*c) < 0x20)
+        {
+            length += static_cast<size_t>(snprintf(out + length, 7, "\\u%04x", static_cast<unsigned>(*c)));
+        }
+        else
+        {
+            out[length++] = *c;
+        }
+    }
+    out[length] = '\0';
+    return length;
+}
+}
+
+FlavorTable::FlavorTable() : pool_(), pool_used_(0), entries_(), count_(0)
+{
+    build(Settings());
+}
+
+void FlavorTable::build(const Settings& settings)
+{
+    pool_used_ = 0;
+    count_ = 0;
+    const uint16_t count = settings.flavor_count < 1 ? 1 : settings.flavor_count;
+    for (uint8_t flavor = 0; flavor < count && flavor < MAX_WORK_FLAVORS; flavor++)
+    {
+        const FlavorSettings& source = settings.flavors[flavor];
+        char number[4];
+        const char* text = source.label;
+        if (text[0] == '\0')
+        {
+            snprintf(number, sizeof(number), "%u", static_cast<unsigned>(flavor));
+            text = number;
+        }
+        const size_t length = strnlen(text, sizeof(source.label) - 1);
+        char label[sizeof(source.label)];
+        memcpy(label, text, length);
+        label[length] = '\0';
+        char escaped[sizeof(source.label) * 6];
+        const size_t escaped_length = escapeJson(label, escaped);
+
+        Entry& entry = entries_[flavor];
+        entry.label = intern(label, length);
+        entry.json_label = intern(escaped, escaped_length);
+        entry.width = 0;
+        entry.color = source.color;
+        entry.work_seconds = static_cast<time_t>(source.work_minutes > 0 ? source.work_minutes : settings.work_minutes)
+            * 60;
+        entry.break_seconds =
+            static_cast<time_t>(source.break_minutes > 0 ? source.break_minutes : settings.break_minutes) * 60;
+        count_++;
+    }
+}
+
+void FlavorTable::measure(const FontMetrics& metrics, const uint8_t font)
+{
+    for (uint8_t flavor = 0; flavor < count_; flavor++)
+    {
+        int16_t width = 0;
+        for (const char* c = label(flavor); *c; c++)
+        {
+            width = static_cast<int16_t>(width + metrics.charWidth(font, *c));
+        }
+        entries_[flavor].width = width;
+    }
+}
+
+uint16_t FlavorTable::intern(const char* text, const size_t length)
+{
+    for (size_t offset = 0; offset < pool_used_;)
+    {
+        const size_t existing = strlen(pool_ + offset);
+        if (existing == length && memcmp(pool_ + offset, text, length) == 0)
+        {
+            return static_cast<uint16_t>(offset);
+        }
+        offset += existing + 1;
+    }
+    // kPoolBytes holds the worst case, so this always fits.
+    const size_t offset = pool_used_;
+    memcpy(pool_ + offset, text, length);
+    pool_[offset + length] = '\0';
+    pool_used_ += length + 1;
+    return static_cast<uint16_t>(offset);
+}
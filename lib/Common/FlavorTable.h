@@ -0,0 +1,101 @@
+//
+// Every flavor's label, color and durations, laid out once at boot for lookups without copies.
+//
+
+#ifndef FLAVORTABLE_H
+#define FLAVORTABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+
+#include "ClockLayout.h"
+#include "ConfigSchema.h"
+#include "Pomodoro.h"
+
+// Labels are interned in one pool: each distinct string once, as text and escaped for the inside
+// of a JSON string (the same bytes when nothing needs escaping). An empty label reads as the
+// flavor's number. build() and measure() run before the clock starts; after that every lookup is
+// an index into the table, safe from any task. Flavors past size() read as flavor 0.
+class FlavorTable
+{
+public:
+    // Every label distinct and 15 characters long, each escaped as \u00XX.
+    static constexpr size_t kPoolBytes = MAX_WORK_FLAVORS * (16 + 15 * 6 + 1);
+
+    // The default flavors, with the default durations.
+    FlavorTable();
+
+    // The first settings.flavor_count flavors; zero minutes take the [durations] ones.
+    void build(const Settings& settings);
+
+    // Pixel width of each label in `font`, for labelWidth().
+    void measure(const FontMetrics& metrics, uint8_t font);
+
+    uint8_t size() const
+    {
+        return count_;
+    }
+
+    const char* label(const uint8_t flavor) const
+    {
+        return pool_ + entry(flavor).label;
+    }
+
+    // Without the quotes.
+    const char* jsonLabel(const uint8_t flavor) const
+    {
+        return pool_ + entry(flavor).json_label;
+    }
+
+    int16_t labelWidth(const uint8_t flavor) const
+    {
+        return entry(flavor).width;
+    }
+
+    uint16_t color(const uint8_t flavor) const
+    {
+        return entry(flavor).color;
+    }
+
+    time_t workSeconds(const uint8_t flavor) const
+    {
+        return entry(flavor).work_seconds;
+    }
+
+    time_t breakSeconds(const uint8_t flavor) const
+    {
+        return entry(flavor).break_seconds;
+    }
+
+    // Pool bytes in use.
+    size_t poolUsed() const
+    {
+        return pool_used_;
+    }
+
+private:
+    struct Entry
+    {
+        uint16_t label;
+        uint16_t json_label;
+        int16_t width;
+        uint16_t color;
+        time_t work_seconds;
+        time_t break_seconds;
+    };
+
+    char pool_[kPoolBytes];
+    size_t pool_used_;
+    Entry entries_[MAX_WORK_FLAVORS];
+    uint8_t count_;
+
+    const Entry& entry(const uint8_t flavor) const
+    {
+        return entries_[flavor < count_ ? flavor : 0];
+    }
+
+    uint16_t intern(const char* text, size_t length);
+};
+
+#endif //FLAVORTABLE_H
@@ -0,0 +1,44 @@
+//
+// Front buffer for asynchronous panel pushes: dirty rectangles packed out of the drawing canvas.
+//
+
+#include "FrameStaging.h"
+
+#include <cstring>
+
+bool FrameStaging::stage(const uint16_t* frame, const int16_t frame_width, const int16_t frame_height,
+                         const DirtyRegion& region)
+{
+    rects_ = 0;
+    pixels_ = 0;
+    const Rect bounds = {0, 0, frame_width, frame_height};
+    size_t needed = 0;
+    for (size_t i = 0; i < region.size(); i++)
+    {
+        needed += static_cast<size_t>(region[i].intersected(bounds).area());
+    }
+    if (!storage_ || needed > capacity_)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < region.size(); i++)
+    {
+        const Rect rect = region[i].intersected(bounds);
+        if (rect.empty())
+        {
+            continue;
+        }
+        rect_[rects_] = rect;
+        offset_[rects_] = pixels_;
+        uint16_t* out = storage_ + pixels_;
+        for (int16_t y = rect.y; y < rect.bottom(); y++)
+        {
+            memcpy(out, frame + static_cast<size_t>(y) * frame_width + rect.x, rect.w * sizeof(uint16_t));
+            out += rect.w;
+        }
+        pixels_ += static_cast<size_t>(rect.area());
+        rects_++;
+    }
+    return true;
+}
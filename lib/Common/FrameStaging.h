@@ -0,0 +1,65 @@
+//
+// Front buffer for asynchronous panel pushes: dirty rectangles packed out of the drawing canvas.
+//
+
+#ifndef FRAMESTAGING_H
+#define FRAMESTAGING_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "DirtyRegion.h"
+
+// Copies the dirty rectangles of an RGB565 frame into one contiguous buffer, each rectangle
+// row-major, so every rectangle can go out as a single DMA transfer while the next frame is drawn
+// into the canvas. Pixels are copied as-is, so the byte order of the canvas is preserved.
+class FrameStaging
+{
+public:
+    FrameStaging() : storage_(nullptr), capacity_(0), rects_(0), pixels_(0)
+    {
+    }
+
+    // `storage` must hold `capacity` pixels and outlive the staging buffer.
+    void attach(uint16_t* storage, size_t capacity)
+    {
+        storage_ = storage;
+        capacity_ = capacity;
+        rects_ = 0;
+        pixels_ = 0;
+    }
+
+    // Replaces the contents with `region` copied out of `frame`. Returns false, leaving the buffer
+    // empty, if the region does not fit; the caller then pushes straight from the canvas.
+    bool stage(const uint16_t* frame, int16_t frame_width, int16_t frame_height, const DirtyRegion& region);
+
+    size_t size() const
+    {
+        return rects_;
+    }
+
+    const Rect& rect(const size_t i) const
+    {
+        return rect_[i];
+    }
+
+    const uint16_t* pixels(const size_t i) const
+    {
+        return storage_ + offset_[i];
+    }
+
+    size_t pixelCount() const
+    {
+        return pixels_;
+    }
+
+private:
+    uint16_t* storage_;
+    size_t capacity_;
+    size_t rects_;
+    size_t pixels_;
+    Rect rect_[DirtyRegion::kMaxRects];
+    size_t offset_[DirtyRegion::kMaxRects];
+};
+
+#endif //FRAMESTAGING_H
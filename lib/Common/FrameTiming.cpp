@@ -0,0 +1,28 @@
+//
+// The monotonic clock the latency histograms use, and a one-line summary of one.
+//
+
+#include "FrameTiming.h"
+
+#include <chrono>
+#include <cstdio>
+
+uint64_t monotonicMicros()
+{
+    // steady_clock is backed by esp_timer on the ESP32, so this is the same clock on both targets.
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+size_t formatLatencySummary(const MetricSample& sample, char* out, const size_t size)
+{
+    const int length = snprintf(out, size, "%s: n=%lu p50<=%luus p90<=%luus p99<=%luus max=%luus", sample.name,
+                                static_cast<unsigned long>(sample.value), static_cast<unsigned long>(sample.p50),
+                                static_cast<unsigned long>(sample.p90), static_cast<unsigned long>(sample.p99),
+                                static_cast<unsigned long>(sample.hmax));
+    if (length < 0 || static_cast<size_t>(length) >= size)
+    {
+        return 0;
+    }
+    return static_cast<size_t>(length);
+}
@@ -0,0 +1,21 @@
+//
+// The monotonic clock the latency histograms use, and a one-line summary of one.
+//
+
+#ifndef FRAMETIMING_H
+#define FRAMETIMING_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Metrics.h"
+
+// Microseconds from a monotonic clock; only differences are meaningful.
+uint64_t monotonicMicros();
+
+// "<name>: n=.. p50<=..us p90<=..us p99<=..us max=..us" for a histogram sample; percentiles are
+// the upper bound of their log2 bucket, max is exact. Returns the length written, or 0 if `size`
+// is too small.
+size_t formatLatencySummary(const MetricSample& sample, char* out, size_t size);
+
+#endif //FRAMETIMING_H
@@ -0,0 +1,138 @@
+//
+// Fixed-size binary pomodoro history with a per-day index.
+//
+
+#include "History.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include "ByteCodec.h"
+#include "TimeFormat.h"
+
+void encodeHistoryRecord(const HistoryRecord& record, uint8_t* out)
+{
+    putUint32(out, record.start);
+    putUint32(out + 4, record.end);
+    out[8] = record.flavor;
+    out[9] = static_cast<uint8_t>(record.outcome);
+    putUint16(out + 10, record.day);
+}
+
+HistoryRecord decodeHistoryRecord(const uint8_t* in)
+{
+    HistoryRecord record;
+    record.start = getUint32(in);
+    record.end = getUint32(in + 4);
+    record.flavor = in[8];
+    record.outcome = static_cast<HistoryOutcome>(in[9]);
+    record.day = getUint16(in + 10);
+    return record;
+}
+
+void encodeHistoryIndexEntry(const HistoryIndexEntry& entry, uint8_t* out)
+{
+    putUint16(out, entry.day);
+    putUint16(out + 2, 0);
+    putUint32(out + 4, entry.first_record);
+}
+
+HistoryIndexEntry decodeHistoryIndexEntry(const uint8_t* in)
+{
+    HistoryIndexEntry entry;
+    entry.day = getUint16(in);
+    entry.first_record = getUint32(in + 4);
+    return entry;
+}
+
+int32_t daysFromCivil(int year, const unsigned month, const unsigned day)
+{
+    // Howard Hinnant's days_from_civil.
+    year -= month <= 2;
+    const int era = (year >= 0 ? year : year - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(year - era * 400);
+    const unsigned doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int32_t>(doe) - 719468;
+}
+
+uint16_t localDay(const time_t t)
+{
+    struct tm timeinfo;
+    localtime_r(&t, &timeinfo);
+    return static_cast<uint16_t>(daysFromCivil(timeinfo.tm_year + 1900, timeinfo.tm_mon + 1, timeinfo.tm_mday));
+}
+
+size_t formatHistoryCsvLine(const HistoryRecord& record, char* out, const size_t size)
+{
+    const time_t start = record.start;
+    const time_t end = record.end;
+    struct tm start_tm;
+    struct tm end_tm;
+    localtime_r(&start, &start_tm);
+    localtime_r(&end, &end_tm);
+    const int length = snprintf(out, size, "%04d-%02d-%02d %02d:%02d:%02d,%04d-%02d-%02d %02d:%02d:%02d,%u\n",
+                                start_tm.tm_year + 1900, start_tm.tm_mon + 1, start_tm.tm_mday,
+                                start_tm.tm_hour, start_tm.tm_min, start_tm.tm_sec,
+                                end_tm.tm_year + 1900, end_tm.tm_mon + 1, end_tm.tm_mday,
+                                end_tm.tm_hour, end_tm.tm_min, end_tm.tm_sec,
+                                static_cast<unsigned>(record.flavor));
+    if (length < 0 || static_cast<size_t>(length) >= size)
+    {
+        return 0;
+    }
+    return static_cast<size_t>(length);
+}
+
+size_t formatHistoryCsvLine(const HistoryRecord& record, LocalTimeCache& calendar, char* out, const size_t size)
+{
+    char flavor[4];
+    const int flavor_length = snprintf(flavor, sizeof(flavor), "%u", static_cast<unsigned>(record.flavor));
+    const size_t length = 19 + 1 + 19 + 1 + static_cast<size_t>(flavor_length) + 1;
+    if (length >= size)
+    {
+        return 0;
+    }
+    calendar.formatIso(record.start, out);
+    out[19] = ',';
+    calendar.formatIso(record.end, out + 20);
+    out[39] = ',';
+    memcpy(out + 40, flavor, static_cast<size_t>(flavor_length));
+    out[length - 1] = '\n';
+    out[length] = '\0';
+    return length;
+}
+
+void HistoryIndex::reset(const uint32_t records, const HistoryIndexEntry* last_entry)
+{
+    records_ = records;
+    has_day_ = last_entry != nullptr && last_entry->first_record <= records;
+    last_day_ = has_day_ ? last_entry->day : 0;
+    last_day_first_ = has_day_ ? last_entry->first_record : 0;
+}
+
+bool HistoryIndex::append(const HistoryRecord& record, HistoryIndexEntry* new_entry)
+{
+    const bool new_day = !has_day_ || record.day != last_day_;
+    if (new_day)
+    {
+        has_day_ = true;
+        last_day_ = record.day;
+        last_day_first_ = records_;
+        if (new_entry)
+        {
+            *new_entry = {last_day_, last_day_first_};
+        }
+    }
+    records_++;
+    return new_day;
+}
+
+uint32_t HistoryIndex::recordsOnDay(const uint16_t day) const
+{
+    if (!has_day_ || day != last_day_)
+    {
+        return 0;
+    }
+    return records_ - last_day_first_;
+}
@@ -0,0 +1,90 @@
+//
+// Fixed-size binary pomodoro history with a per-day index.
+//
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+
+class LocalTimeCache;
+
+enum class HistoryOutcome : uint8_t
+{
+    COMPLETED = 0,
+    CANCELLED = 1,
+};
+
+// One finished pomodoro. `day` is the local calendar day of `start`, in days since 1970-01-01.
+struct HistoryRecord
+{
+    uint32_t start;
+    uint32_t end;
+    uint8_t flavor;
+    HistoryOutcome outcome;
+    uint16_t day;
+};
+
+// First record of a local day, appended to the index file when that day sees its first record.
+struct HistoryIndexEntry
+{
+    uint16_t day;
+    uint32_t first_record;
+};
+
+constexpr size_t HISTORY_RECORD_SIZE = 12;
+constexpr size_t HISTORY_INDEX_ENTRY_SIZE = 8;
+
+// Little-endian on-disk encoding, independent of the host struct layout.
+void encodeHistoryRecord(const HistoryRecord& record, uint8_t* out);
+HistoryRecord decodeHistoryRecord(const uint8_t* in);
+void encodeHistoryIndexEntry(const HistoryIndexEntry& entry, uint8_t* out);
+HistoryIndexEntry decodeHistoryIndexEntry(const uint8_t* in);
+
+// Days since 1970-01-01 of a proleptic Gregorian civil date.
+int32_t daysFromCivil(int year, unsigned month, unsigned day);
+
+// Local calendar day of `t`, in days since 1970-01-01.
+uint16_t localDay(time_t t);
+
+// Formats `record` as a pomodoro.csv line ("YYYY-MM-DD HH:MM:SS,YYYY-MM-DD HH:MM:SS,flavor\n").
+// Returns the line length, or 0 if `size` is too small.
+size_t formatHistoryCsvLine(const HistoryRecord& record, char* out, size_t size);
+
+// Same, reusing `calendar` across consecutive records so a day's worth of lines costs one recomputation.
+size_t formatHistoryCsvLine(const HistoryRecord& record, LocalTimeCache& calendar, char* out, size_t size);
+
+// In-memory view of the history file: total record count and where the most recent day starts.
+// Lookups are O(1); appending a batch only touches the index when a new day begins.
+class HistoryIndex
+{
+public:
+    HistoryIndex() : records_(0), last_day_(0), last_day_first_(0), has_day_(false)
+    {
+    }
+
+    // Restores state from the number of records on disk and the last index entry (if any).
+    void reset(uint32_t records, const HistoryIndexEntry* last_entry);
+
+    // Accounts for `record`, which is appended at position records(). Returns true and fills
+    // `new_entry` when the record opens a new day, i.e. the index file needs a new entry.
+    bool append(const HistoryRecord& record, HistoryIndexEntry* new_entry);
+
+    uint32_t records() const
+    {
+        return records_;
+    }
+
+    // Number of records logged on local day `day`.
+    uint32_t recordsOnDay(uint16_t day) const;
+
+private:
+    uint32_t records_;
+    uint16_t last_day_;
+    uint32_t last_day_first_;
+    bool has_day_;
+};
+
+#endif //HISTORY_H
@@ -0,0 +1,105 @@
+//
+// RGB565 canvas and panel in host memory, for measuring what ClockFace pushes without a device.
+//
+
+#include "HostFramebuffer.h"
+
+int16_t FixedFontMetrics::charWidth(const uint8_t font, const char c) const
+{
+    switch (font)
+    {
+    case 7:
+        return c == ':' || c == ' ' ? 12 : 32;
+    case 4:
+        return c == ' ' ? 7 : 14;
+    case 2:
+        return c == ' ' ? 4 : 8;
+    default:
+        return 6;
+    }
+}
+
+int16_t FixedFontMetrics::height(const uint8_t font) const
+{
+    switch (font)
+    {
+    case 7:
+        return 48;
+    case 4:
+        return 26;
+    case 2:
+        return 16;
+    default:
+        return 8;
+    }
+}
+
+HostFramebuffer::HostFramebuffer(const int16_t width, const int16_t height)
+    : width_(width),
+      height_(height),
+      canvas_(static_cast<size_t>(width) * height, 0),
+      panel_(static_cast<size_t>(width) * height, 0),
+      bytes_pushed_(0),
+      pushes_(0)
+{
+}
+
+void HostFramebuffer::fillRect(const Rect& rect, const uint16_t color)
+{
+    const Rect clipped = rect.intersected({0, 0, width_, height_});
+    for (int16_t y = clipped.y; y < clipped.bottom(); y++)
+    {
+        for (int16_t x = clipped.x; x < clipped.right(); x++)
+        {
+            canvas_[static_cast<size_t>(y) * width_ + x] = color;
+        }
+    }
+}
+
+void HostFramebuffer::drawRun(const TextRun& run, const Rect& clip)
+{
+    const Rect visible = clip.intersected({0, 0, width_, height_});
+    for (size_t i = 0; i < run.length; i++)
+    {
+        const Rect cell = run.cell(i);
+        const Rect area = cell.intersected(visible);
+        const unsigned glyph = static_cast<unsigned char>(run.text[i]);
+        for (int16_t y = area.y; y < area.bottom(); y++)
+        {
+            for (int16_t x = area.x; x < area.right(); x++)
+            {
+                if (((x - cell.x) * 7 + (y - cell.y) * 13 + glyph) % 5 == 0)
+                {
+                    canvas_[static_cast<size_t>(y) * width_ + x] = run.color;
+                }
+            }
+        }
+    }
+}
+
+void HostFramebuffer::push(const Rect& rect)
+{
+    const Rect clipped = rect.intersected({0, 0, width_, height_});
+    if (clipped.empty())
+    {
+        return;
+    }
+    for (int16_t y = clipped.y; y < clipped.bottom(); y++)
+    {
+        const size_t row = static_cast<size_t>(y) * width_;
+        for (int16_t x = clipped.x; x < clipped.right(); x++)
+        {
+            panel_[row + x] = canvas_[row + x];
+        }
+    }
+    bytes_pushed_ += static_cast<uint64_t>(clipped.area()) * sizeof(uint16_t);
+    pushes_++;
+}
+
+void HostFramebuffer::push(const DirtyRegion& region)
+{
+    for (size_t i = 0; i < region.size(); i++)
+    {
+        push(region[i]);
+    }
+}
@@ -0,0 +1,81 @@
+//
+// RGB565 canvas and panel in host memory, for measuring what ClockFace pushes without a device.
+//
+
+#ifndef HOSTFRAMEBUFFER_H
+#define HOSTFRAMEBUFFER_H
+
+#include <cstdint>
+#include <vector>
+
+#include "ClockLayout.h"
+#include "DirtyRegion.h"
+
+// Cell sizes of the M5GFX fonts ClockFace uses (2, 4 and the 7-segment font 7).
+class FixedFontMetrics final : public FontMetrics
+{
+public:
+    int16_t charWidth(uint8_t font, char c) const override;
+    int16_t height(uint8_t font) const override;
+};
+
+// Draws into an off-screen canvas like M5Canvas does, and "pushes" rectangles into a separate
+// panel buffer while counting the bytes that would cross the SPI bus. Glyphs are rendered as a
+// deterministic per-character pattern filling the character cell.
+class HostFramebuffer final : public RenderTarget
+{
+public:
+    HostFramebuffer(int16_t width, int16_t height);
+
+    void fillRect(const Rect& rect, uint16_t color) override;
+    void drawRun(const TextRun& run, const Rect& clip) override;
+
+    void push(const Rect& rect);
+    void push(const DirtyRegion& region);
+
+    int16_t width() const
+    {
+        return width_;
+    }
+
+    int16_t height() const
+    {
+        return height_;
+    }
+
+    const std::vector<uint16_t>& canvas() const
+    {
+        return canvas_;
+    }
+
+    const std::vector<uint16_t>& panel() const
+    {
+        return panel_;
+    }
+
+    uint64_t bytesPushed() const
+    {
+        return bytes_pushed_;
+    }
+
+    uint32_t pushes() const
+    {
+        return pushes_;
+    }
+
+    void resetCounters()
+    {
+        bytes_pushed_ = 0;
+        pushes_ = 0;
+    }
+
+private:
+    int16_t width_;
+    int16_t height_;
+    std::vector<uint16_t> canvas_;
+    std::vector<uint16_t> panel_;
+    uint64_t bytes_pushed_;
+    uint32_t pushes_;
+};
+
+#endif //HOSTFRAMEBUFFER_H
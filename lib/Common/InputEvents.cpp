@@ -0,0 +1,38 @@
+//
+// Debounced, timestamped button presses from raw samples taken at a fixed rate.
+//
+
+#include "InputEvents.h"
+
+ButtonDebouncer::ButtonDebouncer()
+{
+    for (State& state : states_)
+    {
+        state = {false, false, 0, 0};
+    }
+}
+
+size_t ButtonDebouncer::sample(const uint8_t raw, const uint64_t now_us, const time_t now, InputEvent* out)
+{
+    size_t events = 0;
+    for (size_t i = 0; i < BUTTONS; i++)
+    {
+        State& state = states_[i];
+        const bool pressed = (raw >> i) & 1;
+        if (pressed != state.candidate)
+        {
+            state.candidate = pressed;
+            state.since_us = now_us;
+            state.since = now;
+        }
+        if (state.candidate != state.stable && now_us - state.since_us >= kDebounceUs)
+        {
+            state.stable = state.candidate;
+            if (state.stable)
+            {
+                out[events++] = {static_cast<Button>(i), state.since_us, state.since};
+            }
+        }
+    }
+    return events;
+}
@@ -0,0 +1,55 @@
+//
+// Debounced, timestamped button presses from raw samples taken at a fixed rate.
+//
+
+#ifndef INPUTEVENTS_H
+#define INPUTEVENTS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+
+enum class Button : uint8_t
+{
+    A = 0,
+    B = 1,
+    C = 2,
+};
+
+constexpr size_t BUTTONS = 3;
+
+// A press, stamped when the contact was first seen rather than when it was debounced or handled.
+struct InputEvent
+{
+    Button button;
+    // monotonicMicros() and wall-clock time of the first sample that saw the button down.
+    uint64_t pressed_us;
+    time_t pressed_at;
+};
+
+// Turns raw button samples into press events. A change counts once it has held for
+// kDebounceUs; shorter glitches are dropped. Releases produce no event.
+class ButtonDebouncer
+{
+public:
+    static constexpr uint32_t kDebounceUs = 15000;
+
+    ButtonDebouncer();
+
+    // `raw` has bit i set while button i reads as pressed. Writes up to BUTTONS events to `out`
+    // and returns how many.
+    size_t sample(uint8_t raw, uint64_t now_us, time_t now, InputEvent* out);
+
+private:
+    struct State
+    {
+        bool stable;
+        bool candidate;
+        uint64_t since_us;
+        time_t since;
+    };
+
+    State states_[BUTTONS];
+};
+
+#endif //INPUTEVENTS_H
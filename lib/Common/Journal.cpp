@@ -0,0 +1,547 @@
+//
+// Compact binary journal of a clock's inputs and ticks, replayed deterministically on the host.
+//
+
+#include "Journal.h"
+
+#include <cstring>
+
+#include "ByteCodec.h"
+
+namespace
+{
+constexpr uint8_t kMagic[4] = {'P', 'J', 'N', 'L'};
+// Format 1 had no flavor count: its clocks always had DEFAULT_WORK_FLAVORS.
+constexpr uint8_t kFormat = 2;
+constexpr size_t kFormat1HeaderBytes = 5;
+constexpr uint8_t kInlineLimit = 31;
+// Longest entry: kind byte, varint delta, flavor, two varints.
+constexpr size_t kMaxEntryBytes = 1 + kMaxVarintBytes + 1 + 2 * kMaxVarintBytes;
+
+// Entry kinds as written; RUN is a count of ticks, each a second after the one before.
+enum EntryKind : uint8_t
+{
+    TICK = 0,
+    RUN = 1,
+    START = 2,
+    EXTEND = 3,
+    CYCLE = 4,
+    CANCEL = 5,
+    ADOPT = 6,
+};
+
+// Kind byte and time delta; the arguments go after.
+size_t putHead(const uint8_t kind, const int64_t delta, uint8_t* out)
+{
+    if (delta >= 0 && delta < kInlineLimit)
+    {
+        out[0] = static_cast<uint8_t>(kind << 5 | delta);
+        return 1;
+    }
+    out[0] = static_cast<uint8_t>(kind << 5 | kInlineLimit);
+    return 1 + putVarint(zigzag(delta), out + 1);
+}
+
+size_t putRun(const uint32_t ticks, uint8_t* out)
+{
+    if (ticks < kInlineLimit)
+    {
+        out[0] = static_cast<uint8_t>(RUN << 5 | ticks);
+        return 1;
+    }
+    out[0] = static_cast<uint8_t>(RUN << 5 | kInlineLimit);
+    return 1 + putVarint(ticks, out + 1);
+}
+
+size_t encodeInput(const ClockInput& input, const int64_t delta, uint8_t* out)
+{
+    size_t size;
+    switch (input.kind)
+    {
+    case ClockInputKind::START_WORK:
+        size = putHead(START, delta, out);
+        out[size++] = input.work_flavor;
+        size += putVarint(zigzag(input.duration), out + size);
+        size += putVarint(zigzag(input.break_duration), out + size);
+        return size;
+    case ClockInputKind::EXTEND_WORK:
+        size = putHead(EXTEND, delta, out);
+        return size + putVarint(zigzag(input.duration), out + size);
+    case ClockInputKind::CYCLE_FLAVOR:
+        return putHead(CYCLE, delta, out);
+    case ClockInputKind::CANCEL:
+        return putHead(CANCEL, delta, out);
+    case ClockInputKind::ADOPT:
+        size = putHead(ADOPT, delta, out);
+        out[size++] = static_cast<uint8_t>(input.state);
+        out[size++] = input.work_flavor;
+        size += putVarint(zigzag(input.state_ends_at - input.now), out + size);
+        return size + putVarint(zigzag(input.break_duration), out + size);
+    case ClockInputKind::TICK:
+    default:
+        return putHead(TICK, delta, out);
+    }
+}
+
+void encodeHeader(const JournalBlockHeader& header, uint8_t* out)
+{
+    putUint32(out, header.start);
+    putUint32(out + 4, static_cast<uint32_t>(header.state.last_update_at));
+    putUint32(out + 8, static_cast<uint32_t>(header.state.last_state_change_at));
+    putUint32(out + 12, static_cast<uint32_t>(header.state.state_ends_at));
+    out[16] = header.state.work_flavor;
+    out[17] = static_cast<uint8_t>(header.state.state);
+    putUint32(out + 18, static_cast<uint32_t>(header.state.break_duration));
+    putUint16(out + 22, header.length);
+    putUint32(out + 24, header.notifications);
+    putUint32(out + 28, header.digest);
+}
+
+bool sameState(const PomodoroClockState& a, const PomodoroClockState& b)
+{
+    return a.last_update_at == b.last_update_at && a.last_state_change_at == b.last_state_change_at
+        && a.state_ends_at == b.state_ends_at && a.work_flavor == b.work_flavor && a.state == b.state
+        && a.break_duration == b.break_duration;
+}
+
+class DigestObserver final : public PomodoroObserver
+{
+public:
+    EventDigest digest;
+
+    void notification(const ClockUpdate update) override
+    {
+        digest.add(update);
+    }
+
+    void notification(const IdleToWork update) override
+    {
+        digest.add(update);
+    }
+
+    void notification(const WorkToBreak update) override
+    {
+        digest.add(update);
+    }
+
+    void notification(const BreakToIdle update) override
+    {
+        digest.add(update);
+    }
+
+    void notification(const WorkToIdle update) override
+    {
+        digest.add(update);
+    }
+
+    void notification(const AdditionalWork update) override
+    {
+        digest.add(update);
+    }
+};
+}
+
+EventDigest::EventDigest() : hash_(kFnv1aBasis), count_(0)
+{
+}
+
+void EventDigest::add(const ClockUpdate& update)
+{
+    mix(0, update.now, update.state, update.work_flavor, update.remaining_time_in_state);
+}
+
+void EventDigest::add(const IdleToWork& update)
+{
+    mix(1, update.now, update.work_flavor);
+}
+
+void EventDigest::add(const WorkToBreak& update)
+{
+    mix(2, update.now, update.work_duration);
+}
+
+void EventDigest::add(const BreakToIdle& update)
+{
+    mix(3, update.now, update.break_duration);
+}
+
+void EventDigest::add(const WorkToIdle& update)
+{
+    mix(4, update.now, update.cancelled_work_duration);
+}
+
+void EventDigest::add(const AdditionalWork& update)
+{
+    mix(5, update.now, update.work_flavor, update.new_work_duration);
+}
+
+void EventDigest::reset()
+{
+    hash_ = kFnv1aBasis;
+    count_ = 0;
+}
+
+void EventDigest::mix(const uint8_t type, const int64_t a, const int64_t b, const int64_t c, const int64_t d)
+{
+    hash_ = fnv1a(hash_, &type, 1);
+    for (const int64_t field : {a, b, c, d})
+    {
+        uint8_t bytes[8];
+        putUint64(bytes, static_cast<uint64_t>(field));
+        hash_ = fnv1a(hash_, bytes, sizeof(bytes));
+    }
+    count_++;
+}
+
+Journal::Journal(const PomodoroClock& clock)
+    : clock_(clock),
+      blocks_(),
+      first_(0),
+      count_(0),
+      last_time_(0),
+      last_entry_(0),
+      run_(0),
+      last_was_tick_(false),
+      inputs_(0),
+      dropped_blocks_(0)
+{
+}
+
+void Journal::record(const ClockInput& input)
+{
+    inputs_++;
+    if (count_ > 0 && input.kind == ClockInputKind::TICK && last_was_tick_ && input.now - last_time_ == 1
+        && extendRun())
+    {
+        last_time_ = input.now;
+        return;
+    }
+    uint8_t entry[kMaxEntryBytes];
+    if (count_ == 0 || !append(entry, encodeInput(input, input.now - last_time_, entry)))
+    {
+        open(input.now);
+        append(entry, encodeInput(input, 0, entry));
+    }
+    last_time_ = input.now;
+    last_was_tick_ = input.kind == ClockInputKind::TICK;
+}
+
+bool Journal::extendRun()
+{
+    Block& block = current();
+    uint8_t run[1 + 10];
+    const size_t at = run_ > 0 ? last_entry_ : block.header.length;
+    const size_t size = putRun(run_ + 1, run);
+    if (at + size > kBlockBytes)
+    {
+        return false;
+    }
+    memcpy(block.entries + at, run, size);
+    block.header.length = static_cast<uint16_t>(at + size);
+    last_entry_ = at;
+    run_++;
+    return true;
+}
+
+bool Journal::append(const uint8_t* data, const size_t size)
+{
+    Block& block = current();
+    if (block.header.length + size > kBlockBytes)
+    {
+        return false;
+    }
+    memcpy(block.entries + block.header.length, data, size);
+    last_entry_ = block.header.length;
+    block.header.length = static_cast<uint16_t>(block.header.length + size);
+    run_ = 0;
+    return true;
+}
+
+void Journal::open(const time_t now)
+{
+    if (count_ > 0)
+    {
+        seal();
+    }
+    if (count_ == kBlocks)
+    {
+        first_ = (first_ + 1) % kBlocks;
+        count_--;
+        dropped_blocks_++;
+    }
+    count_++;
+    Block& block = current();
+    block.header = {static_cast<uint32_t>(now), clock_.SaveState(), 0, 0, 0};
+    digest_.reset();
+    last_time_ = now;
+    run_ = 0;
+}
+
+void Journal::seal()
+{
+    Block& block = current();
+    block.header.notifications = digest_.count();
+    block.header.digest = digest_.hash();
+}
+
+void Journal::notification(const ClockUpdate update)
+{
+    digest_.add(update);
+}
+
+void Journal::notification(const IdleToWork update)
+{
+    digest_.add(update);
+}
+
+void Journal::notification(const WorkToBreak update)
+{
+    digest_.add(update);
+}
+
+void Journal::notification(const BreakToIdle update)
+{
+    digest_.add(update);
+}
+
+void Journal::notification(const WorkToIdle update)
+{
+    digest_.add(update);
+}
+
+void Journal::notification(const AdditionalWork update)
+{
+    digest_.add(update);
+}
+
+size_t Journal::write(void (*sink)(const uint8_t* data, size_t size, void* context), void* context) const
+{
+    uint8_t head[kJournalFileHeaderBytes];
+    memcpy(head, kMagic, sizeof(kMagic));
+    head[4] = kFormat;
+    head[5] = clock_.FlavorCount();
+    sink(head, sizeof(head), context);
+    size_t written = sizeof(head);
+    for (size_t i = 0; i < count_; i++)
+    {
+        const Block& block = blocks_[(first_ + i) % kBlocks];
+        JournalBlockHeader header = block.header;
+        if (i == count_ - 1)
+        {
+            header.notifications = digest_.count();
+            header.digest = digest_.hash();
+        }
+        uint8_t encoded[kJournalBlockHeaderBytes];
+        encodeHeader(header, encoded);
+        sink(encoded, sizeof(encoded), context);
+        sink(block.entries, header.length, context);
+        written += sizeof(encoded) + header.length;
+    }
+    return written;
+}
+
+void Journal::clear()
+{
+    first_ = 0;
+    count_ = 0;
+    run_ = 0;
+    last_was_tick_ = false;
+    inputs_ = 0;
+    dropped_blocks_ = 0;
+    digest_.reset();
+}
+
+JournalReader::JournalReader(const uint8_t* data, const size_t size)
+    : data_(data),
+      size_(size),
+      offset_(kJournalFileHeaderBytes),
+      block_end_(0),
+      time_(0),
+      run_left_(0),
+      flavor_count_(DEFAULT_WORK_FLAVORS),
+      failed_(false)
+{
+    failed_ = size < kFormat1HeaderBytes || memcmp(data, kMagic, sizeof(kMagic)) != 0;
+    if (!failed_ && data[4] == 1)
+    {
+        offset_ = kFormat1HeaderBytes;
+    }
+    else if (!failed_)
+    {
+        failed_ = data[4] != kFormat || size < kJournalFileHeaderBytes || data[5] < 1 || data[5] > MAX_WORK_FLAVORS;
+        flavor_count_ = failed_ ? flavor_count_ : data[5];
+    }
+}
+
+bool JournalReader::nextBlock(JournalBlockHeader* header)
+{
+    if (failed_ || offset_ >= size_)
+    {
+        return false;
+    }
+    // Inputs left unread in the previous block are skipped.
+    if (block_end_ > offset_)
+    {
+        offset_ = block_end_;
+        if (offset_ >= size_)
+        {
+            return false;
+        }
+    }
+    if (size_ - offset_ < kJournalBlockHeaderBytes)
+    {
+        failed_ = true;
+        return false;
+    }
+    const uint8_t* in = data_ + offset_;
+    header->start = getUint32(in);
+    header->state.last_update_at = getUint32(in + 4);
+    header->state.last_state_change_at = getUint32(in + 8);
+    header->state.state_ends_at = getUint32(in + 12);
+    header->state.work_flavor = in[16];
+    header->state.state = static_cast<PomodoroState>(in[17]);
+    header->state.break_duration = getUint32(in + 18);
+    header->length = getUint16(in + 22);
+    header->notifications = getUint32(in + 24);
+    header->digest = getUint32(in + 28);
+    offset_ += kJournalBlockHeaderBytes;
+    if (header->length > size_ - offset_ || header->length > Journal::kBlockBytes
+        || (in[17] != IDLE && in[17] != WORK && in[17] != BREAK))
+    {
+        failed_ = true;
+        return false;
+    }
+    block_end_ = offset_ + header->length;
+    time_ = header->start;
+    run_left_ = 0;
+    return true;
+}
+
+bool JournalReader::nextInput(ClockInput* input)
+{
+    if (failed_)
+    {
+        return false;
+    }
+    *input = {ClockInputKind::TICK, 0, 0, 0, 0, IDLE, 0};
+    if (run_left_ > 0)
+    {
+        run_left_--;
+        input->now = ++time_;
+        return true;
+    }
+    if (offset_ >= block_end_)
+    {
+        return false;
+    }
+    bool ok = true;
+    auto byte = [&]() -> uint8_t {
+        if (offset_ >= block_end_)
+        {
+            ok = false;
+            return 0;
+        }
+        return data_[offset_++];
+    };
+    auto varint = [&]() -> uint64_t {
+        uint64_t value = 0;
+        const size_t size = getVarint(data_ + offset_, block_end_ - offset_, &value);
+        ok = ok && size > 0;
+        offset_ += size;
+        return value;
+    };
+    const uint8_t head = byte();
+    const uint8_t kind = head >> 5;
+    const uint8_t low = head & kInlineLimit;
+    if (kind == RUN)
+    {
+        const uint64_t ticks = low < kInlineLimit ? low : varint();
+        if (!ok || ticks == 0 || ticks > UINT32_MAX)
+        {
+            failed_ = true;
+            return false;
+        }
+        run_left_ = static_cast<uint32_t>(ticks - 1);
+        input->now = ++time_;
+        return true;
+    }
+    time_ += low < kInlineLimit ? low : unzigzag(varint());
+    input->now = time_;
+    switch (kind)
+    {
+    case TICK:
+        break;
+    case START:
+        input->kind = ClockInputKind::START_WORK;
+        input->work_flavor = byte();
+        input->duration = unzigzag(varint());
+        input->break_duration = unzigzag(varint());
+        break;
+    case EXTEND:
+        input->kind = ClockInputKind::EXTEND_WORK;
+        input->duration = unzigzag(varint());
+        break;
+    case CYCLE:
+        input->kind = ClockInputKind::CYCLE_FLAVOR;
+        break;
+    case CANCEL:
+        input->kind = ClockInputKind::CANCEL;
+        break;
+    case ADOPT:
+    {
+        input->kind = ClockInputKind::ADOPT;
+        const uint8_t state = byte();
+        ok = ok && (state == IDLE || state == WORK || state == BREAK);
+        input->state = static_cast<PomodoroState>(state);
+        input->work_flavor = byte();
+        input->state_ends_at = input->now + unzigzag(varint());
+        input->break_duration = unzigzag(varint());
+        break;
+    }
+    default:
+        ok = false;
+    }
+    if (!ok)
+    {
+        failed_ = true;
+        return false;
+    }
+    return true;
+}
+
+JournalReplay replayJournal(const uint8_t* data, const size_t size, PomodoroClock& clock)
+{
+    JournalReplay result = {0, 0, 0, 0, -1, false};
+    DigestObserver observer;
+    clock.add_observer(observer);
+    JournalReader reader(data, size);
+    clock.SetFlavorCount(reader.flavorCount());
+    JournalBlockHeader header;
+    while (reader.nextBlock(&header))
+    {
+        bool matched = true;
+        if (result.blocks == 0 || !sameState(header.state, clock.SaveState()))
+        {
+            matched = result.blocks == 0;
+            clock.RestoreState(header.state);
+        }
+        observer.digest.reset();
+        ClockInput input;
+        while (reader.nextInput(&input))
+        {
+            clock.Apply(input);
+            result.inputs++;
+        }
+        matched = matched && observer.digest.count() == header.notifications && observer.digest.hash() == header.digest;
+        if (!matched && result.first_mismatch < 0)
+        {
+            result.first_mismatch = static_cast<long>(result.blocks);
+        }
+        result.mismatched += !matched;
+        result.notifications += observer.digest.count();
+        result.blocks++;
+    }
+    result.malformed = reader.failed();
+    clock.remove_observer(observer);
+    return result;
+}
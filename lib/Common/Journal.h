@@ -0,0 +1,188 @@
+//
+// Compact binary journal of a clock's inputs and ticks, replayed deterministically on the host.
+//
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Pomodoro.h"
+
+// What a stream of notifications hashes to (FNV-1a over each one's type and fields), and how
+// many there were. Two runs notified alike if their digests match.
+class EventDigest
+{
+public:
+    EventDigest();
+
+    void add(const ClockUpdate& update);
+    void add(const IdleToWork& update);
+    void add(const WorkToBreak& update);
+    void add(const BreakToIdle& update);
+    void add(const WorkToIdle& update);
+    void add(const AdditionalWork& update);
+    void reset();
+
+    uint32_t hash() const
+    {
+        return hash_;
+    }
+
+    uint32_t count() const
+    {
+        return count_;
+    }
+
+private:
+    uint32_t hash_;
+    uint32_t count_;
+
+    void mix(uint8_t type, int64_t a, int64_t b = 0, int64_t c = 0, int64_t d = 0);
+};
+
+// A block starts with the whole clock state before its first input, so a replay can begin at any
+// block, and ends with the digest of the notifications its inputs caused.
+struct JournalBlockHeader
+{
+    // Time of the first input.
+    uint32_t start;
+    PomodoroClockState state;
+    // Bytes of encoded inputs that follow.
+    uint16_t length;
+    uint32_t notifications;
+    uint32_t digest;
+};
+
+// File: "PJNL", a format byte, the clock's flavor count, then blocks oldest first, each a 32-byte
+// header (little-endian) and its inputs. An input is one byte of kind (high 3 bits) and seconds
+// since the previous input (low 5 bits; 31 means a zigzag varint follows), then its arguments as
+// varints. Ticks a second apart collapse into one run entry, so an idle hour takes a few bytes.
+constexpr size_t kJournalFileHeaderBytes = 6;
+constexpr size_t kJournalBlockHeaderBytes = 32;
+
+// Records every input of the clock it is the recorder of, and digests the notifications it
+// observes, into a RAM ring of kBlocks blocks; the oldest block goes when the ring is full.
+// Recording is a few byte writes; the clock's task is the only one that may call it.
+class Journal final : public PomodoroObserver, public PomodoroRecorder
+{
+public:
+    static constexpr size_t kBlockBytes = 256;
+    static constexpr size_t kBlocks = 32;
+
+    explicit Journal(const PomodoroClock& clock);
+
+    void record(const ClockInput& input) override;
+
+    void notification(ClockUpdate update) override;
+    void notification(IdleToWork update) override;
+    void notification(WorkToBreak update) override;
+    void notification(BreakToIdle update) override;
+    void notification(WorkToIdle update) override;
+    void notification(AdditionalWork update) override;
+
+    // Writes the file through `sink`, the open block as it stands. Returns the bytes written.
+    size_t write(void (*sink)(const uint8_t* data, size_t size, void* context), void* context) const;
+
+    void clear();
+
+    // Inputs recorded since construction or clear(), including those in dropped blocks.
+    uint32_t inputs() const
+    {
+        return inputs_;
+    }
+
+    size_t blocks() const
+    {
+        return count_;
+    }
+
+    uint32_t droppedBlocks() const
+    {
+        return dropped_blocks_;
+    }
+
+private:
+    struct Block
+    {
+        JournalBlockHeader header;
+        uint8_t entries[kBlockBytes];
+    };
+
+    const PomodoroClock& clock_;
+    Block blocks_[kBlocks];
+    size_t first_;
+    size_t count_;
+    EventDigest digest_;
+    time_t last_time_;
+    // Where the last entry starts, and the ticks in it if it is a run (0 otherwise).
+    size_t last_entry_;
+    uint32_t run_;
+    bool last_was_tick_;
+    uint32_t inputs_;
+    uint32_t dropped_blocks_;
+
+    Block& current()
+    {
+        return blocks_[(first_ + count_ - 1) % kBlocks];
+    }
+
+    void open(time_t now);
+    void seal();
+    bool append(const uint8_t* data, size_t size);
+    bool extendRun();
+};
+
+// Walks a written journal block by block, and input by input within a block.
+class JournalReader
+{
+public:
+    JournalReader(const uint8_t* data, size_t size);
+
+    // False at the end of the journal, or if it is malformed (failed() tells which).
+    bool nextBlock(JournalBlockHeader* header);
+    // False at the end of the current block, or if it is malformed.
+    bool nextInput(ClockInput* input);
+
+    bool failed() const
+    {
+        return failed_;
+    }
+
+    // What CycleFlavor wrapped at on the recording clock.
+    uint8_t flavorCount() const
+    {
+        return flavor_count_;
+    }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    size_t offset_;
+    size_t block_end_;
+    time_t time_;
+    uint32_t run_left_;
+    uint8_t flavor_count_;
+    bool failed_;
+};
+
+struct JournalReplay
+{
+    size_t blocks;
+    size_t inputs;
+    size_t notifications;
+    // Blocks that did not start from the recorded state or whose notifications differed.
+    size_t mismatched;
+    // Index of the first of those, or -1.
+    long first_mismatch;
+    bool malformed;
+};
+
+// Replays the journal into `clock`, starting from the first block's state and the recorded flavor
+// count, and checks each block against its digest. Observers already on the clock see every
+// notification; a block that starts from a different state is counted and the clock reset to the
+// recorded one.
+JournalReplay replayJournal(const uint8_t* data, size_t size, PomodoroClock& clock);
+
+#endif //JOURNAL_H
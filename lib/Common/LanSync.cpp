@@ -0,0 +1,658 @@
+//
+// Mirrors one pomodoro across clocks on a LAN: delta-encoded changes over UDP multicast, last writer wins.
+//
+
+#include "LanSync.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "ByteCodec.h"
+
+namespace
+{
+constexpr uint8_t kMagic = 'P';
+constexpr uint8_t kFormat = 1;
+// CHANGE field bit: the base's writer follows, as it is not the sender.
+constexpr uint8_t kBaseWriter = 8;
+constexpr uint8_t kStateBits = 3;
+
+bool validState(const uint8_t state)
+{
+    return state == IDLE || state == WORK || state == BREAK;
+}
+
+// Bounds-checked reads; any read past the end fails the whole decode.
+class Cursor
+{
+public:
+    Cursor(const uint8_t* data, const size_t length) : data_(data), length_(length), offset_(0), ok_(true)
+    {
+    }
+
+    uint8_t byte()
+    {
+        if (offset_ >= length_)
+        {
+            ok_ = false;
+            return 0;
+        }
+        return data_[offset_++];
+    }
+
+    uint32_t uint32()
+    {
+        if (length_ - offset_ < 4)
+        {
+            ok_ = false;
+            return 0;
+        }
+        const uint32_t value = getUint32(data_ + offset_);
+        offset_ += 4;
+        return value;
+    }
+
+    uint64_t varint()
+    {
+        uint64_t value = 0;
+        const size_t size = getVarint(data_ + offset_, length_ - offset_, &value);
+        ok_ = ok_ && size > 0;
+        offset_ += size;
+        return value;
+    }
+
+    bool done() const
+    {
+        return ok_ && offset_ == length_;
+    }
+
+private:
+    const uint8_t* data_;
+    size_t length_;
+    size_t offset_;
+    bool ok_;
+};
+
+bool wouldBlock()
+{
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+}
+}
+
+SyncState syncState(const PomodoroSnapshot& snapshot)
+{
+    if (snapshot.state == IDLE)
+    {
+        return {IDLE, 0, 0, 0};
+    }
+    return {snapshot.state, snapshot.work_flavor, static_cast<uint32_t>(snapshot.state_ends_at),
+            static_cast<uint32_t>(snapshot.break_duration)};
+}
+
+PomodoroSnapshot pomodoroSnapshot(const SyncState& state)
+{
+    return {state.state, state.flavor, static_cast<time_t>(state.deadline), static_cast<time_t>(state.break_duration)};
+}
+
+SyncState advance(const SyncState& state, const uint32_t now)
+{
+    SyncState result = state;
+    if (result.state == WORK && result.deadline != 0 && now >= result.deadline)
+    {
+        result.state = BREAK;
+        result.deadline += result.break_duration;
+    }
+    if (result.state == BREAK && result.deadline != 0 && now >= result.deadline)
+    {
+        result = {IDLE, 0, 0, 0};
+    }
+    return result;
+}
+
+SyncDelta diff(const SyncState& base, const SyncState& next)
+{
+    SyncDelta delta = {0, next.state, next.flavor, 0, next.break_duration};
+    if (next.state == IDLE)
+    {
+        delta.fields = base.state != IDLE ? SYNC_STATE : 0;
+        return delta;
+    }
+    if (next.state != base.state || next.flavor != base.flavor)
+    {
+        delta.fields |= SYNC_STATE;
+    }
+    if (next.deadline != base.deadline)
+    {
+        delta.fields |= SYNC_DEADLINE;
+        delta.deadline_change = static_cast<int64_t>(next.deadline) - static_cast<int64_t>(base.deadline);
+    }
+    if (next.break_duration != base.break_duration)
+    {
+        delta.fields |= SYNC_BREAK;
+    }
+    return delta;
+}
+
+SyncState patch(const SyncState& base, const SyncDelta& delta)
+{
+    SyncState result = base;
+    if (delta.fields & SYNC_STATE)
+    {
+        if (delta.state == IDLE)
+        {
+            return {IDLE, 0, 0, 0};
+        }
+        result.state = delta.state;
+        result.flavor = delta.flavor;
+    }
+    if (delta.fields & SYNC_DEADLINE)
+    {
+        result.deadline = static_cast<uint32_t>(static_cast<int64_t>(base.deadline) + delta.deadline_change);
+    }
+    if (delta.fields & SYNC_BREAK)
+    {
+        result.break_duration = delta.break_duration;
+    }
+    return result;
+}
+
+size_t encodeSyncMessage(const SyncMessage& message, uint8_t* out, const size_t capacity)
+{
+    uint8_t buffer[kSyncMessageMaxBytes];
+    size_t size = 0;
+    buffer[size++] = kMagic;
+    buffer[size++] = static_cast<uint8_t>(kFormat << 4 | static_cast<uint8_t>(message.type));
+    putUint32(buffer + size, message.sender);
+    size += 4;
+    size += putVarint(message.version.seq, buffer + size);
+    switch (message.type)
+    {
+    case SyncMessageType::CHANGE:
+    {
+        const SyncDelta& delta = message.delta;
+        if (message.base.seq >= message.version.seq || ((delta.fields & SYNC_STATE) && delta.flavor > kMaxSyncFlavor))
+        {
+            return 0;
+        }
+        const uint8_t fields = static_cast<uint8_t>((delta.fields & (SYNC_STATE | SYNC_DEADLINE | SYNC_BREAK))
+                                                    | (message.base.writer != message.sender ? kBaseWriter : 0));
+        size += putVarint(message.version.seq - message.base.seq, buffer + size);
+        buffer[size++] = fields;
+        if (fields & kBaseWriter)
+        {
+            putUint32(buffer + size, message.base.writer);
+            size += 4;
+        }
+        if (fields & SYNC_STATE)
+        {
+            buffer[size++] = static_cast<uint8_t>(delta.state | delta.flavor << kStateBits);
+        }
+        if (fields & SYNC_DEADLINE)
+        {
+            size += putVarint(zigzag(delta.deadline_change), buffer + size);
+        }
+        if (fields & SYNC_BREAK)
+        {
+            size += putVarint(delta.break_duration, buffer + size);
+        }
+        break;
+    }
+    case SyncMessageType::FULL:
+        if (message.state.flavor > kMaxSyncFlavor)
+        {
+            return 0;
+        }
+        buffer[size++] = static_cast<uint8_t>(message.state.state | message.state.flavor << kStateBits);
+        putUint32(buffer + size, message.state.deadline);
+        size += 4;
+        size += putVarint(message.state.break_duration, buffer + size);
+        break;
+    case SyncMessageType::REQUEST:
+        putUint32(buffer + size, message.version.writer);
+        size += 4;
+        break;
+    default:
+        return 0;
+    }
+    if (size > capacity)
+    {
+        return 0;
+    }
+    memcpy(out, buffer, size);
+    return size;
+}
+
+bool decodeSyncMessage(const uint8_t* data, const size_t length, SyncMessage* message)
+{
+    Cursor cursor(data, length);
+    if (cursor.byte() != kMagic)
+    {
+        return false;
+    }
+    const uint8_t kind = cursor.byte();
+    if (kind >> 4 != kFormat)
+    {
+        return false;
+    }
+    SyncMessage result = {};
+    result.type = static_cast<SyncMessageType>(kind & 0x0F);
+    result.sender = cursor.uint32();
+    const uint64_t seq = cursor.varint();
+    if (seq > UINT32_MAX)
+    {
+        return false;
+    }
+    result.version = {static_cast<uint32_t>(seq), result.sender};
+    switch (result.type)
+    {
+    case SyncMessageType::CHANGE:
+    {
+        const uint64_t back = cursor.varint();
+        const uint8_t fields = cursor.byte();
+        if (back == 0 || back > seq || fields & ~(SYNC_STATE | SYNC_DEADLINE | SYNC_BREAK | kBaseWriter))
+        {
+            return false;
+        }
+        result.base = {static_cast<uint32_t>(seq - back), (fields & kBaseWriter) ? cursor.uint32() : result.sender};
+        SyncDelta& delta = result.delta;
+        delta.fields = fields & ~kBaseWriter;
+        if (fields & SYNC_STATE)
+        {
+            const uint8_t packed = cursor.byte();
+            if (!validState(packed & ((1 << kStateBits) - 1)))
+            {
+                return false;
+            }
+            delta.state = static_cast<PomodoroState>(packed & ((1 << kStateBits) - 1));
+            delta.flavor = packed >> kStateBits;
+        }
+        if (fields & SYNC_DEADLINE)
+        {
+            delta.deadline_change = unzigzag(cursor.varint());
+        }
+        if (fields & SYNC_BREAK)
+        {
+            const uint64_t break_duration = cursor.varint();
+            if (break_duration > UINT32_MAX)
+            {
+                return false;
+            }
+            delta.break_duration = static_cast<uint32_t>(break_duration);
+        }
+        break;
+    }
+    case SyncMessageType::FULL:
+    {
+        const uint8_t packed = cursor.byte();
+        if (!validState(packed & ((1 << kStateBits) - 1)))
+        {
+            return false;
+        }
+        result.state.state = static_cast<PomodoroState>(packed & ((1 << kStateBits) - 1));
+        result.state.flavor = packed >> kStateBits;
+        result.state.deadline = cursor.uint32();
+        const uint64_t break_duration = cursor.varint();
+        if (break_duration > UINT32_MAX)
+        {
+            return false;
+        }
+        result.state.break_duration = static_cast<uint32_t>(break_duration);
+        if (result.state.state == IDLE)
+        {
+            result.state = {IDLE, 0, 0, 0};
+        }
+        break;
+    }
+    case SyncMessageType::REQUEST:
+        result.version.writer = cursor.uint32();
+        break;
+    default:
+        return false;
+    }
+    if (!cursor.done())
+    {
+        return false;
+    }
+    *message = result;
+    return true;
+}
+
+SyncReplica::SyncReplica(const uint32_t writer) : writer_(writer), history_(), head_(0)
+{
+    // Every peer starts from the same idle version 0, so the first CHANGE applies anywhere.
+    history_[0] = {{0, 0}, {IDLE, 0, 0, 0}, true};
+}
+
+SyncMessage SyncReplica::write(const SyncState& state)
+{
+    SyncMessage message = {};
+    message.type = SyncMessageType::CHANGE;
+    message.sender = writer_;
+    message.version = {version().seq + 1, writer_};
+    message.base = version();
+    message.delta = diff(this->state(), state);
+    push(message.version, state);
+    return message;
+}
+
+SyncReplica::Result SyncReplica::apply(const SyncMessage& message)
+{
+    if (message.type == SyncMessageType::REQUEST || !newer(message.version, version()))
+    {
+        return Result::STALE;
+    }
+    if (message.type == SyncMessageType::FULL)
+    {
+        push(message.version, message.state);
+        return Result::APPLIED;
+    }
+    const Entry* base = find(message.base);
+    if (!base)
+    {
+        return Result::UNKNOWN_BASE;
+    }
+    push(message.version, patch(base->state, message.delta));
+    return Result::APPLIED;
+}
+
+SyncMessage SyncReplica::full() const
+{
+    SyncMessage message = {};
+    message.type = SyncMessageType::FULL;
+    message.sender = writer_;
+    message.version = version();
+    message.state = state();
+    return message;
+}
+
+SyncMessage SyncReplica::request() const
+{
+    SyncMessage message = {};
+    message.type = SyncMessageType::REQUEST;
+    message.sender = writer_;
+    message.version = version();
+    return message;
+}
+
+bool SyncReplica::has(const SyncVersion& version) const
+{
+    return find(version) != nullptr;
+}
+
+const SyncReplica::Entry* SyncReplica::find(const SyncVersion& version) const
+{
+    for (const Entry& entry : history_)
+    {
+        if (entry.valid && entry.version.seq == version.seq && entry.version.writer == version.writer)
+        {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+void SyncReplica::push(const SyncVersion& version, const SyncState& state)
+{
+    head_ = (head_ + 1) % kHistory;
+    history_[head_] = {version, state, true};
+}
+
+LanSync::LanSync(PomodoroClock& clock, SyncLink& link, const uint32_t writer)
+    : clock_(clock),
+      link_(link),
+      replica_(writer),
+      stats_(),
+      written_at_(0),
+      repeats_sent_(0),
+      next_repeat_at_(0),
+      last_request_at_(-1),
+      last_answer_at_(-1)
+{
+}
+
+void LanSync::begin()
+{
+    stats_.requests++;
+    send(replica_.request());
+}
+
+void LanSync::receive(const uint8_t* data, const size_t length, const time_t now)
+{
+    stats_.received++;
+    SyncMessage message;
+    if (!decodeSyncMessage(data, length, &message))
+    {
+        stats_.malformed++;
+        return;
+    }
+    if (message.sender == replica_.writer())
+    {
+        return;
+    }
+    if (message.type == SyncMessageType::REQUEST)
+    {
+        if (replica_.version().seq > 0 && newer(replica_.version(), message.version))
+        {
+            send(replica_.full());
+        }
+        else if (newer(message.version, replica_.version()))
+        {
+            request(now);
+        }
+        return;
+    }
+    switch (replica_.apply(message))
+    {
+    case SyncReplica::Result::APPLIED:
+        stats_.applied++;
+        // The register is already the new state, so the notifications this causes are not writes.
+        clock_.Adopt(pomodoroSnapshot(advance(replica_.state(), static_cast<uint32_t>(now))), now);
+        break;
+    case SyncReplica::Result::UNKNOWN_BASE:
+        request(now);
+        break;
+    case SyncReplica::Result::STALE:
+    default:
+        stats_.stale++;
+        // Its sender missed our latest write; whoever made it sets it right, once a second at most.
+        if (replica_.version().writer == replica_.writer() && newer(replica_.version(), message.version)
+            && now != last_answer_at_)
+        {
+            last_answer_at_ = now;
+            send(replica_.full());
+        }
+        break;
+    }
+}
+
+void LanSync::notification(const ClockUpdate update)
+{
+    changed(update.now);
+}
+
+void LanSync::notification(const IdleToWork update)
+{
+    changed(update.now);
+}
+
+void LanSync::notification(const WorkToBreak update)
+{
+    changed(update.now);
+}
+
+void LanSync::notification(const BreakToIdle update)
+{
+    changed(update.now);
+}
+
+void LanSync::notification(const WorkToIdle update)
+{
+    changed(update.now);
+}
+
+void LanSync::notification(const AdditionalWork update)
+{
+    changed(update.now);
+}
+
+void LanSync::changed(const time_t now)
+{
+    const uint32_t seconds = static_cast<uint32_t>(now);
+    // Compared as both would play out, so a clock a tick behind its own deadline is not a change.
+    const SyncState local = advance(syncState(clock_.Snapshot()), seconds);
+    if (local != advance(replica_.state(), seconds))
+    {
+        const SyncMessage change = replica_.write(local);
+        const SyncMessage full = replica_.full();
+        uint8_t change_bytes[kSyncMessageMaxBytes];
+        uint8_t full_bytes[kSyncMessageMaxBytes];
+        const size_t change_size = encodeSyncMessage(change, change_bytes, sizeof(change_bytes));
+        const size_t full_size = encodeSyncMessage(full, full_bytes, sizeof(full_bytes));
+        const bool use_change = change_size != 0 && change_size < full_size;
+        const size_t size = use_change ? change_size : full_size;
+        if (size != 0 && link_.send(use_change ? change_bytes : full_bytes, size))
+        {
+            stats_.sent++;
+            stats_.sent_bytes += size;
+        }
+        written_at_ = now;
+        repeats_sent_ = 0;
+        next_repeat_at_ = now + static_cast<time_t>(kRepeatSeconds[0]);
+        return;
+    }
+    if (replica_.version().seq > 0 && replica_.version().writer == replica_.writer() && now >= next_repeat_at_)
+    {
+        send(replica_.full());
+        repeats_sent_++;
+        const size_t repeats = sizeof(kRepeatSeconds) / sizeof(kRepeatSeconds[0]);
+        next_repeat_at_ = repeats_sent_ < repeats ? written_at_ + static_cast<time_t>(kRepeatSeconds[repeats_sent_])
+                                                  : now + static_cast<time_t>(kHeartbeatSeconds);
+    }
+}
+
+void LanSync::send(const SyncMessage& message)
+{
+    uint8_t bytes[kSyncMessageMaxBytes];
+    const size_t size = encodeSyncMessage(message, bytes, sizeof(bytes));
+    if (size != 0 && link_.send(bytes, size))
+    {
+        stats_.sent++;
+        stats_.sent_bytes += size;
+    }
+}
+
+void LanSync::request(const time_t now)
+{
+    // One a second at most, however many messages need the state.
+    if (now == last_request_at_)
+    {
+        return;
+    }
+    last_request_at_ = now;
+    stats_.requests++;
+    send(replica_.request());
+}
+
+MulticastLink::MulticastLink(const char* group, const uint16_t port, const char* interface)
+    : group_(group), port_(port), interface_(interface), fd_(-1)
+{
+}
+
+MulticastLink::~MulticastLink()
+{
+    close();
+}
+
+bool MulticastLink::open()
+{
+    close();
+    ip_mreq membership = {};
+    if (inet_pton(AF_INET, group_, &membership.imr_multiaddr) != 1
+        || inet_pton(AF_INET, interface_, &membership.imr_interface) != 1)
+    {
+        return false;
+    }
+    fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd_ < 0)
+    {
+        return false;
+    }
+    const int reuse = 1;
+    setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+#ifdef SO_REUSEPORT
+    setsockopt(fd_, SOL_SOCKET, SO_REUSEPORT, &reuse, sizeof(reuse));
+#endif
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port_);
+    // One hop: the group stays on the LAN. Loopback on, so peers on one host hear each other.
+    const uint8_t ttl = 1;
+    const uint8_t loop = 1;
+    const bool ready = bind(fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0
+        && setsockopt(fd_, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) == 0
+        && setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_IF, &membership.imr_interface,
+                      sizeof(membership.imr_interface)) == 0
+        && setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl)) == 0
+        && setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop)) == 0;
+    if (!ready)
+    {
+        close();
+        return false;
+    }
+    const int flags = fcntl(fd_, F_GETFL, 0);
+    fcntl(fd_, F_SETFL, flags | O_NONBLOCK);
+    return true;
+}
+
+void MulticastLink::close()
+{
+    if (fd_ >= 0)
+    {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+bool MulticastLink::send(const uint8_t* data, const size_t length)
+{
+    if (fd_ < 0)
+    {
+        return false;
+    }
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port_);
+    inet_pton(AF_INET, group_, &address.sin_addr);
+    return sendto(fd_, data, length, 0, reinterpret_cast<sockaddr*>(&address), sizeof(address))
+        == static_cast<ssize_t>(length);
+}
+
+int MulticastLink::receive(uint8_t* data, const size_t capacity, const uint32_t timeout_ms)
+{
+    if (fd_ < 0)
+    {
+        return -1;
+    }
+    fd_set set;
+    FD_ZERO(&set);
+    FD_SET(fd_, &set);
+    timeval timeout = {static_cast<long>(timeout_ms / 1000), static_cast<long>(timeout_ms % 1000) * 1000};
+    if (select(fd_ + 1, &set, nullptr, nullptr, &timeout) <= 0)
+    {
+        return 0;
+    }
+    const ssize_t received = recv(fd_, data, capacity, 0);
+    if (received >= 0)
+    {
+        return static_cast<int>(received);
+    }
+    return wouldBlock() ? 0 : -1;
+}
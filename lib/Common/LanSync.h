@@ -0,0 +1,268 @@
+//
+// Mirrors one pomodoro across clocks on a LAN: delta-encoded changes over UDP multicast, last writer wins.
+//
+
+#ifndef LANSYNC_H
+#define LANSYNC_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Pomodoro.h"
+
+// The shared register: a PomodoroSnapshot with its times as 32-bit seconds. Flavor and deadline
+// are 0 when idle; flavors go up to kMaxSyncFlavor.
+struct SyncState
+{
+    PomodoroState state;
+    uint8_t flavor;
+    uint32_t deadline;
+    uint32_t break_duration;
+
+    bool operator==(const SyncState& other) const
+    {
+        return state == other.state && flavor == other.flavor && deadline == other.deadline
+            && break_duration == other.break_duration;
+    }
+
+    bool operator!=(const SyncState& other) const
+    {
+        return !(*this == other);
+    }
+};
+
+constexpr uint8_t kMaxSyncFlavor = 31;
+
+SyncState syncState(const PomodoroSnapshot& snapshot);
+PomodoroSnapshot pomodoroSnapshot(const SyncState& state);
+
+// What `state` has become by `now` with nobody touching it, as PomodoroClock::PassageOfTime would
+// play it out: work past its deadline turns into a break, a break past its deadline into idle.
+SyncState advance(const SyncState& state, uint32_t now);
+
+// Lamport timestamp of a write; the writer id breaks ties, so every peer orders writes the same.
+struct SyncVersion
+{
+    uint32_t seq;
+    uint32_t writer;
+};
+
+inline bool newer(const SyncVersion& a, const SyncVersion& b)
+{
+    return a.seq != b.seq ? a.seq > b.seq : a.writer > b.writer;
+}
+
+enum class SyncMessageType : uint8_t
+{
+    // The fields that changed since `base`, which receivers must still have.
+    CHANGE = 1,
+    // The whole state.
+    FULL = 2,
+    // Asks peers holding something newer than `version` for a FULL.
+    REQUEST = 3,
+};
+
+enum SyncField : uint8_t
+{
+    SYNC_STATE = 1,
+    SYNC_DEADLINE = 2,
+    SYNC_BREAK = 4,
+};
+
+struct SyncDelta
+{
+    // SyncField bits.
+    uint8_t fields;
+    PomodoroState state;
+    uint8_t flavor;
+    int64_t deadline_change;
+    uint32_t break_duration;
+};
+
+// Going idle clears flavor and deadline by itself, so it only takes the state.
+SyncDelta diff(const SyncState& base, const SyncState& next);
+SyncState patch(const SyncState& base, const SyncDelta& delta);
+
+struct SyncMessage
+{
+    SyncMessageType type;
+    // The peer that sent it. For a CHANGE or FULL it is also the version's writer; a REQUEST
+    // carries the requester's version, which anyone may have written.
+    uint32_t sender;
+    SyncVersion version;
+    // CHANGE only.
+    SyncVersion base;
+    SyncDelta delta;
+    // FULL only.
+    SyncState state;
+};
+
+// Header: 'P', format version << 4 | type, sender (4 bytes LE), seq (varint). A CHANGE adds
+// how far back its base is (varint), the field bits and the changed fields: state and flavor in
+// one byte, the deadline as a zigzag varint difference, the break as a varint. The base's writer
+// is only sent when it is not the message's. A FULL adds state and flavor, the deadline (4 bytes)
+// and the break. The header of a REQUEST has the sender and the seq of its version, followed by
+// the version's writer (4 bytes).
+constexpr size_t kSyncMessageMaxBytes = 40;
+
+// Returns the encoded size, or 0 if the message does not fit in `capacity` or cannot be encoded.
+size_t encodeSyncMessage(const SyncMessage& message, uint8_t* out, size_t capacity);
+bool decodeSyncMessage(const uint8_t* data, size_t length, SyncMessage* message);
+
+// One peer's copy of the register, with the last few versions kept as bases for deltas.
+class SyncReplica
+{
+public:
+    static constexpr size_t kHistory = 4;
+
+    enum class Result : uint8_t
+    {
+        APPLIED,
+        // Not newer than what the replica has.
+        STALE,
+        // A newer CHANGE against a base the replica does not have; ask for a FULL.
+        UNKNOWN_BASE,
+    };
+
+    explicit SyncReplica(uint32_t writer);
+
+    // Writes `state` as a new version from this peer and returns its CHANGE.
+    SyncMessage write(const SyncState& state);
+    Result apply(const SyncMessage& message);
+
+    SyncMessage full() const;
+    SyncMessage request() const;
+
+    // Whether `version` is still kept, so a CHANGE against it can be applied.
+    bool has(const SyncVersion& version) const;
+
+    const SyncState& state() const
+    {
+        return history_[head_].state;
+    }
+
+    const SyncVersion& version() const
+    {
+        return history_[head_].version;
+    }
+
+    uint32_t writer() const
+    {
+        return writer_;
+    }
+
+private:
+    struct Entry
+    {
+        SyncVersion version;
+        SyncState state;
+        bool valid;
+    };
+
+    uint32_t writer_;
+    Entry history_[kHistory];
+    size_t head_;
+
+    const Entry* find(const SyncVersion& version) const;
+    void push(const SyncVersion& version, const SyncState& state);
+};
+
+// Where LanSync sends its datagrams.
+class SyncLink
+{
+public:
+    virtual ~SyncLink() = default;
+
+    virtual bool send(const uint8_t* data, size_t length) = 0;
+};
+
+struct SyncStats
+{
+    uint32_t sent;
+    uint32_t sent_bytes;
+    uint32_t received;
+    uint32_t applied;
+    uint32_t stale;
+    uint32_t requests;
+    uint32_t malformed;
+};
+
+// PomodoroObserver that keeps the clock and its peers on one shared pomodoro. A notification
+// leaving the clock somewhere the register would not have reached by itself (a start, a cancel,
+// more work, another flavor) is a write: sent as a CHANGE, or a FULL when that is no bigger, and
+// repeated as a FULL kRepeatSeconds later against loss. After that its writer sends a FULL every
+// kHeartbeatSeconds, for peers that missed every copy. Transitions the deadlines imply and
+// per-second ticks send nothing. Datagrams from peers go to receive(), which moves the clock with
+// Adopt when they carry a newer write.
+class LanSync final : public PomodoroObserver
+{
+public:
+    static constexpr uint32_t kRepeatSeconds[] = {1, 4};
+    static constexpr uint32_t kHeartbeatSeconds = 60;
+
+    // `writer` must be unique on the LAN (the low bits of the MAC address, say) and not 0.
+    LanSync(PomodoroClock& clock, SyncLink& link, uint32_t writer);
+
+    // Asks the peers for the current state.
+    void begin();
+
+    // One datagram from the group. Call it from the task that drives the clock.
+    void receive(const uint8_t* data, size_t length, time_t now);
+
+    const SyncReplica& replica() const
+    {
+        return replica_;
+    }
+
+    const SyncStats& stats() const
+    {
+        return stats_;
+    }
+
+    void notification(ClockUpdate update) override;
+    void notification(IdleToWork update) override;
+    void notification(WorkToBreak update) override;
+    void notification(BreakToIdle update) override;
+    void notification(WorkToIdle update) override;
+    void notification(AdditionalWork update) override;
+
+private:
+    PomodoroClock& clock_;
+    SyncLink& link_;
+    SyncReplica replica_;
+    SyncStats stats_;
+    time_t written_at_;
+    size_t repeats_sent_;
+    time_t next_repeat_at_;
+    time_t last_request_at_;
+    time_t last_answer_at_;
+
+    void changed(time_t now);
+    void send(const SyncMessage& message);
+    void request(time_t now);
+};
+
+// UDP multicast over BSD sockets: lwIP on the ESP32, the host's on Linux. Every peer in the group
+// binds the same port; datagrams loop back to the sender, and LanSync ignores its own.
+class MulticastLink final : public SyncLink
+{
+public:
+    // `group` and `interface` (an address of the interface to use, "0.0.0.0" for the default)
+    // must outlive the link.
+    MulticastLink(const char* group, uint16_t port, const char* interface = "0.0.0.0");
+    ~MulticastLink() override;
+
+    bool open();
+    void close();
+    bool send(const uint8_t* data, size_t length) override;
+    // Waits up to `timeout_ms` for a datagram: its size, 0 on timeout, -1 if the link is closed.
+    int receive(uint8_t* data, size_t capacity, uint32_t timeout_ms);
+
+private:
+    const char* group_;
+    uint16_t port_;
+    const char* interface_;
+    int fd_;
+};
+
+#endif //LANSYNC_H
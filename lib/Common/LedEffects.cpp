@@ -0,0 +1,175 @@
+//
+// LED frames for the pomodoro state: fixed-point effects rendered from lookup tables.
+//
+
+#include "LedEffects.h"
+
+namespace
+{
+constexpr Rgb kOff = {0, 0, 0};
+constexpr Rgb kWorkColor = {0, 255, 0};
+constexpr Rgb kBreakColor = {255, 0, 0};
+
+Rgb stateColor(const PomodoroState state)
+{
+    switch (state)
+    {
+    case WORK:
+        return kWorkColor;
+    case BREAK:
+        return kBreakColor;
+    case IDLE:
+    default:
+        return kOff;
+    }
+}
+}
+
+bool LedFrame::operator==(const LedFrame& other) const
+{
+    for (size_t i = 0; i < INTERNAL_LEDS; i++)
+    {
+        if (internal[i] != other.internal[i])
+        {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < EXTERNAL_LEDS; i++)
+    {
+        if (external[i] != other.external[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+namespace led_effects
+{
+// round(255 * (i / 255)^2.2)
+const uint8_t kGamma[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2,
+    3, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 6, 6, 6,
+    6, 7, 7, 7, 8, 8, 8, 9, 9, 9, 10, 10, 11, 11, 11, 12,
+    12, 13, 13, 13, 14, 14, 15, 15, 16, 16, 17, 17, 18, 18, 19, 19,
+    20, 20, 21, 22, 22, 23, 23, 24, 25, 25, 26, 26, 27, 28, 28, 29,
+    30, 30, 31, 32, 33, 33, 34, 35, 35, 36, 37, 38, 39, 39, 40, 41,
+    42, 43, 43, 44, 45, 46, 47, 48, 49, 49, 50, 51, 52, 53, 54, 55,
+    56, 57, 58, 59, 60, 61, 62, 63, 64, 65, 66, 67, 68, 69, 70, 71,
+    73, 74, 75, 76, 77, 78, 79, 81, 82, 83, 84, 85, 87, 88, 89, 90,
+    91, 93, 94, 95, 97, 98, 99, 100, 102, 103, 105, 106, 107, 109, 110, 111,
+    113, 114, 116, 117, 119, 120, 121, 123, 124, 126, 127, 129, 130, 132, 133, 135,
+    137, 138, 140, 141, 143, 145, 146, 148, 149, 151, 153, 154, 156, 158, 159, 161,
+    163, 165, 166, 168, 170, 172, 173, 175, 177, 179, 181, 182, 184, 186, 188, 190,
+    192, 194, 196, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221,
+    223, 225, 227, 229, 231, 234, 236, 238, 240, 242, 244, 246, 248, 251, 253, 255,
+};
+
+// round(255 * (exp(sin(2 pi i / 256 - pi / 2)) - 1 / e) / (e - 1 / e))
+const uint8_t kBreath[256] = {
+    0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 2, 2, 2, 3,
+    3, 4, 4, 4, 5, 6, 6, 7, 7, 8, 9, 9, 10, 11, 12, 13,
+    14, 15, 16, 17, 18, 19, 20, 21, 22, 24, 25, 26, 28, 29, 31, 32,
+    34, 36, 38, 39, 41, 43, 45, 47, 49, 52, 54, 56, 58, 61, 63, 66,
+    69, 71, 74, 77, 80, 83, 86, 89, 92, 95, 98, 102, 105, 109, 112, 116,
+    119, 123, 126, 130, 134, 138, 142, 145, 149, 153, 157, 161, 165, 169, 172, 176,
+    180, 184, 188, 191, 195, 199, 202, 206, 209, 213, 216, 219, 222, 225, 228, 231,
+    233, 236, 238, 240, 243, 245, 246, 248, 249, 251, 252, 253, 254, 254, 255, 255,
+    255, 255, 255, 254, 254, 253, 252, 251, 249, 248, 246, 245, 243, 240, 238, 236,
+    233, 231, 228, 225, 222, 219, 216, 213, 209, 206, 202, 199, 195, 191, 188, 184,
+    180, 176, 172, 169, 165, 161, 157, 153, 149, 145, 142, 138, 134, 130, 126, 123,
+    119, 116, 112, 109, 105, 102, 98, 95, 92, 89, 86, 83, 80, 77, 74, 71,
+    69, 66, 63, 61, 58, 56, 54, 52, 49, 47, 45, 43, 41, 39, 38, 36,
+    34, 32, 31, 29, 28, 26, 25, 24, 22, 21, 20, 19, 18, 17, 16, 15,
+    14, 13, 12, 11, 10, 9, 9, 8, 7, 7, 6, 6, 5, 4, 4, 4,
+    3, 3, 2, 2, 2, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0,
+};
+
+void progressBar(Rgb* pixels, const size_t count, const Rgb color, const uint32_t remaining_ms,
+                 const uint32_t total_ms)
+{
+    uint32_t lit = 0;
+    if (total_ms > 0)
+    {
+        const uint32_t clamped = remaining_ms < total_ms ? remaining_ms : total_ms;
+        // Q16 fraction of the period left, then Q8 pixels.
+        const uint32_t fraction = static_cast<uint32_t>((static_cast<uint64_t>(clamped) << 16) / total_ms);
+        lit = static_cast<uint32_t>((static_cast<uint64_t>(fraction) * count) >> 8);
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        const uint32_t start = static_cast<uint32_t>(i) << 8;
+        // The edge fades in 32 steps: smooth to the eye, and 8x fewer frames that need a show().
+        const uint32_t level = lit <= start ? 0 : (lit - start >= 256 ? 255 : (lit - start) & ~7u);
+        pixels[i] = scale(color, kGamma[level]);
+    }
+}
+
+uint8_t breath(const uint32_t now_ms)
+{
+    const uint32_t phase = (now_ms % kBreathPeriodMs) * 256 / kBreathPeriodMs;
+    return static_cast<uint8_t>(kBreathFloor + scale8(kBreath[phase], 255 - kBreathFloor));
+}
+}
+
+LedAnimator::LedAnimator()
+    : state_(IDLE),
+      remaining_ms_(0),
+      total_ms_(0),
+      updated_at_ms_(0),
+      last_frame_(),
+      has_frame_(false)
+{
+}
+
+void LedAnimator::update(const ClockUpdate& update, const uint32_t now_ms)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    const uint32_t remaining_ms = update.remaining_time_in_state > 0
+        ? static_cast<uint32_t>(update.remaining_time_in_state) * 1000 : 0;
+    // The bar spans the whole period: it restarts with each state and grows when work is extended.
+    if (update.state != state_ || remaining_ms > total_ms_)
+    {
+        total_ms_ = remaining_ms;
+    }
+    state_ = update.state;
+    remaining_ms_ = remaining_ms;
+    updated_at_ms_ = now_ms;
+}
+
+bool LedAnimator::render(const uint32_t now_ms, LedFrame* out)
+{
+    using namespace led_effects;
+    std::lock_guard<std::mutex> lock(mutex_);
+    const uint32_t elapsed = now_ms - updated_at_ms_;
+    // Updates arrive once a second; never run the interpolation more than a second ahead of them.
+    const uint32_t ahead = elapsed < 1000 ? elapsed : 1000;
+    const uint32_t remaining_ms = remaining_ms_ > ahead ? remaining_ms_ - ahead : 0;
+
+    Rgb color = stateColor(state_);
+    if (state_ != IDLE && remaining_ms < kBreathFromMs)
+    {
+        color = scale(color, breath(now_ms));
+    }
+    for (Rgb& pixel : out->internal)
+    {
+        pixel = color;
+    }
+    if (state_ == IDLE)
+    {
+        for (Rgb& pixel : out->external)
+        {
+            pixel = kOff;
+        }
+    }
+    else
+    {
+        progressBar(out->external, EXTERNAL_LEDS, color, remaining_ms, total_ms_);
+    }
+
+    const bool changed = !has_frame_ || *out != last_frame_;
+    last_frame_ = *out;
+    has_frame_ = true;
+    return changed;
+}
@@ -0,0 +1,102 @@
+//
+// LED frames for the pomodoro state: fixed-point effects rendered from lookup tables.
+//
+
+#ifndef LEDEFFECTS_H
+#define LEDEFFECTS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include "Pomodoro.h"
+
+struct Rgb
+{
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+
+    bool operator==(const Rgb& other) const
+    {
+        return r == other.r && g == other.g && b == other.b;
+    }
+
+    bool operator!=(const Rgb& other) const
+    {
+        return !(*this == other);
+    }
+};
+
+constexpr size_t INTERNAL_LEDS = 10;
+constexpr size_t EXTERNAL_LEDS = 30;
+
+// One frame for both strips: the 10 LEDs in the M5Stack base and the 30-pixel external strip.
+struct LedFrame
+{
+    Rgb internal[INTERNAL_LEDS];
+    Rgb external[EXTERNAL_LEDS];
+
+    bool operator==(const LedFrame& other) const;
+
+    bool operator!=(const LedFrame& other) const
+    {
+        return !(*this == other);
+    }
+};
+
+namespace led_effects
+{
+constexpr uint32_t kBreathPeriodMs = 2000;
+constexpr uint32_t kBreathFromMs = 60000;
+// Lowest brightness of the breathing pulse, so the strip never goes dark.
+constexpr uint8_t kBreathFloor = 48;
+
+// Perceptual (gamma 2.2) brightness ramp and one exp(sin) breathing period, 256 steps each.
+extern const uint8_t kGamma[256];
+extern const uint8_t kBreath[256];
+
+// (value * scale) / 255, rounded down, without division.
+inline uint8_t scale8(const uint8_t value, const uint8_t scale)
+{
+    return static_cast<uint8_t>((static_cast<uint16_t>(value) * (static_cast<uint16_t>(scale) + 1)) >> 8);
+}
+
+inline Rgb scale(const Rgb& color, const uint8_t level)
+{
+    return {scale8(color.r, level), scale8(color.g, level), scale8(color.b, level)};
+}
+
+// Fills `pixels` as a bar whose lit length is remaining/total of the strip; the edge pixel fades
+// with the fractional part. Lengths are computed in 1/256ths of a pixel, the fade in 32 steps.
+void progressBar(Rgb* pixels, size_t count, Rgb color, uint32_t remaining_ms, uint32_t total_ms);
+
+// Brightness of the breathing pulse at `now_ms`.
+uint8_t breath(uint32_t now_ms);
+}
+
+// Turns ClockUpdates into LED frames at any frame rate: the remaining time is interpolated between
+// updates, the external strip shows it as a progress bar, and the last minute of a work or break
+// period breathes. render() reports whether the frame changed, so unchanged frames need no show().
+class LedAnimator
+{
+public:
+    LedAnimator();
+
+    // Safe to call from any task. `now_ms` is the caller's monotonic millisecond clock.
+    void update(const ClockUpdate& update, uint32_t now_ms);
+
+    // Renders the frame for `now_ms` into `out`. Returns false if it equals the previous frame.
+    bool render(uint32_t now_ms, LedFrame* out);
+
+private:
+    std::mutex mutex_;
+    PomodoroState state_;
+    uint32_t remaining_ms_;
+    uint32_t total_ms_;
+    uint32_t updated_at_ms_;
+    LedFrame last_frame_;
+    bool has_frame_;
+};
+
+#endif //LEDEFFECTS_H
@@ -0,0 +1,58 @@
+//
+// Single-slot mailbox that keeps only the newest value.
+//
+
+#ifndef MAILBOX_H
+#define MAILBOX_H
+
+#include <cstdint>
+#include <mutex>
+
+// Lets a fast producer hand work to a slower consumer without queueing: a value posted before the
+// previous one was taken replaces it. Safe to use from any task.
+template <typename T>
+class Mailbox
+{
+public:
+    Mailbox() : full_(false), replaced_(0)
+    {
+    }
+
+    // Returns true if an untaken value was replaced.
+    bool post(const T& value)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const bool replaced = full_;
+        value_ = value;
+        full_ = true;
+        replaced_ += replaced;
+        return replaced;
+    }
+
+    bool take(T* out)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!full_)
+        {
+            return false;
+        }
+        *out = value_;
+        full_ = false;
+        return true;
+    }
+
+    // Values dropped because a newer one was posted before they were taken.
+    uint32_t replaced() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return replaced_;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    T value_;
+    bool full_;
+    uint32_t replaced_;
+};
+
+#endif //MAILBOX_H
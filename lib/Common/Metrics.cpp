@@ -0,0 +1,352 @@
+//
+// Process-wide registry of lock-free counters, gauges and log2 histograms.
+//
+
+#include "Metrics.h"
+
+#include <climits>
+#include <cstdio>
+#include <cstring>
+
+#include "FrameTiming.h"
+
+namespace
+{
+uint32_t bucketUpperBound(const size_t bucket, const uint32_t max)
+{
+    const uint32_t upper = bucket + 1 < 32 ? (1u << (bucket + 1)) - 1 : max;
+    return upper < max ? upper : max;
+}
+
+// Appends `entry`, formatted into a buffer of `entry_size`, to `out` if it fits with `reserve`
+// bytes to spare.
+bool append(char* out, const size_t size, size_t* written, const char* entry, const int length,
+            const size_t entry_size, const size_t reserve)
+{
+    if (length < 0 || static_cast<size_t>(length) >= entry_size
+        || *written + static_cast<size_t>(length) + reserve >= size)
+    {
+        return false;
+    }
+    memcpy(out + *written, entry, static_cast<size_t>(length));
+    *written += static_cast<size_t>(length);
+    out[*written] = '\0';
+    return true;
+}
+
+int formatSample(const MetricSample& sample, char* out, const size_t size)
+{
+    switch (sample.kind)
+    {
+    case MetricKind::COUNTER:
+        return snprintf(out, size, "counter   %-24s %10lu\n", sample.name, static_cast<unsigned long>(sample.value));
+    case MetricKind::GAUGE:
+        return snprintf(out, size, "gauge     %-24s %10ld (min %ld, max %ld)\n", sample.name,
+                        static_cast<long>(static_cast<int32_t>(sample.value)), static_cast<long>(sample.min),
+                        static_cast<long>(sample.max));
+    case MetricKind::HISTOGRAM:
+        if (sample.budget != 0)
+        {
+            return snprintf(out, size, "histogram %-24s n=%lu p50<=%lu p90<=%lu p99<=%lu max=%lu over %lu: %lu\n",
+                            sample.name, static_cast<unsigned long>(sample.value),
+                            static_cast<unsigned long>(sample.p50), static_cast<unsigned long>(sample.p90),
+                            static_cast<unsigned long>(sample.p99), static_cast<unsigned long>(sample.hmax),
+                            static_cast<unsigned long>(sample.budget), static_cast<unsigned long>(sample.overruns));
+        }
+        return snprintf(out, size, "histogram %-24s n=%lu p50<=%lu p90<=%lu p99<=%lu max=%lu\n", sample.name,
+                        static_cast<unsigned long>(sample.value), static_cast<unsigned long>(sample.p50),
+                        static_cast<unsigned long>(sample.p90), static_cast<unsigned long>(sample.p99),
+                        static_cast<unsigned long>(sample.hmax));
+    }
+    return -1;
+}
+
+int formatSampleJson(const MetricSample& sample, const bool first, char* out, const size_t size)
+{
+    // Names are string literals from the firmware, so they need no escaping.
+    const char* comma = first ? "" : ",";
+    switch (sample.kind)
+    {
+    case MetricKind::COUNTER:
+        return snprintf(out, size, "%s\"%s\":%lu", comma, sample.name, static_cast<unsigned long>(sample.value));
+    case MetricKind::GAUGE:
+        return snprintf(out, size, "%s\"%s\":{\"value\":%ld,\"min\":%ld,\"max\":%ld}", comma, sample.name,
+                        static_cast<long>(static_cast<int32_t>(sample.value)), static_cast<long>(sample.min),
+                        static_cast<long>(sample.max));
+    case MetricKind::HISTOGRAM:
+        if (sample.budget != 0)
+        {
+            return snprintf(out, size,
+                            "%s\"%s\":{\"count\":%lu,\"p50\":%lu,\"p90\":%lu,\"p99\":%lu,\"max\":%lu,"
+                            "\"budget\":%lu,\"overruns\":%lu}", comma, sample.name,
+                            static_cast<unsigned long>(sample.value), static_cast<unsigned long>(sample.p50),
+                            static_cast<unsigned long>(sample.p90), static_cast<unsigned long>(sample.p99),
+                            static_cast<unsigned long>(sample.hmax), static_cast<unsigned long>(sample.budget),
+                            static_cast<unsigned long>(sample.overruns));
+        }
+        return snprintf(out, size, "%s\"%s\":{\"count\":%lu,\"p50\":%lu,\"p90\":%lu,\"p99\":%lu,\"max\":%lu}", comma,
+                        sample.name, static_cast<unsigned long>(sample.value), static_cast<unsigned long>(sample.p50),
+                        static_cast<unsigned long>(sample.p90), static_cast<unsigned long>(sample.p99),
+                        static_cast<unsigned long>(sample.hmax));
+    }
+    return -1;
+}
+}
+
+Metric::Metric(const char* name, const MetricKind kind) : name_(name), kind_(kind), next_(nullptr)
+{
+    metrics().add(this);
+}
+
+Metric::~Metric()
+{
+    metrics().remove(this);
+}
+
+MetricSample Counter::sample() const
+{
+    MetricSample sample = {};
+    sample.name = name();
+    sample.kind = kind();
+    sample.value = value();
+    return sample;
+}
+
+void Counter::reset()
+{
+    value_.store(0, std::memory_order_relaxed);
+}
+
+Gauge::Gauge(const char* name) : Metric(name, MetricKind::GAUGE), value_(0), min_(INT32_MAX), max_(INT32_MIN)
+{
+}
+
+MetricSample Gauge::sample() const
+{
+    MetricSample sample = {};
+    sample.name = name();
+    sample.kind = kind();
+    sample.value = static_cast<uint32_t>(value());
+    const int32_t min = min_.load(std::memory_order_relaxed);
+    const int32_t max = max_.load(std::memory_order_relaxed);
+    // Never set since the last reset: report zeros rather than the sentinels.
+    if (min <= max)
+    {
+        sample.min = min;
+        sample.max = max;
+    }
+    return sample;
+}
+
+void Gauge::reset()
+{
+    // The current value stays; the extremes restart from it.
+    const int32_t value = this->value();
+    min_.store(value, std::memory_order_relaxed);
+    max_.store(value, std::memory_order_relaxed);
+}
+
+Histogram::Histogram(const char* name, const uint32_t budget)
+    : Metric(name, MetricKind::HISTOGRAM), max_(0), budget_(budget), overruns_(0)
+{
+    for (std::atomic<uint32_t>& bucket : buckets_)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+MetricSample Histogram::sample() const
+{
+    MetricSample sample = {};
+    sample.name = name();
+    sample.kind = kind();
+    // Buckets are read one by one while records may land, so a concurrent snapshot can be off by
+    // the records made during it, never inconsistent in any other way.
+    uint32_t counts[kBuckets];
+    uint32_t count = 0;
+    for (size_t i = 0; i < kBuckets; i++)
+    {
+        counts[i] = buckets_[i].load(std::memory_order_relaxed);
+        count += counts[i];
+    }
+    const uint32_t max = max_.load(std::memory_order_relaxed);
+    sample.value = count;
+    sample.hmax = max;
+    sample.budget = budget_;
+    sample.overruns = overruns_.load(std::memory_order_relaxed);
+    uint32_t* const percentiles[] = {&sample.p50, &sample.p90, &sample.p99};
+    const unsigned percents[] = {50, 90, 99};
+    for (size_t p = 0; p < 3 && count > 0; p++)
+    {
+        const uint64_t rank = (static_cast<uint64_t>(count) * percents[p] + 99) / 100;
+        uint64_t seen = 0;
+        *percentiles[p] = max;
+        for (size_t bucket = 0; bucket < kBuckets; bucket++)
+        {
+            seen += counts[bucket];
+            if (seen >= rank)
+            {
+                *percentiles[p] = bucketUpperBound(bucket, max);
+                break;
+            }
+        }
+    }
+    return sample;
+}
+
+void Histogram::reset()
+{
+    for (std::atomic<uint32_t>& bucket : buckets_)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    max_.store(0, std::memory_order_relaxed);
+    overruns_.store(0, std::memory_order_relaxed);
+}
+
+ScopedMetric::ScopedMetric(Histogram& histogram) : histogram_(histogram), start_(monotonicMicros())
+{
+}
+
+ScopedMetric::~ScopedMetric()
+{
+    histogram_.record(static_cast<uint32_t>(monotonicMicros() - start_));
+}
+
+MetricsRegistry::MetricsRegistry() : head_(nullptr), tail_(nullptr)
+{
+}
+
+MetricsRegistry& metrics()
+{
+    // Function-local so metrics defined as statics in any translation unit can register.
+    static MetricsRegistry registry;
+    return registry;
+}
+
+void MetricsRegistry::add(Metric* metric)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (tail_)
+    {
+        tail_->next_ = metric;
+    }
+    else
+    {
+        head_ = metric;
+    }
+    tail_ = metric;
+}
+
+void MetricsRegistry::remove(Metric* metric)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Metric* previous = nullptr;
+    for (Metric* current = head_; current; previous = current, current = current->next_)
+    {
+        if (current == metric)
+        {
+            (previous ? previous->next_ : head_) = current->next_;
+            if (tail_ == metric)
+            {
+                tail_ = previous;
+            }
+            return;
+        }
+    }
+}
+
+size_t MetricsRegistry::snapshot(MetricSample* out, const size_t capacity) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = 0;
+    for (const Metric* metric = head_; metric && count < capacity; metric = metric->next_)
+    {
+        out[count++] = metric->sample();
+    }
+    return count;
+}
+
+size_t MetricsRegistry::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = 0;
+    for (const Metric* metric = head_; metric; metric = metric->next_)
+    {
+        count++;
+    }
+    return count;
+}
+
+Metric* MetricsRegistry::find(const char* name) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (Metric* metric = head_; metric; metric = metric->next_)
+    {
+        if (strcmp(metric->name_, name) == 0)
+        {
+            return metric;
+        }
+    }
+    return nullptr;
+}
+
+void MetricsRegistry::resetAll()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (Metric* metric = head_; metric; metric = metric->next_)
+    {
+        metric->reset();
+    }
+}
+
+size_t MetricsRegistry::format(char* out, const size_t size) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t written = 0;
+    if (size > 0)
+    {
+        out[0] = '\0';
+    }
+    char line[160];
+    for (const Metric* metric = head_; metric; metric = metric->next_)
+    {
+        const int length = formatSample(metric->sample(), line, sizeof(line));
+        if (!append(out, size, &written, line, length, sizeof(line), 0))
+        {
+            break;
+        }
+    }
+    return written;
+}
+
+size_t MetricsRegistry::formatJson(char* out, const size_t size) const
+{
+    if (size < 3)
+    {
+        if (size > 0)
+        {
+            out[0] = '\0';
+        }
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    out[0] = '{';
+    out[1] = '\0';
+    size_t written = 1;
+    bool first = true;
+    char entry[160];
+    for (const Metric* metric = head_; metric; metric = metric->next_)
+    {
+        const int length = formatSampleJson(metric->sample(), first, entry, sizeof(entry));
+        // Keep room for the closing brace.
+        if (!append(out, size, &written, entry, length, sizeof(entry), 1))
+        {
+            break;
+        }
+        first = false;
+    }
+    out[written++] = '}';
+    out[written] = '\0';
+    return written;
+}
@@ -0,0 +1,226 @@
+//
+// Process-wide registry of lock-free counters, gauges and log2 histograms.
+//
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+enum class MetricKind : uint8_t
+{
+    COUNTER,
+    GAUGE,
+    HISTOGRAM,
+};
+
+// A point-in-time copy of one metric. Fields that do not apply to the kind are zero.
+struct MetricSample
+{
+    const char* name;
+    MetricKind kind;
+    // Counter total, gauge value or histogram count.
+    uint32_t value;
+    // Gauge extremes since start or reset.
+    int32_t min;
+    int32_t max;
+    // Histogram percentiles, as the upper bound of their bucket; max is exact.
+    uint32_t p50;
+    uint32_t p90;
+    uint32_t p99;
+    uint32_t hmax;
+    // Histogram time budget (0 if none) and the records that exceeded it.
+    uint32_t budget;
+    uint32_t overruns;
+};
+
+// Metrics register themselves on construction and unregister on destruction, so they can be
+// statics, members or (in tests) locals. Recording is a few relaxed atomic operations and never
+// takes a lock; only registration and snapshots do.
+class Metric
+{
+public:
+    Metric(const Metric&) = delete;
+    Metric& operator=(const Metric&) = delete;
+
+    const char* name() const
+    {
+        return name_;
+    }
+
+    MetricKind kind() const
+    {
+        return kind_;
+    }
+
+    virtual MetricSample sample() const = 0;
+    virtual void reset() = 0;
+
+protected:
+    Metric(const char* name, MetricKind kind);
+    virtual ~Metric();
+
+private:
+    friend class MetricsRegistry;
+
+    const char* name_;
+    MetricKind kind_;
+    Metric* next_;
+};
+
+// Monotonic event count, e.g. HTTP responses by status class. Wraps at 2^32.
+class Counter final : public Metric
+{
+public:
+    explicit Counter(const char* name) : Metric(name, MetricKind::COUNTER), value_(0)
+    {
+    }
+
+    void add(const uint32_t delta = 1)
+    {
+        value_.fetch_add(delta, std::memory_order_relaxed);
+    }
+
+    uint32_t value() const
+    {
+        return value_.load(std::memory_order_relaxed);
+    }
+
+    MetricSample sample() const override;
+    void reset() override;
+
+private:
+    std::atomic<uint32_t> value_;
+};
+
+// Current level of something, e.g. queue depth, with the lowest and highest level seen.
+class Gauge final : public Metric
+{
+public:
+    explicit Gauge(const char* name);
+
+    void set(int32_t value)
+    {
+        value_.store(value, std::memory_order_relaxed);
+        int32_t seen = min_.load(std::memory_order_relaxed);
+        while (value < seen && !min_.compare_exchange_weak(seen, value, std::memory_order_relaxed))
+        {
+        }
+        seen = max_.load(std::memory_order_relaxed);
+        while (value > seen && !max_.compare_exchange_weak(seen, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    int32_t value() const
+    {
+        return value_.load(std::memory_order_relaxed);
+    }
+
+    MetricSample sample() const override;
+    void reset() override;
+
+private:
+    std::atomic<int32_t> value_;
+    std::atomic<int32_t> min_;
+    std::atomic<int32_t> max_;
+};
+
+// Distribution of a duration or size in log2 buckets, recorded without a lock. There is no
+// running sum: it would need a 64-bit atomic, which the ESP32 only emulates with a lock.
+// With a budget, records above it are also counted as overruns.
+class Histogram final : public Metric
+{
+public:
+    static constexpr size_t kBuckets = 24;
+
+    explicit Histogram(const char* name, uint32_t budget = 0);
+
+    void record(const uint32_t value)
+    {
+        if (budget_ != 0 && value > budget_)
+        {
+            overruns_.fetch_add(1, std::memory_order_relaxed);
+        }
+        // Bucket b holds [2^b, 2^(b+1)); 0 shares bucket 0 with 1.
+        const size_t bucket = value == 0 ? 0 : 31 - __builtin_clz(value);
+        buckets_[bucket < kBuckets ? bucket : kBuckets - 1].fetch_add(1, std::memory_order_relaxed);
+        uint32_t seen = max_.load(std::memory_order_relaxed);
+        while (value > seen && !max_.compare_exchange_weak(seen, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    uint32_t budget() const
+    {
+        return budget_;
+    }
+
+    uint32_t overruns() const
+    {
+        return overruns_.load(std::memory_order_relaxed);
+    }
+
+    MetricSample sample() const override;
+    void reset() override;
+
+private:
+    std::atomic<uint32_t> buckets_[kBuckets];
+    std::atomic<uint32_t> max_;
+    const uint32_t budget_;
+    std::atomic<uint32_t> overruns_;
+};
+
+// Times from construction to destruction into a Histogram, in microseconds.
+class ScopedMetric
+{
+public:
+    explicit ScopedMetric(Histogram& histogram);
+    ~ScopedMetric();
+
+private:
+    Histogram& histogram_;
+    uint64_t start_;
+};
+
+class MetricsRegistry
+{
+public:
+    // Copies up to `capacity` samples in registration order; returns how many were copied.
+    size_t snapshot(MetricSample* out, size_t capacity) const;
+
+    size_t size() const;
+
+    // Null if no metric has that name.
+    Metric* find(const char* name) const;
+
+    void resetAll();
+
+    // One aligned line per metric; returns the length written, truncated to whole lines.
+    size_t format(char* out, size_t size) const;
+
+    // A JSON object keyed by metric name, e.g. for pushing to the backend. Metrics that do not fit
+    // are left out, so the output is always valid JSON; returns the length written.
+    size_t formatJson(char* out, size_t size) const;
+
+private:
+    friend class Metric;
+    friend MetricsRegistry& metrics();
+
+    MetricsRegistry();
+
+    mutable std::mutex mutex_;
+    Metric* head_;
+    Metric* tail_;
+
+    void add(Metric* metric);
+    void remove(Metric* metric);
+};
+
+// The registry every metric joins.
+MetricsRegistry& metrics();
+
+#endif //METRICS_H
@@ -0,0 +1,593 @@
+//
+// MQTT 3.1.1 packet codec and a small publishing client over a pluggable byte link.
+//
+
+#include "Mqtt.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "ByteCodec.h"
+#include "FrameTiming.h"
+
+#ifndef MSG_NOSIGNAL
+// lwIP has no SIGPIPE to suppress.
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace
+{
+constexpr uint8_t kProtocolLevel = 4;
+constexpr uint8_t kCleanSessionFlag = 0x02;
+// Remaining length is at most four 7-bit groups.
+constexpr uint8_t kMaxLengthBytes = 4;
+
+uint32_t nowMs()
+{
+    return static_cast<uint32_t>(monotonicMicros() / 1000);
+}
+
+size_t lengthBytes(const size_t length)
+{
+    return length < 128 ? 1 : length < 16384 ? 2 : length < 2097152 ? 3 : 4;
+}
+
+// Writes the fixed header; returns its size, or 0 if header plus body do not fit.
+size_t putHeader(const uint8_t first, size_t length, uint8_t* out, const size_t capacity)
+{
+    const size_t header = 1 + lengthBytes(length);
+    if (header + length > capacity)
+    {
+        return 0;
+    }
+    out[0] = first;
+    size_t i = 1;
+    do
+    {
+        uint8_t digit = length % 128;
+        length /= 128;
+        if (length > 0)
+        {
+            digit |= 0x80;
+        }
+        out[i++] = digit;
+    } while (length > 0);
+    return header;
+}
+
+// MQTT's two-byte integers are big-endian, unlike ByteCodec's.
+uint8_t* putUint16Be(uint8_t* out, const uint16_t value)
+{
+    out[0] = static_cast<uint8_t>(value >> 8);
+    out[1] = static_cast<uint8_t>(value);
+    return out + 2;
+}
+
+uint8_t* putString(uint8_t* out, const char* text, const size_t length)
+{
+    out = putUint16Be(out, static_cast<uint16_t>(length));
+    memcpy(out, text, length);
+    return out + length;
+}
+
+uint16_t getUint16Be(const uint8_t* data)
+{
+    return static_cast<uint16_t>(data[0] << 8 | data[1]);
+}
+
+bool wouldBlock()
+{
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINPROGRESS;
+}
+
+// Waits until `fd` is readable (or writable); false on timeout or error.
+bool waitFor(const int fd, const bool write, const uint32_t timeout_ms)
+{
+    fd_set set;
+    FD_ZERO(&set);
+    FD_SET(fd, &set);
+    timeval timeout = {static_cast<long>(timeout_ms / 1000), static_cast<long>(timeout_ms % 1000) * 1000};
+    return select(fd + 1, write ? nullptr : &set, write ? &set : nullptr, nullptr, &timeout) > 0;
+}
+}
+
+size_t mqttEncodeConnect(const MqttConnectOptions& options, uint8_t* out, const size_t capacity)
+{
+    static const char kProtocol[] = "MQTT";
+    const size_t id_length = strlen(options.client_id);
+    const size_t length = 2 + 4 + 1 + 1 + 2 + 2 + id_length;
+    const size_t header = putHeader(static_cast<uint8_t>(MqttPacketType::CONNECT) << 4, length, out, capacity);
+    if (header == 0)
+    {
+        return 0;
+    }
+    uint8_t* p = putString(out + header, kProtocol, 4);
+    *p++ = kProtocolLevel;
+    *p++ = options.clean_session ? kCleanSessionFlag : 0;
+    p = putUint16Be(p, options.keep_alive_s);
+    putString(p, options.client_id, id_length);
+    return header + length;
+}
+
+size_t mqttEncodeConnAck(const bool session_present, const uint8_t return_code, uint8_t* out, const size_t capacity)
+{
+    const size_t header = putHeader(static_cast<uint8_t>(MqttPacketType::CONNACK) << 4, 2, out, capacity);
+    if (header == 0)
+    {
+        return 0;
+    }
+    out[header] = session_present ? 1 : 0;
+    out[header + 1] = return_code;
+    return header + 2;
+}
+
+size_t mqttEncodePublish(const MqttMessage& message, uint8_t* out, const size_t capacity)
+{
+    const size_t header = mqttEncodePublishHeader(message, out, capacity);
+    if (header == 0 || header + message.payload_length > capacity)
+    {
+        return 0;
+    }
+    memcpy(out + header, message.payload, message.payload_length);
+    return header + message.payload_length;
+}
+
+size_t mqttEncodePublishHeader(const MqttMessage& message, uint8_t* out, const size_t capacity)
+{
+    const size_t variable = 2 + message.topic_length + (message.qos > 0 ? 2 : 0);
+    const size_t length = variable + message.payload_length;
+    const uint8_t first = static_cast<uint8_t>(MqttPacketType::PUBLISH) << 4 | (message.dup ? 0x08 : 0)
+        | (message.qos & 0x03) << 1 | (message.retain ? 0x01 : 0);
+    // Only the headers have to fit here.
+    const size_t header = 1 + lengthBytes(length);
+    if (header + variable > capacity || putHeader(first, length, out, header + length) == 0)
+    {
+        return 0;
+    }
+    uint8_t* p = putString(out + header, message.topic, message.topic_length);
+    if (message.qos > 0)
+    {
+        putUint16Be(p, message.packet_id);
+    }
+    return header + variable;
+}
+
+size_t mqttEncodePubAck(const uint16_t packet_id, uint8_t* out, const size_t capacity)
+{
+    const size_t header = putHeader(static_cast<uint8_t>(MqttPacketType::PUBACK) << 4, 2, out, capacity);
+    if (header == 0)
+    {
+        return 0;
+    }
+    putUint16Be(out + header, packet_id);
+    return header + 2;
+}
+
+size_t mqttEncodeEmpty(const MqttPacketType type, uint8_t* out, const size_t capacity)
+{
+    return putHeader(static_cast<uint8_t>(type) << 4, 0, out, capacity);
+}
+
+MqttReader::MqttReader() : state_(State::HEADER), header_(0), length_bytes_(0), body_length_(0), received_(0)
+{
+}
+
+size_t MqttReader::feed(const uint8_t* data, const size_t length)
+{
+    size_t used = 0;
+    while (used < length && state_ != State::READY && state_ != State::FAILED)
+    {
+        const uint8_t byte = data[used++];
+        switch (state_)
+        {
+        case State::HEADER:
+            header_ = byte;
+            length_bytes_ = 0;
+            body_length_ = 0;
+            received_ = 0;
+            state_ = State::LENGTH;
+            break;
+        case State::LENGTH:
+            body_length_ |= static_cast<size_t>(byte & 0x7F) << (7 * length_bytes_);
+            if (++length_bytes_ > kMaxLengthBytes)
+            {
+                state_ = State::FAILED;
+            }
+            else if (!(byte & 0x80))
+            {
+                state_ = body_length_ > kMaxPacket ? State::FAILED : body_length_ == 0 ? State::READY : State::BODY;
+            }
+            break;
+        case State::BODY:
+            body_[received_++] = byte;
+            if (received_ == body_length_)
+            {
+                state_ = State::READY;
+            }
+            break;
+        case State::READY:
+        case State::FAILED:
+            break;
+        }
+    }
+    return used;
+}
+
+void MqttReader::next()
+{
+    state_ = State::HEADER;
+}
+
+bool mqttParseConnAck(const uint8_t* body, const size_t length, bool* session_present, uint8_t* return_code)
+{
+    if (length != 2)
+    {
+        return false;
+    }
+    *session_present = body[0] & 0x01;
+    *return_code = body[1];
+    return true;
+}
+
+bool mqttParsePubAck(const uint8_t* body, const size_t length, uint16_t* packet_id)
+{
+    if (length != 2)
+    {
+        return false;
+    }
+    *packet_id = getUint16Be(body);
+    return true;
+}
+
+bool mqttParsePublish(const uint8_t flags, const uint8_t* body, const size_t length, MqttMessage* message)
+{
+    message->qos = (flags >> 1) & 0x03;
+    message->retain = flags & 0x01;
+    message->dup = flags & 0x08;
+    if (length < 2 || message->qos > 2)
+    {
+        return false;
+    }
+    message->topic_length = getUint16Be(body);
+    size_t offset = 2 + message->topic_length;
+    if (offset + (message->qos > 0 ? 2 : 0) > length)
+    {
+        return false;
+    }
+    message->topic = reinterpret_cast<const char*>(body + 2);
+    message->packet_id = 0;
+    if (message->qos > 0)
+    {
+        message->packet_id = getUint16Be(body + offset);
+        offset += 2;
+    }
+    message->payload = body + offset;
+    message->payload_length = length - offset;
+    return true;
+}
+
+bool mqttParseConnect(const uint8_t* body, const size_t length, MqttConnectOptions* options, char* client_id,
+                      const size_t id_capacity)
+{
+    // "MQTT", level, flags, keep-alive, then the client id.
+    if (length < 12 || getUint16Be(body) != 4 || memcmp(body + 2, "MQTT", 4) != 0 || body[6] != kProtocolLevel)
+    {
+        return false;
+    }
+    const size_t id_length = getUint16Be(body + 10);
+    if (12 + id_length > length || id_capacity == 0)
+    {
+        return false;
+    }
+    const size_t copied = id_length < id_capacity - 1 ? id_length : id_capacity - 1;
+    memcpy(client_id, body + 12, copied);
+    client_id[copied] = '\0';
+    options->client_id = client_id;
+    options->clean_session = body[7] & kCleanSessionFlag;
+    options->keep_alive_s = getUint16Be(body + 8);
+    return true;
+}
+
+SocketLink::SocketLink(const char* host, const uint16_t port) : host_(host), port_(port), fd_(-1)
+{
+}
+
+SocketLink::~SocketLink()
+{
+    close();
+}
+
+bool SocketLink::open()
+{
+    close();
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    char service[8];
+    snprintf(service, sizeof(service), "%u", static_cast<unsigned>(port_));
+    addrinfo* addresses = nullptr;
+    if (getaddrinfo(host_, service, &hints, &addresses) != 0 || !addresses)
+    {
+        return false;
+    }
+    fd_ = socket(addresses->ai_family, addresses->ai_socktype, addresses->ai_protocol);
+    bool connected = false;
+    if (fd_ >= 0)
+    {
+        const int flags = fcntl(fd_, F_GETFL, 0);
+        fcntl(fd_, F_SETFL, flags | O_NONBLOCK);
+        const int no_delay = 1;
+        setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+        if (connect(fd_, addresses->ai_addr, addresses->ai_addrlen) == 0)
+        {
+            connected = true;
+        }
+        else if (wouldBlock() && waitFor(fd_, true, kConnectTimeoutMs))
+        {
+            int error = 0;
+            socklen_t length = sizeof(error);
+            connected = getsockopt(fd_, SOL_SOCKET, SO_ERROR, &error, &length) == 0 && error == 0;
+        }
+    }
+    freeaddrinfo(addresses);
+    if (!connected)
+    {
+        close();
+    }
+    return connected;
+}
+
+void SocketLink::close()
+{
+    if (fd_ >= 0)
+    {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+bool SocketLink::write(const uint8_t* data, size_t length)
+{
+    while (length > 0 && fd_ >= 0)
+    {
+        const ssize_t sent = send(fd_, data, length, MSG_NOSIGNAL);
+        if (sent > 0)
+        {
+            data += sent;
+            length -= static_cast<size_t>(sent);
+        }
+        else if (sent < 0 && (!wouldBlock() || !waitFor(fd_, true, kConnectTimeoutMs)))
+        {
+            return false;
+        }
+    }
+    return length == 0;
+}
+
+int SocketLink::read(uint8_t* data, const size_t capacity, const uint32_t timeout_ms)
+{
+    if (fd_ < 0)
+    {
+        return -1;
+    }
+    if (!waitFor(fd_, false, timeout_ms))
+    {
+        return 0;
+    }
+    const ssize_t received = recv(fd_, data, capacity, 0);
+    if (received > 0)
+    {
+        return static_cast<int>(received);
+    }
+    return received < 0 && wouldBlock() ? 0 : -1;
+}
+
+MqttClient::MqttClient(MqttLink& link, const char* client_id, const uint16_t keep_alive_s)
+    : link_(link),
+      client_id_(),
+      keep_alive_s_(keep_alive_s),
+      connected_(false),
+      session_present_(false),
+      next_packet_id_(1),
+      pending_id_(0),
+      pending_hash_(0),
+      last_sent_ms_(0),
+      stats_()
+{
+    snprintf(client_id_, sizeof(client_id_), "%s", client_id);
+}
+
+bool MqttClient::publish(const char* topic, const uint8_t* payload, const size_t length, const uint8_t qos,
+                         const bool retain)
+{
+    if (!connected_ && !connect())
+    {
+        return false;
+    }
+    MqttMessage message = {topic, strlen(topic), payload, length, qos > 0 ? uint8_t(1) : uint8_t(0), retain, false, 0};
+    uint32_t hash = 0;
+    if (message.qos > 0)
+    {
+        hash = fnv1a(fnv1a(kFnv1aBasis, topic, message.topic_length), payload, length);
+        if (pending_id_ != 0 && hash == pending_hash_)
+        {
+            message.packet_id = pending_id_;
+            message.dup = true;
+        }
+        else
+        {
+            message.packet_id = next_packet_id_;
+            // Packet id 0 is not allowed.
+            next_packet_id_ = next_packet_id_ == UINT16_MAX ? 1 : next_packet_id_ + 1;
+        }
+        pending_id_ = message.packet_id;
+        pending_hash_ = hash;
+    }
+    const size_t header = mqttEncodePublishHeader(message, packet_, sizeof(packet_));
+    if (header == 0)
+    {
+        return false;
+    }
+    // With Nagle off every write is a segment, so small payloads go out with their header.
+    if (header + length <= sizeof(packet_))
+    {
+        memcpy(packet_ + header, payload, length);
+        if (!send(packet_, header + length))
+        {
+            return false;
+        }
+    }
+    else if (!send(packet_, header) || !send(payload, length))
+    {
+        return false;
+    }
+    stats_.round_trips++;
+    if (message.qos == 0)
+    {
+        return true;
+    }
+    if (!await(MqttPacketType::PUBACK, message.packet_id))
+    {
+        return false;
+    }
+    pending_id_ = 0;
+    return true;
+}
+
+uint32_t MqttClient::keepAlive()
+{
+    if (!connected_ || keep_alive_s_ == 0)
+    {
+        return UINT32_MAX;
+    }
+    const uint32_t interval_ms = keep_alive_s_ * 1000u;
+    const uint32_t ping_after_ms = interval_ms - interval_ms / 4;
+    const uint32_t idle_ms = nowMs() - last_sent_ms_;
+    if (idle_ms < ping_after_ms)
+    {
+        return ping_after_ms - idle_ms;
+    }
+    uint8_t ping[2];
+    const size_t size = mqttEncodeEmpty(MqttPacketType::PINGREQ, ping, sizeof(ping));
+    if (!send(ping, size))
+    {
+        return UINT32_MAX;
+    }
+    stats_.round_trips++;
+    return await(MqttPacketType::PINGRESP, 0) ? ping_after_ms : UINT32_MAX;
+}
+
+void MqttClient::disconnect()
+{
+    if (connected_)
+    {
+        uint8_t packet[2];
+        send(packet, mqttEncodeEmpty(MqttPacketType::DISCONNECT, packet, sizeof(packet)));
+    }
+    drop();
+}
+
+bool MqttClient::connect()
+{
+    if (!link_.open())
+    {
+        return false;
+    }
+    stats_.connects++;
+    reader_.next();
+    connected_ = true;
+    const MqttConnectOptions options = {client_id_, keep_alive_s_, false};
+    const size_t size = mqttEncodeConnect(options, packet_, sizeof(packet_));
+    if (size == 0 || !send(packet_, size))
+    {
+        return false;
+    }
+    stats_.round_trips++;
+    if (!await(MqttPacketType::CONNACK, 0))
+    {
+        return false;
+    }
+    bool session_present = false;
+    uint8_t code = 0xFF;
+    if (!mqttParseConnAck(reader_.body(), reader_.bodyLength(), &session_present, &code) || code != 0)
+    {
+        drop();
+        return false;
+    }
+    session_present_ = session_present;
+    return true;
+}
+
+bool MqttClient::send(const uint8_t* data, const size_t length)
+{
+    if (!link_.write(data, length))
+    {
+        drop();
+        return false;
+    }
+    stats_.bytes_sent += static_cast<uint32_t>(length);
+    last_sent_ms_ = nowMs();
+    return true;
+}
+
+bool MqttClient::await(const MqttPacketType type, const uint16_t packet_id)
+{
+    const uint32_t started = nowMs();
+    reader_.next();
+    uint8_t chunk[64];
+    size_t available = 0;
+    size_t offset = 0;
+    while (true)
+    {
+        if (offset == available)
+        {
+            const uint32_t waited = nowMs() - started;
+            const int received = waited < kAckTimeoutMs ? link_.read(chunk, sizeof(chunk), kAckTimeoutMs - waited) : 0;
+            if (received <= 0)
+            {
+                // A missing acknowledgement means the connection cannot be trusted either.
+                drop();
+                return false;
+            }
+            stats_.bytes_received += static_cast<uint32_t>(received);
+            available = static_cast<size_t>(received);
+            offset = 0;
+        }
+        offset += reader_.feed(chunk + offset, available - offset);
+        if (reader_.failed())
+        {
+            drop();
+            return false;
+        }
+        if (!reader_.ready())
+        {
+            continue;
+        }
+        uint16_t acked = 0;
+        if (reader_.type() == type
+            && (type != MqttPacketType::PUBACK
+                || (mqttParsePubAck(reader_.body(), reader_.bodyLength(), &acked) && acked == packet_id)))
+        {
+            // The caller reads the packet before the next await; bytes past it are not expected
+            // while one request is in flight.
+            return true;
+        }
+        reader_.next();
+    }
+}
+
+void MqttClient::drop()
+{
+    link_.close();
+    connected_ = false;
+    reader_.next();
+}
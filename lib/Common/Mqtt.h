@@ -0,0 +1,223 @@
+//
+// MQTT 3.1.1 packet codec and a small publishing client over a pluggable byte link.
+//
+
+#ifndef MQTT_H
+#define MQTT_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Transport.h"
+
+enum class MqttPacketType : uint8_t
+{
+    CONNECT = 1,
+    CONNACK = 2,
+    PUBLISH = 3,
+    PUBACK = 4,
+    PINGREQ = 12,
+    PINGRESP = 13,
+    DISCONNECT = 14,
+};
+
+struct MqttConnectOptions
+{
+    const char* client_id;
+    uint16_t keep_alive_s;
+    // False asks the broker to keep the session (and its QoS 1 messages) across connections.
+    bool clean_session;
+};
+
+// A PUBLISH packet's contents. Decoding points into the packet, so it lives as long as the reader's
+// current packet.
+struct MqttMessage
+{
+    const char* topic;
+    size_t topic_length;
+    const uint8_t* payload;
+    size_t payload_length;
+    uint8_t qos;
+    bool retain;
+    bool dup;
+    uint16_t packet_id;
+};
+
+// Encoders write one whole packet and return its size, or 0 if it does not fit in `capacity`.
+size_t mqttEncodeConnect(const MqttConnectOptions& options, uint8_t* out, size_t capacity);
+size_t mqttEncodeConnAck(bool session_present, uint8_t return_code, uint8_t* out, size_t capacity);
+size_t mqttEncodePublish(const MqttMessage& message, uint8_t* out, size_t capacity);
+// Everything of a PUBLISH before its payload, for sending large payloads without copying them.
+size_t mqttEncodePublishHeader(const MqttMessage& message, uint8_t* out, size_t capacity);
+size_t mqttEncodePubAck(uint16_t packet_id, uint8_t* out, size_t capacity);
+// PINGREQ, PINGRESP and DISCONNECT have no body.
+size_t mqttEncodeEmpty(MqttPacketType type, uint8_t* out, size_t capacity);
+
+// Splits a byte stream into packets, however it is chunked. Packets larger than kMaxPacket or with
+// a malformed length fail the reader; the connection should be dropped then.
+class MqttReader
+{
+public:
+    static constexpr size_t kMaxPacket = 512;
+
+    MqttReader();
+
+    // Consumes bytes up to the end of the next packet and returns how many it used; feed the rest
+    // after next().
+    size_t feed(const uint8_t* data, size_t length);
+
+    bool ready() const
+    {
+        return state_ == State::READY;
+    }
+
+    bool failed() const
+    {
+        return state_ == State::FAILED;
+    }
+
+    MqttPacketType type() const
+    {
+        return static_cast<MqttPacketType>(header_ >> 4);
+    }
+
+    uint8_t flags() const
+    {
+        return header_ & 0x0F;
+    }
+
+    const uint8_t* body() const
+    {
+        return body_;
+    }
+
+    size_t bodyLength() const
+    {
+        return body_length_;
+    }
+
+    // Drops the current packet (or a failure) and starts on the next one.
+    void next();
+
+private:
+    enum class State : uint8_t
+    {
+        HEADER,
+        LENGTH,
+        BODY,
+        READY,
+        FAILED,
+    };
+
+    State state_;
+    uint8_t header_;
+    uint8_t length_bytes_;
+    size_t body_length_;
+    size_t received_;
+    uint8_t body_[kMaxPacket];
+};
+
+bool mqttParseConnAck(const uint8_t* body, size_t length, bool* session_present, uint8_t* return_code);
+bool mqttParsePubAck(const uint8_t* body, size_t length, uint16_t* packet_id);
+bool mqttParsePublish(uint8_t flags, const uint8_t* body, size_t length, MqttMessage* message);
+// For broker stand-ins. The client id is copied, truncated to `id_capacity`.
+bool mqttParseConnect(const uint8_t* body, size_t length, MqttConnectOptions* options, char* client_id,
+                      size_t id_capacity);
+
+// A byte stream to the broker.
+class MqttLink
+{
+public:
+    virtual ~MqttLink() = default;
+
+    virtual bool open() = 0;
+    virtual void close() = 0;
+    // Writes all of `data`; false if the connection failed.
+    virtual bool write(const uint8_t* data, size_t length) = 0;
+    // Reads what is available, waiting up to `timeout_ms`: the byte count, 0 on timeout, -1 once the
+    // connection is gone.
+    virtual int read(uint8_t* data, size_t capacity, uint32_t timeout_ms) = 0;
+};
+
+// TCP over BSD sockets: lwIP on the ESP32, the host's on Linux. Nagle is off, since every packet
+// is waited on anyway.
+class SocketLink final : public MqttLink
+{
+public:
+    static constexpr uint32_t kConnectTimeoutMs = 5000;
+
+    // `host` must outlive the link.
+    SocketLink(const char* host, uint16_t port);
+    ~SocketLink() override;
+
+    bool open() override;
+    void close() override;
+    bool write(const uint8_t* data, size_t length) override;
+    int read(uint8_t* data, size_t capacity, uint32_t timeout_ms) override;
+
+private:
+    const char* host_;
+    uint16_t port_;
+    int fd_;
+};
+
+// Publishes over one persistent connection, opened on first use and reopened after a failure,
+// with the session kept by the broker (clean session off). QoS 1 publishes wait for their PUBACK;
+// one that is not acknowledged is resent with the same packet id and DUP set when the same
+// topic and payload are published again, so the broker can tell it is a retry.
+class MqttClient
+{
+public:
+    static constexpr uint32_t kAckTimeoutMs = 3000;
+
+    // `client_id` is copied (up to 23 characters, the limit every broker accepts).
+    MqttClient(MqttLink& link, const char* client_id, uint16_t keep_alive_s);
+
+    // True once sent (QoS 0) or acknowledged (QoS 1).
+    bool publish(const char* topic, const uint8_t* payload, size_t length, uint8_t qos, bool retain);
+
+    // Pings the broker if the connection would otherwise lapse within a quarter of the keep-alive.
+    // Returns milliseconds until it next needs to be called (UINT32_MAX while disconnected).
+    uint32_t keepAlive();
+
+    void disconnect();
+
+    bool connected() const
+    {
+        return connected_;
+    }
+
+    // Whether the broker still had our session at the last connect.
+    bool sessionPresent() const
+    {
+        return session_present_;
+    }
+
+    const TransportStats& stats() const
+    {
+        return stats_;
+    }
+
+private:
+    MqttLink& link_;
+    char client_id_[24];
+    uint16_t keep_alive_s_;
+    bool connected_;
+    bool session_present_;
+    uint16_t next_packet_id_;
+    // The unacknowledged QoS 1 publish, if any: its packet id and a hash of its topic and payload.
+    uint16_t pending_id_;
+    uint32_t pending_hash_;
+    uint32_t last_sent_ms_;
+    MqttReader reader_;
+    uint8_t packet_[MqttReader::kMaxPacket];
+    TransportStats stats_;
+
+    bool connect();
+    bool send(const uint8_t* data, size_t length);
+    // Reads until a packet of `type` (with `packet_id`, for PUBACK) arrives, skipping others.
+    bool await(MqttPacketType type, uint16_t packet_id);
+    void drop();
+};
+
+#endif //MQTT_H
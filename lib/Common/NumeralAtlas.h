@@ -0,0 +1,75 @@
+//
+// Fixed geometry of the large 7-segment numerals (font 7), shared by the layout and the glyph atlas.
+//
+
+#ifndef NUMERALATLAS_H
+#define NUMERALATLAS_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace numeral_atlas
+{
+constexpr uint8_t kFont = 7;
+constexpr int16_t kDigitWidth = 32;
+constexpr int16_t kColonWidth = 12;
+constexpr int16_t kHeight = 48;
+
+// One row holds "0123456789:" side by side.
+constexpr int16_t kRowWidth = 10 * kDigitWidth + kColonWidth;
+
+constexpr bool contains(const char c)
+{
+    return (c >= '0' && c <= '9') || c == ':';
+}
+
+constexpr int16_t glyphWidth(const char c)
+{
+    return c == ':' ? kColonWidth : kDigitWidth;
+}
+
+// Left edge of glyph `c` within the atlas row.
+constexpr int16_t atlasX(const char c)
+{
+    return c == ':' ? static_cast<int16_t>(10 * kDigitWidth) : static_cast<int16_t>((c - '0') * kDigitWidth);
+}
+
+// Left edge of cell `i` of `pattern`, relative to the start of the text.
+constexpr int16_t cellOffset(const char* pattern, const size_t i)
+{
+    return i == 0 ? 0 : static_cast<int16_t>(cellOffset(pattern, i - 1) + glyphWidth(pattern[i - 1]));
+}
+
+// The two numeral lines ClockFace draws: wall clock and countdown.
+constexpr const char kClockPattern[] = "00:00:00";
+constexpr const char kCountdownPattern[] = "00:00";
+constexpr size_t kClockLength = sizeof(kClockPattern) - 1;
+constexpr size_t kCountdownLength = sizeof(kCountdownPattern) - 1;
+
+constexpr int16_t kClockCells[kClockLength + 1] = {
+    cellOffset(kClockPattern, 0), cellOffset(kClockPattern, 1), cellOffset(kClockPattern, 2),
+    cellOffset(kClockPattern, 3), cellOffset(kClockPattern, 4), cellOffset(kClockPattern, 5),
+    cellOffset(kClockPattern, 6), cellOffset(kClockPattern, 7), cellOffset(kClockPattern, 8),
+};
+constexpr int16_t kCountdownCells[kCountdownLength + 1] = {
+    cellOffset(kCountdownPattern, 0), cellOffset(kCountdownPattern, 1), cellOffset(kCountdownPattern, 2),
+    cellOffset(kCountdownPattern, 3), cellOffset(kCountdownPattern, 4), cellOffset(kCountdownPattern, 5),
+};
+static_assert(kClockCells[kClockLength] == 6 * kDigitWidth + 2 * kColonWidth, "clock line width");
+static_assert(kCountdownCells[kCountdownLength] == 4 * kDigitWidth + kColonWidth, "countdown line width");
+
+// True if `text` has the shape of `pattern`: digits where it has digits, ':' where it has ':'.
+inline bool matches(const char* text, const char* pattern)
+{
+    for (; *pattern; text++, pattern++)
+    {
+        if (*pattern == ':' ? *text != ':' : !(*text >= '0' && *text <= '9'))
+        {
+            return false;
+        }
+    }
+    return *text == '\0';
+}
+}
+
+#endif //NUMERALATLAS_H
@@ -0,0 +1,55 @@
+//
+// PomodoroObserver decorator that records how long each notification takes.
+//
+
+#include "ObserverProbe.h"
+
+#include "Trace.h"
+
+ObserverProbe::ObserverProbe(const char* metric_name, PomodoroObserver& target, const uint32_t budget_us)
+    : target_(target),
+      latency_(metric_name, budget_us)
+{
+}
+
+void ObserverProbe::notification(const ClockUpdate update)
+{
+    TraceScope trace(latency_.name());
+    ScopedMetric timing(latency_);
+    target_.notification(update);
+}
+
+void ObserverProbe::notification(const IdleToWork update)
+{
+    TraceScope trace(latency_.name());
+    ScopedMetric timing(latency_);
+    target_.notification(update);
+}
+
+void ObserverProbe::notification(const WorkToBreak update)
+{
+    TraceScope trace(latency_.name());
+    ScopedMetric timing(latency_);
+    target_.notification(update);
+}
+
+void ObserverProbe::notification(const BreakToIdle update)
+{
+    TraceScope trace(latency_.name());
+    ScopedMetric timing(latency_);
+    target_.notification(update);
+}
+
+void ObserverProbe::notification(const WorkToIdle update)
+{
+    TraceScope trace(latency_.name());
+    ScopedMetric timing(latency_);
+    target_.notification(update);
+}
+
+void ObserverProbe::notification(const AdditionalWork update)
+{
+    TraceScope trace(latency_.name());
+    ScopedMetric timing(latency_);
+    target_.notification(update);
+}
@@ -0,0 +1,38 @@
+//
+// PomodoroObserver decorator that records how long each notification takes.
+//
+
+#ifndef OBSERVERPROBE_H
+#define OBSERVERPROBE_H
+
+#include "Metrics.h"
+#include "Pomodoro.h"
+
+// Registered with the clock in place of `target`, forwards every notification to it and records
+// the time it took in a histogram named `metric_name` (e.g. "notify_us.display") and as a trace
+// span of the same name, so `metric_name` should be a string literal. The clock notifies
+// observers one after the other, so a slow one delays all those after it. `budget_us`, if
+// non-zero, is how long one notification may take; longer ones are counted as overruns.
+class ObserverProbe final : public PomodoroObserver
+{
+public:
+    ObserverProbe(const char* metric_name, PomodoroObserver& target, uint32_t budget_us = 0);
+
+    void notification(ClockUpdate update) override;
+    void notification(IdleToWork update) override;
+    void notification(WorkToBreak update) override;
+    void notification(BreakToIdle update) override;
+    void notification(WorkToIdle update) override;
+    void notification(AdditionalWork update) override;
+
+    const Histogram& latency() const
+    {
+        return latency_;
+    }
+
+private:
+    PomodoroObserver& target_;
+    Histogram latency_;
+};
+
+#endif //OBSERVERPROBE_H
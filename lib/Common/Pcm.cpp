@@ -0,0 +1,245 @@
+//
+// WAV parsing, resampling and mixing of short PCM cues, all in 16-bit mono.
+//
+
+#include "Pcm.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+uint16_t get16(const uint8_t* in)
+{
+    return static_cast<uint16_t>(in[0] | (in[1] << 8));
+}
+
+uint32_t get32(const uint8_t* in)
+{
+    return get16(in) | (static_cast<uint32_t>(get16(in + 2)) << 16);
+}
+
+// Sample `frame` of `info` as mono 16-bit.
+int32_t monoSample(const WavInfo& info, const size_t frame)
+{
+    const uint8_t* p = info.data + frame * info.channels * (info.bits_per_sample / 8);
+    int32_t sum = 0;
+    for (uint16_t channel = 0; channel < info.channels; channel++)
+    {
+        if (info.bits_per_sample == 8)
+        {
+            sum += (static_cast<int32_t>(p[channel]) - 128) << 8;
+        }
+        else
+        {
+            sum += static_cast<int16_t>(get16(p + channel * 2));
+        }
+    }
+    return info.channels == 2 ? sum >> 1 : sum;
+}
+
+int16_t saturate(const int32_t value)
+{
+    return static_cast<int16_t>(value > INT16_MAX ? INT16_MAX : (value < INT16_MIN ? INT16_MIN : value));
+}
+}
+
+bool parseWav(const uint8_t* file, const size_t size, WavInfo* out)
+{
+    if (size < 12 || memcmp(file, "RIFF", 4) != 0 || memcmp(file + 8, "WAVE", 4) != 0)
+    {
+        return false;
+    }
+    bool has_format = false;
+    size_t offset = 12;
+    while (offset + 8 <= size)
+    {
+        const uint8_t* chunk = file + offset;
+        const uint32_t length = get32(chunk + 4);
+        const size_t available = size - offset - 8;
+        if (memcmp(chunk, "fmt ", 4) == 0)
+        {
+            if (length < 16 || available < 16 || get16(chunk + 8) != 1)
+            {
+                return false;
+            }
+            out->channels = get16(chunk + 10);
+            out->sample_rate = get32(chunk + 12);
+            out->bits_per_sample = get16(chunk + 22);
+            has_format = (out->channels == 1 || out->channels == 2)
+                && (out->bits_per_sample == 8 || out->bits_per_sample == 16) && out->sample_rate > 0;
+            if (!has_format)
+            {
+                return false;
+            }
+        }
+        else if (memcmp(chunk, "data", 4) == 0)
+        {
+            if (!has_format)
+            {
+                return false;
+            }
+            // A data chunk cut short (e.g. a truncated download) is still playable up to its end.
+            const size_t bytes = length < available ? length : available;
+            out->data = chunk + 8;
+            out->frames = bytes / (out->channels * (out->bits_per_sample / 8));
+            return true;
+        }
+        // Chunks are padded to an even length.
+        offset += 8 + static_cast<size_t>(length) + (length & 1);
+    }
+    return false;
+}
+
+size_t resampledFrames(const WavInfo& info, const uint32_t rate, const size_t max_frames)
+{
+    const uint64_t frames = static_cast<uint64_t>(info.frames) * rate / info.sample_rate;
+    return frames < max_frames ? static_cast<size_t>(frames) : max_frames;
+}
+
+size_t resampleToMono16(const WavInfo& info, const uint32_t rate, int16_t* out, const size_t capacity)
+{
+    const size_t frames = resampledFrames(info, rate, capacity);
+    if (info.frames == 0)
+    {
+        return 0;
+    }
+    // Source position in Q16 frames.
+    const uint64_t step = (static_cast<uint64_t>(info.sample_rate) << 16) / rate;
+    uint64_t position = 0;
+    if (info.channels == 1 && info.bits_per_sample == 16 && step == (1u << 16))
+    {
+        for (size_t i = 0; i < frames; i++)
+        {
+            out[i] = static_cast<int16_t>(get16(info.data + i * 2));
+        }
+        return frames;
+    }
+    for (size_t i = 0; i < frames; i++, position += step)
+    {
+        const size_t index = static_cast<size_t>(position >> 16);
+        const int32_t fraction = static_cast<int32_t>(position & 0xFFFF);
+        const int32_t a = monoSample(info, index);
+        const int32_t b = index + 1 < info.frames ? monoSample(info, index + 1) : a;
+        out[i] = saturate(a + static_cast<int32_t>((static_cast<int64_t>(b - a) * fraction) >> 16));
+    }
+    return frames;
+}
+
+void synthesizeTone(int16_t* out, const size_t frames, const uint32_t rate, const uint32_t frequency_hz,
+                    const int16_t amplitude, const uint32_t half_life_ms)
+{
+    // Runs once per cue at boot, so plain floating point is fine here.
+    const double decay = std::pow(0.5, 1000.0 / (static_cast<double>(half_life_ms) * rate));
+    const double omega = 2.0 * 3.14159265358979323846 * frequency_hz / rate;
+    double envelope = amplitude;
+    for (size_t i = 0; i < frames; i++)
+    {
+        out[i] = saturate(static_cast<int32_t>(envelope * std::sin(omega * static_cast<double>(i))));
+        envelope *= decay;
+    }
+}
+
+CueMixer::CueMixer()
+{
+    for (PcmCue& cue : cues_)
+    {
+        cue = {nullptr, 0, 0};
+    }
+    for (Voice& voice : voices_)
+    {
+        voice = {nullptr, 0};
+    }
+}
+
+void CueMixer::setCue(const uint8_t id, const PcmCue& cue)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (id < kMaxCues)
+    {
+        cues_[id] = cue;
+    }
+}
+
+bool CueMixer::trigger(const uint8_t id)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (id >= kMaxCues || !cues_[id].samples || cues_[id].frames == 0)
+    {
+        return false;
+    }
+    Voice* chosen = nullptr;
+    size_t least_left = SIZE_MAX;
+    for (Voice& voice : voices_)
+    {
+        if (!voice.cue)
+        {
+            chosen = &voice;
+            break;
+        }
+        const size_t left = voice.cue->frames - voice.position;
+        if (left < least_left)
+        {
+            least_left = left;
+            chosen = &voice;
+        }
+    }
+    chosen->cue = &cues_[id];
+    chosen->position = 0;
+    return true;
+}
+
+bool CueMixer::mix(int16_t* out, const size_t frames)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    bool playing = false;
+    int32_t sum[64];
+    for (size_t done = 0; done < frames;)
+    {
+        const size_t block = frames - done < 64 ? frames - done : 64;
+        for (size_t i = 0; i < block; i++)
+        {
+            sum[i] = 0;
+        }
+        for (Voice& voice : voices_)
+        {
+            if (!voice.cue)
+            {
+                continue;
+            }
+            playing = true;
+            const size_t left = voice.cue->frames - voice.position;
+            const size_t count = left < block ? left : block;
+            const int16_t* samples = voice.cue->samples + voice.position;
+            const int32_t gain = voice.cue->gain;
+            for (size_t i = 0; i < count; i++)
+            {
+                sum[i] += (samples[i] * gain) >> 8;
+            }
+            voice.position += count;
+            if (voice.position >= voice.cue->frames)
+            {
+                voice.cue = nullptr;
+            }
+        }
+        for (size_t i = 0; i < block; i++)
+        {
+            out[done + i] = saturate(sum[i]);
+        }
+        done += block;
+    }
+    return playing;
+}
+
+bool CueMixer::active() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const Voice& voice : voices_)
+    {
+        if (voice.cue)
+        {
+            return true;
+        }
+    }
+    return false;
+}
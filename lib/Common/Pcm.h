@@ -0,0 +1,80 @@
+//
+// WAV parsing, resampling and mixing of short PCM cues, all in 16-bit mono.
+//
+
+#ifndef PCM_H
+#define PCM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+// The PCM payload of a RIFF/WAVE file. `data` points into the parsed buffer.
+struct WavInfo
+{
+    uint16_t channels;
+    uint32_t sample_rate;
+    uint16_t bits_per_sample;
+    const uint8_t* data;
+    size_t frames;
+};
+
+// Accepts uncompressed PCM (format 1) with 8 or 16 bits and 1 or 2 channels; unknown chunks are
+// skipped. Returns false for anything else. A truncated data chunk is cut to the frames present.
+bool parseWav(const uint8_t* file, size_t size, WavInfo* out);
+
+// Frames produced by resampling `info` to `rate`, capped at `max_frames`.
+size_t resampledFrames(const WavInfo& info, uint32_t rate, size_t max_frames = SIZE_MAX);
+
+// Converts `info` to 16-bit mono at `rate` (stereo is averaged, linear interpolation in Q16
+// fixed point) and writes at most `capacity` frames. Returns the number written. Resampling to
+// rate / k and playing the result at `rate` raises the pitch by k.
+size_t resampleToMono16(const WavInfo& info, uint32_t rate, int16_t* out, size_t capacity);
+
+// A decaying sine tone, e.g. for a chime: `frames` samples at `rate`, starting at `amplitude`
+// (Q15 full scale) and falling by half every `half_life_ms`.
+void synthesizeTone(int16_t* out, size_t frames, uint32_t rate, uint32_t frequency_hz, int16_t amplitude,
+                    uint32_t half_life_ms);
+
+struct PcmCue
+{
+    const int16_t* samples;
+    size_t frames;
+    // Q8 gain, 256 = unity.
+    uint16_t gain;
+};
+
+// Plays up to kVoices cues at once from a table of decoded cues. trigger() may be called from any
+// task; mix() is meant for the single audio task.
+class CueMixer
+{
+public:
+    static constexpr size_t kMaxCues = 8;
+    static constexpr size_t kVoices = 4;
+
+    CueMixer();
+
+    void setCue(uint8_t id, const PcmCue& cue);
+
+    // Starts cue `id`. With every voice busy, the voice closest to its end is replaced.
+    bool trigger(uint8_t id);
+
+    // Writes `frames` samples of the sum of all active voices, saturating at 16 bits, and advances
+    // them. Returns false, writing silence, if nothing was playing.
+    bool mix(int16_t* out, size_t frames);
+
+    bool active() const;
+
+private:
+    struct Voice
+    {
+        const PcmCue* cue;
+        size_t position;
+    };
+
+    mutable std::mutex mutex_;
+    PcmCue cues_[kMaxCues];
+    Voice voices_[kVoices];
+};
+
+#endif //PCM_H
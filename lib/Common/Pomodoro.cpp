@@ -6,12 +6,24 @@
 
 #include <cstdlib>
 
+#include "Metrics.h"
+#include "PostMortem.h"
+#include "Trace.h"
+
 #if defined(ARDUINO_ARCH_ESP32)
 #include <esp_system.h>
 #endif
 
+namespace
+{
+// Seconds left before the watchdog would restart the device; its minimum is the closest call.
+Gauge watchdog_margin("watchdog.margin_s");
+}
+
 bool PomodoroClock::StartWork(const uint8_t flavor, const time_t work_duration, const time_t break_duration, const time_t now)
 {
+    TRACE_SCOPE("clock.start_work");
+    Record({ClockInputKind::START_WORK, now, work_duration, flavor, break_duration, IDLE, 0});
     if (state_ != IDLE)
     {
         return false;
@@ -24,12 +36,14 @@ bool PomodoroClock::StartWork(const uint8_t flavor, const time_t work_duration,
     break_duration_ = break_duration;
     const IdleToWork update = {work_flavor_, now};
     notify_observers(update);
-    PassageOfTime(now);
+    Advance(now);
     return true;
 }
 
 bool PomodoroClock::ExtendWork(const time_t additional_work_duration, const time_t now)
 {
+    TRACE_SCOPE("clock.extend_work");
+    Record({ClockInputKind::EXTEND_WORK, now, additional_work_duration, 0, 0, IDLE, 0});
     if (state_ != WORK)
     {
         return false;
@@ -38,17 +52,19 @@ bool PomodoroClock::ExtendWork(const time_t additional_work_duration, const time
     const AdditionalWork update = {now, work_flavor_, state_ends_at_};
     last_update_at_ = now;
     notify_observers(update);
-    PassageOfTime(now);
+    Advance(now);
     return true;
 }
 
 bool PomodoroClock::CycleFlavor(const time_t now)
 {
+    TRACE_SCOPE("clock.cycle_flavor");
+    Record({ClockInputKind::CYCLE_FLAVOR, now, 0, 0, 0, IDLE, 0});
     if (state_ != WORK)
     {
         return false;
     }
-    work_flavor_ = (work_flavor_ + 1) % 3;
+    work_flavor_ = (work_flavor_ + 1) % flavor_count_;
     last_update_at_ = now;
     ClockUpdate update = {now, state_, work_flavor_, state_ends_at_ - now};
     notify_observers(update);
@@ -57,6 +73,8 @@ bool PomodoroClock::CycleFlavor(const time_t now)
 
 bool PomodoroClock::Cancel(const time_t now)
 {
+    TRACE_SCOPE("clock.cancel");
+    Record({ClockInputKind::CANCEL, now, 0, 0, 0, IDLE, 0});
     bool result;
     const WorkToIdle work_to_idle = {now, now - last_state_change_at_};
     const BreakToIdle break_to_idle = {now, now - last_state_change_at_};
@@ -80,12 +98,24 @@ bool PomodoroClock::Cancel(const time_t now)
     default:
         result = false;
     }
-    PassageOfTime(now);
+    Advance(now);
     return result;
 }
 
+void PomodoroClock::SetFlavorCount(const uint8_t count)
+{
+    flavor_count_ = count < 1 ? 1 : count > MAX_WORK_FLAVORS ? MAX_WORK_FLAVORS : count;
+}
+
 void PomodoroClock::PassageOfTime(const time_t now)
 {
+    Record({ClockInputKind::TICK, now, 0, 0, 0, IDLE, 0});
+    Advance(now);
+}
+
+void PomodoroClock::Advance(const time_t now)
+{
+    TRACE_SCOPE("clock.tick");
     bool state_change = (state_ends_at_ != 0) && (now >= state_ends_at_);
     const WorkToBreak work_to_break = {now, state_ends_at_ - last_state_change_at_};
     const BreakToIdle break_to_idle = {now, state_ends_at_ - last_state_change_at_};
@@ -115,6 +145,100 @@ void PomodoroClock::PassageOfTime(const time_t now)
     notify_observers(update);
 }
 
+PomodoroSnapshot PomodoroClock::Snapshot() const
+{
+    if (state_ == IDLE)
+    {
+        return {IDLE, 0, 0, 0};
+    }
+    return {state_, work_flavor_, state_ends_at_, break_duration_};
+}
+
+void PomodoroClock::Adopt(const PomodoroSnapshot& snapshot, const time_t now)
+{
+    TRACE_SCOPE("clock.adopt");
+    Record({ClockInputKind::ADOPT, now, 0, snapshot.work_flavor, snapshot.break_duration, snapshot.state,
+            snapshot.state_ends_at});
+    const PomodoroState from = state_;
+    const time_t in_state = now - last_state_change_at_;
+    const time_t previous_end = state_ends_at_;
+    state_ = snapshot.state;
+    work_flavor_ = snapshot.state != IDLE ? snapshot.work_flavor : 0;
+    state_ends_at_ = snapshot.state != IDLE ? snapshot.state_ends_at : 0;
+    if (snapshot.state != IDLE)
+    {
+        break_duration_ = snapshot.break_duration;
+    }
+    if (from != state_)
+    {
+        last_state_change_at_ = now;
+    }
+    last_update_at_ = now;
+
+    // Observers see the new state whichever transition they are told about.
+    if (from == WORK && state_ == BREAK)
+    {
+        notify_observers(WorkToBreak{now, in_state});
+    }
+    else if (from == WORK && state_ == IDLE)
+    {
+        notify_observers(WorkToIdle{now, in_state});
+    }
+    else if (from == BREAK && state_ != BREAK)
+    {
+        notify_observers(BreakToIdle{now, in_state});
+    }
+    if (from != WORK && state_ == WORK)
+    {
+        notify_observers(IdleToWork{work_flavor_, now});
+    }
+    else if (from == WORK && state_ == WORK && state_ends_at_ > previous_end)
+    {
+        notify_observers(AdditionalWork{now, work_flavor_, state_ends_at_});
+    }
+    Advance(now);
+}
+
+void PomodoroClock::Apply(const ClockInput& input)
+{
+    switch (input.kind)
+    {
+    case ClockInputKind::TICK:
+        PassageOfTime(input.now);
+        break;
+    case ClockInputKind::START_WORK:
+        StartWork(input.work_flavor, input.duration, input.break_duration, input.now);
+        break;
+    case ClockInputKind::EXTEND_WORK:
+        ExtendWork(input.duration, input.now);
+        break;
+    case ClockInputKind::CYCLE_FLAVOR:
+        CycleFlavor(input.now);
+        break;
+    case ClockInputKind::CANCEL:
+        Cancel(input.now);
+        break;
+    case ClockInputKind::ADOPT:
+        Adopt({input.state, input.work_flavor, input.state_ends_at, input.break_duration}, input.now);
+        break;
+    }
+}
+
+PomodoroClockState PomodoroClock::SaveState() const
+{
+    return {last_update_at_, last_state_change_at_, state_ends_at_, work_flavor_, state_, break_duration_};
+}
+
+void PomodoroClock::RestoreState(const PomodoroClockState& state)
+{
+    last_update_at_ = state.last_update_at;
+    last_state_change_at_ = state.last_state_change_at;
+    state_ends_at_ = state.state_ends_at;
+    work_flavor_ = state.work_flavor;
+    state_ = state.state;
+    break_duration_ = state.break_duration;
+}
+
 PomodoroWatchdog::PomodoroWatchdog(const time_t timeout_seconds)
     : timeout_seconds_(timeout_seconds),
       last_update_(0)
@@ -123,7 +247,7 @@ PomodoroWatchdog::PomodoroWatchdog(const time_t timeout_seconds)
 #endif
 {
 #if defined(ARDUINO_ARCH_ESP32)
-    xTaskCreatePinnedToCore(taskTrampoline, "PomodoroWatchdog", 2048, this, 1, &task_, 0);
+    xTaskCreatePinnedToCore(taskTrampoline, "PomodoroWatchdog", 3072, this, 1, &task_, 0);
 #endif
 }
 
@@ -174,8 +298,14 @@ void PomodoroWatchdog::check(const time_t now)
     {
         return;
     }
+    watchdog_margin.set(static_cast<int32_t>(timeout_seconds_ - (now - last)));
     if (now - last > timeout_seconds_)
     {
+        // Reported by the next boot: what each task was in the middle of, from the trace. Static:
+        // it is too big for the watchdog task's stack, and this runs once.
+        static PostMortem record;
+        capturePostMortem(tracer(), now, static_cast<uint32_t>(now - last), &record);
+        savePostMortem(record);
 #if defined(ARDUINO_ARCH_ESP32)
         esp_restart();
 #else
@@ -63,14 +63,80 @@ struct AdditionalWork
 
 typedef etl::observer<ClockUpdate, IdleToWork, WorkToBreak, BreakToIdle, WorkToIdle, AdditionalWork> PomodoroObserver;
 
-constexpr int MAX_POMODORO_OBSERVERS = 6;
+constexpr int MAX_POMODORO_OBSERVERS = 12;
+// Flavors config.ini can declare, and how many a clock cycles through until told otherwise.
+constexpr uint8_t MAX_WORK_FLAVORS = 8;
+constexpr uint8_t DEFAULT_WORK_FLAVORS = 3;
 constexpr time_t WORK_DEFAULT_DURATION_SECONDS = 25 * 60;
 constexpr time_t BREAK_DEFAULT_DURATION_SECONDS = 5 * 60;
 
+// Everything that decides how a clock runs from here on; what LAN peers exchange to mirror one.
+struct PomodoroSnapshot
+{
+    PomodoroState state;
+    // All 0 when idle.
+    uint8_t work_flavor;
+    time_t state_ends_at;
+    time_t break_duration;
+};
+
+// All of a clock's state, for putting it back exactly as it was (a journal replay starts from one).
+struct PomodoroClockState
+{
+    time_t last_update_at;
+    time_t last_state_change_at;
+    time_t state_ends_at;
+    uint8_t work_flavor;
+    PomodoroState state;
+    time_t break_duration;
+};
+
+enum class ClockInputKind : uint8_t
+{
+    TICK,
+    START_WORK,
+    EXTEND_WORK,
+    CYCLE_FLAVOR,
+    CANCEL,
+    ADOPT,
+};
+
+// One call that moves a clock, with its arguments. Fields a kind does not use are 0.
+struct ClockInput
+{
+    ClockInputKind kind;
+    time_t now;
+    // START_WORK: the work period. EXTEND_WORK: the extension.
+    time_t duration;
+    // START_WORK and ADOPT.
+    uint8_t work_flavor;
+    time_t break_duration;
+    // ADOPT.
+    PomodoroState state;
+    time_t state_ends_at;
+};
+
+// Told about every input before the clock acts on it.
+class PomodoroRecorder
+{
+public:
+    virtual ~PomodoroRecorder() = default;
+
+    virtual void record(const ClockInput& input) = 0;
+};
+
 class PomodoroClock : public etl::observable<PomodoroObserver, MAX_POMODORO_OBSERVERS>
 {
 public:
-    explicit PomodoroClock() : last_update_at_(0), last_state_change_at_(0), state_ends_at_(0), state_(IDLE)
+    explicit PomodoroClock()
+        : last_update_at_(0),
+          last_state_change_at_(0),
+          state_ends_at_(0),
+          work_flavor_(0),
+          state_(IDLE),
+          break_duration_(BREAK_DEFAULT_DURATION_SECONDS),
+          flavor_count_(DEFAULT_WORK_FLAVORS),
+          recorder_(nullptr)
     {
     }
 
@@ -80,11 +146,39 @@ public:
     bool Cancel(time_t now = time(nullptr));
     void PassageOfTime(time_t now = time(nullptr));
 
+    PomodoroSnapshot Snapshot() const;
+    // Moves to `snapshot` as of `now`, notifying the transitions that implies (work cut short, a
+    // cancel, a start, more work) and then a ClockUpdate. Joining a break from idle has no
+    // transition; it only shows in the ClockUpdate.
+    void Adopt(const PomodoroSnapshot& snapshot, time_t now = time(nullptr));
+
+    // Calls the method `input` was recorded from.
+    void Apply(const ClockInput& input);
+
+    PomodoroClockState SaveState() const;
+    // Puts the state back without notifying anyone.
+    void RestoreState(const PomodoroClockState& state);
+
+    // Null stops recording. Only the calls made from outside the clock are recorded.
+    void SetRecorder(PomodoroRecorder* recorder)
+    {
+        recorder_ = recorder;
+    }
+
     inline PomodoroState State() const
     {
         return state_;
     }
 
+    // How many flavors CycleFlavor goes through, 1 to MAX_WORK_FLAVORS. Set before the first input:
+    // a journal records it once, at the start.
+    void SetFlavorCount(uint8_t count);
+
+    inline uint8_t FlavorCount() const
+    {
+        return flavor_count_;
+    }
+
 private:
     time_t last_update_at_;
     time_t last_state_change_at_;
@@ -92,6 +186,18 @@ private:
     uint8_t work_flavor_;
     PomodoroState state_;
     time_t break_duration_;
+    uint8_t flavor_count_;
+    PomodoroRecorder* recorder_;
+
+    void Record(const ClockInput& input)
+    {
+        if (recorder_)
+        {
+            recorder_->record(input);
+        }
+    }
+
+    void Advance(time_t now);
 };
 
 class PomodoroWatchdog final : public PomodoroObserver
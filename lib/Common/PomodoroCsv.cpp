@@ -0,0 +1,142 @@
+//
+// Allocation-free parser for the pomodoro.csv format written by Logger.
+//
+
+#include "PomodoroCsv.h"
+
+#include <cstring>
+
+#include "History.h"
+
+namespace
+{
+inline bool digit(const char c, unsigned* value)
+{
+    *value = static_cast<unsigned char>(c) - static_cast<unsigned>('0');
+    return *value < 10;
+}
+
+inline bool twoDigits(const char* p, unsigned* value)
+{
+    unsigned hi, lo;
+    if (!digit(p[0], &hi) || !digit(p[1], &lo))
+    {
+        return false;
+    }
+    *value = hi * 10 + lo;
+    return true;
+}
+
+bool parseDate(const char* p, int32_t* day)
+{
+    unsigned century, year, month, mday;
+    if (!twoDigits(p, &century) || !twoDigits(p + 2, &year) || p[4] != '-'
+        || !twoDigits(p + 5, &month) || p[7] != '-' || !twoDigits(p + 8, &mday))
+    {
+        return false;
+    }
+    if (month < 1 || month > 12 || mday < 1 || mday > 31)
+    {
+        return false;
+    }
+    *day = daysFromCivil(static_cast<int>(century * 100 + year), month, mday);
+    return true;
+}
+
+bool parseTime(const char* p, int32_t* seconds)
+{
+    unsigned hour, minute, second;
+    if (!twoDigits(p, &hour) || p[2] != ':' || !twoDigits(p + 3, &minute) || p[5] != ':'
+        || !twoDigits(p + 6, &second))
+    {
+        return false;
+    }
+    if (hour > 23 || minute > 59 || second > 60)
+    {
+        return false;
+    }
+    *seconds = static_cast<int32_t>(hour * 3600 + minute * 60 + second);
+    return true;
+}
+}
+
+bool parseCsvTimestamp(const char* p, CsvTimestamp* out)
+{
+    return parseDate(p, &out->day) && p[10] == ' ' && parseTime(p + 11, &out->seconds);
+}
+
+PomodoroCsvParser::PomodoroCsvParser(const char* begin, const char* end)
+    : p_(begin), end_(end), malformed_(0), cached_date_(), cached_day_(0)
+{
+}
+
+bool PomodoroCsvParser::parseTimestamp(const char* p, CsvTimestamp* out)
+{
+    if (memcmp(p, cached_date_, sizeof(cached_date_)) == 0)
+    {
+        out->day = cached_day_;
+    }
+    else
+    {
+        if (!parseDate(p, &out->day))
+        {
+            return false;
+        }
+        memcpy(cached_date_, p, sizeof(cached_date_));
+        cached_day_ = out->day;
+    }
+    return p[10] == ' ' && parseTime(p + 11, &out->seconds);
+}
+
+void PomodoroCsvParser::skipLine()
+{
+    const void* newline = memchr(p_, '\n', static_cast<size_t>(end_ - p_));
+    p_ = newline ? static_cast<const char*>(newline) + 1 : end_;
+}
+
+bool PomodoroCsvParser::next(PomodoroCsvRow* row)
+{
+    constexpr size_t kTimestamps = 2 * CSV_TIMESTAMP_LENGTH + 2;
+    while (p_ < end_)
+    {
+        const char* line = p_;
+        if (static_cast<size_t>(end_ - line) <= kTimestamps
+            || line[CSV_TIMESTAMP_LENGTH] != ','
+            || line[kTimestamps - 1] != ','
+            || !parseTimestamp(line, &row->start)
+            || !parseTimestamp(line + CSV_TIMESTAMP_LENGTH + 1, &row->end))
+        {
+            if (*line != '\n' && *line != '\r')
+            {
+                malformed_++;
+            }
+            skipLine();
+            continue;
+        }
+
+        const char* p = line + kTimestamps;
+        unsigned flavor = 0;
+        unsigned value;
+        int digits = 0;
+        while (p < end_ && digits < 4 && digit(*p, &value))
+        {
+            flavor = flavor * 10 + value;
+            digits++;
+            p++;
+        }
+        if (p < end_ && *p == '\r')
+        {
+            p++;
+        }
+        if (digits == 0 || flavor > 255 || (p < end_ && *p != '\n'))
+        {
+            malformed_++;
+            skipLine();
+            continue;
+        }
+        row->flavor = static_cast<uint8_t>(flavor);
+        p_ = p < end_ ? p + 1 : end_;
+        return true;
+    }
+    return false;
+}
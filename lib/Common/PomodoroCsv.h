@@ -0,0 +1,71 @@
+//
+// Allocation-free parser for the pomodoro.csv format written by Logger.
+//
+
+#ifndef POMODOROCSV_H
+#define POMODOROCSV_H
+
+#include <cstddef>
+#include <cstdint>
+
+// A local wall-clock timestamp as written in the CSV: days since 1970-01-01 and seconds since midnight.
+struct CsvTimestamp
+{
+    int32_t day;
+    int32_t seconds;
+};
+
+struct PomodoroCsvRow
+{
+    CsvTimestamp start;
+    CsvTimestamp end;
+    uint8_t flavor;
+};
+
+constexpr size_t CSV_TIMESTAMP_LENGTH = sizeof("YYYY-MM-DD HH:MM:SS") - 1;
+
+// Parses exactly CSV_TIMESTAMP_LENGTH characters at `p` ("YYYY-MM-DD HH:MM:SS").
+bool parseCsvTimestamp(const char* p, CsvTimestamp* out);
+
+// Day of week (0 = Sunday) of a day number.
+inline int csvWeekday(const int32_t day)
+{
+    const int32_t weekday = (day + 4) % 7;
+    return weekday < 0 ? weekday + 7 : weekday;
+}
+
+// Wall-clock duration between two timestamps, in seconds (negative if `end` precedes `start`).
+inline int64_t csvDuration(const CsvTimestamp& start, const CsvTimestamp& end)
+{
+    return static_cast<int64_t>(end.day - start.day) * 86400 + (end.seconds - start.seconds);
+}
+
+// Streams rows out of a buffer of "start,end,flavor" lines. The buffer is never copied or
+// modified; malformed lines are skipped and counted.
+class PomodoroCsvParser
+{
+public:
+    PomodoroCsvParser(const char* begin, const char* end);
+
+    // Returns false once the input is exhausted.
+    bool next(PomodoroCsvRow* row);
+
+    uint64_t malformed() const
+    {
+        return malformed_;
+    }
+
+private:
+    const char* p_;
+    const char* end_;
+    uint64_t malformed_;
+
+    // Consecutive rows almost always share a date; remember the last one parsed.
+    char cached_date_[10];
+    int32_t cached_day_;
+
+    bool parseTimestamp(const char* p, CsvTimestamp* out);
+    void skipLine();
+};
+
+#endif //POMODOROCSV_H
@@ -0,0 +1,239 @@
+//
+// What was running when the watchdog fired, kept across the restart it triggers.
+//
+
+#include "PostMortem.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "ByteCodec.h"
+#include "FrameTiming.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <esp_attr.h>
+#endif
+
+namespace
+{
+constexpr uint32_t kMagic = 0x504D5254; // "PMRT"
+// Open spans tracked per task while replaying the trace; deeper ones are counted but not named.
+constexpr size_t kMaxDepth = 8;
+
+#if defined(ARDUINO_ARCH_ESP32)
+// Not cleared by a software restart; garbage after power-on, which the checksum rejects.
+RTC_NOINIT_ATTR PostMortem retained;
+#else
+PostMortem retained;
+#endif
+
+// FNV-1a over everything after the checksum.
+uint32_t checksumOf(const PostMortem& record)
+{
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&record) + offsetof(PostMortem, wall_time);
+    const size_t size = sizeof(PostMortem) - offsetof(PostMortem, wall_time);
+    return fnv1a(kFnv1aBasis, bytes, size);
+}
+
+void copyText(char* out, const size_t size, const char* text)
+{
+    snprintf(out, size, "%s", text ? text : "?");
+}
+
+char phaseLetter(const TracePhase phase)
+{
+    switch (phase)
+    {
+    case TracePhase::BEGIN:
+        return 'B';
+    case TracePhase::END:
+        return 'E';
+    case TracePhase::INSTANT:
+        return 'i';
+    case TracePhase::COMPLETE:
+        return 'X';
+    }
+    return '?';
+}
+
+bool append(const size_t size, size_t* written, const int length)
+{
+    if (length < 0 || *written + static_cast<size_t>(length) >= size)
+    {
+        return false;
+    }
+    *written += static_cast<size_t>(length);
+    return true;
+}
+}
+
+void capturePostMortem(TraceBuffer& trace, const time_t now, const uint32_t silent_s, PostMortem* out)
+{
+    memset(out, 0, sizeof(*out));
+    const uint64_t now_us = monotonicMicros();
+    out->wall_time = static_cast<int64_t>(now);
+    out->uptime_s = static_cast<uint32_t>(now_us / 1000000);
+    out->silent_s = silent_s;
+
+    const bool was_enabled = trace.enabled();
+    trace.setEnabled(false);
+    const uint32_t now_ts = static_cast<uint32_t>(now_us);
+    const size_t count = trace.size();
+
+    // Replay the ring to find the spans still open, per task.
+    const TraceEvent* open[TraceBuffer::kMaxTasks][kMaxDepth] = {};
+    size_t depth[TraceBuffer::kMaxTasks] = {};
+    for (size_t i = 0; i < count; i++)
+    {
+        const TraceEvent& event = trace.event(i);
+        const size_t task = event.task < TraceBuffer::kMaxTasks ? event.task : TraceBuffer::kMaxTasks - 1;
+        if (event.phase == TracePhase::BEGIN)
+        {
+            if (depth[task] < kMaxDepth)
+            {
+                open[task][depth[task]] = &event;
+            }
+            depth[task]++;
+        }
+        else if (event.phase == TracePhase::END && depth[task] > 0)
+        {
+            depth[task]--;
+        }
+    }
+    for (size_t task = 0; task < TraceBuffer::kMaxTasks && out->span_count < PostMortem::kMaxSpans; task++)
+    {
+        if (depth[task] == 0 || depth[task] > kMaxDepth)
+        {
+            continue;
+        }
+        const TraceEvent& begin = *open[task][depth[task] - 1];
+        StalledSpan& span = out->spans[out->span_count++];
+        copyText(span.task, sizeof(span.task), trace.taskName(static_cast<uint8_t>(task)));
+        copyText(span.name, sizeof(span.name), begin.name);
+        span.running_ms = (now_ts - begin.ts_us) / 1000;
+    }
+    std::sort(out->spans, out->spans + out->span_count,
+              [](const StalledSpan& a, const StalledSpan& b) { return a.running_ms > b.running_ms; });
+
+    const size_t events = std::min(count, PostMortem::kMaxEvents);
+    for (size_t i = 0; i < events; i++)
+    {
+        const TraceEvent& event = trace.event(count - events + i);
+        PostMortemEvent& copy = out->events[i];
+        copy.age_ms = (now_ts - event.ts_us) / 1000;
+        copyText(copy.task, sizeof(copy.task), trace.taskName(event.task));
+        copyText(copy.name, sizeof(copy.name), event.name);
+        copy.phase = event.phase;
+    }
+    out->event_count = static_cast<uint8_t>(events);
+    trace.setEnabled(was_enabled);
+}
+
+void savePostMortem(const PostMortem& record)
+{
+    retained = record;
+    retained.magic = kMagic;
+    retained.checksum = checksumOf(retained);
+}
+
+bool takePostMortem(PostMortem* out)
+{
+    const bool valid = retained.magic == kMagic && retained.checksum == checksumOf(retained)
+        && retained.span_count <= PostMortem::kMaxSpans && retained.event_count <= PostMortem::kMaxEvents;
+    if (valid)
+    {
+        *out = retained;
+    }
+    retained.magic = 0;
+    return valid;
+}
+
+size_t formatPostMortem(const PostMortem& record, char* out, const size_t size)
+{
+    if (size == 0)
+    {
+        return 0;
+    }
+    out[0] = '\0';
+    size_t written = 0;
+    const time_t wall_time = static_cast<time_t>(record.wall_time);
+    struct tm utc;
+    gmtime_r(&wall_time, &utc);
+    char when[sizeof("YYYY-MM-DD HH:MM:SS")];
+    strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", &utc);
+    if (!append(size, &written,
+                snprintf(out + written, size - written,
+                         "Watchdog fired at %s UTC, uptime %lu s: no clock update for %lu s\n", when,
+                         static_cast<unsigned long>(record.uptime_s), static_cast<unsigned long>(record.silent_s))))
+    {
+        out[0] = '\0';
+        return 0;
+    }
+    if (record.span_count == 0)
+    {
+        append(size, &written, snprintf(out + written, size - written, "  no span was open\n"));
+    }
+    for (size_t i = 0; i < record.span_count; i++)
+    {
+        const StalledSpan& span = record.spans[i];
+        const size_t before = written;
+        if (!append(size, &written,
+                    snprintf(out + written, size - written, "  running: %-16s %-32s %8lu ms\n", span.task, span.name,
+                             static_cast<unsigned long>(span.running_ms))))
+        {
+            out[before] = '\0';
+            return before;
+        }
+    }
+    for (size_t i = 0; i < record.event_count; i++)
+    {
+        const PostMortemEvent& event = record.events[i];
+        const size_t before = written;
+        if (!append(size, &written,
+                    snprintf(out + written, size - written, "  %8lu ms ago %-12s %c %s\n",
+                             static_cast<unsigned long>(event.age_ms), event.task, phaseLetter(event.phase),
+                             event.name)))
+        {
+            out[before] = '\0';
+            return before;
+        }
+    }
+    return written;
+}
+
+size_t formatPostMortemJson(const PostMortem& record, char* out, const size_t size)
+{
+    size_t written = 0;
+    bool fits = append(size, &written,
+                       snprintf(out, size, "{\"wall_time\":%lld,\"uptime_s\":%lu,\"silent_s\":%lu,\"running\":[",
+                                static_cast<long long>(record.wall_time), static_cast<unsigned long>(record.uptime_s),
+                                static_cast<unsigned long>(record.silent_s)));
+    for (size_t i = 0; fits && i < record.span_count; i++)
+    {
+        const StalledSpan& span = record.spans[i];
+        fits = append(size, &written,
+                      snprintf(out + written, size - written, "%s{\"task\":\"%s\",\"span\":\"%s\",\"running_ms\":%lu}",
+                               i > 0 ? "," : "", span.task, span.name, static_cast<unsigned long>(span.running_ms)));
+    }
+    fits = fits && append(size, &written, snprintf(out + written, size - written, "],\"events\":["));
+    for (size_t i = 0; fits && i < record.event_count; i++)
+    {
+        const PostMortemEvent& event = record.events[i];
+        fits = append(size, &written,
+                      snprintf(out + written, size - written,
+                               "%s{\"age_ms\":%lu,\"task\":\"%s\",\"ph\":\"%c\",\"name\":\"%s\"}", i > 0 ? "," : "",
+                               static_cast<unsigned long>(event.age_ms), event.task, phaseLetter(event.phase),
+                               event.name));
+    }
+    fits = fits && append(size, &written, snprintf(out + written, size - written, "]}"));
+    if (!fits)
+    {
+        if (size > 0)
+        {
+            out[0] = '\0';
+        }
+        return 0;
+    }
+    return written;
+}
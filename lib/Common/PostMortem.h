@@ -0,0 +1,67 @@
+//
+// What was running when the watchdog fired, kept across the restart it triggers.
+//
+
+#ifndef POSTMORTEM_H
+#define POSTMORTEM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+
+#include "Trace.h"
+
+// A trace span that had begun but not ended when the watchdog fired.
+struct StalledSpan
+{
+    char task[TraceBuffer::kTaskNameLength];
+    char name[32];
+    uint32_t running_ms;
+};
+
+// One of the last trace events before the watchdog fired, with its name copied: the firmware
+// that reads the record back may not be the one that wrote it.
+struct PostMortemEvent
+{
+    uint32_t age_ms;
+    char task[12];
+    char name[27];
+    TracePhase phase;
+};
+
+// Plain data, so it can live in memory that survives a software restart.
+struct PostMortem
+{
+    static constexpr size_t kMaxSpans = 8;
+    static constexpr size_t kMaxEvents = 16;
+
+    uint32_t magic;
+    uint32_t checksum;
+    int64_t wall_time;
+    uint32_t uptime_s;
+    // Seconds since the last notification reached the watchdog.
+    uint32_t silent_s;
+    uint8_t span_count;
+    uint8_t event_count;
+    StalledSpan spans[kMaxSpans];
+    PostMortemEvent events[kMaxEvents];
+};
+
+// Fills `out` from the trace: the innermost open span of each task, longest-running first (the
+// main loop's is usually the culprit), and the last kMaxEvents events.
+void capturePostMortem(TraceBuffer& trace, time_t now, uint32_t silent_s, PostMortem* out);
+
+// Saves `record` to storage kept across software restarts (RTC memory on the ESP32).
+void savePostMortem(const PostMortem& record);
+
+// Moves the saved record, if there is a valid one, into `out` and clears it. Returns false after
+// a power-on or if the watchdog did not fire.
+bool takePostMortem(PostMortem* out);
+
+// Human-readable report for the serial log. Returns the length written.
+size_t formatPostMortem(const PostMortem& record, char* out, size_t size);
+
+// The same as a JSON object, for the backend. Returns the length written, 0 if it did not fit.
+size_t formatPostMortemJson(const PostMortem& record, char* out, size_t size);
+
+#endif //POSTMORTEM_H
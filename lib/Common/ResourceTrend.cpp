@@ -0,0 +1,133 @@
+//
+// Memory headroom over the whole uptime in a fixed-size trend, and when to warn about it.
+//
+
+#include "ResourceTrend.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace
+{
+void lower(ResourceSample* low, const ResourceSample& sample)
+{
+    low->free_heap = std::min(low->free_heap, sample.free_heap);
+    low->largest_block = std::min(low->largest_block, sample.largest_block);
+    low->free_psram = std::min(low->free_psram, sample.free_psram);
+    low->min_stack_free = std::min(low->min_stack_free, sample.min_stack_free);
+}
+}
+
+uint8_t fragmentationPercent(const uint32_t free_heap, const uint32_t largest_block)
+{
+    if (free_heap == 0 || largest_block >= free_heap)
+    {
+        return 0;
+    }
+    return static_cast<uint8_t>(100 - static_cast<uint64_t>(largest_block) * 100 / free_heap);
+}
+
+uint8_t resourceAlerts(const ResourceSample& sample, const ResourceLimits& limits)
+{
+    uint8_t alerts = 0;
+    if (sample.largest_block < limits.min_largest_block)
+    {
+        alerts |= HEAP_ALERT_SMALL_BLOCK;
+    }
+    if (fragmentationPercent(sample.free_heap, sample.largest_block) > limits.max_fragmentation_percent)
+    {
+        alerts |= HEAP_ALERT_FRAGMENTED;
+    }
+    if (sample.min_stack_free < limits.min_stack_free)
+    {
+        alerts |= HEAP_ALERT_STACK;
+    }
+    return alerts;
+}
+
+ResourceTrend::ResourceTrend() : buckets_(), count_(0), per_bucket_(1)
+{
+}
+
+void ResourceTrend::add(const uint32_t uptime_s, const ResourceSample& sample)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (count_ > 0 && buckets_[count_ - 1].samples < per_bucket_)
+    {
+        Bucket& last = buckets_[count_ - 1];
+        lower(&last.low, sample);
+        last.high_free_heap = std::max(last.high_free_heap, sample.free_heap);
+        last.samples++;
+        return;
+    }
+    if (count_ == kBuckets)
+    {
+        for (size_t i = 0; i < kBuckets / 2; i++)
+        {
+            Bucket merged = buckets_[2 * i];
+            const Bucket& next = buckets_[2 * i + 1];
+            lower(&merged.low, next.low);
+            merged.high_free_heap = std::max(merged.high_free_heap, next.high_free_heap);
+            merged.samples += next.samples;
+            buckets_[i] = merged;
+        }
+        count_ = kBuckets / 2;
+        per_bucket_ *= 2;
+    }
+    buckets_[count_++] = {uptime_s, 1, sample, sample.free_heap};
+}
+
+size_t ResourceTrend::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return count_;
+}
+
+ResourceTrend::Bucket ResourceTrend::bucket(const size_t index) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return index < count_ ? buckets_[index] : Bucket{};
+}
+
+uint32_t ResourceTrend::samplesPerBucket() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return per_bucket_;
+}
+
+size_t ResourceTrend::format(char* out, const size_t size) const
+{
+    if (size == 0)
+    {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t written = 0;
+    out[0] = '\0';
+    const char* header = "  from s   heap min/max      block frag      psram  stack\n";
+    int length = snprintf(out, size, "%s", header);
+    if (length < 0 || static_cast<size_t>(length) >= size)
+    {
+        out[0] = '\0';
+        return 0;
+    }
+    written = static_cast<size_t>(length);
+    for (size_t i = 0; i < count_; i++)
+    {
+        const Bucket& bucket = buckets_[i];
+        length = snprintf(out + written, size - written, "%8lu %7lu/%-7lu %8lu %3u%% %10lu %6lu\n",
+                          static_cast<unsigned long>(bucket.start_s), static_cast<unsigned long>(bucket.low.free_heap),
+                          static_cast<unsigned long>(bucket.high_free_heap),
+                          static_cast<unsigned long>(bucket.low.largest_block),
+                          static_cast<unsigned>(fragmentationPercent(bucket.low.free_heap, bucket.low.largest_block)),
+                          static_cast<unsigned long>(bucket.low.free_psram),
+                          static_cast<unsigned long>(bucket.low.min_stack_free));
+        if (length < 0 || written + static_cast<size_t>(length) >= size)
+        {
+            out[written] = '\0';
+            break;
+        }
+        written += static_cast<size_t>(length);
+    }
+    return written;
+}
@@ -0,0 +1,76 @@
+//
+// Memory headroom over the whole uptime in a fixed-size trend, and when to warn about it.
+//
+
+#ifndef RESOURCETREND_H
+#define RESOURCETREND_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+// One reading of the device's memory, in bytes.
+struct ResourceSample
+{
+    uint32_t free_heap;
+    uint32_t largest_block;
+    uint32_t free_psram;
+    // The least stack any watched task has had left since it started.
+    uint32_t min_stack_free;
+};
+
+// Share of the free heap that a single allocation cannot use, 0-100.
+uint8_t fragmentationPercent(uint32_t free_heap, uint32_t largest_block);
+
+// Alert bits, raised while allocations are still succeeding.
+constexpr uint8_t HEAP_ALERT_SMALL_BLOCK = 1;
+constexpr uint8_t HEAP_ALERT_FRAGMENTED = 2;
+constexpr uint8_t HEAP_ALERT_STACK = 4;
+
+struct ResourceLimits
+{
+    // The largest allocation the firmware makes at run time must still fit.
+    uint32_t min_largest_block;
+    uint8_t max_fragmentation_percent;
+    uint32_t min_stack_free;
+};
+
+uint8_t resourceAlerts(const ResourceSample& sample, const ResourceLimits& limits);
+
+// Keeps the lowest value of each field (and the highest free heap, to show churn) per bucket. When
+// the buckets are full, neighbours merge and each bucket covers twice as many samples, so the
+// trend spans the whole uptime at falling resolution. Safe to use from several tasks.
+class ResourceTrend
+{
+public:
+    static constexpr size_t kBuckets = 32;
+
+    struct Bucket
+    {
+        uint32_t start_s;
+        uint32_t samples;
+        ResourceSample low;
+        uint32_t high_free_heap;
+    };
+
+    ResourceTrend();
+
+    void add(uint32_t uptime_s, const ResourceSample& sample);
+
+    size_t size() const;
+    Bucket bucket(size_t index) const;
+
+    // Samples a full bucket holds.
+    uint32_t samplesPerBucket() const;
+
+    // One line per bucket, oldest first. Truncates to whole lines; returns the length written.
+    size_t format(char* out, size_t size) const;
+
+private:
+    mutable std::mutex mutex_;
+    Bucket buckets_[kBuckets];
+    size_t count_;
+    uint32_t per_bucket_;
+};
+
+#endif //RESOURCETREND_H
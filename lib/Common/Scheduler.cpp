@@ -0,0 +1,230 @@
+//
+// Single-threaded cooperative scheduler for C++20 coroutines: timers, channels and I/O completions.
+//
+
+#include "Scheduler.h"
+
+#ifdef POMODORO_HAS_COROUTINES
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <new>
+
+namespace
+{
+std::atomic<size_t> frame_bytes{0};
+std::atomic<size_t> frames{0};
+}
+
+size_t coroutineFrameBytes()
+{
+    return frame_bytes.load(std::memory_order_relaxed);
+}
+
+size_t coroutineFrames()
+{
+    return frames.load(std::memory_order_relaxed);
+}
+
+void Task::promise_type::unhandled_exception()
+{
+    // Firmware code does not throw; an escaped exception is a bug, not something to recover from.
+    std::terminate();
+}
+
+void* Task::promise_type::operator new(const size_t size)
+{
+    frame_bytes.fetch_add(size, std::memory_order_relaxed);
+    frames.fetch_add(1, std::memory_order_relaxed);
+    return ::operator new(size);
+}
+
+void Task::promise_type::operator delete(void* frame, const size_t size)
+{
+    frame_bytes.fetch_sub(size, std::memory_order_relaxed);
+    frames.fetch_sub(1, std::memory_order_relaxed);
+    ::operator delete(frame);
+}
+
+Scheduler::Scheduler(const Clock clock)
+    : clock_(clock),
+      alive_(0),
+      ready_head_(0),
+      ready_count_(0),
+      timer_count_(0),
+      timer_sequence_(0),
+      max_lateness_us_(0),
+      posted_count_(0),
+      has_posted_(false),
+      stopping_(false)
+{
+}
+
+Scheduler::~Scheduler()
+{
+    for (size_t i = 0; i < alive_; i++)
+    {
+        tasks_[i].destroy();
+    }
+}
+
+bool Scheduler::spawn(Task task)
+{
+    if (alive_ == kMaxTasks)
+    {
+        return false;
+    }
+    tasks_[alive_++] = task.handle_;
+    makeReady(task.handle_);
+    task.handle_ = nullptr;
+    return true;
+}
+
+size_t Scheduler::runReady()
+{
+    collectPosted();
+    collectTimers();
+    // Coroutines made ready by the ones resumed here wait for the next call, so a coroutine that
+    // keeps yielding cannot starve timers and posts.
+    size_t resumed = ready_count_;
+    for (size_t i = 0; i < resumed; i++)
+    {
+        const std::coroutine_handle<> handle = ready_[ready_head_];
+        ready_head_ = (ready_head_ + 1) % kMaxTasks;
+        ready_count_--;
+        handle.resume();
+        if (handle.done())
+        {
+            finish(handle);
+        }
+    }
+    return resumed;
+}
+
+void Scheduler::run()
+{
+    for (;;)
+    {
+        runReady();
+        if (ready_count_ > 0 && !stopping_.load(std::memory_order_relaxed))
+        {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (stopping_ || alive_ == 0)
+        {
+            stopping_ = false;
+            return;
+        }
+        if (ready_count_ > 0 || posted_count_ > 0)
+        {
+            continue;
+        }
+        const uint64_t deadline = nextDeadline();
+        const uint64_t now = clock_();
+        if (deadline <= now)
+        {
+            continue;
+        }
+        const auto ready = [this] { return posted_count_ > 0 || stopping_; };
+        if (deadline == UINT64_MAX)
+        {
+            wake_.wait(lock, ready);
+        }
+        else
+        {
+            wake_.wait_for(lock, std::chrono::microseconds(deadline - now), ready);
+        }
+    }
+}
+
+void Scheduler::stop()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+    wake_.notify_one();
+}
+
+bool Scheduler::post(const std::coroutine_handle<> handle)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (posted_count_ == kMaxPosted)
+    {
+        return false;
+    }
+    posted_[posted_count_++] = handle;
+    has_posted_.store(true, std::memory_order_release);
+    wake_.notify_one();
+    return true;
+}
+
+bool Scheduler::later(const Timer& a, const Timer& b)
+{
+    if (a.deadline_us != b.deadline_us)
+    {
+        return a.deadline_us > b.deadline_us;
+    }
+    return static_cast<int32_t>(a.sequence - b.sequence) > 0;
+}
+
+void Scheduler::makeReady(const std::coroutine_handle<> handle)
+{
+    // Every coroutine in the queue is a suspended task, so it cannot hold more than kMaxTasks.
+    ready_[(ready_head_ + ready_count_) % kMaxTasks] = handle;
+    ready_count_++;
+}
+
+void Scheduler::addTimer(const uint64_t deadline_us, const std::coroutine_handle<> handle)
+{
+    timers_[timer_count_++] = {deadline_us, timer_sequence_++, handle};
+    std::push_heap(timers_, timers_ + timer_count_, later);
+}
+
+void Scheduler::collectPosted()
+{
+    if (!has_posted_.load(std::memory_order_acquire))
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    has_posted_.store(false, std::memory_order_relaxed);
+    for (size_t i = 0; i < posted_count_; i++)
+    {
+        makeReady(posted_[i]);
+    }
+    posted_count_ = 0;
+}
+
+void Scheduler::collectTimers()
+{
+    if (timer_count_ == 0)
+    {
+        return;
+    }
+    const uint64_t now = clock_();
+    while (timer_count_ > 0 && timers_[0].deadline_us <= now)
+    {
+        const uint64_t lateness = now - timers_[0].deadline_us;
+        max_lateness_us_ = std::max(max_lateness_us_, static_cast<uint32_t>(std::min<uint64_t>(lateness, UINT32_MAX)));
+        makeReady(timers_[0].handle);
+        std::pop_heap(timers_, timers_ + timer_count_, later);
+        timer_count_--;
+    }
+}
+
+void Scheduler::finish(const std::coroutine_handle<> handle)
+{
+    for (size_t i = 0; i < alive_; i++)
+    {
+        if (tasks_[i] == handle)
+        {
+            tasks_[i] = tasks_[--alive_];
+            break;
+        }
+    }
+    handle.destroy();
+}
+
+#endif
@@ -0,0 +1,385 @@
+//
+// Single-threaded cooperative scheduler for C++20 coroutines: timers, channels and I/O completions.
+//
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+// The ESP32 toolchain (GCC 8) has no coroutine support, so this is only built where the compiler
+// has it: the native env and any future firmware toolchain.
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#define POMODORO_HAS_COROUTINES 1
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include "FrameTiming.h"
+
+class Scheduler;
+
+// Bytes of coroutine frames currently allocated, and the number of frames.
+size_t coroutineFrameBytes();
+size_t coroutineFrames();
+
+// A top-level coroutine run by a Scheduler. It starts suspended; spawn() hands it to the scheduler,
+// which resumes it and destroys its frame when it returns.
+class Task
+{
+public:
+    struct promise_type
+    {
+        Task get_return_object()
+        {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept
+        {
+            return {};
+        }
+
+        std::suspend_always final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void return_void()
+        {
+        }
+
+        void unhandled_exception();
+
+        static void* operator new(size_t size);
+        static void operator delete(void* frame, size_t size);
+    };
+
+    Task(Task&& other) noexcept : handle_(other.handle_)
+    {
+        other.handle_ = nullptr;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task()
+    {
+        if (handle_)
+        {
+            handle_.destroy();
+        }
+    }
+
+private:
+    friend class Scheduler;
+
+    explicit Task(const std::coroutine_handle<promise_type> handle) : handle_(handle)
+    {
+    }
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+// Runs coroutines on the thread that calls run() or runReady(). Only post() and the Completion
+// it backs may be used from other threads. Capacities are fixed so nothing is allocated after
+// the coroutines themselves.
+class Scheduler
+{
+public:
+    static constexpr size_t kMaxTasks = 32;
+    static constexpr size_t kMaxTimers = kMaxTasks;
+    static constexpr size_t kMaxPosted = kMaxTasks;
+
+    using Clock = uint64_t (*)();
+
+    explicit Scheduler(Clock clock = monotonicMicros);
+
+    // Destroys the frames of coroutines that have not finished.
+    ~Scheduler();
+
+    // Returns false, destroying the task, if kMaxTasks are already alive.
+    bool spawn(Task task);
+
+    // Moves posted and due coroutines to the ready queue and resumes each of them once. Returns
+    // the number resumed.
+    size_t runReady();
+
+    // Runs until every task has returned or stop() is called, sleeping until the next timer or
+    // post() when nothing is ready.
+    void run();
+
+    // Safe from any thread.
+    void stop();
+
+    // Makes a suspended coroutine ready and wakes run(). Safe from any thread. Each suspended
+    // task can be pending at most once, so this only fails if a handle is posted twice.
+    bool post(std::coroutine_handle<> handle);
+
+    uint64_t now() const
+    {
+        return clock_();
+    }
+
+    // The earliest timer deadline, or UINT64_MAX with no timer pending.
+    uint64_t nextDeadline() const
+    {
+        return timer_count_ > 0 ? timers_[0].deadline_us : UINT64_MAX;
+    }
+
+    size_t alive() const
+    {
+        return alive_;
+    }
+
+    // Worst delay seen between a timer's deadline and the coroutine being resumed.
+    uint32_t maxLatenessMicros() const
+    {
+        return max_lateness_us_;
+    }
+
+    struct SleepAwaiter
+    {
+        Scheduler& scheduler;
+        uint64_t deadline_us;
+
+        bool await_ready() const
+        {
+            return deadline_us <= scheduler.now();
+        }
+
+        void await_suspend(const std::coroutine_handle<> handle)
+        {
+            scheduler.addTimer(deadline_us, handle);
+        }
+
+        void await_resume() const
+        {
+        }
+    };
+
+    struct YieldAwaiter
+    {
+        Scheduler& scheduler;
+
+        bool await_ready() const
+        {
+            return false;
+        }
+
+        void await_suspend(const std::coroutine_handle<> handle)
+        {
+            scheduler.makeReady(handle);
+        }
+
+        void await_resume() const
+        {
+        }
+    };
+
+    // co_await scheduler.sleepUntil(t): resumes on the first runReady() at or after `t`.
+    SleepAwaiter sleepUntil(const uint64_t deadline_us)
+    {
+        return {*this, deadline_us};
+    }
+
+    SleepAwaiter sleepFor(const uint64_t micros)
+    {
+        return {*this, now() + micros};
+    }
+
+    // Lets every other ready coroutine run first.
+    YieldAwaiter yield()
+    {
+        return {*this};
+    }
+
+private:
+    template <typename T, size_t N>
+    friend class Channel;
+
+    struct Timer
+    {
+        uint64_t deadline_us;
+        uint32_t sequence;
+        std::coroutine_handle<> handle;
+    };
+
+    Clock clock_;
+    std::coroutine_handle<> tasks_[kMaxTasks];
+    size_t alive_;
+    std::coroutine_handle<> ready_[kMaxTasks];
+    size_t ready_head_;
+    size_t ready_count_;
+    // Min-heap on (deadline, sequence): equal deadlines fire in the order they were set.
+    Timer timers_[kMaxTimers];
+    size_t timer_count_;
+    uint32_t timer_sequence_;
+    uint32_t max_lateness_us_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::coroutine_handle<> posted_[kMaxPosted];
+    size_t posted_count_;
+    // Checked without the mutex so a busy scheduler only locks when there is something posted.
+    std::atomic<bool> has_posted_;
+    std::atomic<bool> stopping_;
+
+    static bool later(const Timer& a, const Timer& b);
+
+    void makeReady(std::coroutine_handle<> handle);
+    void addTimer(uint64_t deadline_us, std::coroutine_handle<> handle);
+    void collectPosted();
+    void collectTimers();
+    void finish(std::coroutine_handle<> handle);
+};
+
+// A bounded FIFO between coroutines of one scheduler: send() never blocks, receive() suspends the
+// (single) receiver until a value arrives.
+template <typename T, size_t N>
+class Channel
+{
+public:
+    explicit Channel(Scheduler& scheduler) : scheduler_(scheduler), head_(0), count_(0), dropped_(0)
+    {
+    }
+
+    // Returns false, counting a drop, if the channel is full.
+    bool send(const T& value)
+    {
+        if (count_ == N)
+        {
+            dropped_++;
+            return false;
+        }
+        items_[(head_ + count_) % N] = value;
+        count_++;
+        if (receiver_)
+        {
+            scheduler_.makeReady(receiver_);
+            receiver_ = nullptr;
+        }
+        return true;
+    }
+
+    size_t size() const
+    {
+        return count_;
+    }
+
+    uint32_t dropped() const
+    {
+        return dropped_;
+    }
+
+    struct ReceiveAwaiter
+    {
+        Channel& channel;
+
+        bool await_ready() const
+        {
+            return channel.count_ > 0;
+        }
+
+        void await_suspend(const std::coroutine_handle<> handle)
+        {
+            channel.receiver_ = handle;
+        }
+
+        T await_resume()
+        {
+            T value = channel.items_[channel.head_];
+            channel.head_ = (channel.head_ + 1) % N;
+            channel.count_--;
+            return value;
+        }
+    };
+
+    // co_await channel.receive() yields the oldest value.
+    ReceiveAwaiter receive()
+    {
+        return {*this};
+    }
+
+private:
+    Scheduler& scheduler_;
+    T items_[N];
+    size_t head_;
+    size_t count_;
+    uint32_t dropped_;
+    std::coroutine_handle<> receiver_;
+};
+
+// The result of an operation finished elsewhere, e.g. an HTTP request on another task: one
+// coroutine co_awaits it, complete() (from any thread) resumes that coroutine on the scheduler.
+template <typename T>
+class Completion
+{
+public:
+    explicit Completion(Scheduler& scheduler) : scheduler_(scheduler), done_(false)
+    {
+    }
+
+    void complete(const T& value)
+    {
+        std::coroutine_handle<> waiter;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            value_ = value;
+            done_ = true;
+            waiter = waiter_;
+            waiter_ = nullptr;
+        }
+        if (waiter)
+        {
+            scheduler_.post(waiter);
+        }
+    }
+
+    struct Awaiter
+    {
+        Completion& completion;
+
+        bool await_ready() const
+        {
+            std::lock_guard<std::mutex> lock(completion.mutex_);
+            return completion.done_;
+        }
+
+        bool await_suspend(const std::coroutine_handle<> handle)
+        {
+            std::lock_guard<std::mutex> lock(completion.mutex_);
+            if (completion.done_)
+            {
+                // Completed between await_ready() and here: carry on without suspending.
+                return false;
+            }
+            completion.waiter_ = handle;
+            return true;
+        }
+
+        T await_resume() const
+        {
+            std::lock_guard<std::mutex> lock(completion.mutex_);
+            return completion.value_;
+        }
+    };
+
+    Awaiter operator co_await()
+    {
+        return {*this};
+    }
+
+private:
+    Scheduler& scheduler_;
+    mutable std::mutex mutex_;
+    T value_;
+    bool done_;
+    std::coroutine_handle<> waiter_;
+};
+
+#endif
+
+#endif //SCHEDULER_H
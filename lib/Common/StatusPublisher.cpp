@@ -0,0 +1,80 @@
+//
+// PomodoroObserver that keeps a StatusServer's /state current and streams transitions to /events.
+//
+
+#include "StatusPublisher.h"
+
+#include <cstdio>
+
+namespace
+{
+const char* stateName(const PomodoroState state)
+{
+    switch (state)
+    {
+    case WORK:
+        return "work";
+    case BREAK:
+        return "break";
+    case IDLE:
+        break;
+    }
+    return "idle";
+}
+}
+
+StatusPublisher::StatusPublisher(StatusServer& server)
+    : server_(server), flavors_(nullptr), last_state_(IDLE), last_countdown_(0)
+{
+}
+
+void StatusPublisher::notification(const ClockUpdate update)
+{
+    char json[StatusServer::kStateBytes];
+    const uint8_t flavors = flavors_ ? flavors_->size() : MAX_WORK_FLAVORS;
+    const uint8_t flavor = update.work_flavor < flavors ? update.work_flavor : 0;
+    const char* label = flavors_ && update.state == WORK ? flavors_->jsonLabel(flavor) : "";
+    snprintf(json, sizeof(json), "{\"state\":\"%s\",\"flavor\":%u,\"label\":\"%s\",\"now\":%lld,\"remaining\":%lld}",
+             stateName(update.state), static_cast<unsigned>(flavor), label,
+             static_cast<long long>(update.now), static_cast<long long>(update.remaining_time_in_state));
+    server_.setState(json);
+    if (update.state != last_state_ || update.now - last_countdown_ >= kCountdownSeconds)
+    {
+        last_state_ = update.state;
+        last_countdown_ = update.now;
+        server_.publish("countdown", json);
+    }
+}
+
+void StatusPublisher::notification(const IdleToWork update)
+{
+    transition("idle_to_work", update.now, "flavor", update.work_flavor);
+}
+
+void StatusPublisher::notification(const WorkToBreak update)
+{
+    transition("work_to_break", update.now, "work_duration", update.work_duration);
+}
+
+void StatusPublisher::notification(const BreakToIdle update)
+{
+    transition("break_to_idle", update.now, "break_duration", update.break_duration);
+}
+
+void StatusPublisher::notification(const WorkToIdle update)
+{
+    transition("work_to_idle", update.now, "cancelled_work_duration", update.cancelled_work_duration);
+}
+
+void StatusPublisher::notification(const AdditionalWork update)
+{
+    transition("additional_work", update.now, "new_work_duration", update.new_work_duration);
+}
+
+void StatusPublisher::transition(const char* name, const time_t now, const char* field, const time_t value)
+{
+    char json[128];
+    snprintf(json, sizeof(json), "{\"transition\":\"%s\",\"now\":%lld,\"%s\":%lld}", name,
+             static_cast<long long>(now), field, static_cast<long long>(value));
+    server_.publish("transition", json);
+}
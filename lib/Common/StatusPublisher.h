@@ -0,0 +1,46 @@
+//
+// PomodoroObserver that keeps a StatusServer's /state current and streams transitions to /events.
+//
+
+#ifndef STATUSPUBLISHER_H
+#define STATUSPUBLISHER_H
+
+#include "FlavorTable.h"
+#include "Pomodoro.h"
+#include "StatusServer.h"
+
+// Formats the clock as {"state":"work","flavor":0,"label":"work","now":...,"remaining":...}.
+// Every ClockUpdate refreshes /state; subscribers get a "transition" event for each transition
+// and a "countdown" event with the state at most every kCountdownSeconds, plus one whenever the
+// state changes. Notifications only format into the server's buffers, so they never block on
+// the network.
+class StatusPublisher final : public PomodoroObserver
+{
+public:
+    static constexpr time_t kCountdownSeconds = 5;
+
+    explicit StatusPublisher(StatusServer& server);
+
+    // Labels come from the table as they are; it must outlive the publisher. Without one they are empty.
+    void setFlavors(const FlavorTable* flavors)
+    {
+        flavors_ = flavors;
+    }
+
+    void notification(ClockUpdate update) override;
+    void notification(IdleToWork update) override;
+    void notification(WorkToBreak update) override;
+    void notification(BreakToIdle update) override;
+    void notification(WorkToIdle update) override;
+    void notification(AdditionalWork update) override;
+
+private:
+    StatusServer& server_;
+    const FlavorTable* flavors_;
+    PomodoroState last_state_;
+    time_t last_countdown_;
+
+    void transition(const char* name, time_t now, const char* field, time_t value);
+};
+
+#endif //STATUSPUBLISHER_H
@@ -0,0 +1,378 @@
+//
+// Tiny HTTP server: GET /state returns a JSON snapshot, GET /events streams Server-Sent Events.
+//
+
+#include "StatusServer.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "FrameTiming.h"
+
+#ifndef MSG_NOSIGNAL
+// lwIP has no SIGPIPE to suppress.
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace
+{
+const char kServiceUnavailable[] =
+    "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+
+bool setNonBlocking(const int fd)
+{
+    const int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+bool wouldBlock()
+{
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+}
+
+uint32_t nowMs()
+{
+    return static_cast<uint32_t>(monotonicMicros() / 1000);
+}
+}
+
+StatusServer::StatusServer() : listener_(-1), port_(0), state_(), dropped_(0)
+{
+    for (Client& client : clients_)
+    {
+        client.fd = -1;
+    }
+    snprintf(state_, sizeof(state_), "{}");
+}
+
+StatusServer::~StatusServer()
+{
+    stop();
+}
+
+bool StatusServer::begin(const uint16_t port)
+{
+    stop();
+    const int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        return false;
+    }
+    const int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    socklen_t length = sizeof(address);
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+        || listen(fd, static_cast<int>(kMaxClients)) != 0 || !setNonBlocking(fd)
+        || getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    listener_ = fd;
+    port_ = ntohs(address.sin_port);
+    return true;
+}
+
+void StatusServer::stop()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (Client& client : clients_)
+    {
+        close(client);
+    }
+    if (listener_ >= 0)
+    {
+        ::close(listener_);
+        listener_ = -1;
+    }
+}
+
+void StatusServer::poll(const int timeout_ms)
+{
+    fd_set reads;
+    fd_set writes;
+    FD_ZERO(&reads);
+    FD_ZERO(&writes);
+    int max_fd;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (listener_ < 0)
+        {
+            return;
+        }
+        FD_SET(listener_, &reads);
+        max_fd = listener_;
+        for (const Client& client : clients_)
+        {
+            if (client.fd < 0)
+            {
+                continue;
+            }
+            FD_SET(client.fd, &reads);
+            if (client.output_length > 0)
+            {
+                FD_SET(client.fd, &writes);
+            }
+            max_fd = client.fd > max_fd ? client.fd : max_fd;
+        }
+    }
+    // Events published while this waits go out when it returns, at most timeout_ms late.
+    timeval timeout = {timeout_ms / 1000, (timeout_ms % 1000) * 1000};
+    if (select(max_fd + 1, &reads, &writes, nullptr, &timeout) < 0)
+    {
+        return;
+    }
+
+    const uint32_t now = nowMs();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (listener_ < 0)
+    {
+        return;
+    }
+    if (FD_ISSET(listener_, &reads))
+    {
+        accept();
+    }
+    for (Client& client : clients_)
+    {
+        if (client.fd >= 0 && FD_ISSET(client.fd, &reads))
+        {
+            receive(client, now);
+        }
+        if (client.fd < 0)
+        {
+            continue;
+        }
+        if (client.streaming && now - client.last_activity_ms >= kKeepAliveMs)
+        {
+            static const char keep_alive[] = ": keep-alive\n\n";
+            queue(client, keep_alive, sizeof(keep_alive) - 1);
+            client.last_activity_ms = now;
+        }
+        else if (!client.streaming && !client.close_when_sent && now - client.last_activity_ms >= kRequestTimeoutMs)
+        {
+            close(client);
+            continue;
+        }
+        flush(client);
+    }
+}
+
+bool StatusServer::setState(const char* json)
+{
+    const size_t length = strlen(json);
+    if (length >= sizeof(state_))
+    {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    memcpy(state_, json, length + 1);
+    return true;
+}
+
+void StatusServer::publish(const char* event, const char* data)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (Client& client : clients_)
+    {
+        if (client.fd >= 0 && client.streaming && !queueEvent(client, event, data))
+        {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            close(client);
+        }
+    }
+}
+
+size_t StatusServer::subscribers() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = 0;
+    for (const Client& client : clients_)
+    {
+        count += client.fd >= 0 && client.streaming;
+    }
+    return count;
+}
+
+void StatusServer::accept()
+{
+    while (true)
+    {
+        const int fd = ::accept(listener_, nullptr, nullptr);
+        if (fd < 0)
+        {
+            return;
+        }
+        Client* slot = nullptr;
+        for (Client& client : clients_)
+        {
+            if (client.fd < 0)
+            {
+                slot = &client;
+                break;
+            }
+        }
+        if (!slot || !setNonBlocking(fd))
+        {
+            // Best effort: the response fits any socket buffer.
+            send(fd, kServiceUnavailable, sizeof(kServiceUnavailable) - 1, MSG_NOSIGNAL);
+            ::close(fd);
+            continue;
+        }
+        slot->fd = fd;
+        slot->streaming = false;
+        slot->close_when_sent = false;
+        slot->last_activity_ms = nowMs();
+        slot->request_length = 0;
+        slot->output_length = 0;
+    }
+}
+
+void StatusServer::receive(Client& client, const uint32_t now_ms)
+{
+    if (client.streaming || client.close_when_sent)
+    {
+        // Nothing more is expected; reading only tells whether the client hung up.
+        // A client that half-closes after its request still gets the response.
+        char discard[64];
+        const ssize_t received = recv(client.fd, discard, sizeof(discard), 0);
+        if ((received == 0 && client.streaming) || (received < 0 && !wouldBlock()))
+        {
+            close(client);
+        }
+        return;
+    }
+    const ssize_t received = recv(client.fd, client.request + client.request_length,
+                                  kRequestBytes - 1 - client.request_length, 0);
+    if (received == 0 || (received < 0 && !wouldBlock()))
+    {
+        close(client);
+        return;
+    }
+    if (received < 0)
+    {
+        return;
+    }
+    client.last_activity_ms = now_ms;
+    client.request_length += static_cast<size_t>(received);
+    client.request[client.request_length] = '\0';
+    if (strstr(client.request, "\r\n\r\n") || strstr(client.request, "\n\n"))
+    {
+        respond(client);
+    }
+    else if (client.request_length == kRequestBytes - 1)
+    {
+        static const char too_large[] =
+            "HTTP/1.1 431 Request Header Fields Too Large\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        queue(client, too_large, sizeof(too_large) - 1);
+        client.close_when_sent = true;
+    }
+}
+
+void StatusServer::respond(Client& client)
+{
+    // Only the request line matters: "GET /path?query HTTP/1.1".
+    const char* path = client.request_length > 4 ? client.request + 4 : "";
+    const size_t path_length = strcspn(path, " ?\r\n");
+    const bool get = strncmp(client.request, "GET ", 4) == 0;
+    const auto is = [path, path_length](const char* expected) {
+        return path_length == strlen(expected) && strncmp(path, expected, path_length) == 0;
+    };
+
+    char header[192];
+    int length;
+    if (get && is("/events"))
+    {
+        length = snprintf(header, sizeof(header),
+                          "HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\nCache-Control: no-cache\r\n"
+                          "Access-Control-Allow-Origin: *\r\nConnection: keep-alive\r\n\r\n");
+        client.streaming = true;
+        queue(client, header, static_cast<size_t>(length));
+        queueEvent(client, "state", state_);
+        return;
+    }
+    client.close_when_sent = true;
+    if (get && is("/state"))
+    {
+        const size_t body = strlen(state_);
+        length = snprintf(header, sizeof(header),
+                          "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: %u\r\n"
+                          "Access-Control-Allow-Origin: *\r\nConnection: close\r\n\r\n",
+                          static_cast<unsigned>(body));
+        queue(client, header, static_cast<size_t>(length));
+        queue(client, state_, body);
+        return;
+    }
+    length = snprintf(header, sizeof(header), "HTTP/1.1 %s\r\nContent-Length: 0\r\nConnection: close\r\n\r\n",
+                      get ? "404 Not Found" : "405 Method Not Allowed");
+    queue(client, header, static_cast<size_t>(length));
+}
+
+void StatusServer::flush(Client& client)
+{
+    if (client.output_length > 0)
+    {
+        const ssize_t sent = send(client.fd, client.output, client.output_length, MSG_NOSIGNAL);
+        if (sent < 0 && !wouldBlock())
+        {
+            close(client);
+            return;
+        }
+        if (sent > 0)
+        {
+            client.output_length -= static_cast<size_t>(sent);
+            memmove(client.output, client.output + sent, client.output_length);
+        }
+    }
+    if (client.output_length == 0 && client.close_when_sent)
+    {
+        close(client);
+    }
+}
+
+bool StatusServer::queue(Client& client, const char* data, const size_t length)
+{
+    if (client.output_length + length > kOutputBytes)
+    {
+        return false;
+    }
+    memcpy(client.output + client.output_length, data, length);
+    client.output_length += length;
+    return true;
+}
+
+bool StatusServer::queueEvent(Client& client, const char* event, const char* data)
+{
+    const size_t room = kOutputBytes - client.output_length;
+    const int length = snprintf(client.output + client.output_length, room, "event: %s\ndata: %s\n\n", event, data);
+    if (length < 0 || static_cast<size_t>(length) >= room)
+    {
+        return false;
+    }
+    client.output_length += static_cast<size_t>(length);
+    client.last_activity_ms = nowMs();
+    return true;
+}
+
+void StatusServer::close(Client& client)
+{
+    if (client.fd >= 0)
+    {
+        ::close(client.fd);
+        client.fd = -1;
+    }
+    client.streaming = false;
+    client.output_length = 0;
+}
@@ -0,0 +1,92 @@
+//
+// Tiny HTTP server: GET /state returns a JSON snapshot, GET /events streams Server-Sent Events.
+//
+
+#ifndef STATUSSERVER_H
+#define STATUSSERVER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+// One non-blocking socket loop (BSD sockets: lwIP on the ESP32, the host's on Linux) with every
+// buffer preallocated, so memory is bounded whatever the clients do. Clients beyond kMaxClients
+// get 503; an /events subscriber that stops reading is disconnected once its output buffer is
+// full rather than buffered without limit. poll() runs the loop; setState() and publish() may be
+// called from any task.
+class StatusServer
+{
+public:
+    static constexpr size_t kMaxClients = 4;
+    static constexpr size_t kRequestBytes = 512;
+    static constexpr size_t kOutputBytes = 1024;
+    static constexpr size_t kStateBytes = 256;
+    // A request must arrive this soon after connecting.
+    static constexpr uint32_t kRequestTimeoutMs = 5000;
+    // Comment lines sent to idle subscribers, so dead connections are noticed.
+    static constexpr uint32_t kKeepAliveMs = 15000;
+
+    StatusServer();
+    ~StatusServer();
+
+    StatusServer(const StatusServer&) = delete;
+    StatusServer& operator=(const StatusServer&) = delete;
+
+    // Listens on `port` on every interface; 0 picks a free port (see port()). False on failure.
+    bool begin(uint16_t port);
+    void stop();
+
+    uint16_t port() const
+    {
+        return port_;
+    }
+
+    // Waits up to `timeout_ms` for socket activity, then accepts, answers and flushes what it can.
+    void poll(int timeout_ms);
+
+    // The body of GET /state, also sent to each new subscriber as a "state" event. False if it
+    // does not fit in kStateBytes.
+    bool setState(const char* json);
+
+    // Sends `data` (one line of JSON) as an event named `event` to every subscriber.
+    void publish(const char* event, const char* data);
+
+    size_t subscribers() const;
+
+    // Subscribers disconnected because they fell kOutputBytes behind.
+    uint32_t dropped() const
+    {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Client
+    {
+        int fd;
+        bool streaming;
+        bool close_when_sent;
+        uint32_t last_activity_ms;
+        size_t request_length;
+        size_t output_length;
+        char request[kRequestBytes];
+        char output[kOutputBytes];
+    };
+
+    int listener_;
+    uint16_t port_;
+    mutable std::mutex mutex_;
+    Client clients_[kMaxClients];
+    char state_[kStateBytes];
+    std::atomic<uint32_t> dropped_;
+
+    void accept();
+    void receive(Client& client, uint32_t now_ms);
+    void respond(Client& client);
+    void flush(Client& client);
+    bool queue(Client& client, const char* data, size_t length);
+    bool queueEvent(Client& client, const char* event, const char* data);
+    void close(Client& client);
+};
+
+#endif //STATUSSERVER_H
@@ -0,0 +1,188 @@
+//
+// Cached local calendar and clock strings, so per-second formatting avoids localtime/strftime.
+//
+
+#include "TimeFormat.h"
+
+#include <cstring>
+
+#include "History.h"
+
+namespace
+{
+constexpr time_t kSecondsPerDay = 86400;
+
+void put2(char* out, const unsigned value)
+{
+    out[0] = static_cast<char>('0' + value / 10 % 10);
+    out[1] = static_cast<char>('0' + value % 10);
+}
+
+void put4(char* out, const unsigned value)
+{
+    put2(out, value / 100);
+    put2(out + 2, value % 100);
+}
+
+long secondsOfDay(const struct tm& timeinfo)
+{
+    return timeinfo.tm_hour * 3600L + timeinfo.tm_min * 60L + timeinfo.tm_sec;
+}
+
+void writeClock(const time_t seconds_of_day, char* out)
+{
+    const unsigned seconds = static_cast<unsigned>(seconds_of_day);
+    put2(out, seconds / 3600);
+    out[2] = ':';
+    put2(out + 3, seconds / 60 % 60);
+    out[5] = ':';
+    put2(out + 6, seconds % 60);
+}
+
+// Computed from the broken-down time, since newlib's struct tm has no tm_gmtoff.
+long utcOffset(const struct tm& timeinfo, const time_t t)
+{
+    const time_t local = static_cast<time_t>(daysFromCivil(timeinfo.tm_year + 1900, timeinfo.tm_mon + 1,
+                                                           timeinfo.tm_mday)) * kSecondsPerDay
+        + secondsOfDay(timeinfo);
+    return static_cast<long>(local - t);
+}
+
+long utcOffset(const time_t t)
+{
+    struct tm timeinfo;
+    localtime_r(&t, &timeinfo);
+    return utcOffset(timeinfo, t);
+}
+
+// First instant in (lo, hi] whose UTC offset differs from the one at `lo`. Assumes at most one
+// transition in the range, which holds for any range shorter than a day.
+time_t findTransition(time_t lo, time_t hi)
+{
+    const long offset = utcOffset(lo);
+    while (hi - lo > 1)
+    {
+        const time_t mid = lo + (hi - lo) / 2;
+        if (utcOffset(mid) == offset)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return hi;
+}
+}
+
+LocalTimeCache::LocalTimeCache()
+    : valid_from_(0),
+      boundary_(0),
+      midnight_(0),
+      last_(0),
+      day_(0),
+      weekday_(0),
+      recomputations_(0)
+{
+    memcpy(hms_, "00:00:00", sizeof(hms_));
+    memcpy(date_, "01 01 1970", sizeof(date_));
+    memcpy(iso_date_, "1970-01-01", sizeof(iso_date_));
+}
+
+void LocalTimeCache::update(const time_t now)
+{
+    if (!contains(now))
+    {
+        recompute(now);
+        writeClock(now - midnight_, hms_);
+    }
+    else if (now == last_ + 1 && now != valid_from_)
+    {
+        // The common case: one second later, same interval. Carry through the digits.
+        char* digit = hms_ + 7;
+        static const char limits[] = {'2', '9', 0, '5', '9', 0, '5', '9'};
+        while (digit >= hms_)
+        {
+            if (*digit == ':')
+            {
+                digit--;
+                continue;
+            }
+            if (*digit < limits[digit - hms_])
+            {
+                ++*digit;
+                break;
+            }
+            *digit-- = '0';
+        }
+    }
+    else if (now != last_)
+    {
+        writeClock(now - midnight_, hms_);
+    }
+    last_ = now;
+}
+
+uint16_t LocalTimeCache::dayOf(const time_t t)
+{
+    if (!contains(t))
+    {
+        recompute(t);
+    }
+    return day_;
+}
+
+void LocalTimeCache::formatIso(const time_t t, char* out)
+{
+    if (!contains(t))
+    {
+        recompute(t);
+    }
+    memcpy(out, iso_date_, 10);
+    out[10] = ' ';
+    writeClock(t - midnight_, out + 11);
+}
+
+void LocalTimeCache::recompute(const time_t now)
+{
+    recomputations_++;
+    struct tm timeinfo;
+    localtime_r(&now, &timeinfo);
+    const long offset = utcOffset(timeinfo, now);
+
+    day_ = static_cast<uint16_t>(daysFromCivil(timeinfo.tm_year + 1900, timeinfo.tm_mon + 1, timeinfo.tm_mday));
+    weekday_ = timeinfo.tm_wday;
+    put2(date_, timeinfo.tm_mday);
+    put2(date_ + 3, timeinfo.tm_mon + 1);
+    put4(date_ + 6, timeinfo.tm_year + 1900);
+    put4(iso_date_, timeinfo.tm_year + 1900);
+    put2(iso_date_ + 5, timeinfo.tm_mon + 1);
+    put2(iso_date_ + 8, timeinfo.tm_mday);
+
+    // Midnight at the current offset; the interval is cut short by a DST transition on either side.
+    midnight_ = now - secondsOfDay(timeinfo);
+    valid_from_ = midnight_;
+    if (utcOffset(valid_from_) != offset)
+    {
+        valid_from_ = findTransition(valid_from_, now);
+    }
+    boundary_ = midnight_ + kSecondsPerDay;
+    if (utcOffset(boundary_ - 1) != offset)
+    {
+        boundary_ = findTransition(now, boundary_ - 1);
+    }
+}
+
+void formatMinSec(const time_t seconds, char* out)
+{
+    long wrapped = static_cast<long>(seconds % 3600);
+    if (wrapped < 0)
+    {
+        wrapped += 3600;
+    }
+    put2(out, static_cast<unsigned>(wrapped / 60));
+    out[2] = ':';
+    put2(out + 3, static_cast<unsigned>(wrapped % 60));
+    out[5] = '\0';
+}
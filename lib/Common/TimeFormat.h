@@ -0,0 +1,89 @@
+//
+// Cached local calendar and clock strings, so per-second formatting avoids localtime/strftime.
+//
+
+#ifndef TIMEFORMAT_H
+#define TIMEFORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+
+// Keeps the broken-down local date for the current interval, i.e. until the next local midnight
+// or DST transition, whichever comes first. Inside that interval the UTC offset is constant, so
+// the time of day is plain arithmetic, and consecutive seconds just increment the "HH:MM:SS"
+// digits. localtime_r only runs when an interval boundary is crossed.
+class LocalTimeCache
+{
+public:
+    LocalTimeCache();
+
+    // Brings the cache to `now`.
+    void update(time_t now);
+
+    // "HH:MM:SS" for the last update().
+    const char* hms() const
+    {
+        return hms_;
+    }
+
+    // "DD MM YYYY" of the cached interval (the last update(), dayOf() or formatIso() time).
+    const char* date() const
+    {
+        return date_;
+    }
+
+    // 0 = Sunday.
+    int weekday() const
+    {
+        return weekday_;
+    }
+
+    // Local calendar day, in days since 1970-01-01.
+    uint16_t day() const
+    {
+        return day_;
+    }
+
+    // When the cached date can next change.
+    time_t boundary() const
+    {
+        return boundary_;
+    }
+
+    // Local day of `t`; reuses the cached interval when `t` falls inside it (and moves it otherwise).
+    uint16_t dayOf(time_t t);
+
+    // Writes "YYYY-MM-DD HH:MM:SS" (19 characters, no terminator) for `t`.
+    void formatIso(time_t t, char* out);
+
+    // Number of calendar recomputations so far, for tests and benchmarks.
+    uint32_t recomputations() const
+    {
+        return recomputations_;
+    }
+
+private:
+    time_t valid_from_;
+    time_t boundary_;
+    time_t midnight_;   // now - seconds since local midnight, at the interval's UTC offset
+    time_t last_;
+    uint16_t day_;
+    int weekday_;
+    uint32_t recomputations_;
+    char hms_[sizeof("HH:MM:SS")];
+    char date_[sizeof("DD MM YYYY")];
+    char iso_date_[sizeof("YYYY-MM-DD")];
+
+    bool contains(time_t t) const
+    {
+        return t >= valid_from_ && t < boundary_;
+    }
+
+    void recompute(time_t now);
+};
+
+// "MM:SS" of a duration (minutes wrap at the hour, as with strftime("%M:%S", gmtime(...))).
+void formatMinSec(time_t seconds, char* out);
+
+#endif //TIMEFORMAT_H
@@ -0,0 +1,242 @@
+//
+// In-RAM ring buffer of begin/end/instant trace events, exportable as Chrome trace JSON.
+//
+
+#include "Trace.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include "FrameTiming.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#endif
+
+static_assert((TraceBuffer::kCapacity & (TraceBuffer::kCapacity - 1)) == 0,
+              "the ring index wraps at 2^32, so the capacity must divide it");
+
+namespace
+{
+struct TaskCache
+{
+    const TraceBuffer* buffer;
+    uint32_t generation;
+    uint8_t task;
+};
+
+thread_local TaskCache task_cache = {nullptr, 0, 0};
+// Its address identifies the calling thread.
+thread_local char thread_key;
+
+// Copies `name` into `out` for a JSON string, dropping characters that would need escaping.
+void copyName(char* out, const size_t size, const char* name)
+{
+    size_t length = 0;
+    for (; *name && length + 1 < size; name++)
+    {
+        if (*name != '"' && *name != '\\' && static_cast<unsigned char>(*name) >= ' ')
+        {
+            out[length++] = *name;
+        }
+    }
+    out[length] = '\0';
+}
+}
+
+TraceBuffer::TraceBuffer() : next_(0), enabled_(true), task_count_(0), generation_(1)
+{
+    memset(events_, 0, sizeof(events_));
+    memset(task_names_, 0, sizeof(task_names_));
+    memset(task_keys_, 0, sizeof(task_keys_));
+}
+
+TraceBuffer& tracer()
+{
+    static TraceBuffer buffer;
+    return buffer;
+}
+
+void TraceBuffer::record(const TracePhase phase, const char* name, const uint32_t arg)
+{
+    record(phase, name, arg, static_cast<uint32_t>(monotonicMicros()));
+}
+
+void TraceBuffer::record(const TracePhase phase, const char* name, const uint32_t arg, const uint32_t ts_us)
+{
+    if (!enabled_.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+    const uint8_t task = currentTask();
+    TraceEvent& event = events_[next_.fetch_add(1, std::memory_order_relaxed) % kCapacity];
+    event.ts_us = ts_us;
+    event.arg = arg;
+    event.name = name;
+    event.task = task;
+    event.phase = phase;
+}
+
+void TraceBuffer::complete(const char* name, const uint64_t start_us)
+{
+    record(TracePhase::COMPLETE, name, static_cast<uint32_t>(monotonicMicros() - start_us),
+           static_cast<uint32_t>(start_us));
+}
+
+void TraceBuffer::clear()
+{
+    std::lock_guard<std::mutex> lock(tasks_mutex_);
+    next_.store(0, std::memory_order_relaxed);
+    task_count_.store(0, std::memory_order_relaxed);
+    generation_.fetch_add(1, std::memory_order_relaxed);
+}
+
+size_t TraceBuffer::size() const
+{
+    const uint32_t next = next_.load(std::memory_order_relaxed);
+    return next < kCapacity ? next : kCapacity;
+}
+
+const TraceEvent& TraceBuffer::event(const size_t index) const
+{
+    const uint32_t next = next_.load(std::memory_order_relaxed);
+    const uint32_t first = next < kCapacity ? 0 : next - static_cast<uint32_t>(kCapacity);
+    return events_[(first + index) % kCapacity];
+}
+
+void TraceBuffer::nameTask(const char* name)
+{
+    const uint8_t task = currentTask();
+    std::lock_guard<std::mutex> lock(tasks_mutex_);
+    copyName(task_names_[task], kTaskNameLength, name);
+}
+
+size_t TraceBuffer::taskCount() const
+{
+    return task_count_.load(std::memory_order_relaxed);
+}
+
+const char* TraceBuffer::taskName(const uint8_t task) const
+{
+    return task < kMaxTasks ? task_names_[task] : "";
+}
+
+uint8_t TraceBuffer::currentTask()
+{
+    const uint32_t generation = generation_.load(std::memory_order_relaxed);
+    if (task_cache.buffer == this && task_cache.generation == generation)
+    {
+        return task_cache.task;
+    }
+    std::lock_guard<std::mutex> lock(tasks_mutex_);
+    const uint8_t known = task_count_.load(std::memory_order_relaxed);
+    uint8_t task = 0;
+    while (task < known && task_keys_[task] != &thread_key)
+    {
+        task++;
+    }
+    if (task < known)
+    {
+        // Registered already; the cache was for another buffer.
+    }
+    else if (task < kMaxTasks)
+    {
+        task_keys_[task] = &thread_key;
+#if defined(ARDUINO_ARCH_ESP32)
+        copyName(task_names_[task], kTaskNameLength, pcTaskGetName(nullptr));
+#else
+        snprintf(task_names_[task], kTaskNameLength, "thread %u", static_cast<unsigned>(task));
+#endif
+        task_count_.store(task + 1, std::memory_order_relaxed);
+    }
+    else
+    {
+        // Tasks past the table share its last slot.
+        task = kMaxTasks - 1;
+        copyName(task_names_[task], kTaskNameLength, "other tasks");
+    }
+    task_cache = {this, generation_.load(std::memory_order_relaxed), task};
+    return task;
+}
+
+size_t exportChromeTrace(TraceBuffer& buffer, const TraceSink sink, void* context)
+{
+    const bool was_enabled = buffer.enabled();
+    buffer.setEnabled(false);
+
+    char line[192];
+    const char* header = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    sink(header, strlen(header), context);
+    bool first = true;
+    const auto emit = [&](const int length) {
+        if (length > 0 && static_cast<size_t>(length) < sizeof(line))
+        {
+            sink(line, static_cast<size_t>(length), context);
+            first = false;
+        }
+    };
+
+    for (size_t task = 0; task < buffer.taskCount(); task++)
+    {
+        emit(snprintf(line, sizeof(line), "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+                      "\"args\":{\"name\":\"%s\"}}", first ? "" : ",\n", static_cast<unsigned>(task),
+                      buffer.taskName(static_cast<uint8_t>(task))));
+    }
+
+    // Open spans per task, to drop ends whose begin has been overwritten.
+    uint32_t depth[TraceBuffer::kMaxTasks] = {};
+    const size_t count = buffer.size();
+    uint32_t previous = count > 0 ? buffer.event(0).ts_us : 0;
+    int64_t unwrapped = 0;
+    size_t written = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        const TraceEvent& event = buffer.event(i);
+        // Timestamps are 32-bit; successive events are close together, so the signed difference
+        // carries them across a wrap.
+        unwrapped += static_cast<int32_t>(event.ts_us - previous);
+        previous = event.ts_us;
+        const long long ts = static_cast<long long>(unwrapped);
+        const unsigned tid = event.task < TraceBuffer::kMaxTasks ? event.task : TraceBuffer::kMaxTasks - 1;
+        const char* separator = first ? "" : ",\n";
+        char name[48];
+        copyName(name, sizeof(name), event.name ? event.name : "?");
+        int length = -1;
+        switch (event.phase)
+        {
+        case TracePhase::BEGIN:
+            depth[tid]++;
+            length = snprintf(line, sizeof(line), "%s{\"name\":\"%s\",\"ph\":\"B\",\"pid\":1,\"tid\":%u,\"ts\":%lld}",
+                              separator, name, tid, ts);
+            break;
+        case TracePhase::END:
+            if (depth[tid] == 0)
+            {
+                continue;
+            }
+            depth[tid]--;
+            length = snprintf(line, sizeof(line), "%s{\"name\":\"%s\",\"ph\":\"E\",\"pid\":1,\"tid\":%u,\"ts\":%lld}",
+                              separator, name, tid, ts);
+            break;
+        case TracePhase::INSTANT:
+            length = snprintf(line, sizeof(line),
+                              "%s{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%u,\"ts\":%lld,"
+                              "\"args\":{\"value\":%lu}}",
+                              separator, name, tid, ts, static_cast<unsigned long>(event.arg));
+            break;
+        case TracePhase::COMPLETE:
+            length = snprintf(line, sizeof(line),
+                              "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%lld,\"dur\":%lu}",
+                              separator, name, tid, ts, static_cast<unsigned long>(event.arg));
+            break;
+        }
+        emit(length);
+        written++;
+    }
+
+    const char* footer = "\n]}\n";
+    sink(footer, strlen(footer), context);
+    buffer.setEnabled(was_enabled);
+    return written;
+}
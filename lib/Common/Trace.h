@@ -0,0 +1,143 @@
+//
+// In-RAM ring buffer of begin/end/instant trace events, exportable as Chrome trace JSON.
+//
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+enum class TracePhase : uint8_t
+{
+    BEGIN,
+    END,
+    INSTANT,
+    // A span recorded after the fact: `arg` holds its duration in microseconds.
+    COMPLETE,
+};
+
+// 16 bytes on the ESP32. `name` must be a string literal (or otherwise outlive the buffer);
+// `ts_us` is the low 32 bits of monotonicMicros() and is unwrapped on export.
+struct TraceEvent
+{
+    uint32_t ts_us;
+    uint32_t arg;
+    const char* name;
+    uint8_t task;
+    TracePhase phase;
+};
+
+// Fixed-size ring of the most recent events. Recording claims a slot with one atomic increment and
+// never blocks; once the ring is full the oldest events are overwritten. Tasks get a small id the
+// first time they record, named after the FreeRTOS task (or the host thread, see nameTask()).
+class TraceBuffer
+{
+public:
+    static constexpr size_t kCapacity = 1024;
+    static constexpr size_t kMaxTasks = 16;
+    static constexpr size_t kTaskNameLength = 16;
+
+    TraceBuffer();
+
+    void record(TracePhase phase, const char* name, uint32_t arg = 0);
+    void record(TracePhase phase, const char* name, uint32_t arg, uint32_t ts_us);
+
+    void begin(const char* name)
+    {
+        record(TracePhase::BEGIN, name);
+    }
+
+    void end(const char* name)
+    {
+        record(TracePhase::END, name);
+    }
+
+    void instant(const char* name, const uint32_t arg = 0)
+    {
+        record(TracePhase::INSTANT, name, arg);
+    }
+
+    // Records a span that started at `start_us` (monotonicMicros()) and ends now.
+    void complete(const char* name, uint64_t start_us);
+
+    // Paused while exporting so the events being read are not overwritten.
+    void setEnabled(bool enabled)
+    {
+        enabled_.store(enabled, std::memory_order_relaxed);
+    }
+
+    bool enabled() const
+    {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+
+    void clear();
+
+    // Events currently held, at most kCapacity.
+    size_t size() const;
+
+    // The index-th held event, oldest first.
+    const TraceEvent& event(size_t index) const;
+
+    // Names the calling task, e.g. "main" for a host thread. FreeRTOS tasks are named already.
+    void nameTask(const char* name);
+
+    size_t taskCount() const;
+    const char* taskName(uint8_t task) const;
+
+private:
+    TraceEvent events_[kCapacity];
+    std::atomic<uint32_t> next_;
+    std::atomic<bool> enabled_;
+
+    mutable std::mutex tasks_mutex_;
+    char task_names_[kMaxTasks][kTaskNameLength];
+    const void* task_keys_[kMaxTasks];
+    std::atomic<uint8_t> task_count_;
+    // Bumped by clear() so threads re-register with the emptied task table.
+    std::atomic<uint32_t> generation_;
+
+    uint8_t currentTask();
+};
+
+// The buffer the firmware's trace points record into.
+TraceBuffer& tracer();
+
+// Begin on construction, end on destruction.
+class TraceScope
+{
+public:
+    explicit TraceScope(const char* name, TraceBuffer& buffer = tracer()) : buffer_(buffer), name_(name)
+    {
+        buffer_.begin(name_);
+    }
+
+    ~TraceScope()
+    {
+        buffer_.end(name_);
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    TraceBuffer& buffer_;
+    const char* name_;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+
+// Receives the exported JSON in pieces, e.g. to write it to Serial or a file.
+using TraceSink = void (*)(const char* data, size_t size, void* context);
+
+// Writes the held events as a Chrome trace ({"traceEvents": [...]}) that chrome://tracing and
+// ui.perfetto.dev open directly, with one track per task. An end whose begin was overwritten is
+// dropped. Pauses recording while it runs. Returns the number of events written.
+size_t exportChromeTrace(TraceBuffer& buffer, TraceSink sink, void* context);
+
+#endif //TRACE_H
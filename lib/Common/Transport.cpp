@@ -0,0 +1,96 @@
+//
+// How HttpNotifier delivers queued transitions, a compact binary form of them, and what delivery costs.
+//
+
+#include "Transport.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include "ByteCodec.h"
+
+namespace
+{
+constexpr uint32_t kSegmentHeaderBytes = 40;
+constexpr uint32_t kConnectionSegments = 3 + 4;
+// A segment and its ACK each way.
+constexpr uint32_t kRoundTripSegments = 4;
+constexpr uint8_t kRecordVersion = 1;
+
+const char* const kTransitionNames[] = {"idle_to_work", "work_to_break", "break_to_idle", "work_to_idle"};
+}
+
+uint32_t airBytes(const TransportStats& stats)
+{
+    return stats.bytes_sent + stats.bytes_received
+        + (stats.connects * kConnectionSegments + stats.round_trips * kRoundTripSegments) * kSegmentHeaderBytes;
+}
+
+uint32_t httpPostBytes(const char* host, const uint16_t port, const char* path, const size_t payload_length)
+{
+    // Header for header as HTTPClient::sendHeader writes them; the port is left out when it is 80.
+    char port_suffix[8] = "";
+    if (port != 80)
+    {
+        snprintf(port_suffix, sizeof(port_suffix), ":%u", static_cast<unsigned>(port));
+    }
+    const int headers = snprintf(nullptr, 0,
+                                 "POST %s HTTP/1.1\r\nHost: %s%s\r\nUser-Agent: ESP32HTTPClient\r\n"
+                                 "Connection: keep-alive\r\nAccept-Encoding: identity;q=1,chunked;q=0.1,*;q=0\r\n"
+                                 "Content-Type: application/json\r\nContent-Length: %zu\r\n\r\n",
+                                 path, host, port_suffix, payload_length);
+    return static_cast<uint32_t>(headers > 0 ? headers : 0) + static_cast<uint32_t>(payload_length);
+}
+
+bool transitionKind(const char* name, TransitionKind* kind)
+{
+    for (size_t i = 0; i < sizeof(kTransitionNames) / sizeof(kTransitionNames[0]); i++)
+    {
+        if (strcmp(name, kTransitionNames[i]) == 0)
+        {
+            *kind = static_cast<TransitionKind>(i + 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* transitionName(const TransitionKind kind)
+{
+    const size_t index = static_cast<size_t>(kind) - 1;
+    return index < sizeof(kTransitionNames) / sizeof(kTransitionNames[0]) ? kTransitionNames[index] : "unknown";
+}
+
+size_t encodeTransition(const TransitionRecord& record, uint8_t* out, const size_t capacity)
+{
+    const size_t label = strnlen(record.flavor, sizeof(record.flavor) - 1);
+    const size_t size = 15 + label;
+    if (size > capacity)
+    {
+        return 0;
+    }
+    out[0] = kRecordVersion;
+    out[1] = static_cast<uint8_t>(record.kind);
+    putUint32(out + 2, record.start_time);
+    putUint32(out + 6, record.event_time);
+    putUint32(out + 10, record.duration);
+    out[14] = static_cast<uint8_t>(label);
+    memcpy(out + 15, record.flavor, label);
+    return size;
+}
+
+bool decodeTransition(const uint8_t* data, const size_t length, TransitionRecord* record)
+{
+    if (length < 15 || data[0] != kRecordVersion || data[14] >= sizeof(record->flavor)
+        || length != 15u + data[14])
+    {
+        return false;
+    }
+    record->kind = static_cast<TransitionKind>(data[1]);
+    record->start_time = getUint32(data + 2);
+    record->event_time = getUint32(data + 6);
+    record->duration = getUint32(data + 10);
+    memcpy(record->flavor, data + 15, data[14]);
+    record->flavor[data[14]] = '\0';
+    return true;
+}
@@ -0,0 +1,87 @@
+//
+// How HttpNotifier delivers queued transitions, a compact binary form of them, and what delivery costs.
+//
+
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+
+// Traffic a transport caused, as a proxy for radio energy: the radio stays awake for every
+// connection setup and every request/acknowledgement round trip, and airtime grows with bytes.
+struct TransportStats
+{
+    uint32_t connects;
+    uint32_t round_trips;
+    uint32_t bytes_sent;
+    uint32_t bytes_received;
+};
+
+// Bytes on the air including what TCP/IP adds: 40 bytes of headers per segment, a segment and
+// its ACK per direction of each round trip, and a three-way handshake plus four-segment close
+// per connection. A model for comparing transports, not a measurement.
+uint32_t airBytes(const TransportStats& stats);
+
+// What arduino-esp32's HTTPClient sends for a POST of `payload_length` bytes of JSON.
+uint32_t httpPostBytes(const char* host, uint16_t port, const char* path, size_t payload_length);
+
+// The reference backend's (tools/http_backend.py) response headers, which HTTPClient does not count.
+constexpr uint32_t kHttpResponseHeaderBytes = 129;
+
+// Where HttpNotifier sends things. Only its queue task calls these, so implementations may
+// block and keep a connection between calls.
+class Transport
+{
+public:
+    virtual ~Transport() = default;
+
+    // Delivers one queued transition (the JSON HttpNotifier queued on the SD card). True once the
+    // backend has acknowledged it; the event stays queued otherwise.
+    virtual bool sendTransition(time_t start_time, const char* json) = 0;
+
+    // Delivers a "metrics" or "postmortem" JSON document. True once acknowledged.
+    virtual bool sendDocument(const char* name, const char* json) = 0;
+
+    // Called whenever the queue task wakes up; keeps a persistent connection alive. Returns how
+    // many milliseconds the task may sleep before calling it again (UINT32_MAX: no limit).
+    virtual uint32_t idle()
+    {
+        return UINT32_MAX;
+    }
+
+    virtual TransportStats stats() const = 0;
+};
+
+enum class TransitionKind : uint8_t
+{
+    IDLE_TO_WORK = 1,
+    WORK_TO_BREAK = 2,
+    BREAK_TO_IDLE = 3,
+    WORK_TO_IDLE = 4,
+};
+
+// One transition as HttpNotifier queues it. `duration` is the work, break or cancelled work
+// duration (0 for IDLE_TO_WORK); `flavor` is the label, empty after a break.
+struct TransitionRecord
+{
+    TransitionKind kind;
+    uint32_t start_time;
+    uint32_t event_time;
+    uint32_t duration;
+    char flavor[16];
+};
+
+// "idle_to_work" and so on; false for anything else.
+bool transitionKind(const char* name, TransitionKind* kind);
+const char* transitionName(TransitionKind kind);
+
+// Binary form: version, kind, start, event and duration (little-endian uint32), then the label's
+// length and bytes. 15 bytes plus the label, against about 110 bytes of JSON. Returns the size,
+// or 0 if `capacity` is too small.
+constexpr size_t kTransitionRecordMaxBytes = 15 + 15;
+size_t encodeTransition(const TransitionRecord& record, uint8_t* out, size_t capacity);
+bool decodeTransition(const uint8_t* data, size_t length, TransitionRecord* record);
+
+#endif //TRANSPORT_H
@@ -0,0 +1,132 @@
+//
+// Emulator: Serial on stdin/stdout, the Arduino clock on virtual time, and the chip id.
+//
+
+#include <Arduino.h>
+
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <mutex>
+
+#include "Emulator.h"
+
+HardwareSerial Serial;
+EspClass ESP;
+
+namespace
+{
+std::mutex serial_mutex;
+
+size_t writeOut(const char* data, const size_t size)
+{
+    std::lock_guard<std::mutex> lock(serial_mutex);
+    const size_t written = fwrite(data, 1, size, stdout);
+    fflush(stdout);
+    return written;
+}
+}
+
+void HardwareSerial::begin(unsigned long)
+{
+}
+
+int HardwareSerial::available()
+{
+    // Bytes waiting, not readability: stdin at end of file is readable but has nothing to read.
+    int waiting = 0;
+    return ioctl(STDIN_FILENO, FIONREAD, &waiting) == 0 ? waiting : 0;
+}
+
+int HardwareSerial::read()
+{
+    if (!available())
+    {
+        return -1;
+    }
+    unsigned char c;
+    return ::read(STDIN_FILENO, &c, 1) == 1 ? c : -1;
+}
+
+size_t HardwareSerial::write(const uint8_t* data, const size_t size)
+{
+    return writeOut(reinterpret_cast<const char*>(data), size);
+}
+
+size_t HardwareSerial::write(const uint8_t byte)
+{
+    return write(&byte, 1);
+}
+
+size_t HardwareSerial::print(const char* text)
+{
+    return writeOut(text, strlen(text));
+}
+
+size_t HardwareSerial::print(const String& text)
+{
+    return writeOut(text.c_str(), text.length());
+}
+
+size_t HardwareSerial::print(const char c)
+{
+    return writeOut(&c, 1);
+}
+
+size_t HardwareSerial::print(const long value)
+{
+    return print(String(value));
+}
+
+size_t HardwareSerial::println(const char* text)
+{
+    return print(String(text) + "\n");
+}
+
+size_t HardwareSerial::println(const String& text)
+{
+    return print(text + "\n");
+}
+
+size_t HardwareSerial::println(const long value)
+{
+    return println(String(value));
+}
+
+size_t HardwareSerial::printf(const char* format, ...)
+{
+    char buffer[512];
+    va_list arguments;
+    va_start(arguments, format);
+    const int length = vsnprintf(buffer, sizeof(buffer), format, arguments);
+    va_end(arguments);
+    if (length < 0)
+    {
+        return 0;
+    }
+    return writeOut(buffer, std::min(static_cast<size_t>(length), sizeof(buffer) - 1));
+}
+
+uint64_t EspClass::getEfuseMac()
+{
+    // Locally administered, with the process id where the firmware takes its LAN sync writer id
+    // from (bits 16 and up, the lowest forced to 1).
+    return 0x020000000000ull | static_cast<uint64_t>(getpid()) << 17;
+}
+
+// 32 bits wide, as on the device, so code that subtracts them sees the same wraparound.
+unsigned long millis()
+{
+    return static_cast<uint32_t>(emulator::virtualMicros() / 1000);
+}
+
+unsigned long micros()
+{
+    return static_cast<uint32_t>(emulator::virtualMicros());
+}
+
+void delay(const uint32_t ms)
+{
+    vTaskDelay(pdMS_TO_TICKS(ms));
+}
@@ -0,0 +1,21 @@
+//
+// Emulator: the files board_build.embed_files links into the firmware, under the same symbols.
+//
+
+// Paths are relative to the project directory, which the emulator env passes to the assembler.
+asm(R"(
+    .section .rodata
+    .global _binary_gong_wav_start
+    .global _binary_gong_wav_end
+    .balign 4
+_binary_gong_wav_start:
+    .incbin "gong.wav"
+_binary_gong_wav_end:
+    .global _binary_pomodoro_red_splash_jpeg_start
+    .global _binary_pomodoro_red_splash_jpeg_end
+    .balign 4
+_binary_pomodoro_red_splash_jpeg_start:
+    .incbin "pomodoro-red-splash.jpeg"
+_binary_pomodoro_red_splash_jpeg_end:
+    .previous
+)");
@@ -0,0 +1,319 @@
+//
+// Emulator: the virtual clock, the wrapped system clock calls and the cost reports.
+//
+
+#include "Emulator.h"
+
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+emulator::Options run_options;
+std::atomic<int64_t> wall_offset_us(0);
+std::atomic<bool> interrupted(false);
+
+std::atomic<uint32_t> second_frames(0);
+std::atomic<uint64_t> second_panel_bytes(0);
+std::atomic<uint32_t> second_led_shows(0);
+std::atomic<uint64_t> second_audio_frames(0);
+std::atomic<uint64_t> second_sd_read(0);
+std::atomic<uint64_t> second_sd_write(0);
+
+std::mutex frames_mutex;
+std::vector<uint32_t> frame_cpu_us;
+uint64_t frame_bytes_total = 0;
+FILE* per_frame_file = nullptr;
+
+std::atomic<const uint16_t*> screen(nullptr);
+int16_t screen_width = 0;
+int16_t screen_height = 0;
+
+std::chrono::steady_clock::time_point bootTime()
+{
+    static const std::chrono::steady_clock::time_point boot = std::chrono::steady_clock::now();
+    return boot;
+}
+
+uint64_t cpuNanos(const clockid_t clock)
+{
+    timespec value;
+    if (clock_gettime(clock, &value) != 0)
+    {
+        return 0;
+    }
+    return static_cast<uint64_t>(value.tv_sec) * 1000000000ull + static_cast<uint64_t>(value.tv_nsec);
+}
+
+uint32_t percentile(const std::vector<uint32_t>& sorted, const unsigned percent)
+{
+    return sorted.empty() ? 0 : sorted[(sorted.size() - 1) * percent / 100];
+}
+
+void writeScreen()
+{
+    const uint16_t* pixels = screen.load();
+    if (run_options.screen_ppm.empty() || !pixels)
+    {
+        return;
+    }
+    FILE* file = fopen(run_options.screen_ppm.c_str(), "wb");
+    if (!file)
+    {
+        fprintf(stderr, "emulator: cannot write %s\n", run_options.screen_ppm.c_str());
+        return;
+    }
+    fprintf(file, "P6\n%d %d\n255\n", screen_width, screen_height);
+    for (size_t i = 0; i < static_cast<size_t>(screen_width) * screen_height; i++)
+    {
+        // Panel byte order back to RGB565, then to 8 bits a channel.
+        const uint16_t color = static_cast<uint16_t>((pixels[i] >> 8) | (pixels[i] << 8));
+        const uint8_t rgb[3] = {static_cast<uint8_t>((color >> 11) * 255 / 31),
+                                static_cast<uint8_t>(((color >> 5) & 0x3F) * 255 / 63),
+                                static_cast<uint8_t>((color & 0x1F) * 255 / 31)};
+        fwrite(rgb, 1, sizeof(rgb), file);
+    }
+    fclose(file);
+}
+
+void writeSummary(const double real_seconds, const uint64_t process_cpu_ns, const uint64_t seconds,
+                  const uint64_t totals[6])
+{
+    const double virtual_seconds = static_cast<double>(emulator::virtualMicros()) / 1e6;
+    fprintf(stderr, "emulator: %.0f s virtual in %.1f s real (%.1fx, asked %.1fx), %.2f s CPU\n", virtual_seconds,
+            real_seconds, real_seconds > 0 ? virtual_seconds / real_seconds : 0.0, run_options.speed,
+            static_cast<double>(process_cpu_ns) / 1e9);
+    fprintf(stderr, "%-18s %12s %7s\n", "task", "cpu_us", "share");
+    for (const emulator::TaskCpu& task : emulator::taskCpu())
+    {
+        fprintf(stderr, "%-18s %12llu %6.1f%%\n", task.name, static_cast<unsigned long long>(task.cpu_ns / 1000),
+                process_cpu_ns > 0 ? 100.0 * static_cast<double>(task.cpu_ns) / static_cast<double>(process_cpu_ns)
+                                   : 0.0);
+    }
+    {
+        std::lock_guard<std::mutex> lock(frames_mutex);
+        std::vector<uint32_t> sorted = frame_cpu_us;
+        std::sort(sorted.begin(), sorted.end());
+        fprintf(stderr, "frames: %zu, %llu bytes; cpu_us p50 %u p99 %u max %u\n", sorted.size(),
+                static_cast<unsigned long long>(frame_bytes_total), percentile(sorted, 50), percentile(sorted, 99),
+                sorted.empty() ? 0 : sorted.back());
+    }
+    const double per = seconds > 0 ? 1.0 / static_cast<double>(seconds) : 0.0;
+    fprintf(stderr,
+            "per second: %.2f frames, %.0f panel bytes, %.2f LED shows, %.0f audio frames, %.0f SD bytes read, "
+            "%.0f written\n",
+            totals[0] * per, totals[1] * per, totals[2] * per, totals[3] * per, totals[4] * per, totals[5] * per);
+}
+}
+
+const emulator::Options& emulator::options()
+{
+    return run_options;
+}
+
+void emulator::configure(const Options& options)
+{
+    run_options = options;
+    bootTime();
+    if (!run_options.per_frame_csv.empty())
+    {
+        per_frame_file = fopen(run_options.per_frame_csv.c_str(), "w");
+        if (per_frame_file)
+        {
+            fprintf(per_frame_file, "frame,second,cpu_us,bytes,rects\n");
+        }
+    }
+}
+
+uint64_t emulator::virtualMicros()
+{
+    const auto elapsed = std::chrono::steady_clock::now() - bootTime();
+    const double real_us = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count())
+        / 1000.0;
+    return static_cast<uint64_t>(real_us * run_options.speed);
+}
+
+std::chrono::steady_clock::time_point emulator::realTimeAt(const uint64_t virtual_us)
+{
+    const double real_ns = static_cast<double>(virtual_us) * 1000.0 / run_options.speed;
+    return bootTime() + std::chrono::nanoseconds(static_cast<int64_t>(real_ns));
+}
+
+void emulator::sleepUntil(const uint64_t virtual_us)
+{
+    std::this_thread::sleep_until(realTimeAt(virtual_us));
+}
+
+int64_t emulator::wallMicros()
+{
+    return wall_offset_us + static_cast<int64_t>(virtualMicros());
+}
+
+void emulator::setWallMicros(const int64_t wall_us)
+{
+    wall_offset_us = wall_us - static_cast<int64_t>(virtualMicros());
+}
+
+int64_t emulator::trueWallMicros()
+{
+    return static_cast<int64_t>(run_options.start) * 1000000 + static_cast<int64_t>(virtualMicros());
+}
+
+void emulator::frameDone(const uint32_t bytes, const uint32_t rects)
+{
+    // What the pushing task spent since its previous frame: rendering this one.
+    thread_local uint64_t last_cpu_ns = 0;
+    const uint64_t cpu_ns = cpuNanos(CLOCK_THREAD_CPUTIME_ID);
+    const uint32_t cpu_us = static_cast<uint32_t>((cpu_ns - last_cpu_ns) / 1000);
+    last_cpu_ns = cpu_ns;
+    second_frames++;
+    second_panel_bytes += bytes;
+    std::lock_guard<std::mutex> lock(frames_mutex);
+    frame_cpu_us.push_back(cpu_us);
+    frame_bytes_total += bytes;
+    if (per_frame_file)
+    {
+        fprintf(per_frame_file, "%zu,%llu,%u,%u,%u\n", frame_cpu_us.size() - 1,
+                static_cast<unsigned long long>(virtualMicros() / 1000000), cpu_us, bytes, rects);
+    }
+}
+
+void emulator::ledsShown(const uint32_t)
+{
+    second_led_shows++;
+}
+
+void emulator::audioQueued(const uint32_t frames)
+{
+    second_audio_frames += frames;
+}
+
+void emulator::sdRead(const size_t bytes)
+{
+    second_sd_read += bytes;
+}
+
+void emulator::sdWritten(const size_t bytes)
+{
+    second_sd_write += bytes;
+}
+
+void emulator::setScreen(const uint16_t* pixels, const int16_t width, const int16_t height)
+{
+    screen_width = width;
+    screen_height = height;
+    screen = pixels;
+}
+
+void emulator::report()
+{
+    // Ctrl-C ends the run at the next second, with the summary.
+    signal(SIGINT, [](int) { interrupted = true; });
+    FILE* per_second = run_options.per_second_csv.empty() ? nullptr : fopen(run_options.per_second_csv.c_str(), "w");
+    if (per_second)
+    {
+        fprintf(per_second, "second,cpu_us,frames,panel_bytes,led_shows,audio_frames,sd_read,sd_write,busiest_task,"
+                            "busiest_cpu_us\n");
+    }
+    const auto started = std::chrono::steady_clock::now();
+    std::vector<TaskCpu> last_tasks = taskCpu();
+    uint64_t last_cpu_ns = cpuNanos(CLOCK_PROCESS_CPUTIME_ID);
+    uint64_t totals[6] = {};
+    uint64_t second = 0;
+    while (!interrupted && (run_options.seconds <= 0 || static_cast<double>(second) < run_options.seconds))
+    {
+        second++;
+        sleepUntil(second * 1000000);
+        const uint64_t cpu_ns = cpuNanos(CLOCK_PROCESS_CPUTIME_ID);
+        const uint64_t counts[6] = {second_frames.exchange(0),       second_panel_bytes.exchange(0),
+                                    second_led_shows.exchange(0),    second_audio_frames.exchange(0),
+                                    second_sd_read.exchange(0),      second_sd_write.exchange(0)};
+        const std::vector<TaskCpu> tasks = taskCpu();
+        const char* busiest = "-";
+        uint64_t busiest_ns = 0;
+        for (size_t i = 0; i < tasks.size(); i++)
+        {
+            const uint64_t before = i < last_tasks.size() ? last_tasks[i].cpu_ns : 0;
+            if (tasks[i].cpu_ns - before > busiest_ns)
+            {
+                busiest_ns = tasks[i].cpu_ns - before;
+                busiest = tasks[i].name;
+            }
+        }
+        for (size_t i = 0; i < 6; i++)
+        {
+            totals[i] += counts[i];
+        }
+        if (per_second)
+        {
+            fprintf(per_second, "%llu,%llu", static_cast<unsigned long long>(second),
+                    static_cast<unsigned long long>((cpu_ns - last_cpu_ns) / 1000));
+            for (const uint64_t count : counts)
+            {
+                fprintf(per_second, ",%llu", static_cast<unsigned long long>(count));
+            }
+            fprintf(per_second, ",%s,%llu\n", busiest, static_cast<unsigned long long>(busiest_ns / 1000));
+        }
+        last_cpu_ns = cpu_ns;
+        last_tasks = tasks;
+    }
+    const double real_seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    fflush(stdout);
+    writeSummary(real_seconds, cpuNanos(CLOCK_PROCESS_CPUTIME_ID), second, totals);
+    writeScreen();
+    if (per_second)
+    {
+        fclose(per_second);
+    }
+    {
+        std::lock_guard<std::mutex> lock(frames_mutex);
+        if (per_frame_file)
+        {
+            fclose(per_frame_file);
+            per_frame_file = nullptr;
+        }
+    }
+    fflush(stderr);
+    // The firmware's tasks never return; leave without running destructors under them.
+    _exit(0);
+}
+
+// Linked with --wrap=time,--wrap=gettimeofday,--wrap=settimeofday: the firmware and lib/Common
+// see the emulated system clock, which starts at 1970 like the ESP32's until something sets it.
+extern "C" time_t __wrap_time(time_t* out)
+{
+    const time_t now = static_cast<time_t>(emulator::wallMicros() / 1000000);
+    if (out)
+    {
+        *out = now;
+    }
+    return now;
+}
+
+extern "C" int __wrap_gettimeofday(timeval* out, void*)
+{
+    if (out)
+    {
+        const int64_t now = emulator::wallMicros();
+        out->tv_sec = static_cast<time_t>(now / 1000000);
+        out->tv_usec = static_cast<suseconds_t>(now % 1000000);
+    }
+    return 0;
+}
+
+extern "C" int __wrap_settimeofday(const timeval* value, const void*)
+{
+    if (value)
+    {
+        emulator::setWallMicros(static_cast<int64_t>(value->tv_sec) * 1000000 + value->tv_usec);
+    }
+    return 0;
+}
@@ -0,0 +1,79 @@
+//
+// The emulated board: virtual time, run options and the cost reports the shims feed.
+//
+
+#ifndef EMULATOR_H
+#define EMULATOR_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace emulator
+{
+struct ScriptedPress
+{
+    // 0, 1, 2 for BtnA, BtnB, BtnC.
+    uint8_t button;
+    uint64_t at_us;
+};
+
+struct Options
+{
+    // Virtual seconds per real second.
+    double speed = 1.0;
+    // Virtual seconds to run before reporting and exiting; 0 runs until interrupted.
+    double seconds = 0;
+    std::string sd_dir = "sd";
+    // What the RTC and, once synchronized, NTP say it is at boot.
+    time_t start = 0;
+    double wifi_after = 2.0;
+    bool offline = false;
+    std::vector<ScriptedPress> presses;
+    std::string per_second_csv;
+    std::string per_frame_csv;
+    std::string screen_ppm;
+};
+
+const Options& options();
+void configure(const Options& options);
+
+// Microseconds of virtual time since boot. millis(), micros(), ticks and the wall clock follow
+// it; monotonicMicros() and the cost reports stay on host time.
+uint64_t virtualMicros();
+std::chrono::steady_clock::time_point realTimeAt(uint64_t virtual_us);
+void sleepUntil(uint64_t virtual_us);
+
+// The system clock as time()/gettimeofday() see it, and what it should say.
+int64_t wallMicros();
+void setWallMicros(int64_t wall_us);
+int64_t trueWallMicros();
+
+// Called by the panel when a frame finished going out, from the task that pushed it.
+void frameDone(uint32_t bytes, uint32_t rects);
+void ledsShown(uint32_t leds);
+void audioQueued(uint32_t frames);
+void sdRead(size_t bytes);
+void sdWritten(size_t bytes);
+
+// The panel's pixels in panel byte order, for the screenshot.
+void setScreen(const uint16_t* pixels, int16_t width, int16_t height);
+
+// Host CPU time of each task, exited ones included, in creation order.
+struct TaskCpu
+{
+    const char* name;
+    uint64_t cpu_ns;
+};
+
+std::vector<TaskCpu> taskCpu();
+
+// Runs the per-second report until options().seconds of virtual time have passed, then writes the
+// summary and exits the process. Call from main() once setup() is running on its task.
+[[noreturn]] void report();
+}
+
+#endif //EMULATOR_H
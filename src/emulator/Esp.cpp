@@ -0,0 +1,140 @@
+//
+// Emulator: NVS in memory and the capability heaps of the ESP32 with 8 MB of PSRAM, 4 MB mapped.
+//
+
+#include <Preferences.h>
+#include <esp_heap_caps.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+// What is left of the internal heap once the Arduino core and WiFi are up.
+constexpr size_t kInternalBytes = 200 * 1024;
+constexpr size_t kPsramBytes = 4 * 1024 * 1024;
+
+std::mutex nvs_mutex;
+std::map<std::string, std::vector<uint8_t>> nvs;
+
+struct Region
+{
+    size_t size;
+    size_t used;
+    size_t peak;
+};
+
+std::mutex heap_mutex;
+Region internal_heap = {kInternalBytes, 0, 0};
+Region psram = {kPsramBytes, 0, 0};
+std::unordered_map<void*, std::pair<Region*, size_t>> allocations;
+
+Region& region(const uint32_t caps)
+{
+    return caps & MALLOC_CAP_SPIRAM ? psram : internal_heap;
+}
+}
+
+bool Preferences::begin(const char* name, const bool read_only)
+{
+    namespace_ = name;
+    open_ = true;
+    read_only_ = read_only;
+    return true;
+}
+
+void Preferences::end()
+{
+    open_ = false;
+}
+
+size_t Preferences::getBytesLength(const char* key)
+{
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    const auto found = nvs.find(namespace_ + "/" + key);
+    return open_ && found != nvs.end() ? found->second.size() : 0;
+}
+
+size_t Preferences::getBytes(const char* key, void* buffer, const size_t capacity)
+{
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    const auto found = nvs.find(namespace_ + "/" + key);
+    if (!open_ || found == nvs.end() || found->second.size() > capacity)
+    {
+        return 0;
+    }
+    memcpy(buffer, found->second.data(), found->second.size());
+    return found->second.size();
+}
+
+size_t Preferences::putBytes(const char* key, const void* data, const size_t size)
+{
+    if (!open_ || read_only_)
+    {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    nvs[namespace_ + "/" + key].assign(bytes, bytes + size);
+    return size;
+}
+
+void* heap_caps_malloc(const size_t size, const uint32_t caps)
+{
+    std::lock_guard<std::mutex> lock(heap_mutex);
+    Region& from = region(caps);
+    if (size > from.size - from.used)
+    {
+        return nullptr;
+    }
+    void* pointer = malloc(size);
+    if (pointer)
+    {
+        from.used += size;
+        from.peak = from.used > from.peak ? from.used : from.peak;
+        allocations[pointer] = {&from, size};
+    }
+    return pointer;
+}
+
+void heap_caps_free(void* pointer)
+{
+    if (!pointer)
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(heap_mutex);
+        const auto found = allocations.find(pointer);
+        if (found != allocations.end())
+        {
+            found->second.first->used -= found->second.second;
+            allocations.erase(found);
+        }
+    }
+    free(pointer);
+}
+
+size_t heap_caps_get_free_size(const uint32_t caps)
+{
+    std::lock_guard<std::mutex> lock(heap_mutex);
+    const Region& from = region(caps);
+    return from.size - from.used;
+}
+
+// No fragmentation is modelled: the free space is one block.
+size_t heap_caps_get_largest_free_block(const uint32_t caps)
+{
+    return heap_caps_get_free_size(caps);
+}
+
+size_t heap_caps_get_minimum_free_size(const uint32_t caps)
+{
+    std::lock_guard<std::mutex> lock(heap_mutex);
+    const Region& from = region(caps);
+    return from.size - from.peak;
+}
@@ -0,0 +1,46 @@
+//
+// Emulator: FastLED's show() as the time the strips' data takes on the wire.
+//
+
+#include <FastLED.h>
+
+#include "Emulator.h"
+
+CFastLED FastLED;
+
+namespace
+{
+// 24 bits at 800 kHz, plus the latch.
+constexpr uint64_t kUsPerLed = 30;
+constexpr uint64_t kLatchUs = 80;
+}
+
+void CFastLED::addStrip(CRGB* leds, const int count)
+{
+    if (count_ < kMaxStrips)
+    {
+        strips_[count_++] = {leds, count};
+    }
+}
+
+void CFastLED::clear()
+{
+    for (size_t i = 0; i < count_; i++)
+    {
+        for (int led = 0; led < strips_[i].count; led++)
+        {
+            strips_[i].leds[led] = CRGB();
+        }
+    }
+}
+
+void CFastLED::show()
+{
+    uint32_t leds = 0;
+    for (size_t i = 0; i < count_; i++)
+    {
+        leds += static_cast<uint32_t>(strips_[i].count);
+    }
+    emulator::ledsShown(leds);
+    emulator::sleepUntil(emulator::virtualMicros() + leds * kUsPerLed + count_ * kLatchUs);
+}
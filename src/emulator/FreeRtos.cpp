@@ -0,0 +1,435 @@
+//
+// Emulator: FreeRTOS tasks, notifications, queues and mutexes on host threads, waiting in virtual time.
+//
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#include <pthread.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Emulator.h"
+
+struct tskTaskControlBlock
+{
+    char name[16];
+    TaskFunction_t code;
+    void* parameters;
+    // Bytes, scaled for host frames (kHostStackScale).
+    uint32_t stack_depth;
+    // The mapping starts with a guard page; the stack proper follows it.
+    uint8_t* mapping;
+    uint8_t* stack;
+    size_t stack_size;
+    // Bytes at the top taken before the task's code ran: the thread descriptor and TLS.
+    size_t baseline;
+    pthread_t thread;
+    clockid_t cpu_clock;
+    std::atomic<bool> running;
+    std::atomic<bool> deleted;
+    std::atomic<uint64_t> final_cpu_ns;
+    std::mutex mutex;
+    std::condition_variable wake;
+    uint32_t notifications;
+};
+
+struct QueueDefinition
+{
+    std::mutex mutex;
+    std::condition_variable changed;
+    size_t item_size;
+    size_t length;
+    std::vector<uint8_t> items;
+    size_t head;
+    size_t count;
+};
+
+struct SemaphoreDefinition
+{
+    std::timed_mutex mutex;
+};
+
+namespace
+{
+constexpr uint8_t kPaint = 0xA5;
+constexpr size_t kHostStackBytes = 256 * 1024;
+// x86-64 frames and glibc's printf take several times the stack of the device's; headroom is
+// reported against the depth asked for times this, so the monitor's alerts keep their meaning.
+constexpr uint32_t kHostStackScale = 4;
+
+std::mutex registry_mutex;
+// Exited tasks stay, for the report.
+std::vector<tskTaskControlBlock*> registry;
+thread_local tskTaskControlBlock* current_task = nullptr;
+
+uint64_t cpuNanos(const clockid_t clock)
+{
+    timespec value;
+    if (clock_gettime(clock, &value) != 0)
+    {
+        return 0;
+    }
+    return static_cast<uint64_t>(value.tv_sec) * 1000000000ull + static_cast<uint64_t>(value.tv_nsec);
+}
+
+bool forever(const TickType_t ticks)
+{
+    return ticks == portMAX_DELAY;
+}
+
+std::chrono::steady_clock::time_point deadline(const TickType_t ticks)
+{
+    return emulator::realTimeAt(emulator::virtualMicros() + static_cast<uint64_t>(ticks) * 1000u);
+}
+
+[[noreturn]] void exitTask(tskTaskControlBlock* task)
+{
+    task->final_cpu_ns = cpuNanos(task->cpu_clock);
+    task->running = false;
+    pthread_exit(nullptr);
+}
+
+// A task another one deleted goes at its next wait.
+void checkDeleted()
+{
+    if (current_task && current_task->deleted)
+    {
+        exitTask(current_task);
+    }
+}
+
+void sleepUntilReal(const std::chrono::steady_clock::time_point until)
+{
+    tskTaskControlBlock* task = current_task;
+    if (!task)
+    {
+        std::this_thread::sleep_until(until);
+        return;
+    }
+    {
+        std::unique_lock<std::mutex> lock(task->mutex);
+        task->wake.wait_until(lock, until, [task]() { return task->deleted.load(); });
+    }
+    checkDeleted();
+}
+
+void* runTask(void* context)
+{
+    tskTaskControlBlock* task = static_cast<tskTaskControlBlock*>(context);
+    current_task = task;
+    pthread_setname_np(pthread_self(), task->name);
+    uint8_t marker;
+    task->baseline = static_cast<size_t>(task->stack + task->stack_size - &marker);
+    task->code(task->parameters);
+    // FreeRTOS tasks must not return; treat it as vTaskDelete(nullptr).
+    exitTask(task);
+}
+}
+
+BaseType_t xTaskCreatePinnedToCore(const TaskFunction_t code, const char* name, const uint32_t stack_depth,
+                                   void* parameters, UBaseType_t, TaskHandle_t* created, BaseType_t)
+{
+    tskTaskControlBlock* task = new tskTaskControlBlock();
+    snprintf(task->name, sizeof(task->name), "%s", name ? name : "");
+    task->code = code;
+    task->parameters = parameters;
+    task->stack_depth = stack_depth * kHostStackScale;
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    task->stack_size = kHostStackBytes;
+    void* mapping = mmap(nullptr, page + task->stack_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED)
+    {
+        delete task;
+        return pdFAIL;
+    }
+    task->mapping = static_cast<uint8_t*>(mapping);
+    mprotect(task->mapping, page, PROT_NONE);
+    task->stack = task->mapping + page;
+    // Painted like FreeRTOS paints its stacks, so the high-water mark is the first byte overwritten.
+    memset(task->stack, kPaint, task->stack_size);
+    task->running = true;
+    task->deleted = false;
+    task->final_cpu_ns = 0;
+    task->notifications = 0;
+
+    pthread_attr_t attributes;
+    pthread_attr_init(&attributes);
+    pthread_attr_setstack(&attributes, task->stack, task->stack_size);
+    pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+    {
+        // Registered before it runs, so a task may look itself up by name straight away.
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        registry.push_back(task);
+        if (created)
+        {
+            *created = task;
+        }
+        if (pthread_create(&task->thread, &attributes, runTask, task) != 0)
+        {
+            registry.pop_back();
+            pthread_attr_destroy(&attributes);
+            if (created)
+            {
+                *created = nullptr;
+            }
+            return pdFAIL;
+        }
+        pthread_getcpuclockid(task->thread, &task->cpu_clock);
+    }
+    pthread_attr_destroy(&attributes);
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if (!task || task == current_task)
+    {
+        if (current_task)
+        {
+            exitTask(current_task);
+        }
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(task->mutex);
+        task->deleted = true;
+    }
+    task->wake.notify_all();
+    while (task->running)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void vTaskDelay(const TickType_t ticks)
+{
+    sleepUntilReal(deadline(ticks));
+}
+
+void vTaskDelayUntil(TickType_t* previous_wake, const TickType_t increment)
+{
+    const TickType_t target = *previous_wake + increment;
+    *previous_wake = target;
+    const uint64_t now_ms = emulator::virtualMicros() / 1000;
+    const int32_t remaining = static_cast<int32_t>(target - static_cast<TickType_t>(now_ms));
+    // Like FreeRTOS: a wake time already passed does not block.
+    if (remaining > 0)
+    {
+        sleepUntilReal(emulator::realTimeAt((now_ms + static_cast<uint64_t>(remaining)) * 1000u));
+    }
+    else
+    {
+        checkDeleted();
+    }
+}
+
+TickType_t xTaskGetTickCount()
+{
+    return static_cast<TickType_t>(emulator::virtualMicros() / 1000);
+}
+
+TaskHandle_t xTaskGetHandle(const char* name)
+{
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (tskTaskControlBlock* task : registry)
+    {
+        if (task->running && strncmp(task->name, name, sizeof(task->name) - 1) == 0)
+        {
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+char* pcTaskGetName(TaskHandle_t task)
+{
+    static char unknown[] = "?";
+    task = task ? task : current_task;
+    return task ? task->name : unknown;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+    task = task ? task : current_task;
+    if (!task)
+    {
+        return 0;
+    }
+    // Word by word: the monitor samples every task's stack, and its time shows up in the report.
+    uint64_t painted;
+    memset(&painted, kPaint, sizeof(painted));
+    size_t untouched = 0;
+    while (untouched + sizeof(painted) <= task->stack_size
+           && memcmp(task->stack + untouched, &painted, sizeof(painted)) == 0)
+    {
+        untouched += sizeof(painted);
+    }
+    const size_t used = task->stack_size - untouched - task->baseline;
+    return used < task->stack_depth ? static_cast<UBaseType_t>((task->stack_depth - used) / kHostStackScale) : 0;
+}
+
+void xTaskNotifyGive(TaskHandle_t task)
+{
+    {
+        std::lock_guard<std::mutex> lock(task->mutex);
+        task->notifications++;
+    }
+    task->wake.notify_all();
+}
+
+uint32_t ulTaskNotifyTake(const BaseType_t clear_on_exit, const TickType_t ticks_to_wait)
+{
+    tskTaskControlBlock* task = current_task;
+    if (!task)
+    {
+        return 0;
+    }
+    uint32_t value;
+    {
+        std::unique_lock<std::mutex> lock(task->mutex);
+        const auto ready = [task]() { return task->notifications > 0 || task->deleted; };
+        if (forever(ticks_to_wait))
+        {
+            task->wake.wait(lock, ready);
+        }
+        else
+        {
+            task->wake.wait_until(lock, deadline(ticks_to_wait), ready);
+        }
+        value = task->notifications;
+        if (value > 0)
+        {
+            task->notifications = clear_on_exit ? 0 : value - 1;
+        }
+    }
+    checkDeleted();
+    return value;
+}
+
+QueueHandle_t xQueueCreate(const UBaseType_t length, const UBaseType_t item_size)
+{
+    QueueDefinition* queue = new QueueDefinition();
+    queue->item_size = item_size;
+    queue->length = length;
+    queue->items.resize(static_cast<size_t>(length) * item_size);
+    queue->head = 0;
+    queue->count = 0;
+    return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    delete queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, const TickType_t ticks_to_wait)
+{
+    {
+        std::unique_lock<std::mutex> lock(queue->mutex);
+        const auto room = [queue]() { return queue->count < queue->length; };
+        if (!room())
+        {
+            if (ticks_to_wait == 0)
+            {
+                return pdFALSE;
+            }
+            if (forever(ticks_to_wait))
+            {
+                queue->changed.wait(lock, room);
+            }
+            else if (!queue->changed.wait_until(lock, deadline(ticks_to_wait), room))
+            {
+                return pdFALSE;
+            }
+        }
+        const size_t slot = (queue->head + queue->count) % queue->length;
+        memcpy(queue->items.data() + slot * queue->item_size, item, queue->item_size);
+        queue->count++;
+    }
+    queue->changed.notify_all();
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, const TickType_t ticks_to_wait)
+{
+    {
+        std::unique_lock<std::mutex> lock(queue->mutex);
+        const auto waiting = [queue]() { return queue->count > 0; };
+        if (!waiting())
+        {
+            if (ticks_to_wait == 0)
+            {
+                return pdFALSE;
+            }
+            if (forever(ticks_to_wait))
+            {
+                queue->changed.wait(lock, waiting);
+            }
+            else if (!queue->changed.wait_until(lock, deadline(ticks_to_wait), waiting))
+            {
+                return pdFALSE;
+            }
+        }
+        memcpy(item, queue->items.data() + queue->head * queue->item_size, queue->item_size);
+        queue->head = (queue->head + 1) % queue->length;
+        queue->count--;
+    }
+    queue->changed.notify_all();
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    return static_cast<UBaseType_t>(queue->count);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex()
+{
+    return new SemaphoreDefinition();
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore)
+{
+    delete semaphore;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, const TickType_t ticks_to_wait)
+{
+    if (forever(ticks_to_wait))
+    {
+        semaphore->mutex.lock();
+        return pdTRUE;
+    }
+    return semaphore->mutex.try_lock_until(deadline(ticks_to_wait)) ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+    semaphore->mutex.unlock();
+    return pdTRUE;
+}
+
+std::vector<emulator::TaskCpu> emulator::taskCpu()
+{
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    std::vector<TaskCpu> tasks;
+    tasks.reserve(registry.size());
+    for (const tskTaskControlBlock* task : registry)
+    {
+        tasks.push_back({task->name, task->running ? cpuNanos(task->cpu_clock) : task->final_cpu_ns.load()});
+    }
+    return tasks;
+}
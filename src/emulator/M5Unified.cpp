@@ -0,0 +1,460 @@
+//
+// Emulator: the Core2's panel, canvases, buttons, speaker and RTC.
+//
+
+#include <M5Unified.h>
+
+#include <algorithm>
+#include <array>
+
+#include "Emulator.h"
+#include "HostFramebuffer.h"
+
+M5Unified M5;
+
+namespace
+{
+// 40 MHz SPI: five bytes a microsecond.
+constexpr uint64_t kPanelBytesPerUs = 5;
+// Long enough in host time for the 15 ms debouncer, whatever the speed.
+constexpr uint64_t kHoldRealUs = 40000;
+constexpr uint16_t kSplashColor = 0xD8A3;
+
+uint16_t panelOrder(const uint32_t color)
+{
+    return static_cast<uint16_t>(((color >> 8) & 0xFF) | ((color & 0xFF) << 8));
+}
+
+uint16_t rgb888to565(const uint32_t rgb)
+{
+    return static_cast<uint16_t>(((rgb >> 8) & 0xF800) | ((rgb >> 5) & 0x07E0) | ((rgb >> 3) & 0x001F));
+}
+
+// Each button's presses as [down, up) in virtual time: held kHoldRealUs of host time, and released
+// for as long before the next press, so presses scripted too close together come later instead
+// of merging.
+struct Hold
+{
+    uint64_t down_us;
+    uint64_t up_us;
+};
+
+const std::vector<Hold>& holds(const uint8_t button)
+{
+    static const std::array<std::vector<Hold>, 3> schedule = []() {
+        std::array<std::vector<Hold>, 3> result;
+        std::vector<emulator::ScriptedPress> presses = emulator::options().presses;
+        std::stable_sort(presses.begin(), presses.end(),
+                         [](const emulator::ScriptedPress& a, const emulator::ScriptedPress& b) {
+                             return a.at_us < b.at_us;
+                         });
+        const uint64_t hold_us = static_cast<uint64_t>(kHoldRealUs * emulator::options().speed);
+        for (const emulator::ScriptedPress& press : presses)
+        {
+            if (press.button >= result.size())
+            {
+                continue;
+            }
+            std::vector<Hold>& button_holds = result[press.button];
+            const uint64_t earliest = button_holds.empty() ? 0 : button_holds.back().up_us + hold_us;
+            const uint64_t down_us = std::max(press.at_us, earliest);
+            button_holds.push_back({down_us, down_us + hold_us});
+        }
+        return result;
+    }();
+    return schedule[button];
+}
+}
+
+M5GFX::M5GFX()
+    : pixels_(static_cast<size_t>(kWidth) * kHeight, 0),
+      clip_x_(0),
+      clip_y_(0),
+      clip_w_(kWidth),
+      clip_h_(kHeight),
+      write_depth_(0),
+      frame_bytes_(0),
+      frame_rects_(0),
+      frame_cpu_ns_(0),
+      dma_done_us_(0)
+{
+    emulator::setScreen(pixels_.data(), kWidth, kHeight);
+}
+
+void M5GFX::startWrite()
+{
+    write_depth_++;
+}
+
+void M5GFX::endWrite()
+{
+    if (write_depth_ > 0 && --write_depth_ == 0 && frame_rects_ > 0)
+    {
+        emulator::frameDone(frame_bytes_, frame_rects_);
+        frame_bytes_ = 0;
+        frame_rects_ = 0;
+    }
+}
+
+void M5GFX::waitDMA()
+{
+    emulator::sleepUntil(dma_done_us_);
+}
+
+void M5GFX::setClipRect(const int32_t x, const int32_t y, const int32_t w, const int32_t h)
+{
+    clip_x_ = x;
+    clip_y_ = y;
+    clip_w_ = w;
+    clip_h_ = h;
+}
+
+void M5GFX::clearClipRect()
+{
+    setClipRect(0, 0, kWidth, kHeight);
+}
+
+void M5GFX::pushImageDMA(const int32_t x, const int32_t y, const int32_t w, const int32_t h,
+                         const lgfx::swap565_t* pixels)
+{
+    startWrite();
+    transfer(x, y, w, h, reinterpret_cast<const uint16_t*>(pixels), w);
+    endWrite();
+}
+
+void M5GFX::fillScreen(const uint16_t color)
+{
+    const std::vector<uint16_t> row(kWidth, panelOrder(color));
+    startWrite();
+    for (int32_t y = 0; y < kHeight; y++)
+    {
+        transfer(0, y, kWidth, 1, row.data(), kWidth);
+    }
+    endWrite();
+    waitDMA();
+}
+
+bool M5GFX::drawJpg(const uint8_t*, size_t, const int32_t, const int32_t)
+{
+    fillScreen(kSplashColor);
+    return true;
+}
+
+void M5GFX::setTextSize(float)
+{
+}
+
+size_t M5GFX::print(const char* text)
+{
+    fprintf(stderr, "emulator: panel text: %s\n", text);
+    return strlen(text);
+}
+
+uint32_t M5GFX::color16to24(const uint16_t color)
+{
+    const uint32_t r = (color >> 11) & 0x1F;
+    const uint32_t g = (color >> 5) & 0x3F;
+    const uint32_t b = color & 0x1F;
+    return (r * 255 / 31) << 16 | (g * 255 / 63) << 8 | (b * 255 / 31);
+}
+
+void M5GFX::transfer(const int32_t x, const int32_t y, const int32_t w, const int32_t h, const uint16_t* pixels,
+                     const int32_t stride)
+{
+    const int32_t left = std::max({x, clip_x_, 0});
+    const int32_t top = std::max({y, clip_y_, 0});
+    const int32_t right = std::min({x + w, clip_x_ + clip_w_, kWidth});
+    const int32_t bottom = std::min({y + h, clip_y_ + clip_h_, kHeight});
+    if (left >= right || top >= bottom)
+    {
+        return;
+    }
+    for (int32_t row = top; row < bottom; row++)
+    {
+        std::copy_n(pixels + static_cast<size_t>(row - y) * stride + (left - x), right - left,
+                    pixels_.begin() + static_cast<size_t>(row) * kWidth + left);
+    }
+    const uint32_t bytes = static_cast<uint32_t>((right - left) * (bottom - top)) * sizeof(uint16_t);
+    frame_bytes_ += bytes;
+    frame_rects_++;
+    dma_done_us_ = std::max(dma_done_us_, emulator::virtualMicros()) + bytes / kPanelBytesPerUs;
+}
+
+M5Canvas::M5Canvas(M5GFX* parent)
+    : panel_(parent),
+      canvas_(nullptr),
+      width_(0),
+      height_(0),
+      bits_(16),
+      palette_{0, 0xFFFF},
+      clip_x_(0),
+      clip_y_(0),
+      clip_w_(0),
+      clip_h_(0),
+      text_color_(0xFFFF),
+      font_(1)
+{
+}
+
+M5Canvas::M5Canvas(M5Canvas* parent) : M5Canvas(static_cast<M5GFX*>(nullptr))
+{
+    canvas_ = parent;
+}
+
+void* M5Canvas::createSprite(const int32_t w, const int32_t h)
+{
+    width_ = w;
+    height_ = h;
+    // One element a pixel at either depth; a 1-bit pixel holds its palette index.
+    pixels_.assign(static_cast<size_t>(w) * h, 0);
+    clearClipRect();
+    return getBuffer();
+}
+
+void M5Canvas::deleteSprite()
+{
+    pixels_.clear();
+    pixels_.shrink_to_fit();
+    width_ = 0;
+    height_ = 0;
+}
+
+void M5Canvas::setColorDepth(const int bits)
+{
+    bits_ = bits;
+}
+
+bool M5Canvas::createPalette()
+{
+    return bits_ == 1;
+}
+
+void M5Canvas::setPaletteColor(const size_t index, const uint32_t rgb888)
+{
+    if (index < 2)
+    {
+        palette_[index] = panelOrder(rgb888to565(rgb888));
+    }
+}
+
+void M5Canvas::fillSprite(const uint32_t color)
+{
+    const int32_t x = clip_x_;
+    const int32_t y = clip_y_;
+    const int32_t w = clip_w_;
+    const int32_t h = clip_h_;
+    clearClipRect();
+    fillRect(0, 0, width_, height_, color);
+    setClipRect(x, y, w, h);
+}
+
+void M5Canvas::fillRect(const int32_t x, const int32_t y, const int32_t w, const int32_t h, const uint32_t color)
+{
+    // Clipped once and filled a row at a time, so the shim adds little to what a profile shows.
+    const int32_t left = std::max({x, clip_x_, 0});
+    const int32_t top = std::max({y, clip_y_, 0});
+    const int32_t right = std::min({x + w, clip_x_ + clip_w_, width_});
+    const int32_t bottom = std::min({y + h, clip_y_ + clip_h_, height_});
+    const uint16_t value = bits_ == 1 ? static_cast<uint16_t>(color & 1) : panelOrder(color);
+    for (int32_t row = top; row < bottom; row++)
+    {
+        std::fill_n(pixels_.begin() + static_cast<size_t>(row) * width_ + left, right - left, value);
+    }
+}
+
+void M5Canvas::setClipRect(const int32_t x, const int32_t y, const int32_t w, const int32_t h)
+{
+    clip_x_ = x;
+    clip_y_ = y;
+    clip_w_ = w;
+    clip_h_ = h;
+}
+
+void M5Canvas::clearClipRect()
+{
+    setClipRect(0, 0, width_, height_);
+}
+
+void M5Canvas::setTextColor(const uint32_t color)
+{
+    text_color_ = color;
+}
+
+void M5Canvas::setTextSize(float)
+{
+}
+
+void M5Canvas::setTextFont(const uint8_t font)
+{
+    font_ = font;
+}
+
+void M5Canvas::setTextDatum(textdatum_t)
+{
+}
+
+int32_t M5Canvas::drawString(const char* text, const int32_t x, const int32_t y)
+{
+    const FixedFontMetrics metrics;
+    const int32_t height = metrics.height(font_);
+    int32_t cell_x = x;
+    for (const char* c = text; *c != '\0'; c++)
+    {
+        const int32_t width = metrics.charWidth(font_, *c);
+        const unsigned glyph = static_cast<unsigned char>(*c);
+        for (int32_t dy = 0; dy < height; dy++)
+        {
+            for (int32_t dx = 0; dx < width; dx++)
+            {
+                if ((dx * 7 + dy * 13 + glyph) % 5 == 0)
+                {
+                    plot(cell_x + dx, y + dy, text_color_);
+                }
+            }
+        }
+        cell_x += width;
+    }
+    return cell_x - x;
+}
+
+int32_t M5Canvas::fontHeight() const
+{
+    return FixedFontMetrics().height(font_);
+}
+
+int32_t M5Canvas::textWidth(const char* text) const
+{
+    const FixedFontMetrics metrics;
+    int32_t width = 0;
+    for (const char* c = text; *c != '\0'; c++)
+    {
+        width += metrics.charWidth(font_, *c);
+    }
+    return width;
+}
+
+void M5Canvas::pushSprite(const int32_t x, const int32_t y)
+{
+    if (!panel_ || pixels_.empty())
+    {
+        return;
+    }
+    panel_->startWrite();
+    panel_->transfer(x, y, width_, height_, pixels_.data(), width_);
+    panel_->endWrite();
+    // Not DMA: the caller waits for the wire.
+    panel_->waitDMA();
+}
+
+void M5Canvas::pushSprite(M5Canvas* destination, const int32_t x, const int32_t y)
+{
+    const int32_t left = std::max({x, destination->clip_x_, 0});
+    const int32_t top = std::max({y, destination->clip_y_, 0});
+    const int32_t right = std::min({x + width_, destination->clip_x_ + destination->clip_w_, destination->width_});
+    const int32_t bottom = std::min({y + height_, destination->clip_y_ + destination->clip_h_, destination->height_});
+    for (int32_t row = top; row < bottom; row++)
+    {
+        for (int32_t column = left; column < right; column++)
+        {
+            const uint16_t value = at(column - x, row - y);
+            destination->pixels_[static_cast<size_t>(row) * destination->width_ + column] =
+                bits_ == 1 ? palette_[value & 1] : value;
+        }
+    }
+}
+
+void M5Canvas::plot(const int32_t x, const int32_t y, const uint32_t color)
+{
+    if (x < std::max(clip_x_, 0) || y < std::max(clip_y_, 0) || x >= std::min(clip_x_ + clip_w_, width_)
+        || y >= std::min(clip_y_ + clip_h_, height_))
+    {
+        return;
+    }
+    pixels_[static_cast<size_t>(y) * width_ + x] = bits_ == 1 ? static_cast<uint16_t>(color & 1) : panelOrder(color);
+}
+
+uint16_t M5Canvas::at(const int32_t x, const int32_t y) const
+{
+    return pixels_[static_cast<size_t>(y) * width_ + x];
+}
+
+bool Button_Class::isPressed() const
+{
+    const uint64_t now = emulator::virtualMicros();
+    for (const Hold& hold : holds(index_))
+    {
+        if (now < hold.down_us)
+        {
+            return false;
+        }
+        if (now < hold.up_us)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t Speaker_Class::isPlaying(const uint8_t)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    expire();
+    return ends_us_.size();
+}
+
+bool Speaker_Class::playRaw(const int16_t*, const size_t frames, const uint32_t rate, const bool stereo, uint32_t,
+                            int, const bool stop_current)
+{
+    if (rate == 0)
+    {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    expire();
+    if (stop_current)
+    {
+        ends_us_.clear();
+    }
+    const uint64_t start_us = ends_us_.empty() ? emulator::virtualMicros() : ends_us_.back();
+    const uint64_t played = stereo ? frames / 2 : frames;
+    ends_us_.push_back(start_us + played * 1000000 / rate);
+    emulator::audioQueued(static_cast<uint32_t>(played));
+    return true;
+}
+
+void Speaker_Class::stop(uint8_t)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    ends_us_.clear();
+}
+
+void Speaker_Class::expire()
+{
+    const uint64_t now = emulator::virtualMicros();
+    while (!ends_us_.empty() && ends_us_.front() <= now)
+    {
+        ends_us_.pop_front();
+    }
+}
+
+m5::rtc_datetime_t RTC_Class::getDateTime()
+{
+    if (!set_)
+    {
+        offset_ = static_cast<int64_t>(emulator::options().start);
+        set_ = true;
+    }
+    const time_t now = static_cast<time_t>(offset_ + static_cast<int64_t>(emulator::virtualMicros() / 1000000));
+    tm utc;
+    gmtime_r(&now, &utc);
+    return {{static_cast<int16_t>(utc.tm_year + 1900), static_cast<int8_t>(utc.tm_mon + 1),
+             static_cast<int8_t>(utc.tm_mday), static_cast<int8_t>(utc.tm_wday)},
+            {static_cast<int8_t>(utc.tm_hour), static_cast<int8_t>(utc.tm_min), static_cast<int8_t>(utc.tm_sec)}};
+}
+
+void RTC_Class::setDateTime(const tm* utc)
+{
+    tm copy = *utc;
+    offset_ = static_cast<int64_t>(timegm(&copy)) - static_cast<int64_t>(emulator::virtualMicros() / 1000000);
+    set_ = true;
+}
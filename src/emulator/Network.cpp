@@ -0,0 +1,216 @@
+//
+// Emulator: the WiFi station, SNTP and HTTPClient. Sockets the firmware opens itself are the host's.
+//
+
+#include <HTTPClient.h>
+#include <WiFi.h>
+#include <esp_sntp.h>
+
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+
+#include "Emulator.h"
+
+WiFiClass WiFi;
+
+namespace
+{
+std::atomic<bool> sntp_started(false);
+std::atomic<bool> sntp_synchronized(false);
+std::atomic<sntp_sync_time_cb_t> sntp_callback(nullptr);
+
+// Once, and only with WiFi up, like a real first sync.
+void sntpSynchronize()
+{
+    if (!sntp_started || WiFi.status() != WL_CONNECTED || sntp_synchronized.exchange(true))
+    {
+        return;
+    }
+    emulator::setWallMicros(emulator::trueWallMicros());
+    if (const sntp_sync_time_cb_t callback = sntp_callback.load())
+    {
+        timeval now;
+        gettimeofday(&now, nullptr);
+        callback(&now);
+    }
+}
+
+bool sendAll(const int socket, const char* data, size_t size)
+{
+    while (size > 0)
+    {
+        const ssize_t sent = send(socket, data, size, MSG_NOSIGNAL);
+        if (sent <= 0)
+        {
+            return false;
+        }
+        data += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+}
+
+String IPAddress::toString() const
+{
+    char text[16];
+    snprintf(text, sizeof(text), "%u.%u.%u.%u", (address_ >> 24) & 0xFF, (address_ >> 16) & 0xFF,
+             (address_ >> 8) & 0xFF, address_ & 0xFF);
+    return String(text);
+}
+
+wl_status_t WiFiClass::begin(const char*, const char*)
+{
+    begun_ = true;
+    begun_us_ = emulator::virtualMicros();
+    return status();
+}
+
+wl_status_t WiFiClass::status()
+{
+    const double wifi_after_us = emulator::options().wifi_after * 1e6;
+    if (!begun_ || emulator::options().offline
+        || static_cast<double>(emulator::virtualMicros() - begun_us_) < wifi_after_us)
+    {
+        return WL_DISCONNECTED;
+    }
+    return WL_CONNECTED;
+}
+
+bool WiFiClass::disconnect()
+{
+    begun_ = false;
+    return true;
+}
+
+IPAddress WiFiClass::localIP()
+{
+    return IPAddress(status() == WL_CONNECTED ? 0x7F000001u : 0u);
+}
+
+void sntp_set_time_sync_notification_cb(const sntp_sync_time_cb_t callback)
+{
+    sntp_callback = callback;
+}
+
+void sntp_setoperatingmode(uint8_t)
+{
+}
+
+void sntp_setservername(uint8_t, const char*)
+{
+}
+
+void sntp_init()
+{
+    sntp_started = true;
+    sntpSynchronize();
+}
+
+sntp_sync_status_t sntp_get_sync_status()
+{
+    if (!sntp_started || WiFi.status() != WL_CONNECTED)
+    {
+        return SNTP_SYNC_STATUS_RESET;
+    }
+    sntpSynchronize();
+    return SNTP_SYNC_STATUS_COMPLETED;
+}
+
+bool HTTPClient::begin(WiFiClient&, const String& url)
+{
+    const std::string& text = url.str();
+    const std::string scheme = "http://";
+    if (text.compare(0, scheme.size(), scheme) != 0)
+    {
+        return false;
+    }
+    const size_t path_at = text.find('/', scheme.size());
+    const std::string authority = text.substr(scheme.size(), path_at - scheme.size());
+    path_ = path_at == std::string::npos ? "/" : text.substr(path_at);
+    const size_t colon = authority.find(':');
+    host_ = authority.substr(0, colon);
+    port_ = colon == std::string::npos ? 80 : static_cast<uint16_t>(atoi(authority.c_str() + colon + 1));
+    headers_.clear();
+    size_ = -1;
+    return !host_.empty() && port_ != 0;
+}
+
+void HTTPClient::addHeader(const String& name, const String& value)
+{
+    headers_ += name.str() + ": " + value.str() + "\r\n";
+}
+
+void HTTPClient::setTimeout(const uint16_t timeout_ms)
+{
+    timeout_ms_ = timeout_ms;
+}
+
+int HTTPClient::POST(uint8_t* payload, const size_t size)
+{
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses = nullptr;
+    if (getaddrinfo(host_.c_str(), std::to_string(port_).c_str(), &hints, &addresses) != 0)
+    {
+        return HTTPC_ERROR_CONNECTION_REFUSED;
+    }
+    int socket = -1;
+    for (const addrinfo* address = addresses; address && socket < 0; address = address->ai_next)
+    {
+        socket = ::socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (socket >= 0 && connect(socket, address->ai_addr, address->ai_addrlen) != 0)
+        {
+            close(socket);
+            socket = -1;
+        }
+    }
+    freeaddrinfo(addresses);
+    if (socket < 0)
+    {
+        return HTTPC_ERROR_CONNECTION_REFUSED;
+    }
+    // Host time, like the lwIP timeouts on the device.
+    const timeval timeout = {timeout_ms_ / 1000, static_cast<suseconds_t>(timeout_ms_ % 1000) * 1000};
+    setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    const std::string request = "POST " + path_ + " HTTP/1.1\r\nHost: " + host_ + "\r\n" + headers_
+        + "Content-Length: " + std::to_string(size) + "\r\nConnection: close\r\n\r\n";
+    if (!sendAll(socket, request.data(), request.size())
+        || !sendAll(socket, reinterpret_cast<const char*>(payload), size))
+    {
+        close(socket);
+        return HTTPC_ERROR_SEND_PAYLOAD_FAILED;
+    }
+    std::string response;
+    char buffer[512];
+    ssize_t received;
+    while (response.find("\r\n\r\n") == std::string::npos && (received = recv(socket, buffer, sizeof(buffer), 0)) > 0)
+    {
+        response.append(buffer, static_cast<size_t>(received));
+    }
+    close(socket);
+    int code = 0;
+    if (sscanf(response.c_str(), "HTTP/%*s %d", &code) != 1)
+    {
+        return HTTPC_ERROR_READ_TIMEOUT;
+    }
+    const size_t length_at = response.find("Content-Length:");
+    size_ = length_at == std::string::npos ? -1 : atoi(response.c_str() + length_at + 15);
+    return code;
+}
+
+int HTTPClient::getSize() const
+{
+    return size_;
+}
+
+void HTTPClient::end()
+{
+    headers_.clear();
+}
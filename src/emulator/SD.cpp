@@ -0,0 +1,240 @@
+//
+// Emulator: the SD card over a host directory.
+//
+
+#include <SD.h>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "Emulator.h"
+
+SDFS SD;
+
+struct File::Handle
+{
+    std::string path;
+    std::string name;
+    FILE* file = nullptr;
+    DIR* directory = nullptr;
+
+    ~Handle()
+    {
+        if (file)
+        {
+            fclose(file);
+        }
+        if (directory)
+        {
+            closedir(directory);
+        }
+    }
+};
+
+namespace
+{
+std::string hostPath(const char* path)
+{
+    return emulator::options().sd_dir + (path[0] == '/' ? "" : "/") + path;
+}
+}
+
+size_t File::size() const
+{
+    struct stat status;
+    if (!handle_ || !handle_->file || fstat(fileno(handle_->file), &status) != 0)
+    {
+        return 0;
+    }
+    // Counts what is still buffered for writing too.
+    return std::max(static_cast<size_t>(status.st_size), position());
+}
+
+time_t File::getLastWrite() const
+{
+    struct stat status;
+    return handle_ && stat(handle_->path.c_str(), &status) == 0 ? status.st_mtime : 0;
+}
+
+size_t File::position() const
+{
+    if (!handle_ || !handle_->file)
+    {
+        return 0;
+    }
+    const long at = ftell(handle_->file);
+    return at < 0 ? 0 : static_cast<size_t>(at);
+}
+
+bool File::seek(const uint32_t position)
+{
+    return handle_ && handle_->file && fseek(handle_->file, static_cast<long>(position), SEEK_SET) == 0;
+}
+
+int File::available() const
+{
+    const size_t length = size();
+    const size_t at = position();
+    return at < length ? static_cast<int>(length - at) : 0;
+}
+
+int File::read()
+{
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+size_t File::read(uint8_t* buffer, const size_t size)
+{
+    if (!handle_ || !handle_->file)
+    {
+        return 0;
+    }
+    const size_t count = fread(buffer, 1, size, handle_->file);
+    emulator::sdRead(count);
+    return count;
+}
+
+size_t File::write(const uint8_t* data, const size_t size)
+{
+    if (!handle_ || !handle_->file)
+    {
+        return 0;
+    }
+    const size_t written = fwrite(data, 1, size, handle_->file);
+    emulator::sdWritten(written);
+    return written;
+}
+
+size_t File::print(const String& text)
+{
+    return write(reinterpret_cast<const uint8_t*>(text.c_str()), text.length());
+}
+
+size_t File::print(const char* text)
+{
+    return write(reinterpret_cast<const uint8_t*>(text), strlen(text));
+}
+
+void File::close()
+{
+    handle_.reset();
+}
+
+bool File::isDirectory() const
+{
+    return handle_ && handle_->directory;
+}
+
+File File::openNextFile()
+{
+    if (!handle_ || !handle_->directory)
+    {
+        return File();
+    }
+    while (const dirent* entry = readdir(handle_->directory))
+    {
+        if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0)
+        {
+            const std::string path = handle_->path + "/" + entry->d_name;
+            auto handle = std::make_shared<Handle>();
+            handle->path = path;
+            handle->name = entry->d_name;
+            handle->directory = opendir(path.c_str());
+            if (!handle->directory)
+            {
+                handle->file = fopen(path.c_str(), "rb");
+            }
+            return File(std::move(handle));
+        }
+    }
+    return File();
+}
+
+const char* File::name() const
+{
+    return handle_ ? handle_->name.c_str() : "";
+}
+
+bool SDFS::begin(uint8_t)
+{
+    const std::string& root = emulator::options().sd_dir;
+    struct stat status;
+    if (stat(root.c_str(), &status) != 0 && ::mkdir(root.c_str(), 0755) != 0)
+    {
+        return false;
+    }
+    return stat(root.c_str(), &status) == 0 && S_ISDIR(status.st_mode);
+}
+
+File SDFS::open(const char* path, const char* mode)
+{
+    auto handle = std::make_shared<File::Handle>();
+    handle->path = hostPath(path);
+    const char* slash = strrchr(path, '/');
+    handle->name = slash ? slash + 1 : path;
+    if (mode[0] == 'r')
+    {
+        handle->directory = opendir(handle->path.c_str());
+    }
+    if (!handle->directory)
+    {
+        handle->file = fopen(handle->path.c_str(), mode[0] == 'a' ? "ab" : mode[0] == 'w' ? "wb" : "rb");
+        if (!handle->file)
+        {
+            return File();
+        }
+    }
+    return File(std::move(handle));
+}
+
+File SDFS::open(const String& path, const char* mode)
+{
+    return open(path.c_str(), mode);
+}
+
+bool SDFS::exists(const char* path)
+{
+    struct stat status;
+    return stat(hostPath(path).c_str(), &status) == 0;
+}
+
+bool SDFS::exists(const String& path)
+{
+    return exists(path.c_str());
+}
+
+bool SDFS::remove(const char* path)
+{
+    return ::remove(hostPath(path).c_str()) == 0;
+}
+
+bool SDFS::remove(const String& path)
+{
+    return remove(path.c_str());
+}
+
+bool SDFS::mkdir(const char* path)
+{
+    return ::mkdir(hostPath(path).c_str(), 0755) == 0;
+}
+
+bool SDFS::mkdir(const String& path)
+{
+    return mkdir(path.c_str());
+}
+
+// Linked with --wrap=truncate: on the device the card is mounted at "/sd" in the VFS.
+extern "C" int __real_truncate(const char* path, off_t length);
+
+extern "C" int __wrap_truncate(const char* path, const off_t length)
+{
+    if (strncmp(path, "/sd/", 4) == 0)
+    {
+        return __real_truncate(hostPath(path + 3).c_str(), length);
+    }
+    return __real_truncate(path, length);
+}
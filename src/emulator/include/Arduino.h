@@ -0,0 +1,232 @@
+//
+// Emulator shim: the parts of the Arduino core the firmware uses, on virtual time.
+//
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <sys/time.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+class StringSumHelper;
+
+// Arduino's String over std::string; numbers convert to decimal text as on the device.
+class String
+{
+public:
+    String() = default;
+
+    String(const char* text) : value_(text ? text : "")
+    {
+    }
+
+    String(const std::string& text) : value_(text)
+    {
+    }
+
+    explicit String(char c) : value_(1, c)
+    {
+    }
+
+    explicit String(unsigned char value) : value_(std::to_string(value))
+    {
+    }
+
+    explicit String(int value) : value_(std::to_string(value))
+    {
+    }
+
+    explicit String(unsigned int value) : value_(std::to_string(value))
+    {
+    }
+
+    explicit String(long value) : value_(std::to_string(value))
+    {
+    }
+
+    explicit String(unsigned long value) : value_(std::to_string(value))
+    {
+    }
+
+    explicit String(long long value) : value_(std::to_string(value))
+    {
+    }
+
+    explicit String(unsigned long long value) : value_(std::to_string(value))
+    {
+    }
+
+    const char* c_str() const
+    {
+        return value_.c_str();
+    }
+
+    unsigned int length() const
+    {
+        return static_cast<unsigned int>(value_.size());
+    }
+
+    bool reserve(unsigned int size)
+    {
+        value_.reserve(size);
+        return true;
+    }
+
+    bool concat(const char* text)
+    {
+        value_ += text ? text : "";
+        return true;
+    }
+
+    bool concat(const char* text, unsigned int length)
+    {
+        value_.append(text, length);
+        return true;
+    }
+
+    String& operator+=(const String& other)
+    {
+        value_ += other.value_;
+        return *this;
+    }
+
+    String& operator+=(const char* text)
+    {
+        value_ += text ? text : "";
+        return *this;
+    }
+
+    String& operator+=(char c)
+    {
+        value_ += c;
+        return *this;
+    }
+
+    char operator[](unsigned int index) const
+    {
+        return index < value_.size() ? value_[index] : '\0';
+    }
+
+    int indexOf(char c, unsigned int from = 0) const
+    {
+        const size_t at = value_.find(c, from);
+        return at == std::string::npos ? -1 : static_cast<int>(at);
+    }
+
+    String substring(unsigned int from, unsigned int to = ~0u) const
+    {
+        return from < value_.size() ? String(value_.substr(from, to > from ? to - from : 0)) : String();
+    }
+
+    bool startsWith(const String& prefix) const
+    {
+        return value_.compare(0, prefix.value_.size(), prefix.value_) == 0;
+    }
+
+    long toInt() const
+    {
+        return strtol(value_.c_str(), nullptr, 10);
+    }
+
+    bool operator==(const String& other) const
+    {
+        return value_ == other.value_;
+    }
+
+    bool operator!=(const String& other) const
+    {
+        return value_ != other.value_;
+    }
+
+    bool operator<(const String& other) const
+    {
+        return value_ < other.value_;
+    }
+
+    const std::string& str() const
+    {
+        return value_;
+    }
+
+private:
+    std::string value_;
+};
+
+// What `+` on Strings returns on the device; ArduinoJson takes either.
+class StringSumHelper : public String
+{
+public:
+    using String::String;
+
+    StringSumHelper(const String& value) : String(value)
+    {
+    }
+};
+
+inline StringSumHelper operator+(const String& a, const String& b)
+{
+    return StringSumHelper(a.str() + b.str());
+}
+
+inline StringSumHelper operator+(const String& a, const char* b)
+{
+    return StringSumHelper(a.str() + (b ? b : ""));
+}
+
+inline StringSumHelper operator+(const char* a, const String& b)
+{
+    return StringSumHelper((a ? a : "") + b.str());
+}
+
+inline StringSumHelper operator+(const String& a, const char b)
+{
+    return StringSumHelper(a.str() + b);
+}
+
+// Serial output goes to stdout a line at a time across tasks; input comes from stdin.
+class HardwareSerial
+{
+public:
+    void begin(unsigned long baud);
+    int available();
+    int read();
+    size_t write(const uint8_t* data, size_t size);
+    size_t write(uint8_t byte);
+    size_t print(const char* text);
+    size_t print(const String& text);
+    size_t print(char c);
+    size_t print(long value);
+    size_t println(const char* text = "");
+    size_t println(const String& text);
+    size_t println(long value);
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+extern HardwareSerial Serial;
+
+class EspClass
+{
+public:
+    // Distinct per process, so emulators on one host are told apart (LAN sync writer ids).
+    uint64_t getEfuseMac();
+};
+
+extern EspClass ESP;
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+
+#endif //Arduino_h
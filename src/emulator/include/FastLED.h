@@ -0,0 +1,79 @@
+//
+// Emulator shim: FastLED's strips as plain arrays; show() takes the strips' wire time.
+//
+
+#ifndef FASTLED_H
+#define FASTLED_H
+
+#include <cstddef>
+#include <cstdint>
+
+struct CRGB
+{
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+
+    CRGB() : r(0), g(0), b(0)
+    {
+    }
+
+    CRGB(uint8_t red, uint8_t green, uint8_t blue) : r(red), g(green), b(blue)
+    {
+    }
+};
+
+enum EOrder
+{
+    RGB,
+    GRB,
+};
+
+template <uint8_t DATA_PIN, EOrder ORDER = GRB>
+class WS2812
+{
+};
+
+template <uint8_t DATA_PIN, EOrder ORDER = GRB>
+class SK6812
+{
+};
+
+class CFastLED
+{
+public:
+    static constexpr size_t kMaxStrips = 4;
+
+    template <template <uint8_t, EOrder> class CHIPSET, uint8_t DATA_PIN, EOrder ORDER>
+    CFastLED& addLeds(CRGB* leds, int count)
+    {
+        addStrip(leds, count);
+        return *this;
+    }
+
+    void setBrightness(uint8_t brightness)
+    {
+        brightness_ = brightness;
+    }
+
+    void clear();
+    // 30 us per LED at 800 kHz, strips one after another as the RMT driver sends them.
+    void show();
+
+private:
+    struct Strip
+    {
+        CRGB* leds;
+        int count;
+    };
+
+    Strip strips_[kMaxStrips] = {};
+    size_t count_ = 0;
+    uint8_t brightness_ = 255;
+
+    void addStrip(CRGB* leds, int count);
+};
+
+extern CFastLED FastLED;
+
+#endif //FASTLED_H
@@ -0,0 +1,36 @@
+//
+// Emulator shim: HTTPClient's POST as one blocking HTTP/1.1 exchange over a host socket.
+//
+
+#ifndef HTTPCLIENT_H
+#define HTTPCLIENT_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_SEND_PAYLOAD_FAILED (-3)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
+
+class HTTPClient
+{
+public:
+    // Only http://host[:port]/path URLs.
+    bool begin(WiFiClient& client, const String& url);
+    void addHeader(const String& name, const String& value);
+    void setTimeout(uint16_t timeout_ms);
+    int POST(uint8_t* payload, size_t size);
+    // Content-Length of the last response, or -1.
+    int getSize() const;
+    void end();
+
+private:
+    std::string host_;
+    uint16_t port_ = 80;
+    std::string path_;
+    std::string headers_;
+    uint16_t timeout_ms_ = 5000;
+    int size_ = -1;
+};
+
+#endif //HTTPCLIENT_H
@@ -0,0 +1,251 @@
+//
+// Emulator shim: the M5Unified panel, canvases, buttons, speaker and RTC of a Core2, in host memory.
+//
+
+#ifndef M5UNIFIED_H
+#define M5UNIFIED_H
+
+#include <Arduino.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace lgfx
+{
+// RGB565 with the bytes swapped, as the panel takes it over SPI.
+struct swap565_t
+{
+    uint16_t raw;
+};
+}
+
+namespace m5
+{
+enum pin_name_t
+{
+    sd_spi_ss,
+};
+
+struct rtc_date_t
+{
+    int16_t year;
+    int8_t month;
+    int8_t date;
+    int8_t weekDay;
+};
+
+struct rtc_time_t
+{
+    int8_t hours;
+    int8_t minutes;
+    int8_t seconds;
+};
+
+struct rtc_datetime_t
+{
+    rtc_date_t date;
+    rtc_time_t time;
+};
+}
+
+enum textdatum_t : uint8_t
+{
+    top_left = 0,
+};
+
+constexpr uint16_t BLACK = 0x0000;
+
+class M5Canvas;
+
+// The 320x240 ILI9342C. Pixels are kept in panel byte order; transfers are modelled at the 40 MHz
+// SPI clock, so a DMA push completes when the wire would have finished with it.
+class M5GFX
+{
+public:
+    M5GFX();
+
+    int32_t width() const
+    {
+        return kWidth;
+    }
+
+    int32_t height() const
+    {
+        return kHeight;
+    }
+
+    void startWrite();
+    void endWrite();
+    void waitDMA();
+    void setClipRect(int32_t x, int32_t y, int32_t w, int32_t h);
+    void clearClipRect();
+    void pushImageDMA(int32_t x, int32_t y, int32_t w, int32_t h, const lgfx::swap565_t* pixels);
+    void fillScreen(uint16_t color);
+    // No decoder: the splash is drawn as a flat color, with the wire time of a full frame.
+    bool drawJpg(const uint8_t* data, size_t length, int32_t x, int32_t y);
+    void setTextSize(float size);
+    size_t print(const char* text);
+
+    static uint32_t color16to24(uint16_t color);
+
+private:
+    friend class M5Canvas;
+
+    static constexpr int32_t kWidth = 320;
+    static constexpr int32_t kHeight = 240;
+
+    std::vector<uint16_t> pixels_;
+    int32_t clip_x_;
+    int32_t clip_y_;
+    int32_t clip_w_;
+    int32_t clip_h_;
+    int32_t write_depth_;
+    uint32_t frame_bytes_;
+    uint32_t frame_rects_;
+    uint64_t frame_cpu_ns_;
+    // Virtual time at which the wire is done with what was queued so far.
+    uint64_t dma_done_us_;
+
+    void transfer(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t* pixels, int32_t stride);
+};
+
+// A sprite: 16-bit in panel byte order, or 1-bit with a two-entry palette.
+class M5Canvas
+{
+public:
+    explicit M5Canvas(M5GFX* parent);
+    explicit M5Canvas(M5Canvas* parent);
+
+    void* createSprite(int32_t w, int32_t h);
+    void deleteSprite();
+
+    void* getBuffer()
+    {
+        return pixels_.empty() ? nullptr : pixels_.data();
+    }
+
+    int32_t width() const
+    {
+        return width_;
+    }
+
+    int32_t height() const
+    {
+        return height_;
+    }
+
+    void setColorDepth(int bits);
+    bool createPalette();
+    void setPaletteColor(size_t index, uint32_t rgb888);
+    void fillSprite(uint32_t color);
+    void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color);
+    void setClipRect(int32_t x, int32_t y, int32_t w, int32_t h);
+    void clearClipRect();
+    void setTextColor(uint32_t color);
+    void setTextSize(float size);
+    void setTextFont(uint8_t font);
+    void setTextDatum(textdatum_t datum);
+    // Glyphs are the stand-in pattern HostFramebuffer draws, in the cells of the real font metrics.
+    int32_t drawString(const char* text, int32_t x, int32_t y);
+    int32_t fontHeight() const;
+    int32_t textWidth(const char* text) const;
+    void pushSprite(int32_t x, int32_t y);
+    void pushSprite(M5Canvas* destination, int32_t x, int32_t y);
+
+private:
+    M5GFX* panel_;
+    M5Canvas* canvas_;
+    int32_t width_;
+    int32_t height_;
+    int bits_;
+    std::vector<uint16_t> pixels_;
+    // Panel byte order, converted from the 24-bit colors set.
+    uint16_t palette_[2];
+    int32_t clip_x_;
+    int32_t clip_y_;
+    int32_t clip_w_;
+    int32_t clip_h_;
+    uint32_t text_color_;
+    uint8_t font_;
+
+    void plot(int32_t x, int32_t y, uint32_t color);
+    uint16_t at(int32_t x, int32_t y) const;
+};
+
+// Scripted: a press from the run options holds the button down for a few debounce periods.
+class Button_Class
+{
+public:
+    explicit Button_Class(uint8_t index) : index_(index)
+    {
+    }
+
+    void setDebounceThresh(uint32_t)
+    {
+    }
+
+    bool isPressed() const;
+
+private:
+    uint8_t index_;
+};
+
+// One channel queue of raw blocks, each done when its samples would have been played.
+class Speaker_Class
+{
+public:
+    size_t isPlaying(uint8_t channel);
+    bool playRaw(const int16_t* data, size_t frames, uint32_t rate, bool stereo, uint32_t repeat, int channel,
+                 bool stop_current);
+    void stop(uint8_t channel);
+
+private:
+    std::mutex mutex_;
+    std::deque<uint64_t> ends_us_;
+
+    void expire();
+};
+
+// Starts at options().start; setDateTime() moves it like the BM8563 would.
+class RTC_Class
+{
+public:
+    m5::rtc_datetime_t getDateTime();
+    void setDateTime(const tm* utc);
+
+private:
+    // RTC time minus virtual time, in seconds.
+    int64_t offset_ = 0;
+    bool set_ = false;
+};
+
+class M5Unified
+{
+public:
+    M5GFX Lcd;
+    Button_Class BtnA{0};
+    Button_Class BtnB{1};
+    Button_Class BtnC{2};
+    Speaker_Class Speaker;
+    RTC_Class Rtc;
+
+    void begin()
+    {
+    }
+
+    void update()
+    {
+    }
+
+    int8_t getPin(m5::pin_name_t)
+    {
+        return 4;
+    }
+};
+
+extern M5Unified M5;
+
+#endif //M5UNIFIED_H
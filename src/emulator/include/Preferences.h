@@ -0,0 +1,27 @@
+//
+// Emulator shim: NVS namespaces in process memory; they last as long as the run.
+//
+
+#ifndef PREFERENCES_H
+#define PREFERENCES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class Preferences
+{
+public:
+    bool begin(const char* name, bool read_only = false);
+    void end();
+    size_t getBytesLength(const char* key);
+    size_t getBytes(const char* key, void* buffer, size_t capacity);
+    size_t putBytes(const char* key, const void* data, size_t size);
+
+private:
+    std::string namespace_;
+    bool open_ = false;
+    bool read_only_ = false;
+};
+
+#endif //PREFERENCES_H
@@ -0,0 +1,70 @@
+//
+// Emulator shim: the SD card as a host directory (options().sd_dir), with the bytes moved counted.
+//
+
+#ifndef SD_H
+#define SD_H
+
+#include <Arduino.h>
+
+#include <memory>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+class File
+{
+public:
+    File() = default;
+
+    explicit operator bool() const
+    {
+        return handle_ != nullptr;
+    }
+
+    size_t size() const;
+    time_t getLastWrite() const;
+    size_t position() const;
+    bool seek(uint32_t position);
+    int available() const;
+    int read();
+    size_t read(uint8_t* buffer, size_t size);
+    size_t write(const uint8_t* data, size_t size);
+    size_t print(const String& text);
+    size_t print(const char* text);
+    void close();
+    bool isDirectory() const;
+    File openNextFile();
+    const char* name() const;
+
+private:
+    friend class SDFS;
+    struct Handle;
+
+    // Shared like the ESP32 core's File: copies refer to the same open file.
+    std::shared_ptr<Handle> handle_;
+
+    explicit File(std::shared_ptr<Handle> handle) : handle_(std::move(handle))
+    {
+    }
+};
+
+class SDFS
+{
+public:
+    // Creates the directory if it is missing.
+    bool begin(uint8_t ss_pin);
+    File open(const char* path, const char* mode = FILE_READ);
+    File open(const String& path, const char* mode = FILE_READ);
+    bool exists(const char* path);
+    bool exists(const String& path);
+    bool remove(const char* path);
+    bool remove(const String& path);
+    bool mkdir(const char* path);
+    bool mkdir(const String& path);
+};
+
+extern SDFS SD;
+
+#endif //SD_H
@@ -0,0 +1,95 @@
+//
+// Emulator shim: a station that associates options().wifi_after virtual seconds after begin().
+//
+
+#ifndef WIFI_H
+#define WIFI_H
+
+#include <Arduino.h>
+
+#include <functional>
+
+enum wl_status_t
+{
+    WL_IDLE_STATUS = 0,
+    WL_CONNECTED = 3,
+    WL_DISCONNECTED = 6,
+};
+
+enum wifi_mode_t
+{
+    WIFI_OFF = 0,
+    WIFI_STA = 1,
+};
+
+enum arduino_event_id_t
+{
+    ARDUINO_EVENT_WIFI_STA_CONNECTED,
+    ARDUINO_EVENT_WIFI_STA_DISCONNECTED,
+};
+
+typedef arduino_event_id_t WiFiEvent_t;
+
+union arduino_event_info_t
+{
+    struct
+    {
+        uint8_t reason;
+    } wifi_sta_disconnected;
+};
+
+typedef arduino_event_info_t WiFiEventInfo_t;
+typedef std::function<void(arduino_event_id_t, arduino_event_info_t)> WiFiEventFuncCb;
+
+class IPAddress
+{
+public:
+    explicit IPAddress(uint32_t address = 0) : address_(address)
+    {
+    }
+
+    String toString() const;
+
+private:
+    // Host byte order.
+    uint32_t address_;
+};
+
+class WiFiClass
+{
+public:
+    bool mode(wifi_mode_t)
+    {
+        return true;
+    }
+
+    bool setAutoReconnect(bool)
+    {
+        return true;
+    }
+
+    // Never called back: the emulated link does not drop.
+    int onEvent(WiFiEventFuncCb, arduino_event_id_t)
+    {
+        return 0;
+    }
+
+    wl_status_t begin(const char* ssid, const char* password);
+    wl_status_t status();
+    bool disconnect();
+    // 127.0.0.1: the servers the firmware starts listen on the host.
+    IPAddress localIP();
+
+private:
+    bool begun_ = false;
+    // Virtual time of the last begin().
+    uint64_t begun_us_ = 0;
+};
+
+extern WiFiClass WiFi;
+
+class WiFiClient
+{
+};
+
+#endif //WIFI_H
@@ -0,0 +1,27 @@
+//
+// Emulator shim: capability-tagged allocation, tracked against the Core2's internal heap and PSRAM.
+//
+
+#ifndef ESP_HEAP_CAPS_H
+#define ESP_HEAP_CAPS_H
+
+#include <cstddef>
+#include <cstdint>
+
+#define MALLOC_CAP_EXEC (1 << 0)
+#define MALLOC_CAP_32BIT (1 << 1)
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_DMA (1 << 3)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_DEFAULT (1 << 12)
+
+// Fails, like the device, once the region the caps select is used up. Only these allocations
+// count: ordinary new/malloc go to the host heap unseen.
+void* heap_caps_malloc(size_t size, uint32_t caps);
+void heap_caps_free(void* pointer);
+size_t heap_caps_get_free_size(uint32_t caps);
+size_t heap_caps_get_largest_free_block(uint32_t caps);
+size_t heap_caps_get_minimum_free_size(uint32_t caps);
+
+#endif //ESP_HEAP_CAPS_H
@@ -0,0 +1,22 @@
+//
+// Emulator shim: ESP-IDF logging levels; the firmware only adjusts them.
+//
+
+#ifndef ESP_LOG_H
+#define ESP_LOG_H
+
+typedef enum
+{
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE,
+} esp_log_level_t;
+
+inline void esp_log_level_set(const char*, esp_log_level_t)
+{
+}
+
+#endif //ESP_LOG_H
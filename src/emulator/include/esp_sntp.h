@@ -0,0 +1,30 @@
+//
+// Emulator shim: SNTP that completes once WiFi is up, setting the system clock to true time.
+//
+
+#ifndef ESP_SNTP_H
+#define ESP_SNTP_H
+
+#include <cstdint>
+
+#include <sys/time.h>
+
+#define SNTP_OPMODE_POLL 0
+
+typedef enum
+{
+    SNTP_SYNC_STATUS_RESET,
+    SNTP_SYNC_STATUS_COMPLETED,
+    SNTP_SYNC_STATUS_IN_PROGRESS,
+} sntp_sync_status_t;
+
+typedef void (*sntp_sync_time_cb_t)(struct timeval* tv);
+
+// Called on the first sync, from sntp_init() if WiFi is already up or else the first status poll.
+void sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t callback);
+void sntp_setoperatingmode(uint8_t mode);
+void sntp_setservername(uint8_t index, const char* server);
+void sntp_init();
+sntp_sync_status_t sntp_get_sync_status();
+
+#endif //ESP_SNTP_H
@@ -0,0 +1,148 @@
+//
+// Emulator entry point: runs the firmware's setup() and loop() on a host thread in virtual time.
+//
+
+#include <Arduino.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "Emulator.h"
+
+void setup();
+void loop();
+
+namespace
+{
+void usage()
+{
+    fprintf(stderr,
+            "usage: program [--speed X] [--seconds N] [--sd DIR] [--start EPOCH] [--wifi-after S] [--offline]\n"
+            "               [--press a@S,b@S,...] [--per-second FILE.csv] [--per-frame FILE.csv]\n"
+            "               [--screen FILE.ppm]\n"
+            "  --speed       virtual seconds per real second (default 1)\n"
+            "  --seconds     virtual seconds to run, then report and exit (default: until Ctrl-C)\n"
+            "  --sd          host directory standing in for the SD card (default ./sd)\n"
+            "  --start       UTC the RTC and NTP say it is at boot (default now; 0 leaves the RTC unset)\n"
+            "  --wifi-after  virtual seconds WiFi takes to connect (default 2)\n"
+            "  --offline     never connect\n"
+            "  --press       scripted button presses: button a, b or c at virtual second S\n");
+}
+
+bool parsePresses(const char* text, std::vector<emulator::ScriptedPress>* presses)
+{
+    const char* at = text;
+    while (*at != '\0')
+    {
+        const char button = *at;
+        if (button < 'a' || button > 'c' || at[1] != '@')
+        {
+            return false;
+        }
+        char* end;
+        const double seconds = strtod(at + 2, &end);
+        if (end == at + 2 || seconds < 0)
+        {
+            return false;
+        }
+        presses->push_back({static_cast<uint8_t>(button - 'a'), static_cast<uint64_t>(seconds * 1e6)});
+        at = *end == ',' ? end + 1 : end;
+        if (*end != ',' && *end != '\0')
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void loopTask(void*)
+{
+    setup();
+    while (true)
+    {
+        loop();
+        vTaskDelay(1);
+    }
+}
+}
+
+int main(int argc, char** argv)
+{
+    emulator::Options options;
+    options.start = static_cast<time_t>(
+        std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch())
+            .count());
+    for (int i = 1; i < argc; i++)
+    {
+        const char* name = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        const bool takes_value = strcmp(name, "--offline") != 0;
+        if (takes_value && !value)
+        {
+            usage();
+            return 1;
+        }
+        if (strcmp(name, "--speed") == 0)
+        {
+            options.speed = atof(value);
+        }
+        else if (strcmp(name, "--seconds") == 0)
+        {
+            options.seconds = atof(value);
+        }
+        else if (strcmp(name, "--sd") == 0)
+        {
+            options.sd_dir = value;
+        }
+        else if (strcmp(name, "--start") == 0)
+        {
+            options.start = static_cast<time_t>(atoll(value));
+        }
+        else if (strcmp(name, "--wifi-after") == 0)
+        {
+            options.wifi_after = atof(value);
+        }
+        else if (strcmp(name, "--offline") == 0)
+        {
+            options.offline = true;
+        }
+        else if (strcmp(name, "--press") == 0)
+        {
+            if (!parsePresses(value, &options.presses))
+            {
+                fprintf(stderr, "emulator: bad --press %s\n", value);
+                return 1;
+            }
+        }
+        else if (strcmp(name, "--per-second") == 0)
+        {
+            options.per_second_csv = value;
+        }
+        else if (strcmp(name, "--per-frame") == 0)
+        {
+            options.per_frame_csv = value;
+        }
+        else if (strcmp(name, "--screen") == 0)
+        {
+            options.screen_ppm = value;
+        }
+        else
+        {
+            usage();
+            return 1;
+        }
+        i += takes_value ? 1 : 0;
+    }
+    if (options.speed <= 0)
+    {
+        usage();
+        return 1;
+    }
+    emulator::configure(options);
+    // The Arduino core's loop task, with its stack size.
+    xTaskCreatePinnedToCore(loopTask, "loopTask", 8192, nullptr, 1, nullptr, 1);
+    emulator::report();
+}
@@ -3,70 +3,406 @@
 //
 
 #include "ClockFace.h"
+
+#include <cstring>
+
+#include <esp_heap_caps.h>
+
 #include "Global.h"
+#include "NumeralAtlas.h"
+#include "Trace.h"
 
 const char* days_of_week[] = {
     "Sunday", "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday"
 };
 
-int weekday(const time_t t)
+// Fonts ClockFace draws with, in the order of the width/height tables.
+static constexpr uint8_t kFontIds[] = {2, 4, 7};
+
+static int fontSlot(const uint8_t font)
+{
+  for (int i = 0; i < static_cast<int>(sizeof(kFontIds)); i++)
+  {
+    if (kFontIds[i] == font)
+    {
+      return i;
+    }
+  }
+  return -1;
+}
+
+ClockFace::ClockFace()
+  : canvas_(&M5.Lcd),
+    atlas_(&canvas_),
+    atlas_ready_(false),
+    flavors_(nullptr),
+    daily_stats_(nullptr),
+    renderer_(M5.Lcd.width(), M5.Lcd.height()),
+    last_frame_bytes_(0),
+    render_timing_("display.render_us"),
+    input_latency_("input.to_pixel_us"),
+    pending_input_us_(0),
+    render_task_(nullptr),
+    staging_storage_({nullptr, nullptr}),
+    back_staging_(0),
+    dma_in_flight_(false),
+    dma_input_us_(0),
+    dma_started_us_(0),
+    // A full 320x240 frame takes about 31 ms at 40 MHz; partial frames far less.
+    push_timing_("display.push_us", 40000),
+    bus_client_(spi_bus, "display", BusPriority::INTERACTIVE)
+{
+  canvas_.createSprite(M5.Lcd.width(), M5.Lcd.height());
+  measureFonts();
+  buildAtlas();
+  for (size_t i = 0; i < staging_.size(); i++)
+  {
+    staging_storage_[i] = static_cast<uint16_t*>(
+      heap_caps_malloc(kStagingPixels * sizeof(uint16_t), MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL));
+    staging_[i].attach(staging_storage_[i], staging_storage_[i] ? kStagingPixels : 0);
+  }
+  xTaskCreatePinnedToCore(renderTaskTrampoline, "ClockFace", 6144, this, 2, &render_task_, 0);
+}
+
+ClockFace::~ClockFace()
 {
-    struct tm *timeinfo = localtime(&t);
-    return timeinfo->tm_wday;
+  if (render_task_)
+  {
+    vTaskDelete(render_task_);
+  }
+  M5.Lcd.waitDMA();
+  for (uint16_t* storage : staging_storage_)
+  {
+    heap_caps_free(storage);
+  }
+  atlas_.deleteSprite();
+  canvas_.deleteSprite();
 }
 
 inline void ClockFace::notification(ClockUpdate update)
 {
-  char time_buffer[sizeof("HH:MM:SS")];
-  char time_buffer2[sizeof("DD MM YYYY")];
-  strftime(time_buffer, sizeof(time_buffer), "%H:%M:%S", localtime(&update.now));
-  strftime(time_buffer2, sizeof(time_buffer2), "%d %m %Y", localtime(&update.now));
-  int weekday_index = weekday(update.now) % 7;
+  mailbox_.post(update);
+  if (render_task_)
+  {
+    xTaskNotifyGive(render_task_);
+  }
+}
+
+void ClockFace::renderTaskTrampoline(void* context)
+{
+  ClockFace* self = static_cast<ClockFace*>(context);
+  if (self)
+  {
+    self->renderTask();
+  }
+  vTaskDelete(nullptr);
+}
+
+void ClockFace::renderTask()
+{
+  while (true)
+  {
+    // While a DMA push is in flight the SPI bus stays ours; give a new frame a short
+    // window to be drawn alongside it, then complete the push so the SD card can use the bus.
+    ulTaskNotifyTake(pdTRUE, dma_in_flight_ ? pdMS_TO_TICKS(kDmaSettleMs) : portMAX_DELAY);
+    ClockUpdate update;
+    if (mailbox_.take(&update))
+    {
+      renderFrame(update, pending_input_us_.exchange(0));
+    }
+    else if (dma_in_flight_)
+    {
+      finishPush();
+    }
+  }
+}
+
+void ClockFace::renderFrame(const ClockUpdate& update, const uint64_t input_us)
+{
+  const DirtyRegion* dirty;
+  {
+    TRACE_SCOPE("display.render");
+    ScopedMetric timing(render_timing_);
+    dirty = &render(update);
+  }
+  last_frame_bytes_ = static_cast<uint32_t>(dirty->pixels()) * sizeof(uint16_t);
+
+  // The other front buffer may still be going out; this one is free.
+  FrameStaging& staging = staging_[back_staging_];
+  const bool staged = !dirty->empty()
+    && staging.stage(static_cast<const uint16_t*>(canvas_.getBuffer()), canvas_.width(), canvas_.height(), *dirty);
+  if (dma_in_flight_)
+  {
+    finishPush();
+  }
+  if (staged)
+  {
+    startPush(staging, input_us);
+    back_staging_ ^= 1;
+  }
+  else
+  {
+    pushNow(*dirty, input_us);
+  }
+  reportTiming();
+}
+
+const DirtyRegion& ClockFace::render(const ClockUpdate& update)
+{
+  calendar_.update(update.now);
   char remaining_time_buffer[sizeof("MM:SS")];
-  strftime(remaining_time_buffer, sizeof(remaining_time_buffer), "%M:%S", gmtime(&update.remaining_time_in_state));
-  switch(update.state) {
-  case IDLE:
-    canvas_.fillScreen(BLACK);
-    drawTime(time_buffer, WHITE, 0, 7, 1);
-    drawTime(time_buffer2, YELLOW, 1, 4, 1);
-    drawTime(days_of_week[weekday_index], YELLOW, 2, 4, 1);
-    break;
-  case WORK:
-    canvas_.fillScreen(DARKGREEN);
-    drawFlavor(update.work_flavor);
-    drawTime(time_buffer, WHITE, 0, 7, 1);
-    drawTime(remaining_time_buffer, BLACK, 1, 7, 1);
-    break;
-  case BREAK:
-    canvas_.fillScreen(RED);
-    drawTime(time_buffer, WHITE, 0, 7, 1);
-    drawTime(remaining_time_buffer, BLACK, 1, 7, 1);
-    break;
+  formatMinSec(update.remaining_time_in_state, remaining_time_buffer);
+
+  const uint16_t work_color = flavors_ ? flavors_->color(update.work_flavor) : clock_colors::kDarkGreen;
+  ClockFrameText text = {update.state, update.work_flavor, work_color, calendar_.hms(), calendar_.date(),
+                         days_of_week[calendar_.weekday() % 7], remaining_time_buffer, nullptr, nullptr, nullptr};
+  if (update.state == WORK && flavors_)
+  {
+    text.flavor_label = flavors_->label(update.work_flavor);
+  }
+
+  char stats_summary[48];
+  char stats_flavors[TEXT_RUN_CAPACITY + 1];
+  if (update.state == IDLE && daily_stats_)
+  {
+    const DailyStatsSnapshot stats = daily_stats_->snapshot();
+    snprintf(stats_summary, sizeof(stats_summary), "Today: %u pomodoros, %lu min",
+             static_cast<unsigned>(stats.completed), static_cast<unsigned long>(stats.focus_seconds / 60));
+    // As many flavors as fit across the screen, from the label widths measured at boot.
+    const int16_t gap = static_cast<int16_t>(2 * charWidth(clock_fonts::kStats, ' '));
+    size_t length = 0;
+    int16_t width = 0;
+    stats_flavors[0] = '\0';
+    for (uint8_t flavor = 0; flavors_ && flavor < flavors_->size(); flavor++)
+    {
+      char counts[24];
+      const int counts_length = snprintf(counts, sizeof(counts), " %u/%lum",
+                                         static_cast<unsigned>(stats.flavors[flavor].completed),
+                                         static_cast<unsigned long>(stats.flavors[flavor].focus_seconds / 60));
+      int16_t segment = static_cast<int16_t>(flavors_->labelWidth(flavor) + (flavor > 0 ? gap : 0));
+      for (int i = 0; i < counts_length; i++)
+      {
+        segment = static_cast<int16_t>(segment + charWidth(clock_fonts::kStats, counts[i]));
+      }
+      const char* label = flavors_->label(flavor);
+      if (width + segment > canvas_.width()
+          || length + (flavor > 0 ? 2 : 0) + strlen(label) + counts_length >= sizeof(stats_flavors))
+      {
+        break;
+      }
+      length += static_cast<size_t>(snprintf(stats_flavors + length, sizeof(stats_flavors) - length, "%s%s%s",
+                                             flavor > 0 ? "  " : "", label, counts));
+      width = static_cast<int16_t>(width + segment);
+    }
+    text.stats_summary = stats_summary;
+    text.stats_flavors = stats_flavors;
   }
 
-  std::lock_guard<std::recursive_mutex> lock(spi_mutex);
-  canvas_.pushSprite(0, 0);
+  layoutClockFrame(text, *this, canvas_.width(), canvas_.height(), &layout_);
+  return renderer_.render(layout_, *this);
 }
 
-void ClockFace::drawTime(const char* time, int color, int line, int font, int font_size)
+void ClockFace::reportTiming()
 {
-  canvas_.setTextColor(color);
-  canvas_.setTextSize(font_size);
-  canvas_.setTextFont(font);
-  const int padding = canvas_.fontHeight() / 4;
-  canvas_.drawCenterString(time, canvas_.width() / 2, canvas_.height() / 2 - (canvas_.fontHeight() + padding) + (canvas_.fontHeight() + padding) * line);
+  const MetricSample summary = render_timing_.sample();
+  if (summary.value % kTimingReportFrames != 0)
+  {
+    return;
+  }
+  char line[128];
+  if (formatLatencySummary(summary, line, sizeof(line)) > 0)
+  {
+    Serial.println(line);
+  }
+  if (formatLatencySummary(input_latency_.sample(), line, sizeof(line)) > 0)
+  {
+    Serial.println(line);
+  }
+  Serial.printf("ClockFace: %lu updates coalesced\n", static_cast<unsigned long>(coalescedFrames()));
+  // Who held the bus while frames waited for it.
+  char bus_report[768];
+  spi_bus.format(bus_report, sizeof(bus_report));
+  Serial.print(bus_report);
 }
 
+void ClockFace::startPush(const FrameStaging& staging, const uint64_t input_us)
+{
+  spi_bus.acquire(bus_client_);
+  dma_started_us_ = monotonicMicros();
+  M5.Lcd.startWrite();
+  for (size_t i = 0; i < staging.size(); i++)
+  {
+    const Rect& rect = staging.rect(i);
+    // The canvas keeps pixels in panel byte order; staging copies them untouched.
+    M5.Lcd.pushImageDMA(rect.x, rect.y, rect.w, rect.h, reinterpret_cast<const lgfx::swap565_t*>(staging.pixels(i)));
+  }
+  dma_in_flight_ = true;
+  dma_input_us_ = input_us;
+}
+
+void ClockFace::finishPush()
+{
+  M5.Lcd.waitDMA();
+  M5.Lcd.endWrite();
+  push_timing_.record(static_cast<uint32_t>(monotonicMicros() - dma_started_us_));
+  // From the start of the transfer, so it overlaps the render of the next frame.
+  tracer().complete("display.dma", dma_started_us_);
+  spi_bus.release();
+  dma_in_flight_ = false;
+  recordInput(dma_input_us_);
+}
+
+void ClockFace::pushNow(const DirtyRegion& dirty, const uint64_t input_us)
+{
+  if (!dirty.empty())
+  {
+    TRACE_SCOPE("display.push");
+    BusLock lock(bus_client_);
+    ScopedMetric timing(push_timing_);
+    M5.Lcd.startWrite();
+    for (size_t i = 0; i < dirty.size(); i++)
+    {
+      // pushSprite honours the panel's clip rect and only transfers the clipped pixels.
+      M5.Lcd.setClipRect(dirty[i].x, dirty[i].y, dirty[i].w, dirty[i].h);
+      canvas_.pushSprite(0, 0);
+    }
+    M5.Lcd.clearClipRect();
+    M5.Lcd.endWrite();
+  }
+  recordInput(input_us);
+}
+
+void ClockFace::recordInput(const uint64_t input_us)
+{
+  if (input_us != 0)
+  {
+    input_latency_.record(static_cast<uint32_t>(monotonicMicros() - input_us));
+  }
+}
 
-void ClockFace::drawFlavor(const uint8_t flavor)
+void ClockFace::fillRect(const Rect& rect, const uint16_t color)
 {
-  canvas_.setTextColor(BLACK);
+  canvas_.fillRect(rect.x, rect.y, rect.w, rect.h, color);
+}
+
+void ClockFace::drawRun(const TextRun& run, const Rect& clip)
+{
+  if (blitNumerals(run, clip))
+  {
+    return;
+  }
+  canvas_.setClipRect(clip.x, clip.y, clip.w, clip.h);
+  canvas_.setTextColor(run.color);
   canvas_.setTextSize(1);
-  canvas_.setTextFont(4);
-  String label = String(flavor);
-  if (flavor < flavor_labels_.size() && flavor_labels_[flavor].length() > 0)
+  canvas_.setTextFont(run.font);
+  canvas_.setTextDatum(top_left);
+  canvas_.drawString(run.text, run.cell_x[0], run.y);
+  canvas_.clearClipRect();
+}
+
+void ClockFace::measureFonts()
+{
+  char glyph[2] = {0, 0};
+  for (int slot = 0; slot < kFonts; slot++)
   {
-    label = flavor_labels_[flavor];
+    canvas_.setTextSize(1);
+    canvas_.setTextFont(kFontIds[slot]);
+    font_heights_[slot] = static_cast<int16_t>(canvas_.fontHeight());
+    for (int c = 0; c < kGlyphs; c++)
+    {
+      glyph[0] = static_cast<char>(' ' + c);
+      char_widths_[slot * kGlyphs + c] = static_cast<int16_t>(canvas_.textWidth(glyph));
+    }
   }
-  canvas_.drawString(label, 10, 10);
+}
+
+void ClockFace::buildAtlas()
+{
+  using namespace numeral_atlas;
+  // The layout places numeral cells from compile-time widths; only use the atlas if font 7 agrees.
+  for (const char c : kClockPattern)
+  {
+    if (c != '\0' && charWidth(kFont, c) != glyphWidth(c))
+    {
+      Serial.println("ClockFace: unexpected font 7 metrics, drawing numerals as text");
+      return;
+    }
+  }
+  if (height(kFont) != kHeight)
+  {
+    Serial.println("ClockFace: unexpected font 7 height, drawing numerals as text");
+    return;
+  }
+
+  atlas_.setColorDepth(1);
+  if (!atlas_.createSprite(kRowWidth, kHeight))
+  {
+    return;
+  }
+  atlas_.createPalette();
+  atlas_.fillSprite(0);
+  atlas_.setTextSize(1);
+  atlas_.setTextFont(kFont);
+  atlas_.setTextColor(1);
+  atlas_.setTextDatum(top_left);
+  char glyph[2] = {0, 0};
+  for (const char c : "0123456789:")
+  {
+    if (c != '\0')
+    {
+      glyph[0] = c;
+      atlas_.drawString(glyph, atlasX(c), 0);
+    }
+  }
+  atlas_ready_ = true;
+}
+
+bool ClockFace::blitNumerals(const TextRun& run, const Rect& clip)
+{
+  using namespace numeral_atlas;
+  if (!atlas_ready_ || run.font != kFont)
+  {
+    return false;
+  }
+  for (size_t i = 0; i < run.length; i++)
+  {
+    if (!contains(run.text[i]) || run.cell_x[i + 1] - run.cell_x[i] != glyphWidth(run.text[i]))
+    {
+      return false;
+    }
+  }
+
+  // One mask serves every state: the palette supplies this run's foreground and background.
+  atlas_.setPaletteColor(0, M5.Lcd.color16to24(layout_.background));
+  atlas_.setPaletteColor(1, M5.Lcd.color16to24(run.color));
+  for (size_t i = 0; i < run.length; i++)
+  {
+    const Rect cell = run.cell(i);
+    const Rect area = cell.intersected(clip);
+    if (area.empty())
+    {
+      continue;
+    }
+    canvas_.setClipRect(area.x, area.y, area.w, area.h);
+    atlas_.pushSprite(&canvas_, cell.x - atlasX(run.text[i]), cell.y);
+  }
+  canvas_.clearClipRect();
+  return true;
+}
+
+int16_t ClockFace::charWidth(const uint8_t font, const char c) const
+{
+  const int slot = fontSlot(font);
+  const int glyph = static_cast<unsigned char>(c) - ' ';
+  if (slot < 0 || glyph < 0 || glyph >= kGlyphs)
+  {
+    return 0;
+  }
+  return char_widths_[slot * kGlyphs + glyph];
+}
+
+int16_t ClockFace::height(const uint8_t font) const
+{
+  const int slot = fontSlot(font);
+  return slot < 0 ? 0 : font_heights_[slot];
 }
@@ -6,26 +6,37 @@
 #define CLOCKFACE_H
 
 #include <array>
+#include <atomic>
 
 #include <M5Unified.h>
-
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "BusArbiter.h"
+#include "ClockLayout.h"
+#include "DailyStats.h"
+#include "DirtyRegion.h"
+#include "FlavorTable.h"
+#include "FrameStaging.h"
+#include "FrameTiming.h"
+#include "Metrics.h"
+#include "Mailbox.h"
 #include "Pomodoro.h"
+#include "TimeFormat.h"
 
-class ClockFace final : public PomodoroObserver
+// Renders into an off-screen canvas and pushes only the rectangles that changed since the
+// previous frame; the whole screen is repainted on state or flavor changes. The clock and
+// countdown numerals are blitted from a 1-bit glyph atlas rasterized once at startup.
+//
+// Rendering runs on its own task on core 0. notification() only posts the update to a one-slot
+// mailbox, so the main loop never waits for the panel, and updates that arrive while a frame is
+// being drawn are coalesced into the newest one. Dirty rectangles are copied into one of two
+// front buffers and pushed by DMA while the next frame is drawn into the canvas.
+class ClockFace final : public PomodoroObserver, private RenderTarget, private FontMetrics
 {
 public:
-    ClockFace()
-        : canvas_(&M5.Lcd),
-          flavor_labels_({String("0"), String("1"), String("2")})
-    {
-        canvas_.createSprite(M5.Lcd.width(), M5.Lcd.height());
-    }
-
-    ~ClockFace() override
-    {
-        canvas_.deleteSprite();
-    }
-
+    ClockFace();
+    ~ClockFace() override;
 
     void notification(ClockUpdate update) override;
 
@@ -49,17 +60,106 @@ public:
     {
     };
 
-    void setFlavorLabels(const std::array<String, 3>& labels)
+    // Call before the first frame; the render task reads the table without locking. Measures the
+    // labels in the stats font, for fitting the idle screen's per-flavor line.
+    void setFlavors(FlavorTable* flavors)
+    {
+        flavors->measure(*this, clock_fonts::kStats);
+        flavors_ = flavors;
+        renderer_.invalidate();
+    }
+
+    // Today's totals are shown below the date while IDLE.
+    void setDailyStats(const DailyStats* stats)
+    {
+        daily_stats_ = stats;
+    }
+
+    // Bytes sent to the panel for the most recent frame.
+    uint32_t lastFrameBytes() const
     {
-        flavor_labels_ = labels;
+        return last_frame_bytes_;
+    }
+
+    // Layout and rasterization time per frame, excluding the push to the panel.
+    const Histogram& renderTiming() const
+    {
+        return render_timing_;
+    }
+
+    // Marks a button press; the next frame to reach the panel records the press-to-pixel time.
+    void inputReceived(uint64_t micros = monotonicMicros())
+    {
+        uint64_t expected = 0;
+        pending_input_us_.compare_exchange_strong(expected, micros);
+    }
+
+    // Time from inputReceived() until the resulting frame finished transferring to the panel.
+    const Histogram& inputLatency() const
+    {
+        return input_latency_;
+    }
+
+    // Updates dropped because a newer one arrived before the render task got to them.
+    uint32_t coalescedFrames() const
+    {
+        return mailbox_.replaced();
     }
 
 private:
-    M5Canvas canvas_;
-    std::array<String, 3> flavor_labels_;
+    static constexpr int kFonts = 3;
+    static constexpr int kGlyphs = 96;
+    static constexpr uint32_t kTimingReportFrames = 600;
+    // Two front buffers of 20 KB each in DMA-capable RAM; larger (full-screen) frames are pushed
+    // synchronously from the canvas.
+    static constexpr size_t kStagingPixels = 10240;
+    // How long the render task waits for a new frame before completing an in-flight DMA push.
+    static constexpr uint32_t kDmaSettleMs = 5;
 
-    void drawTime(const char* time, int color, int line, int font, int font_size);
-    void drawFlavor(const uint8_t flavor);
+    M5Canvas canvas_;
+    M5Canvas atlas_;
+    bool atlas_ready_;
+    const FlavorTable* flavors_;
+    const DailyStats* daily_stats_;
+    DirtyRenderer renderer_;
+    FrameLayout layout_;
+    LocalTimeCache calendar_;
+    uint32_t last_frame_bytes_;
+    Histogram render_timing_;
+    Histogram input_latency_;
+    std::atomic<uint64_t> pending_input_us_;
+    Mailbox<ClockUpdate> mailbox_;
+    TaskHandle_t render_task_;
+    std::array<FrameStaging, 2> staging_;
+    std::array<uint16_t*, 2> staging_storage_;
+    size_t back_staging_;
+    bool dma_in_flight_;
+    uint64_t dma_input_us_;
+    uint64_t dma_started_us_;
+    // Bus hold time of each push: DMA start to completion, or a synchronous pushSprite.
+    Histogram push_timing_;
+    // Interactive: background SD jobs wait while a frame is waiting for the bus.
+    BusClient bus_client_;
+    std::array<int16_t, kFonts * kGlyphs> char_widths_;
+    std::array<int16_t, kFonts> font_heights_;
+
+    void fillRect(const Rect& rect, uint16_t color) override;
+    void drawRun(const TextRun& run, const Rect& clip) override;
+    int16_t charWidth(uint8_t font, char c) const override;
+    int16_t height(uint8_t font) const override;
+
+    const DirtyRegion& render(const ClockUpdate& update);
+    void measureFonts();
+    void buildAtlas();
+    bool blitNumerals(const TextRun& run, const Rect& clip);
+    void reportTiming();
+    static void renderTaskTrampoline(void* context);
+    void renderTask();
+    void renderFrame(const ClockUpdate& update, uint64_t input_us);
+    void startPush(const FrameStaging& staging, uint64_t input_us);
+    void finishPush();
+    void pushNow(const DirtyRegion& dirty, uint64_t input_us);
+    void recordInput(uint64_t input_us);
 };
 
 
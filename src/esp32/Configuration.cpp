@@ -15,38 +15,54 @@ bool ConfigurationClass::load()
         return false;
     }
 
-    std::lock_guard<std::recursive_mutex> lock(spi_mutex);
-    File file = SD.open("/config.ini", FILE_READ);
-    if (!file)
+    const uint32_t started = micros();
+    uint32_t fingerprint;
     {
-        return false;
-    }
-
-    std::string line;
-    std::string section;
-    while (file.available())
-    {
-        String rawLine = file.readStringUntil('\n');
-        line = rawLine.c_str();
-        line.erase(line.find_last_not_of(" \n\r\t") + 1);
-        if (line.empty())
+        static BusClient bus_client(spi_bus, "config", BusPriority::BACKGROUND);
+        BusLock lock(bus_client);
+        File file = SD.open("/config.ini", FILE_READ);
+        if (!file)
         {
-            continue;
+            return false;
         }
-        if (line[0] == '[' && line[line.size() - 1] == ']')
+        fingerprint = configFingerprint(file.size(), file.getLastWrite());
+        from_cache_ = cache_.load(fingerprint, &settings_);
+        if (!from_cache_)
         {
-            section = line.substr(1, line.size() - 2);
-            continue;
+            ScopedMetric timing(sd_read_us);
+            char chunk[256];
+            int read;
+            while ((read = file.read(reinterpret_cast<uint8_t*>(chunk), sizeof(chunk))) > 0)
+            {
+                parser_.feed(chunk, static_cast<size_t>(read));
+            }
         }
-        const auto pos = line.find('=');
-        if (pos == std::string::npos)
-        {
-            continue;
-        }
-        std::string key = line.substr(0, pos);
-        std::string value = line.substr(pos + 1);
-        sections[section][key] = value;
+        file.close();
+    }
+    if (from_cache_)
+    {
+        load_us_ = micros() - started;
+        Serial.printf("config.ini: cached settings in %lu us\n", static_cast<unsigned long>(load_us_));
+        return true;
+    }
+
+    // Only a parse without fatal errors is cached, so a broken file is reported on every boot until
+    // fixed. Warnings are reported once, on the boot that parses the file.
+    if (parser_.finish() && !cache_.save(fingerprint, settings_))
+    {
+        Serial.println("config.ini: could not cache settings in NVS");
+    }
+    load_us_ = micros() - started;
+
+    const size_t errors = parser_.errorCount();
+    for (size_t i = 0; i < errors && i < ConfigParser::kMaxErrors; i++)
+    {
+        char message[96];
+        ConfigParser::formatError(parser_.error(i), message, sizeof(message));
+        Serial.printf("%s%s\n", configErrorIsFatal(parser_.error(i).code) ? "" : "warning: ", message);
     }
-    file.close();
+    Serial.printf("config.ini: %u lines, %u errors, %u warnings parsed in %lu us\n",
+                  static_cast<unsigned>(parser_.lines()), static_cast<unsigned>(parser_.fatalErrorCount()),
+                  static_cast<unsigned>(errors - parser_.fatalErrorCount()), static_cast<unsigned long>(load_us_));
     return true;
 }
@@ -5,28 +5,52 @@
 #ifndef CONFIGURATION_H
 #define CONFIGURATION_H
 
-#include <string>
-#include <unordered_map>
+#include "ConfigCache.h"
+#include "ConfigSchema.h"
+#include "NvsStore.h"
 
+// Loads /config.ini from the SD card into typed Settings in one streaming pass. A parse without
+// errors is cached in NVS under the file's size and modification time, so later boots only stat
+// the file and read the cached blob.
 class ConfigurationClass
 {
 public:
+    ConfigurationClass() : parser_(&settings_), cache_store_("pomodoro", "config"), cache_(&cache_store_)
+    {
+    }
+
+    // Returns false if there is no SD card or no /config.ini; the defaults stay in place. Parse
+    // and validation errors and warnings are logged and kept in parser().
     bool load();
 
-    typedef std::unordered_map<std::string, std::string> Section;
+    const Settings& settings() const
+    {
+        return settings_;
+    }
+
+    const ConfigParser& parser() const
+    {
+        return parser_;
+    }
 
-    Section& operator[](const std::string& section)
+    // Whether the last load() came from the NVS cache, and how long it took (SD mount excluded).
+    bool fromCache() const
     {
-        return sections[section];
+        return from_cache_;
     }
 
-    const Section& operator[](const std::string& section) const
+    uint32_t loadMicros() const
     {
-        return sections.at(section);
+        return load_us_;
     }
 
 private:
-    std::unordered_map<std::string, Section> sections;
+    Settings settings_;
+    ConfigParser parser_;
+    NvsCheckpointStore cache_store_;
+    ConfigCache cache_;
+    bool from_cache_ = false;
+    uint32_t load_us_ = 0;
 };
 
 extern ConfigurationClass Configuration;
@@ -0,0 +1,114 @@
+//
+// Plays the audio cues from PCM decoded once at boot, mixed on a task of its own.
+//
+
+#include <M5Unified.h>
+#include <esp_heap_caps.h>
+
+#include "CuePlayer.h"
+
+extern const unsigned char gong_wav_start[] asm("_binary_gong_wav_start");
+extern const unsigned char gong_wav_end[] asm("_binary_gong_wav_end");
+
+namespace
+{
+constexpr size_t kGongFrames = 12 * 16000;
+constexpr size_t kBreakGongFrames = 6 * 16000;
+constexpr size_t kChimeFrames = 16000 / 4;
+constexpr size_t kWarningFrames = 16000 * 3 / 5;
+constexpr size_t kPoolFrames = kGongFrames + kBreakGongFrames + 2 * kChimeFrames + kWarningFrames;
+}
+
+CuePlayer::CuePlayer() : pool_(nullptr), task_(nullptr), blocks_(0)
+{
+    pool_ = static_cast<int16_t*>(heap_caps_malloc(kPoolFrames * sizeof(int16_t), MALLOC_CAP_SPIRAM));
+    if (!pool_)
+    {
+        pool_ = static_cast<int16_t*>(malloc(kPoolFrames * sizeof(int16_t)));
+    }
+    if (!pool_)
+    {
+        Serial.println("CuePlayer: no memory for the cue pool");
+        return;
+    }
+    decodeCues();
+    xTaskCreatePinnedToCore(taskTrampoline, "CuePlayer", 3072, this, 3, &task_, 0);
+}
+
+CuePlayer::~CuePlayer()
+{
+    if (task_)
+    {
+        vTaskDelete(task_);
+    }
+    M5.Speaker.stop(kChannel);
+    free(pool_);
+}
+
+void CuePlayer::decodeCues()
+{
+    int16_t* next = pool_;
+    WavInfo gong;
+    if (parseWav(gong_wav_start, gong_wav_end - gong_wav_start, &gong))
+    {
+        const size_t frames = resampleToMono16(gong, kMixRate, next, kGongFrames);
+        mixer_.setCue(static_cast<uint8_t>(AudioCue::END_WORK), {next, frames, 256});
+        next += frames;
+        // Resampled to 2/3 of the mix rate and played at the mix rate: a fifth higher, and shorter.
+        const size_t pitched = resampleToMono16(gong, kMixRate * 2 / 3, next, kBreakGongFrames);
+        mixer_.setCue(static_cast<uint8_t>(AudioCue::END_BREAK), {next, pitched, 224});
+        next += pitched;
+    }
+    else
+    {
+        Serial.println("CuePlayer: gong.wav is not a PCM WAV file");
+    }
+
+    // Rising two-note chime for the start of work: 660 Hz, then 880 Hz.
+    synthesizeTone(next, kChimeFrames, kMixRate, 660, 12000, 120);
+    synthesizeTone(next + kChimeFrames, kChimeFrames, kMixRate, 880, 12000, 150);
+    mixer_.setCue(static_cast<uint8_t>(AudioCue::START_WORK), {next, 2 * kChimeFrames, 256});
+    next += 2 * kChimeFrames;
+
+    synthesizeTone(next, kWarningFrames, kMixRate, 1320, 6000, 200);
+    mixer_.setCue(static_cast<uint8_t>(AudioCue::WARNING), {next, kWarningFrames, 192});
+}
+
+void CuePlayer::play(const AudioCue cue)
+{
+    if (task_ && mixer_.trigger(static_cast<uint8_t>(cue)))
+    {
+        xTaskNotifyGive(task_);
+    }
+}
+
+void CuePlayer::taskTrampoline(void* context)
+{
+    CuePlayer* self = static_cast<CuePlayer*>(context);
+    if (self)
+    {
+        self->task();
+    }
+    vTaskDelete(nullptr);
+}
+
+void CuePlayer::task()
+{
+    size_t next = 0;
+    while (true)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        while (mixer_.active())
+        {
+            // isPlaying() is 2 while both the playing and the queued slot are taken.
+            while (M5.Speaker.isPlaying(kChannel) > 1)
+            {
+                vTaskDelay(pdMS_TO_TICKS(5));
+            }
+            mixer_.mix(block_[next], kBlockFrames);
+            M5.Speaker.playRaw(block_[next], kBlockFrames, kMixRate, false, 1, kChannel, false);
+            blocks_.fetch_add(1, std::memory_order_relaxed);
+            next = (next + 1) % kBlocks;
+        }
+    }
+}
@@ -0,0 +1,53 @@
+//
+// Plays the audio cues from PCM decoded once at boot, mixed on a task of its own.
+//
+
+#ifndef CUEPLAYER_H
+#define CUEPLAYER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "AudioCues.h"
+#include "Pcm.h"
+
+// Decodes the embedded gong and synthesizes the chimes into one PCM pool (PSRAM when present) at
+// construction. play() only starts a voice in the mixer and wakes the audio task, which mixes
+// small blocks and queues them on M5.Speaker; the speaker's own task feeds them to I2S by DMA.
+class CuePlayer final : public CueSink
+{
+public:
+    CuePlayer();
+    ~CuePlayer() override;
+
+    void play(AudioCue cue) override;
+
+    // Blocks queued on the speaker since boot.
+    uint32_t blocks() const
+    {
+        return blocks_.load(std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr uint32_t kMixRate = 16000;
+    static constexpr size_t kBlockFrames = 512;
+    // The speaker holds a playing and a queued block; the third is the one being mixed.
+    static constexpr size_t kBlocks = 3;
+    static constexpr uint8_t kChannel = 0;
+
+    CueMixer mixer_;
+    int16_t* pool_;
+    int16_t block_[kBlocks][kBlockFrames];
+    TaskHandle_t task_;
+    std::atomic<uint32_t> blocks_;
+
+    void decodeCues();
+    static void taskTrampoline(void* context);
+    void task();
+};
+
+#endif //CUEPLAYER_H
@@ -1,6 +1,12 @@
 #pragma once
-#include <mutex>
+#include "BusArbiter.h"
+#include "Metrics.h"
 
-extern std::recursive_mutex spi_mutex;
+// Arbitrates the SPI bus shared by the LCD and the SD card.
+extern BusArbiter spi_bus;
+
+// Time spent in SD reads and writes, bus wait excluded, across every user of the card.
+extern Histogram sd_read_us;
+extern Histogram sd_write_us;
 
 bool ensureSDMounted();
@@ -6,40 +6,70 @@
 
 #include <ctype.h>
 
-#include <HTTPClient.h>
 #include <SD.h>
 #include <WiFi.h>
 #include <ArduinoJson.h>
 
 #include "Global.h"
+#include "Metrics.h"
+#include "Trace.h"
 
-HttpNotifier::HttpNotifier(const char* host, const uint16_t port)
-    : host_(host ? host : ""),
-      port_(port),
+namespace
+{
+Gauge http_queue_depth("http.queue_depth");
+// Radio energy proxies (see airBytes), whichever transport is in use.
+Counter transport_connects("transport.connects");
+Counter transport_round_trips("transport.round_trips");
+Counter transport_bytes_sent("transport.bytes_sent");
+Counter transport_bytes_received("transport.bytes_received");
+Counter transport_air_bytes("transport.air_bytes");
+}
+
+HttpNotifier::HttpNotifier(Transport* transport)
+    : bus_client_(spi_bus, "http queue", BusPriority::BACKGROUND),
+      transport_(transport),
+      counted_stats_(),
       current_start_time_(0),
       current_work_flavor_(0),
       enabled_(false),
       queue_task_(nullptr),
       event_queue_(nullptr),
-      flavor_labels_({String("0"), String("1"), String("2")})
+      flavors_(nullptr),
+      daily_stats_(nullptr),
+      last_metrics_push_ms_(0),
+      post_mortem_pending_(false)
 {
-    enabled_ = host_.length() > 0 && port_ > 0;
+    enabled_ = transport_ != nullptr;
     if (enabled_)
     {
         if (ensureSDMounted())
         {
-            std::lock_guard<std::recursive_mutex> lock(spi_mutex);
+            BusLock lock(bus_client_);
             ensureQueueDir();
         }
-        event_queue_ = xQueueCreate(16, sizeof(QueueEvent*));
+        event_queue_ = xQueueCreate(16, sizeof(QueueEvent));
         xTaskCreatePinnedToCore(queueTaskTrampoline, "HttpNotifyQueue", 8192, this, 1, &queue_task_, 0);
         notifyQueueTask();
     }
 }
 
-void HttpNotifier::setFlavorLabels(const std::array<String, 3>& labels)
+void HttpNotifier::networkUp()
 {
-    flavor_labels_ = labels;
+    if (enabled_)
+    {
+        notifyQueueTask();
+    }
+}
+
+void HttpNotifier::reportPostMortem(const char* json)
+{
+    if (!enabled_ || post_mortem_pending_.load(std::memory_order_acquire))
+    {
+        return;
+    }
+    post_mortem_ = json;
+    post_mortem_pending_.store(true, std::memory_order_release);
+    notifyQueueTask();
 }
 
 void HttpNotifier::notification(const ClockUpdate update)
@@ -59,8 +89,7 @@ void HttpNotifier::notification(const IdleToWork update)
     }
     current_start_time_ = update.now;
     current_work_flavor_ = update.work_flavor;
-    const String extra_json = String("\"work_flavor\":\"") + escapeJsonString(flavorLabel(update.work_flavor)) + "\"";
-    enqueueEvent(update.now, current_start_time_, "idle_to_work", extra_json);
+    enqueueEvent({update.now, current_start_time_, EventKind::IDLE_TO_WORK, update.work_flavor, 0});
     notifyQueueTask();
 }
 
@@ -72,12 +101,8 @@ void HttpNotifier::notification(const WorkToBreak update)
     }
     const time_t start_time = current_start_time_ > 0 ? current_start_time_ : update.now - update.work_duration;
     current_start_time_ = start_time;
-    const String extra_json = String("\"work_duration\":")
-        + String(static_cast<unsigned long>(update.work_duration))
-        + ",\"work_flavor\":\""
-        + escapeJsonString(flavorLabel(current_work_flavor_))
-        + "\"";
-    enqueueEvent(update.now, start_time, "work_to_break", extra_json);
+    enqueueEvent({update.now, start_time, EventKind::WORK_TO_BREAK, current_work_flavor_,
+                  static_cast<uint32_t>(update.work_duration)});
     notifyQueueTask();
 }
 
@@ -88,8 +113,7 @@ void HttpNotifier::notification(const BreakToIdle update)
         return;
     }
     const time_t start_time = current_start_time_ > 0 ? current_start_time_ : update.now;
-    const String extra_json = String("\"break_duration\":") + String(static_cast<unsigned long>(update.break_duration));
-    enqueueEvent(update.now, start_time, "break_to_idle", extra_json);
+    enqueueEvent({update.now, start_time, EventKind::BREAK_TO_IDLE, 0, static_cast<uint32_t>(update.break_duration)});
     current_start_time_ = 0;
     current_work_flavor_ = 0;
     notifyQueueTask();
@@ -102,12 +126,8 @@ void HttpNotifier::notification(const WorkToIdle update)
         return;
     }
     const time_t start_time = current_start_time_ > 0 ? current_start_time_ : update.now - update.cancelled_work_duration;
-    const String extra_json = String("\"cancelled_work_duration\":")
-        + String(static_cast<unsigned long>(update.cancelled_work_duration))
-        + ",\"work_flavor\":\""
-        + escapeJsonString(flavorLabel(current_work_flavor_))
-        + "\"";
-    enqueueEvent(update.now, start_time, "work_to_idle", extra_json);
+    enqueueEvent({update.now, start_time, EventKind::WORK_TO_IDLE, current_work_flavor_,
+                  static_cast<uint32_t>(update.cancelled_work_duration)});
     current_start_time_ = 0;
     current_work_flavor_ = 0;
     notifyQueueTask();
@@ -144,44 +164,45 @@ String HttpNotifier::makeQueueFilename(const time_t event_time)
     return path;
 }
 
-String HttpNotifier::makePayload(const time_t event_time, const time_t start_time, const char* transition, const String& extra_json)
+size_t HttpNotifier::makePayload(const QueueEvent& event, char* out, const size_t size) const
 {
-    JsonDocument doc;
-    doc["transition"] = transition;
-    doc["start_time"] = static_cast<unsigned long>(start_time);
-    doc["event_time"] = static_cast<unsigned long>(event_time);
-
-    if (extra_json.length() > 0)
+    static const char* const kTransitions[] = {"idle_to_work", "work_to_break", "break_to_idle", "work_to_idle"};
+    int length = snprintf(out, size, "{\"transition\":\"%s\",\"start_time\":%lu,\"event_time\":%lu",
+                          kTransitions[static_cast<uint8_t>(event.kind)],
+                          static_cast<unsigned long>(event.start_time), static_cast<unsigned long>(event.event_time));
+    const unsigned long duration = event.duration;
+    // The table's labels are already escaped for the inside of a JSON string.
+    switch (event.kind)
     {
-        JsonDocument extra_doc;
-        deserializeJson(extra_doc, "{" + extra_json + "}");
-        for (JsonPair kv : extra_doc.as<JsonObject>()) {
-            doc[kv.key()] = kv.value();
-        }
-    }
-
-    String payload;
-    serializeJson(doc, payload);
-    return payload;
+    case EventKind::IDLE_TO_WORK:
+        length += snprintf(out + length, size - length, ",\"work_flavor\":\"%s\"}", jsonFlavorLabel(event.work_flavor));
+        break;
+    case EventKind::WORK_TO_BREAK:
+        length += snprintf(out + length, size - length, ",\"work_duration\":%lu,\"work_flavor\":\"%s\"}", duration,
+                           jsonFlavorLabel(event.work_flavor));
+        break;
+    case EventKind::BREAK_TO_IDLE:
+        length += snprintf(out + length, size - length, ",\"break_duration\":%lu}", duration);
+        break;
+    case EventKind::WORK_TO_IDLE:
+        length += snprintf(out + length, size - length, ",\"cancelled_work_duration\":%lu,\"work_flavor\":\"%s\"}",
+                           duration, jsonFlavorLabel(event.work_flavor));
+        break;
+    }
+    return static_cast<size_t>(length);
 }
 
-bool HttpNotifier::enqueueEvent(const time_t event_time, const time_t start_time, const char* transition, const String& extra_json)
+bool HttpNotifier::enqueueEvent(const QueueEvent& event)
 {
-    Serial.println("HttpNotifier: Enqueuing event: " + String(transition) + " at " + String(static_cast<unsigned long>(event_time)));
-
     if (!event_queue_)
     {
         Serial.println("HttpNotifier: Event queue not available");
         return false;
     }
-    QueueEvent* event = new QueueEvent{event_time, start_time, String(transition), extra_json};
     if (xQueueSend(event_queue_, &event, pdMS_TO_TICKS(50)) != pdTRUE)
     {
         Serial.println("HttpNotifier: Failed to enqueue event");
-        delete event;
         return false;
-    } else {
-        Serial.println("HttpNotifier: Event enqueued");
     }
     notifyQueueTask();
     return true;
@@ -189,25 +210,28 @@ bool HttpNotifier::enqueueEvent(const time_t event_time, const time_t start_time
 
 bool HttpNotifier::persistEvent(const QueueEvent& event)
 {
+    TRACE_SCOPE("http.persist");
     if (!ensureSDMounted())
     {
         return false;
     }
 
-    std::lock_guard<std::recursive_mutex> lock(spi_mutex);
+    char payload[kPayloadBytes];
+    const size_t length = makePayload(event, payload, sizeof(payload));
+    BusLock lock(bus_client_);
+    ScopedMetric timing(sd_write_us);
     if (!ensureQueueDir())
     {
         return false;
     }
 
     const String path = makeQueueFilename(event.event_time);
-    const String payload = makePayload(event.event_time, event.start_time, event.transition.c_str(), event.extra_json);
     File file = SD.open(path, FILE_WRITE);
     if (!file)
     {
         return false;
     }
-    file.print(payload);
+    file.write(reinterpret_cast<const uint8_t*>(payload), length);
     file.close();
     return true;
 }
@@ -226,48 +250,14 @@ bool HttpNotifier::extractUInt64(const String& payload, const char* key, unsigne
     return true;
 }
 
-String HttpNotifier::flavorLabel(const uint8_t flavor) const
+const char* HttpNotifier::jsonFlavorLabel(const uint8_t flavor) const
 {
-    if (flavor < flavor_labels_.size() && flavor_labels_[flavor].length() > 0)
-    {
-        return flavor_labels_[flavor];
-    }
-    return String(flavor);
-}
-
-String HttpNotifier::escapeJsonString(const String& input) const
-{
-    String output;
-    output.reserve(input.length());
-    for (unsigned int i = 0; i < input.length(); i++)
-    {
-        const char ch = input[i];
-        switch (ch)
-        {
-        case '\\':
-        case '"':
-            output += '\\';
-            output += ch;
-            break;
-        case '\n':
-            output += "\\n";
-            break;
-        case '\r':
-            output += "\\r";
-            break;
-        case '\t':
-            output += "\\t";
-            break;
-        default:
-            output += ch;
-            break;
-        }
-    }
-    return output;
+    return flavors_ ? flavors_->jsonLabel(flavor) : "";
 }
 
 HttpNotifier::FlushResult HttpNotifier::flushQueueOnce()
 {
+    TRACE_SCOPE("http.flush");
     if (WiFi.status() != WL_CONNECTED)
     {
         return FlushResult::ERROR;
@@ -283,9 +273,10 @@ HttpNotifier::FlushResult HttpNotifier::flushQueueOnce()
     String payload;
     time_t oldest_time = 0;
     String oldest_name;
+    int32_t queued = 0;
 
     {
-        std::lock_guard<std::recursive_mutex> lock(spi_mutex);
+        BusLock lock(bus_client_);
         File dir = SD.open("/queue");
         if (!dir || !dir.isDirectory())
         {
@@ -303,6 +294,7 @@ HttpNotifier::FlushResult HttpNotifier::flushQueueOnce()
                 const unsigned long long ts = strtoull(name.c_str(), &endptr, 10);
                 if (ts > 0)
                 {
+                    queued++;
                     if (oldest_time == 0 || ts < static_cast<unsigned long long>(oldest_time)
                         || (ts == static_cast<unsigned long long>(oldest_time) && name < oldest_name))
                     {
@@ -312,10 +304,13 @@ HttpNotifier::FlushResult HttpNotifier::flushQueueOnce()
                 }
             }
             entry.close();
+            // A long directory scan must not hold up the display.
+            lock.yield();
             entry = dir.openNextFile();
         }
         dir.close();
     }
+    http_queue_depth.set(queued);
 
     if (oldest_name.length() == 0)
     {
@@ -326,7 +321,8 @@ HttpNotifier::FlushResult HttpNotifier::flushQueueOnce()
 
     path = String("/queue/") + oldest_name;
     {
-        std::lock_guard<std::recursive_mutex> lock(spi_mutex);
+        BusLock lock(bus_client_);
+        ScopedMetric timing(sd_read_us);
         File file = SD.open(path, FILE_READ);
         if (!file)
         {
@@ -343,7 +339,7 @@ HttpNotifier::FlushResult HttpNotifier::flushQueueOnce()
     if (!extractUInt64(payload, "start_time", &start_time))
     {
         {
-            std::lock_guard<std::recursive_mutex> lock(spi_mutex);
+            BusLock lock(bus_client_);
             SD.remove(path);
         }
         return FlushResult::SUCCESS;
@@ -356,7 +352,7 @@ HttpNotifier::FlushResult HttpNotifier::flushQueueOnce()
     }
 
     {
-        std::lock_guard<std::recursive_mutex> lock(spi_mutex);
+        BusLock lock(bus_client_);
         SD.remove(path);
     }
     Serial.println("HttpNotifier: end flushQueueOnce");
@@ -369,22 +365,48 @@ bool HttpNotifier::sendPayload(const String& payload, const time_t start_time)
     {
         return false;
     }
+    return transport_->sendTransition(start_time, payload.c_str());
+}
 
-    HTTPClient http;
-    WiFiClient client;
-    String url = "http://" + host_ + ":" + String(port_) + "/pomodoros/" + String(static_cast<unsigned long>(start_time)) + "/transitions";
-    Serial.println("HttpNotifier: Sending payload to " + url);
-    if (!http.begin(client, url))
+void HttpNotifier::pushMetrics()
+{
+    // Only the queue task pushes, so one buffer will do. Sized for about 40 metrics and today's totals.
+    static char json[4096 + kDailyStatsJsonBytes];
+    size_t length = metrics().formatJson(json, sizeof(json) - kDailyStatsJsonBytes);
+    if (daily_stats_ && flavors_ && length > 0)
     {
-        Serial.println("HttpNotifier: HTTP begin failed");
-        return false;
+        // Reopen the object for one more key; the metrics left room for it and the closing brace.
+        length--;
+        length += snprintf(json + length, sizeof(json) - length, "%s\"daily_stats\":", length > 1 ? "," : "");
+        length += formatDailyStatsJson(daily_stats_->snapshot(), *flavors_, json + length, sizeof(json) - length - 1);
+        json[length++] = '}';
+        json[length] = '\0';
+    }
+    transport_->sendDocument("metrics", json);
+    // A failed push is not retried early: the next snapshot carries the same totals. Never 0, which
+    // means "not pushed yet".
+    last_metrics_push_ms_ = millis() | 1;
+}
+
+void HttpNotifier::pushPostMortem()
+{
+    // Kept for the next attempt unless the backend took it.
+    if (transport_->sendDocument("postmortem", post_mortem_.c_str()))
+    {
+        post_mortem_pending_.store(false, std::memory_order_relaxed);
+        post_mortem_ = String();
     }
-    http.addHeader("Content-Type", "application/json");
-    http.setTimeout(2000);
-    const int code = http.POST(payload);
-    http.end();
-    Serial.println("HttpNotifier: HTTP response code: " + String(code));
-    return code >= 200 && code < 300;
+}
+
+void HttpNotifier::countTransportStats()
+{
+    const TransportStats stats = transport_->stats();
+    transport_connects.add(stats.connects - counted_stats_.connects);
+    transport_round_trips.add(stats.round_trips - counted_stats_.round_trips);
+    transport_bytes_sent.add(stats.bytes_sent - counted_stats_.bytes_sent);
+    transport_bytes_received.add(stats.bytes_received - counted_stats_.bytes_received);
+    transport_air_bytes.add(airBytes(stats) - airBytes(counted_stats_));
+    counted_stats_ = stats;
 }
 
 void HttpNotifier::notifyQueueTask()
@@ -418,14 +440,10 @@ void HttpNotifier::queueTask()
         }
         if (event_queue_)
         {
-            QueueEvent* event = nullptr;
+            QueueEvent event;
             while (xQueueReceive(event_queue_, &event, 0) == pdTRUE)
             {
-                if (event)
-                {
-                    persistEvent(*event);
-                    delete event;
-                }
+                persistEvent(event);
             }
         }
         
@@ -442,5 +460,27 @@ void HttpNotifier::queueTask()
         } else {
             wait_ticks = pdMS_TO_TICKS(5000);
         }
+
+        // Wake up for the next metrics push even with nothing queued.
+        if (WiFi.status() == WL_CONNECTED)
+        {
+            if (post_mortem_pending_.load(std::memory_order_acquire))
+            {
+                pushPostMortem();
+            }
+            if (last_metrics_push_ms_ == 0 || millis() - last_metrics_push_ms_ >= kMetricsPushMs)
+            {
+                pushMetrics();
+            }
+            const TickType_t until_push = pdMS_TO_TICKS(kMetricsPushMs - (millis() - last_metrics_push_ms_));
+            wait_ticks = until_push < wait_ticks ? until_push : wait_ticks;
+            // A persistent connection may need pinging before then.
+            const uint32_t until_idle = transport_->idle();
+            if (until_idle != UINT32_MAX && pdMS_TO_TICKS(until_idle) < wait_ticks)
+            {
+                wait_ticks = pdMS_TO_TICKS(until_idle);
+            }
+        }
+        countTransportStats();
     }
 }
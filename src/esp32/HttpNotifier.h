@@ -5,7 +5,7 @@
 #ifndef HTTPNOTIFIER_H
 #define HTTPNOTIFIER_H
 
-#include <array>
+#include <atomic>
 
 #include <Arduino.h>
 #include <freertos/FreeRTOS.h>
@@ -13,13 +13,37 @@
 #include <freertos/semphr.h>
 #include <freertos/task.h>
 
+#include "BusArbiter.h"
+#include "DailyStats.h"
+#include "FlavorTable.h"
 #include "Pomodoro.h"
+#include "Transport.h"
 
+// Queues transitions on the SD card and has a background task deliver them, oldest first, through
+// a Transport (HTTP or MQTT). Null disables it.
 class HttpNotifier final : public PomodoroObserver
 {
 public:
-    HttpNotifier(const char* host, uint16_t port);
-    void setFlavorLabels(const std::array<String, 3>& labels);
+    explicit HttpNotifier(Transport* transport);
+
+    // Labels go into the JSON as the table escaped them; it must outlive the notifier.
+    void setFlavors(const FlavorTable* flavors)
+    {
+        flavors_ = flavors;
+    }
+
+    // Adds today's totals to each metrics push as "daily_stats"; needs setFlavors() too.
+    void setDailyStats(const DailyStats* daily_stats)
+    {
+        daily_stats_ = daily_stats;
+    }
+
+    // Events are queued on the SD card while offline; call when WiFi comes up to send them now
+    // instead of at the next retry.
+    void networkUp();
+
+    // Sends a watchdog post-mortem (formatPostMortemJson) as the "postmortem" document once online.
+    void reportPostMortem(const char* json);
 
     void notification(ClockUpdate update) override;
     void notification(IdleToWork update) override;
@@ -29,22 +53,46 @@ public:
     void notification(AdditionalWork) override {}
 
 private:
+    enum class EventKind : uint8_t
+    {
+        IDLE_TO_WORK,
+        WORK_TO_BREAK,
+        BREAK_TO_IDLE,
+        WORK_TO_IDLE
+    };
+
+    // Queued by value; the JSON is only written on the queue task.
     struct QueueEvent
     {
         time_t event_time;
         time_t start_time;
-        String transition;
-        String extra_json;
+        EventKind kind;
+        uint8_t work_flavor;
+        // Work, break or cancelled work duration, as the kind says.
+        uint32_t duration;
     };
 
-    String host_;
-    uint16_t port_;
+    // The largest payload: work_to_idle with a fully escaped label.
+    static constexpr size_t kPayloadBytes = 256;
+
+    // Metrics snapshots are sent this often while the network is up.
+    static constexpr uint32_t kMetricsPushMs = 15 * 60 * 1000;
+
+    BusClient bus_client_;
+    Transport* transport_;
+    // What the transport had sent when last added to the transport.* counters.
+    TransportStats counted_stats_;
     time_t current_start_time_;
     uint8_t current_work_flavor_;
     bool enabled_;
     TaskHandle_t queue_task_;
     QueueHandle_t event_queue_;
-    std::array<String, 3> flavor_labels_;
+    const FlavorTable* flavors_;
+    const DailyStats* daily_stats_;
+    uint32_t last_metrics_push_ms_;
+    String post_mortem_;
+    // Set once post_mortem_ is written; the queue task only reads it after seeing this.
+    std::atomic<bool> post_mortem_pending_;
 
     enum class FlushResult {
         SUCCESS,
@@ -54,14 +102,16 @@ private:
 
     bool ensureQueueDir();
     String makeQueueFilename(time_t event_time);
-    String makePayload(time_t event_time, time_t start_time, const char* transition, const String& extra_json);
-    bool enqueueEvent(time_t event_time, time_t start_time, const char* transition, const String& extra_json);
+    size_t makePayload(const QueueEvent& event, char* out, size_t size) const;
+    bool enqueueEvent(const QueueEvent& event);
     bool persistEvent(const QueueEvent& event);
     FlushResult flushQueueOnce();
     bool sendPayload(const String& payload, time_t start_time);
+    void pushMetrics();
+    void countTransportStats();
+    void pushPostMortem();
     bool extractUInt64(const String& payload, const char* key, unsigned long long* value) const;
-    String flavorLabel(uint8_t flavor) const;
-    String escapeJsonString(const String& input) const;
+    const char* jsonFlavorLabel(uint8_t flavor) const;
     void notifyQueueTask();
     static void queueTaskTrampoline(void* context);
     void queueTask();
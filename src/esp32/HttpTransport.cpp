@@ -0,0 +1,86 @@
+//
+// Delivers HttpNotifier's events as one HTTP POST each, over a fresh connection.
+//
+
+#include "HttpTransport.h"
+
+#include <HTTPClient.h>
+#include <WiFi.h>
+
+#include "Metrics.h"
+#include "Trace.h"
+
+namespace
+{
+// A backend on the LAN answers well within the budget; the client gives up at 2 s.
+Histogram http_rtt_us("http.rtt_us", 500000);
+Counter http_2xx("http.status_2xx");
+Counter http_4xx("http.status_4xx");
+Counter http_5xx("http.status_5xx");
+// Connection failures and timeouts: HTTPClient reports them as negative codes.
+Counter http_failed("http.failed");
+}
+
+HttpTransport::HttpTransport(const char* host, const uint16_t port) : host_(host ? host : ""), port_(port), stats_()
+{
+}
+
+bool HttpTransport::sendTransition(const time_t start_time, const char* json)
+{
+    const int code = post("/pomodoros/" + String(static_cast<unsigned long>(start_time)) + "/transitions", json);
+    return code >= 200 && code < 300;
+}
+
+bool HttpTransport::sendDocument(const char* name, const char* json)
+{
+    const int code = post(String("/") + name, json);
+    return code >= 200 && code < 300;
+}
+
+int HttpTransport::post(const String& path, const char* payload)
+{
+    TRACE_SCOPE("http.post");
+    HTTPClient http;
+    WiFiClient client;
+    String url = "http://" + host_ + ":" + String(port_) + path;
+    Serial.println("HttpNotifier: Sending payload to " + url);
+    if (!http.begin(client, url))
+    {
+        Serial.println("HttpNotifier: HTTP begin failed");
+        http_failed.add();
+        return -1;
+    }
+    http.addHeader("Content-Type", "application/json");
+    http.setTimeout(2000);
+    const size_t length = strlen(payload);
+    const uint32_t started = micros();
+    const int code = http.POST(reinterpret_cast<uint8_t*>(const_cast<char*>(payload)), length);
+    http_rtt_us.record(micros() - started);
+    stats_.connects++;
+    stats_.round_trips++;
+    stats_.bytes_sent += httpPostBytes(host_.c_str(), port_, path.c_str(), length);
+    if (code > 0)
+    {
+        const int body = http.getSize();
+        stats_.bytes_received += kHttpResponseHeaderBytes + (body > 0 ? static_cast<uint32_t>(body) : 0);
+    }
+    http.end();
+    Serial.println("HttpNotifier: HTTP response code: " + String(code));
+    if (code >= 200 && code < 300)
+    {
+        http_2xx.add();
+    }
+    else if (code >= 400 && code < 500)
+    {
+        http_4xx.add();
+    }
+    else if (code >= 500)
+    {
+        http_5xx.add();
+    }
+    else if (code <= 0)
+    {
+        http_failed.add();
+    }
+    return code;
+}
@@ -0,0 +1,36 @@
+//
+// Delivers HttpNotifier's events as one HTTP POST each, over a fresh connection.
+//
+
+#ifndef HTTPTRANSPORT_H
+#define HTTPTRANSPORT_H
+
+#include <Arduino.h>
+
+#include "Transport.h"
+
+// POST /pomodoros/{start_time}/transitions for transitions, POST /{name} for documents. Bytes are
+// counted with httpPostBytes and the reference backend's response headers, since HTTPClient
+// reports neither.
+class HttpTransport final : public Transport
+{
+public:
+    HttpTransport(const char* host, uint16_t port);
+
+    bool sendTransition(time_t start_time, const char* json) override;
+    bool sendDocument(const char* name, const char* json) override;
+
+    TransportStats stats() const override
+    {
+        return stats_;
+    }
+
+private:
+    String host_;
+    uint16_t port_;
+    TransportStats stats_;
+
+    int post(const String& path, const char* payload);
+};
+
+#endif //HTTPTRANSPORT_H
@@ -0,0 +1,74 @@
+//
+// Samples the buttons on a task of its own and queues debounced, timestamped presses.
+//
+
+#include <M5Unified.h>
+
+#include "InputTask.h"
+
+#include "Trace.h"
+
+InputTask::InputTask() : action_latency_("input.to_state_us"), queue_(nullptr), task_(nullptr), dropped_(0)
+{
+    M5.BtnA.setDebounceThresh(0);
+    M5.BtnB.setDebounceThresh(0);
+    M5.BtnC.setDebounceThresh(0);
+    queue_ = xQueueCreate(kQueueLength, sizeof(InputEvent));
+    xTaskCreatePinnedToCore(taskTrampoline, "Input", 3072, this, 3, &task_, 1);
+}
+
+bool InputTask::next(InputEvent* event, const TickType_t wait)
+{
+    return xQueueReceive(queue_, event, wait) == pdTRUE;
+}
+
+void InputTask::handled(const InputEvent& event)
+{
+    action_latency_.record(static_cast<uint32_t>(monotonicMicros() - event.pressed_us));
+    const MetricSample summary = action_latency_.sample();
+    if (summary.value % kReportEvery == 0)
+    {
+        char line[160];
+        formatLatencySummary(summary, line, sizeof(line));
+        Serial.println(line);
+    }
+}
+
+void InputTask::taskTrampoline(void* context)
+{
+    InputTask* self = static_cast<InputTask*>(context);
+    if (self)
+    {
+        self->task();
+    }
+    vTaskDelete(nullptr);
+}
+
+void InputTask::task()
+{
+    TickType_t last_wake = xTaskGetTickCount();
+    InputEvent events[BUTTONS];
+    while (true)
+    {
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(kSampleMs));
+        // Buttons and touch are read over I2C; nothing here needs the SPI bus.
+        const uint64_t update_started_us = monotonicMicros();
+        M5.update();
+        // Sampled every few ms: only the slow updates are worth a slot in the trace ring.
+        if (monotonicMicros() - update_started_us >= kSlowUpdateUs)
+        {
+            tracer().complete("m5.update", update_started_us);
+        }
+        const uint8_t raw = (M5.BtnA.isPressed() ? 1 : 0) | (M5.BtnB.isPressed() ? 2 : 0)
+            | (M5.BtnC.isPressed() ? 4 : 0);
+        const size_t count = debouncer_.sample(raw, monotonicMicros(), time(nullptr), events);
+        for (size_t i = 0; i < count; i++)
+        {
+            tracer().instant("input.press", static_cast<uint32_t>(events[i].button));
+            if (xQueueSend(queue_, &events[i], 0) != pdTRUE)
+            {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+}
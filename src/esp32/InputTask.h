@@ -0,0 +1,59 @@
+//
+// Samples the buttons on a task of its own and queues debounced, timestamped presses.
+//
+
+#ifndef INPUTTASK_H
+#define INPUTTASK_H
+
+#include <atomic>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
+#include "FrameTiming.h"
+#include "InputEvents.h"
+
+// Calls M5.update() every kSampleMs and feeds BtnA/B/C (touch areas on the Core2) through a
+// ButtonDebouncer; M5Unified's own debounce is turned off so presses are stamped at first
+// contact. The main loop blocks on next() instead of polling.
+class InputTask
+{
+public:
+    InputTask();
+
+    // Waits up to `wait` for the next press. Only the main loop may call this.
+    bool next(InputEvent* event, TickType_t wait);
+
+    // Records press-to-state-change latency once the main loop has changed the state for `event`,
+    // and logs a summary every kReportEvery such presses. Not for presses that changed nothing.
+    void handled(const InputEvent& event);
+
+    const Histogram& actionLatency() const
+    {
+        return action_latency_;
+    }
+
+    // Presses lost because the queue was full.
+    uint32_t dropped() const
+    {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr uint32_t kSampleMs = 5;
+    static constexpr uint64_t kSlowUpdateUs = 1000;
+    static constexpr UBaseType_t kQueueLength = 8;
+    static constexpr uint32_t kReportEvery = 20;
+
+    ButtonDebouncer debouncer_;
+    Histogram action_latency_;
+    QueueHandle_t queue_;
+    TaskHandle_t task_;
+    std::atomic<uint32_t> dropped_;
+
+    static void taskTrampoline(void* context);
+    void task();
+};
+
+#endif //INPUTTASK_H
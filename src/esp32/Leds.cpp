@@ -6,36 +6,50 @@
 
 #include "Leds.h"
 
-Leds::Leds()
+Leds::Leds() : task_(nullptr), frames_(0), shows_(0)
 {
-    FastLED.addLeds<WS2812, 15, GRB>(internal_leds_, 10);
-    FastLED.addLeds<SK6812, 26, GRB>(external_leds_, 30);
+    FastLED.addLeds<WS2812, 15, GRB>(internal_leds_, kInternalLeds);
+    FastLED.addLeds<SK6812, 26, GRB>(external_leds_, kExternalLeds);
     FastLED.setBrightness(200);
     FastLED.clear();
+    xTaskCreatePinnedToCore(taskTrampoline, "Leds", 3072, this, 1, &task_, 1);
 }
 
 void Leds::notification(ClockUpdate update)
 {
-    RGBColor color;
-    switch (update.state)
-    {
-    case IDLE:
-        color = RGBColor(0, 0, 0);
-        break;
-    case WORK:
-        color = RGBColor(0, 255, 0);
-        break;
-    case BREAK:
-        color = RGBColor(255, 0, 0);
-        break;
-    }
-    for (int i = 0; i < kInternalLeds; i++)
+    animator_.update(update, millis());
+}
+
+void Leds::taskTrampoline(void* context)
+{
+    Leds* self = static_cast<Leds*>(context);
+    if (self)
     {
-        internal_leds_[i] = CRGB(color.r, color.g, color.b);
+        self->task();
     }
-    for (int i = 0; i < kExternalLeds; i++)
+    vTaskDelete(nullptr);
+}
+
+void Leds::task()
+{
+    TickType_t last_wake = xTaskGetTickCount();
+    while (true)
     {
-        external_leds_[i] = CRGB(color.r, color.g, color.b);
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(kFrameMs));
+        frames_.fetch_add(1, std::memory_order_relaxed);
+        if (!animator_.render(millis(), &frame_))
+        {
+            continue;
+        }
+        for (int i = 0; i < kInternalLeds; i++)
+        {
+            internal_leds_[i] = CRGB(frame_.internal[i].r, frame_.internal[i].g, frame_.internal[i].b);
+        }
+        for (int i = 0; i < kExternalLeds; i++)
+        {
+            external_leds_[i] = CRGB(frame_.external[i].r, frame_.external[i].g, frame_.external[i].b);
+        }
+        FastLED.show();
+        shows_.fetch_add(1, std::memory_order_relaxed);
     }
-    FastLED.show();
 }
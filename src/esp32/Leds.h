@@ -4,10 +4,17 @@
 
 #ifndef LEDS_H
 #define LEDS_H
+#include <atomic>
+
 #include <Pomodoro.h>
 #include <FastLED.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 
+#include "LedEffects.h"
 
+// Drives both LED strips from a LedAnimator on a fixed-rate task. Observer callbacks only hand the
+// update over; FastLED.show() runs only for frames that differ from the last one shown.
 class Leds : public PomodoroObserver
 {
 public:
@@ -18,12 +25,33 @@ public:
     void notification(::BreakToIdle) override {}
     void notification(::WorkToIdle) override {}
     void notification(::AdditionalWork) override {}
+
+    // Frames rendered, and how many of them needed a show().
+    uint32_t frames() const
+    {
+        return frames_.load(std::memory_order_relaxed);
+    }
+
+    uint32_t shows() const
+    {
+        return shows_.load(std::memory_order_relaxed);
+    }
+
 private:
-    constexpr static int kInternalLeds = 10;
-    constexpr static int kExternalLeds = 30;
+    constexpr static int kInternalLeds = INTERNAL_LEDS;
+    constexpr static int kExternalLeds = EXTERNAL_LEDS;
+    constexpr static uint32_t kFrameMs = 20;
 
     CRGB internal_leds_[kInternalLeds];
     CRGB external_leds_[kExternalLeds];
+    LedAnimator animator_;
+    LedFrame frame_;
+    TaskHandle_t task_;
+    std::atomic<uint32_t> frames_;
+    std::atomic<uint32_t> shows_;
+
+    static void taskTrampoline(void* context);
+    void task();
 };
 
 
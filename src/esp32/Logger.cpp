@@ -1,37 +1,333 @@
 #include "Logger.h"
+#include "ByteCodec.h"
 #include "Global.h"
+#include "Trace.h"
 #include <SD.h>
 #include <Arduino.h>
+#include <unistd.h>
 
-String isoformat_ctime(const time_t* t)
+namespace
 {
-    struct tm* timeinfo = localtime(t);
-    char buffer[20];
-    strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", timeinfo);
-    return String(buffer);
+// The Arduino File has no truncate; the card's files are under the VFS mount point "/sd".
+bool truncateOnCard(const char* path, const size_t size)
+{
+    char vfs_path[64];
+    snprintf(vfs_path, sizeof(vfs_path), "/sd%s", path);
+    return truncate(vfs_path, static_cast<off_t>(size)) == 0;
+}
 }
 
-void Logger::log_pomodoro(time_t start, time_t end, uint8_t flavor) {
-    if (!ensureSDMounted())
+Logger::Logger()
+{
+    record_queue_ = xQueueCreate(kMaxBatch, sizeof(HistoryRecord));
+    xTaskCreatePinnedToCore(flushTaskTrampoline, "LoggerFlush", 4096, this, 1, &flush_task_, 0);
+}
+
+void Logger::log_pomodoro(time_t start, time_t end, uint8_t flavor, HistoryOutcome outcome) {
+    const HistoryRecord record = {static_cast<uint32_t>(start), static_cast<uint32_t>(end), flavor, outcome, 0};
+    if (!record_queue_ || xQueueSend(record_queue_, &record, 0) != pdTRUE)
     {
+        dropped_.add();
+        Serial.println("Logger: history queue full, dropping record");
         return;
     }
+    if (flush_task_)
+    {
+        xTaskNotifyGive(flush_task_);
+    }
+}
 
-    std::lock_guard<std::recursive_mutex> lock(spi_mutex);
-    File file = SD.open(FILENAME, FILE_APPEND);
-    if (!file)
+uint32_t Logger::pomodorosToday(const time_t now) const
+{
+    const uint16_t today = localDay(now);
+    std::lock_guard<std::mutex> lock(index_mutex_);
+    return index_.recordsOnDay(today);
+}
+
+void Logger::exportCsv()
+{
+    export_requested_.store(true, std::memory_order_relaxed);
+    if (flush_task_)
     {
-        return;
+        xTaskNotifyGive(flush_task_);
+    }
+}
+
+bool Logger::loadIndex()
+{
+    if (!ensureSDMounted())
+    {
+        return false;
     }
 
-    String st_start = isoformat_ctime(&start);
-    String st_end = isoformat_ctime(&end);
+    uint32_t records = 0;
+    HistoryIndexEntry last_entry = {0, 0};
+    bool has_entry = false;
+    {
+        BusLock lock(bus_client_);
+        if (!SD.exists(DIRECTORY) && !SD.mkdir(DIRECTORY))
+        {
+            return false;
+        }
+        File history = SD.open(HISTORY_FILENAME, FILE_READ);
+        if (history)
+        {
+            records = history.size() / HISTORY_RECORD_SIZE;
+            history.close();
+        }
+        File index = SD.open(INDEX_FILENAME, FILE_READ);
+        if (index)
+        {
+            const size_t entries = index.size() / HISTORY_INDEX_ENTRY_SIZE;
+            uint8_t buffer[HISTORY_INDEX_ENTRY_SIZE];
+            if (entries > 0 && index.seek((entries - 1) * HISTORY_INDEX_ENTRY_SIZE)
+                && index.read(buffer, sizeof(buffer)) == sizeof(buffer))
+            {
+                last_entry = decodeHistoryIndexEntry(buffer);
+                has_entry = true;
+            }
+            index.close();
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(index_mutex_);
+    index_.reset(records, has_entry ? &last_entry : nullptr);
+    return true;
+}
 
-    file.print(st_start);
-    file.print(",");
-    file.print(st_end);
-    file.print(",");
-    file.print(flavor);
-    file.print("\n");
-    file.close();
-}
\ No newline at end of file
+bool Logger::writeBatch(HistoryRecord* records, const size_t count)
+{
+    TRACE_SCOPE("logger.write_batch");
+    // Calendar work happens before taking the SPI bus.
+    uint8_t buffer[kMaxBatch * HISTORY_RECORD_SIZE];
+    uint8_t entries_buffer[kMaxBatch * HISTORY_INDEX_ENTRY_SIZE];
+    size_t new_entries = 0;
+    HistoryIndex staged;
+    {
+        std::lock_guard<std::mutex> lock(index_mutex_);
+        staged = index_;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        records[i].day = calendar_.dayOf(records[i].start);
+        encodeHistoryRecord(records[i], buffer + i * HISTORY_RECORD_SIZE);
+        HistoryIndexEntry entry;
+        if (staged.append(records[i], &entry))
+        {
+            encodeHistoryIndexEntry(entry, entries_buffer + new_entries * HISTORY_INDEX_ENTRY_SIZE);
+            new_entries++;
+        }
+    }
+
+    if (!ensureSDMounted())
+    {
+        return false;
+    }
+
+    {
+        BusLock lock(bus_client_);
+        ScopedMetric timing(sd_write_us);
+        File file = SD.open(HISTORY_FILENAME, FILE_APPEND);
+        if (!file)
+        {
+            return false;
+        }
+        // A partial record would shift every later one; on any failure both files go back to
+        // their previous size and the caller retries the whole batch.
+        const size_t history_size = file.size();
+        const size_t bytes = count * HISTORY_RECORD_SIZE;
+        const size_t written = file.write(buffer, bytes);
+        file.close();
+        if (written != bytes)
+        {
+            truncateOnCard(HISTORY_FILENAME, history_size);
+            return false;
+        }
+        if (new_entries > 0)
+        {
+            File index = SD.open(INDEX_FILENAME, FILE_APPEND);
+            if (!index)
+            {
+                truncateOnCard(HISTORY_FILENAME, history_size);
+                return false;
+            }
+            const size_t index_size = index.size();
+            const size_t index_bytes = new_entries * HISTORY_INDEX_ENTRY_SIZE;
+            const bool indexed = index.write(entries_buffer, index_bytes) == index_bytes;
+            index.close();
+            if (!indexed)
+            {
+                truncateOnCard(INDEX_FILENAME, index_size);
+                truncateOnCard(HISTORY_FILENAME, history_size);
+                return false;
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(index_mutex_);
+    index_ = staged;
+    return true;
+}
+
+bool Logger::exportPending()
+{
+    TRACE_SCOPE("logger.export");
+    if (!ensureSDMounted())
+    {
+        return false;
+    }
+
+    uint32_t exported = 0;
+    uint32_t records = 0;
+    {
+        std::lock_guard<std::mutex> lock(index_mutex_);
+        records = index_.records();
+    }
+    {
+        BusLock lock(bus_client_);
+        File mark = SD.open(EXPORT_MARK_FILENAME, FILE_READ);
+        uint8_t buffer[4];
+        if (mark && mark.read(buffer, sizeof(buffer)) == sizeof(buffer))
+        {
+            exported = getUint32(buffer);
+        }
+        if (mark)
+        {
+            mark.close();
+        }
+    }
+    if (exported > records)
+    {
+        exported = 0;
+    }
+
+    while (exported < records)
+    {
+        uint8_t buffer[kMaxBatch * HISTORY_RECORD_SIZE];
+        char lines[kMaxBatch * 48];
+        const size_t count = records - exported < kMaxBatch ? records - exported : kMaxBatch;
+        {
+            BusLock lock(bus_client_);
+            ScopedMetric timing(sd_read_us);
+            File history = SD.open(HISTORY_FILENAME, FILE_READ);
+            if (!history)
+            {
+                return false;
+            }
+            const bool ok = history.seek(exported * HISTORY_RECORD_SIZE)
+                && history.read(buffer, count * HISTORY_RECORD_SIZE) == count * HISTORY_RECORD_SIZE;
+            history.close();
+            if (!ok)
+            {
+                return false;
+            }
+        }
+
+        size_t length = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            length += formatHistoryCsvLine(decodeHistoryRecord(buffer + i * HISTORY_RECORD_SIZE), calendar_,
+                                           lines + length, sizeof(lines) - length);
+        }
+
+        {
+            BusLock lock(bus_client_);
+            ScopedMetric timing(sd_write_us);
+            File csv = SD.open(FILENAME, FILE_APPEND);
+            if (!csv)
+            {
+                return false;
+            }
+            // The mark only moves past lines that made it to the card; a failed or short append is
+            // taken back and retried on the next export.
+            const size_t csv_size = csv.size();
+            const size_t written = csv.write(reinterpret_cast<const uint8_t*>(lines), length);
+            csv.close();
+            if (written != length)
+            {
+                truncateOnCard(FILENAME, csv_size);
+                return false;
+            }
+
+            if (!writeExportMark(exported + count))
+            {
+                // Lines in the CSV but not counted by the mark would be exported twice.
+                truncateOnCard(FILENAME, csv_size);
+                writeExportMark(exported);
+                return false;
+            }
+            exported += count;
+        }
+    }
+    return true;
+}
+
+bool Logger::writeExportMark(const uint32_t exported)
+{
+    uint8_t buffer[4];
+    putUint32(buffer, exported);
+    File mark = SD.open(EXPORT_MARK_FILENAME, FILE_WRITE);
+    if (!mark)
+    {
+        return false;
+    }
+    const bool written = mark.write(buffer, sizeof(buffer)) == sizeof(buffer);
+    mark.close();
+    return written;
+}
+
+void Logger::flushTaskTrampoline(void* context)
+{
+    Logger* self = static_cast<Logger*>(context);
+    if (self)
+    {
+        self->flushTask();
+    }
+    vTaskDelete(nullptr);
+}
+
+void Logger::flushTask()
+{
+    bool index_loaded = loadIndex();
+    // Records that failed to write stay at the front of the batch and go first on the next try.
+    HistoryRecord batch[kMaxBatch];
+    size_t pending = 0;
+    for (;;)
+    {
+        ulTaskNotifyTake(pdTRUE, pending > 0 ? pdMS_TO_TICKS(kRetryMs) : portMAX_DELAY);
+        // Give closely spaced records (e.g. a cancel right after a transition) a chance to share a write.
+        vTaskDelay(pdMS_TO_TICKS(kBatchWindowMs));
+
+        if (!index_loaded)
+        {
+            index_loaded = loadIndex();
+        }
+
+        queue_depth_.set(static_cast<int32_t>(uxQueueMessagesWaiting(record_queue_)));
+        for (;;)
+        {
+            while (pending < kMaxBatch && xQueueReceive(record_queue_, &batch[pending], 0) == pdTRUE)
+            {
+                pending++;
+            }
+            if (pending == 0)
+            {
+                break;
+            }
+            if (!index_loaded || !writeBatch(batch, pending))
+            {
+                Serial.println("Logger: failed to write history batch, will retry");
+                break;
+            }
+            pending = 0;
+        }
+
+        if (index_loaded && export_requested_.exchange(false, std::memory_order_relaxed))
+        {
+            if (!exportPending())
+            {
+                Serial.println("Logger: CSV export failed");
+            }
+        }
+    }
+}
@@ -1,33 +1,81 @@
 #ifndef LOGGER_H
 #define LOGGER_H
 
+#include <atomic>
+#include <mutex>
+
 #include <M5Unified.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
+#include "Global.h"
+#include "History.h"
 #include "Pomodoro.h"
+#include "TimeFormat.h"
 
+// Appends finished pomodoros to a fixed-record binary history on SD. Observer callbacks only
+// enqueue a record; a background task batches them into a single write per flush, off the
+// notification path. pomodoro.csv is produced on demand by exportCsv().
 class Logger : public PomodoroObserver {
 
+    const char* DIRECTORY = "/sd";
     const char* FILENAME = "/sd/pomodoro.csv";
+    const char* HISTORY_FILENAME = "/sd/pomodoro.bin";
+    const char* INDEX_FILENAME = "/sd/pomodoro.idx";
+    const char* EXPORT_MARK_FILENAME = "/sd/pomodoro.exp";
+
+    static constexpr size_t kMaxBatch = 16;
+    static constexpr uint32_t kBatchWindowMs = 1000;
+    static constexpr uint32_t kRetryMs = 30000;
 
     time_t start_time = 0;
     uint8_t work_flavor = 0;
 
-    void log_pomodoro(time_t start, time_t end, uint8_t flavor);
+    QueueHandle_t record_queue_ = nullptr;
+    TaskHandle_t flush_task_ = nullptr;
+    std::atomic<bool> export_requested_{false};
+
+    mutable std::mutex index_mutex_;
+    HistoryIndex index_;
+    LocalTimeCache calendar_;   // flush task only
+    BusClient bus_client_{spi_bus, "logger", BusPriority::BACKGROUND};
+    Gauge queue_depth_{"logger.queue_depth"};
+    Counter dropped_{"logger.dropped"};
+
+    void log_pomodoro(time_t start, time_t end, uint8_t flavor, HistoryOutcome outcome);
+
+    bool loadIndex();
+    bool writeBatch(HistoryRecord* records, size_t count);
+    bool exportPending();
+    // Bus held by the caller.
+    bool writeExportMark(uint32_t exported);
+    static void flushTaskTrampoline(void* context);
+    void flushTask();
 
     public:
 
+    Logger();
+
+    // Number of pomodoros (completed or cancelled) already written to the history today.
+    uint32_t pomodorosToday(time_t now = time(nullptr)) const;
+
+    // Asks the background task to append the records not yet exported to pomodoro.csv.
+    void exportCsv();
+
     void notification(IdleToWork update) override {
         start_time = update.now;
         work_flavor = update.work_flavor;
     }
     void notification(WorkToBreak update) override {
-        log_pomodoro(start_time, update.now, work_flavor);
+        log_pomodoro(start_time, update.now, work_flavor, HistoryOutcome::COMPLETED);
     }
     void notification(WorkToIdle update) override {
-        log_pomodoro(start_time, update.now, work_flavor);
+        log_pomodoro(start_time, update.now, work_flavor, HistoryOutcome::CANCELLED);
     }
     void notification(AdditionalWork update) override {}
     void notification(BreakToIdle update) override {}
     void notification(ClockUpdate update) override {}
 };
 
-#endif //LOGGER_H
\ No newline at end of file
+#endif //LOGGER_H
@@ -0,0 +1,96 @@
+//
+// Delivers HttpNotifier's events over one persistent MQTT connection with binary payloads.
+//
+
+#include "MqttTransport.h"
+
+#include <cstring>
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#include "Metrics.h"
+#include "Trace.h"
+
+namespace
+{
+Histogram mqtt_rtt_us("mqtt.rtt_us", 500000);
+Counter mqtt_failed("mqtt.failed");
+Counter mqtt_sessions_lost("mqtt.sessions_lost");
+
+// The queued JSON, as HttpNotifier::makePayload writes it.
+bool parseTransition(const char* json, TransitionRecord* record)
+{
+    JsonDocument doc;
+    if (deserializeJson(doc, json) || !transitionKind(doc["transition"] | "", &record->kind))
+    {
+        return false;
+    }
+    record->start_time = doc["start_time"] | 0UL;
+    record->event_time = doc["event_time"] | 0UL;
+    record->duration = 0;
+    for (const char* key : {"work_duration", "break_duration", "cancelled_work_duration"})
+    {
+        if (doc.containsKey(key))
+        {
+            record->duration = doc[key].as<uint32_t>();
+        }
+    }
+    snprintf(record->flavor, sizeof(record->flavor), "%s", doc["work_flavor"] | "");
+    return true;
+}
+}
+
+MqttTransport::MqttTransport(const char* host, const uint16_t port, const char* client_id)
+    : link_(host, port), client_(link_, client_id, kKeepAliveSeconds), topic_root_()
+{
+    snprintf(topic_root_, sizeof(topic_root_), "pomodoro/%s", client_id);
+}
+
+bool MqttTransport::sendTransition(time_t, const char* json)
+{
+    TransitionRecord record = {};
+    if (!parseTransition(json, &record))
+    {
+        // Retrying would not help; acknowledging drops it from the queue.
+        Serial.println("MqttTransport: dropping unreadable event");
+        return true;
+    }
+    uint8_t payload[kTransitionRecordMaxBytes];
+    const size_t length = encodeTransition(record, payload, sizeof(payload));
+    return publish("state", payload, length, 1, true);
+}
+
+bool MqttTransport::sendDocument(const char* name, const char* json)
+{
+    const uint8_t qos = strcmp(name, "metrics") == 0 ? 0 : 1;
+    return publish(name, reinterpret_cast<const uint8_t*>(json), strlen(json), qos, false);
+}
+
+uint32_t MqttTransport::idle()
+{
+    return client_.keepAlive();
+}
+
+bool MqttTransport::publish(const char* leaf, const uint8_t* payload, const size_t length, const uint8_t qos,
+                            const bool retain)
+{
+    TRACE_SCOPE("mqtt.publish");
+    char topic[sizeof(topic_root_) + 16];
+    snprintf(topic, sizeof(topic), "%s/%s", topic_root_, leaf);
+    const bool was_connected = client_.connected();
+    const uint32_t started = micros();
+    const bool ok = client_.publish(topic, payload, length, qos, retain);
+    mqtt_rtt_us.record(micros() - started);
+    if (!ok)
+    {
+        mqtt_failed.add();
+        Serial.printf("MqttTransport: publish to %s failed\n", topic);
+    }
+    else if (!was_connected && !client_.sessionPresent())
+    {
+        // The broker forgot us (first connect, or it restarted without persistence).
+        mqtt_sessions_lost.add();
+    }
+    return ok;
+}
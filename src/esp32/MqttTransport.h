@@ -0,0 +1,41 @@
+//
+// Delivers HttpNotifier's events over one persistent MQTT connection with binary payloads.
+//
+
+#ifndef MQTTTRANSPORT_H
+#define MQTTTRANSPORT_H
+
+#include "Mqtt.h"
+#include "Transport.h"
+
+// Transitions go to pomodoro/{client_id}/state as QoS 1 retained TransitionRecords, so a backend
+// subscribed with a persistent session gets every one and a new subscriber sees the latest state.
+// Metrics go to .../metrics at QoS 0 (the next snapshot carries the same totals), post-mortems to
+// .../postmortem at QoS 1, both as JSON. The keep-alive is long: a ping costs less than a
+// reconnect, but pomodoros are minutes apart.
+class MqttTransport final : public Transport
+{
+public:
+    static constexpr uint16_t kKeepAliveSeconds = 20 * 60;
+
+    // `host` must outlive the transport.
+    MqttTransport(const char* host, uint16_t port, const char* client_id);
+
+    bool sendTransition(time_t start_time, const char* json) override;
+    bool sendDocument(const char* name, const char* json) override;
+    uint32_t idle() override;
+
+    TransportStats stats() const override
+    {
+        return client_.stats();
+    }
+
+private:
+    SocketLink link_;
+    MqttClient client_;
+    char topic_root_[40];
+
+    bool publish(const char* leaf, const uint8_t* payload, size_t length, uint8_t qos, bool retain);
+};
+
+#endif //MQTTTRANSPORT_H
@@ -0,0 +1,159 @@
+//
+// Brings up WiFi and NTP on a background task so the clock never waits for the network.
+//
+
+#include <M5Unified.h>
+#include <WiFi.h>
+#include <esp_sntp.h>
+#include <sys/time.h>
+
+#include "NetworkStartup.h"
+#include "FrameTiming.h"
+#include "History.h"
+#include "Trace.h"
+
+namespace
+{
+// Anything earlier means the clock was never set.
+constexpr time_t kValidTime = 1735689600; // 2025-01-01
+// SNTP's sync callback takes no context; there is one NetworkStartup.
+NetworkStartup* sync_listener = nullptr;
+}
+
+NetworkStartup::NetworkStartup(const char* ssid, const char* password, const char* ntp_host,
+                               BootTimeline* timeline)
+    : ssid_(ssid),
+      password_(password),
+      ntp_host_(ntp_host),
+      timeline_(timeline),
+      task_(nullptr),
+      connected_(false),
+      synchronized_(false)
+{
+}
+
+void NetworkStartup::start()
+{
+    xTaskCreatePinnedToCore(taskTrampoline, "Network", 4096, this, 1, &task_, 0);
+}
+
+void NetworkStartup::taskTrampoline(void* context)
+{
+    NetworkStartup* self = static_cast<NetworkStartup*>(context);
+    if (self)
+    {
+        self->task();
+    }
+    vTaskDelete(nullptr);
+}
+
+void NetworkStartup::task()
+{
+    connect();
+    synchronize();
+}
+
+void NetworkStartup::connect()
+{
+    WiFi.mode(WIFI_STA);
+    WiFi.setAutoReconnect(true);
+    // Auto-reconnects happen behind our back; mark the drops so stalls around them can be told apart.
+    WiFi.onEvent([](WiFiEvent_t, WiFiEventInfo_t info) {
+        tracer().instant("wifi.disconnected", info.wifi_sta_disconnected.reason);
+    }, ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+    while (true)
+    {
+        const uint64_t started = monotonicMicros();
+        WiFi.begin(ssid_, password_);
+        const TickType_t deadline = xTaskGetTickCount() + pdMS_TO_TICKS(kConnectTimeoutMs);
+        while (WiFi.status() != WL_CONNECTED && xTaskGetTickCount() < deadline)
+        {
+            vTaskDelay(pdMS_TO_TICKS(100));
+        }
+        const bool ok = WiFi.status() == WL_CONNECTED;
+        report("wifi", started, ok);
+        if (ok)
+        {
+            connected_ = true;
+            return;
+        }
+        WiFi.disconnect();
+        vTaskDelay(pdMS_TO_TICKS(kConnectTimeoutMs));
+    }
+}
+
+void NetworkStartup::synchronize()
+{
+    const uint64_t started = monotonicMicros();
+    sync_listener = this;
+    sntp_set_time_sync_notification_cb(onTimeSync);
+    // The time zone was set at boot; configTime() would reset it, so start SNTP directly.
+    sntp_setoperatingmode(SNTP_OPMODE_POLL);
+    sntp_setservername(0, ntp_host_);
+    sntp_init();
+    // SNTP keeps polling after a slow first sync, and again every hour; each sync it completes wakes
+    // this task, which writes the time back to the RTC (an I2C transfer, kept off the lwIP task).
+    bool timed_out = false;
+    for (;;)
+    {
+        if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(kSyncTimeoutMs)) == 0)
+        {
+            if (!synchronized_ && !timed_out)
+            {
+                timed_out = true;
+                report("ntp", started, false);
+            }
+            continue;
+        }
+        if (!synchronized_)
+        {
+            synchronized_ = true;
+            report("ntp", started, true);
+        }
+        const time_t now = time(nullptr);
+        struct tm utc;
+        gmtime_r(&now, &utc);
+        M5.Rtc.setDateTime(&utc);
+    }
+}
+
+void NetworkStartup::onTimeSync(timeval*)
+{
+    if (sync_listener && sync_listener->task_)
+    {
+        xTaskNotifyGive(sync_listener->task_);
+    }
+}
+
+void NetworkStartup::report(const char* name, const uint64_t start_us, const bool ok)
+{
+    const uint64_t end_us = monotonicMicros();
+    tracer().complete(name, start_us);
+    timeline_->record(name, start_us, end_us, ok);
+    char line[64];
+    timeline_->formatPhase({name, start_us, end_us, ok}, line, sizeof(line));
+    Serial.println(line);
+}
+
+bool setSystemTimeFromRtc()
+{
+    const m5::rtc_datetime_t now = M5.Rtc.getDateTime();
+    if (now.date.year < 2025 || now.date.month < 1 || now.date.month > 12)
+    {
+        return false;
+    }
+    const time_t utc = static_cast<time_t>(daysFromCivil(now.date.year, now.date.month, now.date.date)) * 86400
+        + now.time.hours * 3600 + now.time.minutes * 60 + now.time.seconds;
+    if (utc < kValidTime)
+    {
+        return false;
+    }
+    const timeval value = {utc, 0};
+    settimeofday(&value, nullptr);
+    return true;
+}
+
+bool systemTimeValid()
+{
+    return time(nullptr) >= kValidTime;
+}
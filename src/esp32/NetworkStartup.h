@@ -0,0 +1,66 @@
+//
+// Brings up WiFi and NTP on a background task so the clock never waits for the network.
+//
+
+#ifndef NETWORKSTARTUP_H
+#define NETWORKSTARTUP_H
+
+#include <atomic>
+
+#include <sys/time.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "BootTimeline.h"
+
+// Connects to the access point (retrying for as long as it takes), then starts SNTP and, whenever a
+// sync completes, writes the time back to the RTC for the next boot. Each step is recorded in the
+// BootTimeline and printed when it ends; a first sync slower than kSyncTimeoutMs is recorded as
+// failed, then again once it completes.
+class NetworkStartup
+{
+public:
+    NetworkStartup(const char* ssid, const char* password, const char* ntp_host, BootTimeline* timeline);
+
+    // The strings must outlive the task; the Settings they come from live for the whole run.
+    void start();
+
+    bool connected() const
+    {
+        return connected_;
+    }
+
+    bool synchronized() const
+    {
+        return synchronized_;
+    }
+
+private:
+    static constexpr uint32_t kConnectTimeoutMs = 15000;
+    static constexpr uint32_t kSyncTimeoutMs = 30000;
+
+    const char* ssid_;
+    const char* password_;
+    const char* ntp_host_;
+    BootTimeline* timeline_;
+    TaskHandle_t task_;
+    std::atomic<bool> connected_;
+    std::atomic<bool> synchronized_;
+
+    void connect();
+    void synchronize();
+    void report(const char* name, uint64_t start_us, bool ok);
+    static void onTimeSync(timeval* tv);
+    static void taskTrampoline(void* context);
+    void task();
+};
+
+// Sets the system clock from the RTC, which holds UTC. Returns false, leaving the clock alone, if
+// the RTC was never set (lost power, or first boot).
+bool setSystemTimeFromRtc();
+
+// Whether the system clock holds a real date, from the RTC or NTP.
+bool systemTimeValid();
+
+#endif //NETWORKSTARTUP_H
@@ -0,0 +1,32 @@
+//
+// CheckpointStore backed by a key in the ESP32 NVS partition.
+//
+
+#include "NvsStore.h"
+
+#include <Preferences.h>
+
+size_t NvsCheckpointStore::load(uint8_t* data, const size_t capacity)
+{
+    Preferences preferences;
+    if (!preferences.begin(namespace_, true))
+    {
+        return 0;
+    }
+    const size_t size = preferences.getBytesLength(key_);
+    const size_t result = size > 0 && size <= capacity ? preferences.getBytes(key_, data, capacity) : 0;
+    preferences.end();
+    return result;
+}
+
+bool NvsCheckpointStore::save(const uint8_t* data, const size_t size)
+{
+    Preferences preferences;
+    if (!preferences.begin(namespace_, false))
+    {
+        return false;
+    }
+    const bool result = preferences.putBytes(key_, data, size) == size;
+    preferences.end();
+    return result;
+}
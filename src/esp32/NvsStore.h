@@ -0,0 +1,25 @@
+//
+// CheckpointStore backed by a key in the ESP32 NVS partition.
+//
+
+#ifndef NVSSTORE_H
+#define NVSSTORE_H
+
+#include "Checkpoint.h"
+
+class NvsCheckpointStore final : public CheckpointStore
+{
+public:
+    NvsCheckpointStore(const char* name_space, const char* key) : namespace_(name_space), key_(key)
+    {
+    }
+
+    size_t load(uint8_t* data, size_t capacity) override;
+    bool save(const uint8_t* data, size_t size) override;
+
+private:
+    const char* namespace_;
+    const char* key_;
+};
+
+#endif //NVSSTORE_H
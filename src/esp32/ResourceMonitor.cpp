@@ -0,0 +1,131 @@
+//
+// Samples task stack headroom, heap and PSRAM on a task of its own, for metrics and a long-run trend.
+//
+
+#include "ResourceMonitor.h"
+
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+
+#include "Metrics.h"
+#include "Trace.h"
+
+namespace
+{
+struct WatchedTask
+{
+    const char* name;
+    Gauge stack_free;
+};
+
+// Every task the firmware creates, by the name it was created with. Tasks that have exited (Network
+// does once connected) are skipped.
+WatchedTask watched_tasks[] = {
+    {"loopTask", Gauge("stack_free.loop")},
+    {"ClockFace", Gauge("stack_free.clock_face")},
+    {"Input", Gauge("stack_free.input")},
+    {"Leds", Gauge("stack_free.leds")},
+    {"CuePlayer", Gauge("stack_free.cue_player")},
+    {"LoggerFlush", Gauge("stack_free.logger")},
+    {"HttpNotifyQueue", Gauge("stack_free.http")},
+    {"Network", Gauge("stack_free.network")},
+    {"PomodoroWatchdog", Gauge("stack_free.watchdog")},
+    {"ResourceMon", Gauge("stack_free.resource_mon")},
+    {"StatusServer", Gauge("stack_free.status")},
+    {"LanSync", Gauge("stack_free.sync")},
+};
+
+Gauge heap_free("heap.free");
+Gauge heap_largest_block("heap.largest_block");
+Gauge heap_fragmentation("heap.fragmentation_pct");
+// Since boot, as kept by the allocator.
+Gauge heap_min_free("heap.min_free");
+Gauge psram_free("psram.free");
+Counter resource_alerts("heap.alerts");
+
+// HTTPClient and lwIP need a few contiguous KB at run time; warn well before they would fail.
+constexpr ResourceLimits kLimits = {16384, 70, 512};
+}
+
+ResourceMonitor::ResourceMonitor() : task_(nullptr), alerts_(0)
+{
+    xTaskCreatePinnedToCore(taskTrampoline, "ResourceMon", 3072, this, 1, &task_, 0);
+}
+
+void ResourceMonitor::taskTrampoline(void* context)
+{
+    ResourceMonitor* self = static_cast<ResourceMonitor*>(context);
+    if (self)
+    {
+        self->task();
+    }
+    vTaskDelete(nullptr);
+}
+
+void ResourceMonitor::task()
+{
+    TickType_t last_wake = xTaskGetTickCount();
+    while (true)
+    {
+        sample();
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(kSampleMs));
+    }
+}
+
+void ResourceMonitor::sample()
+{
+    TRACE_SCOPE("resources.sample");
+    ResourceSample sample = {};
+    sample.min_stack_free = UINT32_MAX;
+    const char* tightest = nullptr;
+    for (WatchedTask& watched : watched_tasks)
+    {
+        const TaskHandle_t handle = xTaskGetHandle(watched.name);
+        if (!handle)
+        {
+            continue;
+        }
+        // On the ESP32 the high-water mark is in bytes.
+        const uint32_t stack_free = uxTaskGetStackHighWaterMark(handle);
+        watched.stack_free.set(static_cast<int32_t>(stack_free));
+        if (stack_free < sample.min_stack_free)
+        {
+            sample.min_stack_free = stack_free;
+            tightest = watched.name;
+        }
+    }
+    // Internal RAM only: PSRAM's multi-megabyte block would hide the fragmentation that starves
+    // HTTPClient and lwIP.
+    constexpr uint32_t kInternalHeap = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+    sample.free_heap = heap_caps_get_free_size(kInternalHeap);
+    sample.largest_block = heap_caps_get_largest_free_block(kInternalHeap);
+    sample.free_psram = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    heap_free.set(static_cast<int32_t>(sample.free_heap));
+    heap_largest_block.set(static_cast<int32_t>(sample.largest_block));
+    heap_fragmentation.set(fragmentationPercent(sample.free_heap, sample.largest_block));
+    heap_min_free.set(static_cast<int32_t>(heap_caps_get_minimum_free_size(kInternalHeap)));
+    psram_free.set(static_cast<int32_t>(sample.free_psram));
+    trend_.add(static_cast<uint32_t>(millis() / 1000), sample);
+
+    // Only newly raised alerts are reported; they re-arm once the condition clears.
+    const uint8_t alerts = resourceAlerts(sample, kLimits);
+    const uint8_t raised = alerts & ~alerts_;
+    alerts_ = alerts;
+    if (raised == 0)
+    {
+        return;
+    }
+    resource_alerts.add();
+    tracer().instant("resources.alert", raised);
+    if (raised & (HEAP_ALERT_SMALL_BLOCK | HEAP_ALERT_FRAGMENTED))
+    {
+        Serial.printf("ResourceMonitor: heap fragmented: %lu bytes free, largest block %lu (%u%%)\n",
+                      static_cast<unsigned long>(sample.free_heap), static_cast<unsigned long>(sample.largest_block),
+                      static_cast<unsigned>(fragmentationPercent(sample.free_heap, sample.largest_block)));
+    }
+    if (raised & HEAP_ALERT_STACK)
+    {
+        Serial.printf("ResourceMonitor: task %s has only %lu bytes of stack left\n", tightest ? tightest : "?",
+                      static_cast<unsigned long>(sample.min_stack_free));
+    }
+}
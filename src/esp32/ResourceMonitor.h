@@ -0,0 +1,38 @@
+//
+// Samples task stack headroom, heap and PSRAM on a task of its own, for metrics and a long-run trend.
+//
+
+#ifndef RESOURCEMONITOR_H
+#define RESOURCEMONITOR_H
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "ResourceTrend.h"
+
+// Every kSampleMs publishes each watched task's stack high-water mark and the internal heap's free
+// size, largest free block, fragmentation and low-water mark as gauges (their min is the worst seen),
+// adds them to a ResourceTrend, and warns once per episode when a ResourceLimits bound is crossed.
+class ResourceMonitor
+{
+public:
+    ResourceMonitor();
+
+    const ResourceTrend& trend() const
+    {
+        return trend_;
+    }
+
+private:
+    static constexpr uint32_t kSampleMs = 10000;
+
+    ResourceTrend trend_;
+    TaskHandle_t task_;
+    uint8_t alerts_;
+
+    static void taskTrampoline(void* context);
+    void task();
+    void sample();
+};
+
+#endif //RESOURCEMONITOR_H
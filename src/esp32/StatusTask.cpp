@@ -0,0 +1,46 @@
+//
+// Runs the StatusServer's socket loop on a task of its own once WiFi is up.
+//
+
+#include "StatusTask.h"
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+StatusTask::StatusTask(StatusServer& server, const uint16_t port, const NetworkStartup& network)
+    : server_(server), port_(port), network_(network), task_(nullptr)
+{
+    if (port_ != 0)
+    {
+        xTaskCreatePinnedToCore(taskTrampoline, "StatusServer", 4096, this, 1, &task_, 0);
+    }
+}
+
+void StatusTask::taskTrampoline(void* context)
+{
+    StatusTask* self = static_cast<StatusTask*>(context);
+    if (self)
+    {
+        self->task();
+    }
+    vTaskDelete(nullptr);
+}
+
+void StatusTask::task()
+{
+    while (!network_.connected())
+    {
+        vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+    if (!server_.begin(port_))
+    {
+        Serial.printf("StatusServer: cannot listen on port %u\n", static_cast<unsigned>(port_));
+        return;
+    }
+    Serial.printf("StatusServer: http://%s:%u/state and /events\n", WiFi.localIP().toString().c_str(),
+                  static_cast<unsigned>(port_));
+    while (true)
+    {
+        server_.poll(kPollMs);
+    }
+}
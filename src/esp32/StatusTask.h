@@ -0,0 +1,33 @@
+//
+// Runs the StatusServer's socket loop on a task of its own once WiFi is up.
+//
+
+#ifndef STATUSTASK_H
+#define STATUSTASK_H
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "NetworkStartup.h"
+#include "StatusServer.h"
+
+// Waits for the network, listens on `port` and polls the server every kPollMs at most. Port 0
+// leaves the server off and starts no task. The server and network must outlive this.
+class StatusTask
+{
+public:
+    StatusTask(StatusServer& server, uint16_t port, const NetworkStartup& network);
+
+private:
+    static constexpr int kPollMs = 100;
+
+    StatusServer& server_;
+    uint16_t port_;
+    const NetworkStartup& network_;
+    TaskHandle_t task_;
+
+    static void taskTrampoline(void* context);
+    void task();
+};
+
+#endif //STATUSTASK_H
@@ -0,0 +1,85 @@
+//
+// Receives the LAN sync group's datagrams on a task of its own and hands them to the main loop.
+//
+
+#include "SyncTask.h"
+
+#include <Arduino.h>
+
+#include "Metrics.h"
+
+namespace
+{
+// Datagrams lost because the main loop had not drained the queue.
+Counter sync_dropped("sync.dropped");
+}
+
+SyncTask::SyncTask(const char* group, const uint16_t port)
+    : link_(group, port), port_(port), queue_(nullptr), task_(nullptr)
+{
+    if (port_ != 0)
+    {
+        queue_ = xQueueCreate(kQueueLength, sizeof(Datagram));
+    }
+}
+
+bool SyncTask::networkUp()
+{
+    if (!queue_ || task_)
+    {
+        return false;
+    }
+    if (!link_.open())
+    {
+        Serial.printf("LanSync: cannot join the group on port %u\n", static_cast<unsigned>(port_));
+        return false;
+    }
+    xTaskCreatePinnedToCore(taskTrampoline, "LanSync", 3072, this, 1, &task_, 0);
+    return true;
+}
+
+void SyncTask::drain(LanSync& sync, const time_t now)
+{
+    if (!queue_)
+    {
+        return;
+    }
+    Datagram datagram;
+    while (xQueueReceive(queue_, &datagram, 0) == pdTRUE)
+    {
+        sync.receive(datagram.bytes, datagram.length, now);
+    }
+}
+
+void SyncTask::taskTrampoline(void* context)
+{
+    SyncTask* self = static_cast<SyncTask*>(context);
+    if (self)
+    {
+        self->task();
+    }
+    vTaskDelete(nullptr);
+}
+
+void SyncTask::task()
+{
+    Datagram datagram;
+    while (true)
+    {
+        // Anything longer than the longest message is not ours; it is cut short and fails to decode.
+        const int received = link_.receive(datagram.bytes, sizeof(datagram.bytes), kReceiveTimeoutMs);
+        if (received < 0)
+        {
+            return;
+        }
+        if (received == 0)
+        {
+            continue;
+        }
+        datagram.length = static_cast<uint8_t>(received);
+        if (xQueueSend(queue_, &datagram, 0) != pdTRUE)
+        {
+            sync_dropped.add();
+        }
+    }
+}
@@ -0,0 +1,57 @@
+//
+// Receives the LAN sync group's datagrams on a task of its own and hands them to the main loop.
+//
+
+#ifndef SYNCTASK_H
+#define SYNCTASK_H
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
+#include "LanSync.h"
+
+// Owns the multicast link LanSync sends on. The task only reads; datagrams are queued for the
+// main loop, which owns the clock and applies them at its next tick. Port 0 leaves sync off and
+// starts no task. `group` must outlive this.
+class SyncTask
+{
+public:
+    SyncTask(const char* group, uint16_t port);
+
+    bool enabled() const
+    {
+        return port_ != 0;
+    }
+
+    SyncLink& link()
+    {
+        return link_;
+    }
+
+    // Joins the group and starts receiving. Main loop only, once WiFi is up.
+    bool networkUp();
+
+    // Applies what arrived since the last call. Main loop only.
+    void drain(LanSync& sync, time_t now);
+
+private:
+    struct Datagram
+    {
+        uint8_t length;
+        uint8_t bytes[kSyncMessageMaxBytes];
+    };
+
+    static constexpr UBaseType_t kQueueLength = 16;
+    static constexpr uint32_t kReceiveTimeoutMs = 1000;
+
+    MulticastLink link_;
+    uint16_t port_;
+    QueueHandle_t queue_;
+    TaskHandle_t task_;
+
+    static void taskTrampoline(void* context);
+    void task();
+};
+
+#endif //SYNCTASK_H
@@ -2,31 +2,106 @@
 
 #include <Arduino.h>
 #include <SD.h> // must be included before M5Unified.h
-#include <WiFi.h>
 #include <cstdlib>
-#include <array>
 
 #include <M5Unified.h>
 #include <esp_log.h>
 
 #include "WiFiSettings.h"
+#include "BootTimeline.h"
 #include "Configuration.h"
 #include "Pomodoro.h"
 #include "ClockFace.h"
 #include "Splash.h"
 #include "Global.h"
-#include "Gong.h"
+#include "AudioCues.h"
+#include "CuePlayer.h"
 #include "Logger.h"
 #include "Leds.h"
 #include "HttpNotifier.h"
+#include "HttpTransport.h"
+#include "DailyStats.h"
+#include "FlavorTable.h"
+#include "NvsStore.h"
+#include "NetworkStartup.h"
+#include "FrameTiming.h"
+#include "InputTask.h"
+#include "Journal.h"
+#include "Metrics.h"
+#include "MqttTransport.h"
+#include "ObserverProbe.h"
+#include "PostMortem.h"
+#include "ResourceMonitor.h"
+#include "StatusPublisher.h"
+#include "StatusTask.h"
+#include "SyncTask.h"
+#include "Trace.h"
 
-std::recursive_mutex spi_mutex;
+BusArbiter spi_bus;
+// Budgets in microseconds: a batch of SD work should not hold the bus for longer.
+Histogram sd_read_us("sd.read_us", 100000);
+Histogram sd_write_us("sd.write_us", 100000);
+
+void printTrace(const char* data, const size_t size, void*) {
+    Serial.write(reinterpret_cast<const uint8_t*>(data), size);
+}
+
+void writeToFile(const uint8_t* data, const size_t size, void* file) {
+    static_cast<File*>(file)->write(data, size);
+}
+
+// Saves the journal for `pomostat replay`; the ring keeps recording meanwhile.
+void saveJournal(const Journal& journal) {
+    if (!ensureSDMounted()) {
+        return;
+    }
+    static BusClient bus_client(spi_bus, "journal", BusPriority::BACKGROUND);
+    BusLock lock(bus_client);
+    ScopedMetric timing(sd_write_us);
+    File file = SD.open("/journal.bin", FILE_WRITE);
+    if (!file) {
+        Serial.println("journal: cannot open /journal.bin");
+        return;
+    }
+    const size_t size = journal.write(writeToFile, &file);
+    file.close();
+    Serial.printf("journal: %u bytes, %u blocks, %u inputs to /journal.bin\n", static_cast<unsigned>(size),
+                  static_cast<unsigned>(journal.blocks()), static_cast<unsigned>(journal.inputs()));
+}
+
+// Serial commands: 'm' prints every metric, 'r' the memory trend since boot, 't' dumps the trace
+// ring as Chrome trace JSON (save what is between the markers and open it in ui.perfetto.dev),
+// 'j' saves the input journal to /journal.bin on the SD card, 'c' exports the new history records to
+// pomodoro.csv.
+void pollSerialCommands(const ResourceMonitor& resources, const Journal& journal, Logger& logger) {
+    while (Serial.available() > 0) {
+        const int command = Serial.read();
+        if (command == 'm') {
+            static char report[4096];
+            metrics().format(report, sizeof(report));
+            Serial.print(report);
+        } else if (command == 'r') {
+            static char trend[3072];
+            resources.trend().format(trend, sizeof(trend));
+            Serial.print(trend);
+        } else if (command == 't') {
+            Serial.println("--- trace begin ---");
+            exportChromeTrace(tracer(), printTrace, nullptr);
+            Serial.println("--- trace end ---");
+        } else if (command == 'j') {
+            saveJournal(journal);
+        } else if (command == 'c') {
+            logger.exportCsv();
+        }
+    }
+}
 
 bool ensureSDMounted() {
     static bool attempt_made = false;
     static bool mounted = false;
     
-    std::lock_guard<std::recursive_mutex> lock(spi_mutex);
+    static BusClient bus_client(spi_bus, "sd mount", BusPriority::BACKGROUND);
+    BusLock lock(bus_client);
     if (!attempt_made) {
         attempt_made = true;
         if (!SD.begin(M5.getPin(m5::sd_spi_ss))) {
@@ -43,57 +118,50 @@ void setup()
     M5.begin();
     Serial.begin(115200);
 
-    std::string httpHost;
-    uint16_t httpPort = 0;
-    std::array<String, 3> flavor_labels = {String("work"), String("leisure"), String("chores")};
+    // If the watchdog restarted us, say what was stuck.
+    static PostMortem post_mortem;
+    static char post_mortem_json[2048];
+    post_mortem_json[0] = '\0';
+    if (takePostMortem(&post_mortem))
+    {
+        static char text[2048];
+        formatPostMortem(post_mortem, text, sizeof(text));
+        Serial.print(text);
+        formatPostMortemJson(post_mortem, post_mortem_json, sizeof(post_mortem_json));
+    }
+
+    BootTimeline timeline;
+    const Settings& settings = Configuration.settings();
+    const char* ssid = wifi::ssid;
+    const char* password = wifi::password;
 
     try
     {
         Splash splash;
-        std::string ssid = wifi::ssid;
-        std::string password = wifi::password;
-        std::string ntpServer = "pool.ntp.org";
-        std::string timezone = "CET-1CEST,M3.5.0,M10.5.0/3";
-
-        if (Configuration.load()) {
-            ssid = Configuration["wifi"]["ssid"];
-            if (ssid.empty())
-                throw std::runtime_error("WiFi SSID not found");
-            password = Configuration["wifi"]["pass"];
-            if (password.empty())
-                throw std::runtime_error("WiFi password not found");
-            ntpServer = Configuration["ntp"]["host"];
-            if (ntpServer.empty())
-                throw std::runtime_error("NTP server not found");
-            timezone = Configuration["ntp"]["tz"];
-            httpHost = Configuration["http"]["host"];
-            std::string httpPortString = Configuration["http"]["port"];
-            if (!httpPortString.empty())
+        const uint64_t config_started = monotonicMicros();
+        const bool configured = Configuration.load();
+        timeline.record("config", config_started, monotonicMicros(), configured);
+        Serial.printf("boot: configuration from %s\n",
+                      !configured ? "defaults" : (Configuration.fromCache() ? "NVS cache" : "config.ini"));
+        if (configured) {
+            // Unknown sections and keys were logged as warnings; only errors stop the boot.
+            const ConfigParser& parser = Configuration.parser();
+            if (parser.fatalErrorCount() > 0)
             {
-                httpPort = static_cast<uint16_t>(std::strtoul(httpPortString.c_str(), nullptr, 10));
-            }
-            const std::string flavor0 = Configuration["flavors"]["flavor0"];
-            const std::string flavor1 = Configuration["flavors"]["flavor1"];
-            const std::string flavor2 = Configuration["flavors"]["flavor2"];
-            if (!flavor0.empty())
-            {
-                flavor_labels[0] = flavor0.c_str();
-            }
-            if (!flavor1.empty())
-            {
-                flavor_labels[1] = flavor1.c_str();
-            }
-            if (!flavor2.empty())
-            {
-                flavor_labels[2] = flavor2.c_str();
+                char message[96] = "config.ini: too many errors and warnings";
+                for (size_t i = 0; i < parser.errorCount() && i < ConfigParser::kMaxErrors; i++)
+                {
+                    if (configErrorIsFatal(parser.error(i).code))
+                    {
+                        ConfigParser::formatError(parser.error(i), message, sizeof(message));
+                        break;
+                    }
+                }
+                throw std::runtime_error(message);
             }
+            ssid = settings.wifi_ssid;
+            password = settings.wifi_pass;
         }
-        WiFi.begin(ssid.c_str(), password.c_str());
-        while (WiFi.status() != WL_CONNECTED)
-        {
-            delay(500);
-        }
-        configTzTime(timezone.c_str(), ntpServer.c_str());
     }
     catch (const std::exception& e)
     {
@@ -103,82 +171,178 @@ void setup()
         return;
     }
 
-    PomodoroClock pomodoro;
-    Logger logger;
-    pomodoro.add_observer(logger);
+    // Local time from the RTC right away; NTP corrects it once the network is up.
+    uint64_t started = monotonicMicros();
+    setenv("TZ", settings.ntp_tz, 1);
+    tzset();
+    timeline.record("rtc", started, monotonicMicros(), setSystemTimeFromRtc());
+
+    // WiFi and NTP come up in the background and report their own phases as they finish.
+    NetworkStartup network(ssid, password, settings.ntp_host, &timeline);
+    network.start();
 
+    // The clock face first, so the device is usable before anything touches the network.
+    started = monotonicMicros();
+    PomodoroClock pomodoro;
+    // Static: a kilobyte of labels the loop task's stack can do without. Observers look flavors up
+    // by index from here on.
+    static FlavorTable flavors;
+    flavors.build(settings);
+    pomodoro.SetFlavorCount(flavors.size());
+    // Static: the ring is too big for the loop task's stack. Records from the first input on.
+    static Journal journal(pomodoro);
+    pomodoro.SetRecorder(&journal);
+    NvsCheckpointStore daily_stats_store("pomodoro", "daily");
+    DailyStats daily_stats(&daily_stats_store);
     ClockFace clock_face;
+    clock_face.setDailyStats(&daily_stats);
+    clock_face.setFlavors(&flavors);
+    // Each observer is registered through a probe that times its notifications against a budget in
+    // microseconds. Observers hand slow work to their own tasks; DailyStats writes NVS on transitions.
+    ObserverProbe daily_stats_probe("notify_us.daily_stats", daily_stats, 30000);
+    ObserverProbe clock_face_probe("notify_us.display", clock_face, 1000);
+    pomodoro.add_observer(daily_stats_probe);
+    pomodoro.add_observer(clock_face_probe);
+    ObserverProbe journal_probe("notify_us.journal", journal, 100);
+    pomodoro.add_observer(journal_probe);
+    if (systemTimeValid())
+    {
+        pomodoro.PassageOfTime();
+    }
+    timeline.record("clock", started, monotonicMicros());
+
+    started = monotonicMicros();
+    Logger logger;
+    ObserverProbe logger_probe("notify_us.logger", logger, 1000);
+    pomodoro.add_observer(logger_probe);
+    logger.exportCsv();
     PomodoroWatchdog watchdog;
-    Gong gong;
+    CuePlayer cue_player;
+    AudioCues audio_cues(cue_player, static_cast<time_t>(settings.warning_minutes) * 60);
     Leds leds;
-    HttpNotifier notifier(httpHost.c_str(), httpPort);
-    clock_face.setFlavorLabels(flavor_labels);
-    notifier.setFlavorLabels(flavor_labels);
-    pomodoro.add_observer(clock_face);
-    pomodoro.add_observer(watchdog);
-    pomodoro.add_observer(gong);
-    pomodoro.add_observer(leds);
-    pomodoro.add_observer(notifier);
+    // MQTT when a broker is configured, otherwise HTTP when a backend is, otherwise nothing.
+    char mqtt_client_id[24];
+    snprintf(mqtt_client_id, sizeof(mqtt_client_id), "pomodoro-%06llx",
+             static_cast<unsigned long long>(ESP.getEfuseMac() & 0xFFFFFF));
+    static MqttTransport mqtt_transport(settings.mqtt_host, settings.mqtt_port, mqtt_client_id);
+    static HttpTransport http_transport(settings.http_host, settings.http_port);
+    Transport* transport = nullptr;
+    if (settings.mqtt_host[0] != '\0')
+    {
+        transport = &mqtt_transport;
+    }
+    else if (settings.http_host[0] != '\0' && settings.http_port > 0)
+    {
+        transport = &http_transport;
+    }
+    HttpNotifier notifier(transport);
+    notifier.setFlavors(&flavors);
+    notifier.setDailyStats(&daily_stats);
+    if (post_mortem_json[0] != '\0')
+    {
+        notifier.reportPostMortem(post_mortem_json);
+    }
+    ObserverProbe watchdog_probe("notify_us.watchdog", watchdog, 200);
+    ObserverProbe audio_cues_probe("notify_us.audio", audio_cues, 1000);
+    ObserverProbe leds_probe("notify_us.leds", leds, 500);
+    ObserverProbe notifier_probe("notify_us.http", notifier, 2000);
+    // Static: the server's client buffers would not fit on the loop task's stack.
+    static StatusServer status_server;
+    StatusPublisher status_publisher(status_server);
+    status_publisher.setFlavors(&flavors);
+    ObserverProbe status_probe("notify_us.status", status_publisher, 1000);
+    pomodoro.add_observer(watchdog_probe);
+    pomodoro.add_observer(audio_cues_probe);
+    pomodoro.add_observer(leds_probe);
+    pomodoro.add_observer(notifier_probe);
+    pomodoro.add_observer(status_probe);
+    StatusTask status_task(status_server, settings.status_port, network);
+    // Peers tell writers apart by the last four bytes of the MAC address; 0 is not a writer id.
+    static SyncTask sync_task(settings.sync_group, settings.sync_port);
+    const uint32_t sync_writer = static_cast<uint32_t>(ESP.getEfuseMac() >> 16) | 1u;
+    LanSync lan_sync(pomodoro, sync_task.link(), sync_writer);
+    ObserverProbe sync_probe("notify_us.sync", lan_sync, 500);
+    if (sync_task.enabled())
+    {
+        pomodoro.add_observer(sync_probe);
+    }
+    timeline.record("observers", started, monotonicMicros());
 
+    char report[512];
+    timeline.format(report, sizeof(report));
+    Serial.print(report);
+
+    bool network_was_up = false;
+    InputTask input;
+    ResourceMonitor resources;
 
     while (true)
     {
-        bool buttons = M5.BtnA.wasPressed() || M5.BtnB.wasPressed() || M5.BtnC.wasPressed();
-        if (!buttons) { pomodoro.PassageOfTime(); }
-        else
+        if (!network_was_up && network.connected())
         {
-            switch (pomodoro.State())
+            network_was_up = true;
+            notifier.networkUp();
+            if (sync_task.networkUp())
             {
-            case IDLE:
-                if (M5.BtnA.wasPressed())
-                {
-                    pomodoro.StartWork(0);
-                } else if (M5.BtnB.wasPressed())
-                {
-                    pomodoro.StartWork(1);
-                } else if (M5.BtnC.wasPressed())
-                {
-                    pomodoro.StartWork(2);
-                }
-                break;
-            case WORK:
-                if (M5.BtnA.wasPressed())
-                {
-                    pomodoro.CycleFlavor();
-                }
-                if (M5.BtnB.wasPressed())
-                {
-                    pomodoro.ExtendWork();
-                }
-                if (M5.BtnC.wasPressed())
-                {
-                    pomodoro.Cancel();
-                }
-                break;
-            case BREAK:
-                if (M5.BtnC.wasPressed())
-                {
-                    pomodoro.Cancel();
-                }
-                break;
+                lan_sync.begin();
             }
         }
+        pollSerialCommands(resources, journal, logger);
+        // Without a set RTC the clock waits for NTP rather than logging pomodoros in 1970.
+        const bool clock_set = systemTimeValid();
+        if (clock_set)
+        {
+            sync_task.drain(lan_sync, time(nullptr));
+            pomodoro.PassageOfTime();
+        }
 
-        // wait for the next second
-        const time_t now = time(nullptr);
-        for (int i = 0; i < 10; i++) {
+        // Sleep until the next second unless a button is pressed first.
+        timeval now;
+        gettimeofday(&now, nullptr);
+        InputEvent event;
+        if (!input.next(&event, pdMS_TO_TICKS(1000 - now.tv_usec / 1000)) || !clock_set)
+        {
+            continue;
+        }
+        clock_face.inputReceived(event.pressed_us);
+        // Act as of the press, not as of now.
+        const time_t at = event.pressed_at;
+        // Presses that change nothing, like B during a break, have no press-to-state latency.
+        bool changed = false;
+        switch (pomodoro.State())
+        {
+        case IDLE:
+        {
+            // A, B and C start the first three flavors; CycleFlavor reaches the rest.
+            const uint8_t button = static_cast<uint8_t>(event.button);
+            const uint8_t flavor = button < flavors.size() ? button : 0;
+            changed = pomodoro.StartWork(flavor, flavors.workSeconds(flavor), flavors.breakSeconds(flavor), at);
+            break;
+        }
+        case WORK:
+            if (event.button == Button::A)
+            {
+                changed = pomodoro.CycleFlavor(at);
+            }
+            else if (event.button == Button::B)
             {
-                std::lock_guard<std::recursive_mutex> lock(spi_mutex);
-                M5.update();
+                changed = pomodoro.ExtendWork(0, at);
             }
-            if (M5.BtnA.wasPressed() || M5.BtnB.wasPressed() || M5.BtnC.wasPressed())
+            else
             {
-                break;
+                changed = pomodoro.Cancel(at);
             }
-            if (time(nullptr) > now) {
-                break;
+            break;
+        case BREAK:
+            if (event.button == Button::C)
+            {
+                changed = pomodoro.Cancel(at);
             }
-            delay(100);
+            break;
+        }
+        if (changed)
+        {
+            input.handled(event);
         }
     }
 }
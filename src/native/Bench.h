@@ -0,0 +1,51 @@
+//
+// Host benchmarks run through `pomostat bench <name>`.
+//
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <chrono>
+
+struct Benchmark
+{
+    const char* name;
+    const char* description;
+    int (*run)(int argc, char** argv);
+};
+
+class BenchTimer
+{
+public:
+    BenchTimer() : start_(std::chrono::steady_clock::now())
+    {
+    }
+
+    double seconds() const
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start_;
+};
+
+// Keeps the optimizer from discarding a computed value.
+template <typename T>
+inline void benchKeep(const T& value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+int benchCsv(int argc, char** argv);
+int benchFrame(int argc, char** argv);
+int benchTime(int argc, char** argv);
+int benchLeds(int argc, char** argv);
+int benchAudio(int argc, char** argv);
+int benchConfig(int argc, char** argv);
+int benchScheduler(int argc, char** argv);
+int benchMetrics(int argc, char** argv);
+int benchTransport(int argc, char** argv);
+int benchSync(int argc, char** argv);
+
+#endif //BENCH_H
@@ -0,0 +1,131 @@
+//
+// Decoding and mixing cost of the audio cues: WAV parse + resample at boot, block mixing at runtime.
+//
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "Bench.h"
+#include "MappedFile.h"
+#include "Pcm.h"
+
+namespace
+{
+void put16(std::vector<uint8_t>& out, const uint16_t value)
+{
+    out.push_back(static_cast<uint8_t>(value));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+void put32(std::vector<uint8_t>& out, const uint32_t value)
+{
+    put16(out, static_cast<uint16_t>(value));
+    put16(out, static_cast<uint16_t>(value >> 16));
+}
+
+// A 17 s, 11025 Hz mono 16-bit tone shaped like gong.wav, for when the file is not at hand.
+std::vector<uint8_t> synthesizeGong()
+{
+    constexpr uint32_t kRate = 11025;
+    constexpr size_t kFrames = 17 * kRate;
+    std::vector<int16_t> samples(kFrames);
+    synthesizeTone(samples.data(), kFrames, kRate, 220, 20000, 2000);
+    std::vector<uint8_t> out;
+    out.insert(out.end(), {'R', 'I', 'F', 'F'});
+    put32(out, static_cast<uint32_t>(36 + kFrames * 2));
+    out.insert(out.end(), {'W', 'A', 'V', 'E', 'f', 'm', 't', ' '});
+    put32(out, 16);
+    put16(out, 1);
+    put16(out, 1);
+    put32(out, kRate);
+    put32(out, kRate * 2);
+    put16(out, 2);
+    put16(out, 16);
+    out.insert(out.end(), {'d', 'a', 't', 'a'});
+    put32(out, static_cast<uint32_t>(kFrames * 2));
+    for (const int16_t sample : samples)
+    {
+        put16(out, static_cast<uint16_t>(sample));
+    }
+    return out;
+}
+}
+
+// bench audio [path]: decodes `path` (default gong.wav) to the 16 kHz cue pool and mixes cues.
+int benchAudio(int argc, char** argv)
+{
+    constexpr uint32_t kMixRate = 16000;
+    constexpr size_t kBlockFrames = 512;
+    constexpr int kDecodes = 50;
+    const char* path = argc > 0 ? argv[0] : "gong.wav";
+
+    MappedFile file;
+    std::vector<uint8_t> synthesized;
+    const uint8_t* bytes;
+    size_t size;
+    if (file.open(path))
+    {
+        bytes = reinterpret_cast<const uint8_t*>(file.data());
+        size = file.size();
+    }
+    else
+    {
+        printf("%s not found, using a synthesized gong\n", path);
+        synthesized = synthesizeGong();
+        bytes = synthesized.data();
+        size = synthesized.size();
+    }
+
+    WavInfo info;
+    if (!parseWav(bytes, size, &info))
+    {
+        fprintf(stderr, "bench audio: %s is not a PCM WAV file\n", path);
+        return 1;
+    }
+    printf("%s: %u Hz, %u bit, %u channel(s), %zu frames (%.1f s)\n", path, info.sample_rate,
+           info.bits_per_sample, info.channels, info.frames,
+           static_cast<double>(info.frames) / info.sample_rate);
+
+    std::vector<int16_t> pool(resampledFrames(info, kMixRate) + resampledFrames(info, kMixRate * 2 / 3));
+    size_t gong_frames = 0;
+    size_t pitched_frames = 0;
+    BenchTimer decode_timer;
+    for (int i = 0; i < kDecodes; i++)
+    {
+        WavInfo parsed;
+        parseWav(bytes, size, &parsed);
+        gong_frames = resampleToMono16(parsed, kMixRate, pool.data(), pool.size());
+        pitched_frames = resampleToMono16(parsed, kMixRate * 2 / 3, pool.data() + gong_frames,
+                                          pool.size() - gong_frames);
+        benchKeep(pool[gong_frames / 2]);
+    }
+    const double decode_seconds = decode_timer.seconds() / kDecodes;
+    const double source_bytes = static_cast<double>(info.frames) * info.channels * info.bits_per_sample / 8;
+    printf("decode + resample both gongs: %.2f ms (%.0f MB/s of source PCM, %zu pool frames)\n",
+           decode_seconds * 1e3, 2 * source_bytes / decode_seconds / 1e6, gong_frames + pitched_frames);
+
+    // Four overlapping voices, the worst case for the mixer.
+    CueMixer mixer;
+    mixer.setCue(0, {pool.data(), gong_frames, 256});
+    mixer.setCue(1, {pool.data() + gong_frames, pitched_frames, 224});
+    int16_t block[kBlockFrames];
+    uint64_t mixed = 0;
+    BenchTimer mix_timer;
+    for (int round = 0; round < 20; round++)
+    {
+        for (uint8_t voice = 0; voice < CueMixer::kVoices; voice++)
+        {
+            mixer.trigger(voice % 2);
+        }
+        while (mixer.mix(block, kBlockFrames))
+        {
+            mixed += kBlockFrames;
+        }
+        benchKeep(block[0]);
+    }
+    const double mix_seconds = mix_timer.seconds();
+    printf("mix, 4 voices: %.1f Mframes/s (%.0fx real time at %u Hz)\n", mixed / mix_seconds / 1e6,
+           mixed / mix_seconds / kMixRate, kMixRate);
+    return 0;
+}
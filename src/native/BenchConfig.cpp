@@ -0,0 +1,135 @@
+//
+// config.ini load time: the old std::string/unordered_map loader, ConfigParser, and the NVS cache blob.
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+
+#include "Bench.h"
+#include "ConfigCache.h"
+#include "ConfigSchema.h"
+
+namespace
+{
+const char kConfig[] =
+    "[wifi]\n"
+    "ssid=your wifi ssid\n"
+    "pass=your wifi password\n"
+    "\n"
+    "[ntp]\n"
+    "host=pool.ntp.org\n"
+    "tz=CET-1CEST,M3.5.0,M10.5.0/3\n"
+    "\n"
+    "[http]\n"
+    "host=192.168.1.10\n"
+    "port=8080\n"
+    "\n"
+    "[flavors]\n"
+    "flavor0=work\n"
+    "flavor1=leisure\n"
+    "flavor2=chores\n"
+    "\n"
+    "[durations]\n"
+    "work_minutes=25\n"
+    "break_minutes=5\n"
+    "\n"
+    "[audio]\n"
+    "warning_minutes=2\n";
+
+typedef std::unordered_map<std::string, std::unordered_map<std::string, std::string>> Sections;
+
+// The previous ConfigurationClass::load, with readStringUntil('\n') as a copy into a String.
+void legacyLoad(const char* text, const size_t size, Sections& sections)
+{
+    std::string line;
+    std::string section;
+    size_t offset = 0;
+    while (offset < size)
+    {
+        size_t end = offset;
+        while (end < size && text[end] != '\n')
+        {
+            end++;
+        }
+        const std::string raw_line(text + offset, end - offset);
+        offset = end + 1;
+        line = raw_line.c_str();
+        line.erase(line.find_last_not_of(" \n\r\t") + 1);
+        if (line.empty())
+        {
+            continue;
+        }
+        if (line[0] == '[' && line[line.size() - 1] == ']')
+        {
+            section = line.substr(1, line.size() - 2);
+            continue;
+        }
+        const auto pos = line.find('=');
+        if (pos == std::string::npos)
+        {
+            continue;
+        }
+        sections[section][line.substr(0, pos)] = line.substr(pos + 1);
+    }
+}
+}
+
+// bench config [iterations]: parses the README's config.ini, read in 256-byte chunks as on the SD card.
+int benchConfig(int argc, char** argv)
+{
+    const long iterations = argc > 0 ? strtol(argv[0], nullptr, 10) : 200000;
+    const size_t size = sizeof(kConfig) - 1;
+
+    BenchTimer legacy_timer;
+    for (long i = 0; i < iterations; i++)
+    {
+        Sections sections;
+        legacyLoad(kConfig, size, sections);
+        // main.cpp's lookups, including the port conversion.
+        benchKeep(sections["wifi"]["ssid"].size());
+        benchKeep(strtoul(sections["http"]["port"].c_str(), nullptr, 10));
+    }
+    const double legacy_ns = legacy_timer.seconds() * 1e9 / static_cast<double>(iterations);
+
+    BenchTimer parser_timer;
+    for (long i = 0; i < iterations; i++)
+    {
+        Settings settings;
+        ConfigParser parser(&settings);
+        for (size_t offset = 0; offset < size; offset += 256)
+        {
+            parser.feed(kConfig + offset, size - offset < 256 ? size - offset : 256);
+        }
+        parser.finish();
+        benchKeep(settings.http_port);
+        benchKeep(settings.wifi_ssid[0]);
+    }
+    const double parser_ns = parser_timer.seconds() * 1e9 / static_cast<double>(iterations);
+
+    // A warm boot: the NVS blob decoded instead of the file parsed.
+    Settings parsed;
+    ConfigParser parser(&parsed);
+    parser.feed(kConfig, size);
+    parser.finish();
+    const uint32_t fingerprint = configFingerprint(size, 1738569600);
+    uint8_t blob[ConfigCache::kMaxSize];
+    const size_t blob_size = ConfigCache::serialize(fingerprint, parsed, blob, sizeof(blob));
+    BenchTimer cache_timer;
+    for (long i = 0; i < iterations; i++)
+    {
+        Settings settings;
+        benchKeep(ConfigCache::restore(blob, blob_size, fingerprint, &settings));
+        benchKeep(settings.http_port);
+    }
+    const double cache_ns = cache_timer.seconds() * 1e9 / static_cast<double>(iterations);
+
+    printf("%zu bytes, %ld iterations\n", size, iterations);
+    printf("string/unordered_map loader: %8.0f ns per load\n", legacy_ns);
+    printf("ConfigParser:                %8.0f ns per load (%.1fx), %zu bytes of parser + settings\n",
+           parser_ns, legacy_ns / parser_ns, sizeof(ConfigParser) + sizeof(Settings));
+    printf("ConfigCache::restore:        %8.0f ns per load (%.1fx), %zu byte blob\n", cache_ns,
+           legacy_ns / cache_ns, blob_size);
+    return 0;
+}
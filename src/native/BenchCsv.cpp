@@ -0,0 +1,181 @@
+//
+// pomodoro.csv parse throughput on a synthetic file.
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Bench.h"
+#include "CsvStats.h"
+#include "MappedFile.h"
+#include "PomodoroCsv.h"
+
+namespace
+{
+bool writeSyntheticCsv(const char* path, const uint64_t rows)
+{
+    FILE* file = fopen(path, "wb");
+    if (!file)
+    {
+        return false;
+    }
+    std::vector<char> buffer(1 << 20);
+    size_t used = 0;
+    time_t start = 1420099200; // 2015-01-01 08:00:00
+    uint32_t seed = 12345;
+    for (uint64_t i = 0; i < rows; i++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        const time_t end = start + 25 * 60 - static_cast<time_t>((seed >> 16) % 600);
+        struct tm start_tm;
+        struct tm end_tm;
+        gmtime_r(&start, &start_tm);
+        gmtime_r(&end, &end_tm);
+        if (buffer.size() - used < 64)
+        {
+            fwrite(buffer.data(), 1, used, file);
+            used = 0;
+        }
+        used += static_cast<size_t>(snprintf(buffer.data() + used, buffer.size() - used,
+                                             "%04d-%02d-%02d %02d:%02d:%02d,%04d-%02d-%02d %02d:%02d:%02d,%u\n",
+                                             start_tm.tm_year + 1900, start_tm.tm_mon + 1, start_tm.tm_mday,
+                                             start_tm.tm_hour, start_tm.tm_min, start_tm.tm_sec,
+                                             end_tm.tm_year + 1900, end_tm.tm_mon + 1, end_tm.tm_mday,
+                                             end_tm.tm_hour, end_tm.tm_min, end_tm.tm_sec,
+                                             (seed >> 8) % 3));
+        // Roughly a pomodoro every half hour during the day, then skip to the next morning.
+        start += 30 * 60 + static_cast<time_t>((seed >> 20) % 300);
+        if (start % 86400 > 18 * 3600)
+        {
+            start += 14 * 3600;
+        }
+    }
+    fwrite(buffer.data(), 1, used, file);
+    return fclose(file) == 0;
+}
+
+void report(const char* label, const size_t bytes, const uint64_t rows, const double seconds)
+{
+    printf("%-28s %8.3f s  %8.2f GB/s  %8.1f Mrows/s\n", label, seconds,
+           static_cast<double>(bytes) / seconds / 1e9, static_cast<double>(rows) / seconds / 1e6);
+}
+}
+
+// bench csv [rows] [path] [--keep]
+int benchCsv(int argc, char** argv)
+{
+    uint64_t rows = 10000000;
+    std::string path = "pomostat-bench.csv";
+    bool keep = false;
+    int positional = 0;
+    for (int i = 0; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--keep") == 0)
+        {
+            keep = true;
+        }
+        else if (positional++ == 0)
+        {
+            rows = strtoull(argv[i], nullptr, 10);
+        }
+        else
+        {
+            path = argv[i];
+        }
+    }
+
+    printf("Generating %llu rows into %s...\n", static_cast<unsigned long long>(rows), path.c_str());
+    if (!writeSyntheticCsv(path.c_str(), rows))
+    {
+        fprintf(stderr, "cannot write %s\n", path.c_str());
+        return 1;
+    }
+
+    MappedFile file;
+    if (!file.open(path.c_str()))
+    {
+        fprintf(stderr, "cannot map %s\n", path.c_str());
+        return 1;
+    }
+    const char* begin = file.data();
+    const char* end = begin + file.size();
+    printf("%.1f MB\n", static_cast<double>(file.size()) / 1e6);
+
+    // Touch every page once so the runs below measure parsing, not page faults.
+    {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < file.size(); i += 4096)
+        {
+            sum += static_cast<unsigned char>(begin[i]);
+        }
+        benchKeep(sum);
+    }
+
+    {
+        BenchTimer timer;
+        PomodoroCsvParser parser(begin, end);
+        PomodoroCsvRow row;
+        uint64_t parsed = 0;
+        int64_t checksum = 0;
+        while (parser.next(&row))
+        {
+            parsed++;
+            checksum += row.start.seconds + row.flavor;
+        }
+        benchKeep(checksum);
+        report("parse, 1 thread", file.size(), parsed, timer.seconds());
+    }
+
+    {
+        BenchTimer timer;
+        const CsvStats stats = CsvStats::parseParallel(begin, end, 1);
+        report("aggregate, 1 thread", file.size(), stats.rows(), timer.seconds());
+    }
+
+    const unsigned threads = std::thread::hardware_concurrency();
+    {
+        BenchTimer timer;
+        const CsvStats stats = CsvStats::parseParallel(begin, end, threads);
+        char label[64];
+        snprintf(label, sizeof(label), "aggregate, %u thread(s)", threads);
+        report(label, file.size(), stats.rows(), timer.seconds());
+    }
+
+    {
+        // The strptime/mktime path this parser replaces, on the first million rows.
+        const char* p = begin;
+        uint64_t parsed = 0;
+        int64_t checksum = 0;
+        BenchTimer timer;
+        while (p < end && parsed < 1000000)
+        {
+            struct tm start_tm = {};
+            struct tm end_tm = {};
+            const char* q = strptime(p, "%Y-%m-%d %H:%M:%S", &start_tm);
+            q = q ? strptime(q + 1, "%Y-%m-%d %H:%M:%S", &end_tm) : nullptr;
+            if (q)
+            {
+                start_tm.tm_isdst = -1;
+                end_tm.tm_isdst = -1;
+                checksum += mktime(&end_tm) - mktime(&start_tm) + strtol(q + 1, nullptr, 10);
+            }
+            parsed++;
+            const char* newline = static_cast<const char*>(memchr(p, '\n', static_cast<size_t>(end - p)));
+            p = newline ? newline + 1 : end;
+        }
+        benchKeep(checksum);
+        report("strptime+mktime, 1 thread", static_cast<size_t>(p - begin), parsed, timer.seconds());
+    }
+
+    file.close();
+    if (!keep)
+    {
+        remove(path.c_str());
+    }
+    return 0;
+}
@@ -0,0 +1,74 @@
+//
+// Bytes pushed to the panel per ClockFace frame, full-screen versus dirty rectangles.
+//
+
+#include <cstdio>
+#include <ctime>
+#include <vector>
+
+#include "Bench.h"
+#include "ClockLayout.h"
+#include "DirtyRegion.h"
+#include "FrameStaging.h"
+#include "HostFramebuffer.h"
+
+// bench frame: one simulated hour (25 min work, 5 min break, 30 min idle) at one frame per second.
+int benchFrame(int, char**)
+{
+    constexpr int16_t kWidth = 320;
+    constexpr int16_t kHeight = 240;
+    FixedFontMetrics metrics;
+    HostFramebuffer framebuffer(kWidth, kHeight);
+    DirtyRenderer renderer(kWidth, kHeight);
+    FrameLayout layout;
+
+    const time_t start = 1738569600;
+    uint64_t frames = 0;
+    uint64_t full_frames = 0;
+    uint32_t worst = 0;
+    // Same front-buffer size as ClockFace: frames that fit go out by DMA, the rest synchronously.
+    std::vector<uint16_t> staging_storage(10240);
+    FrameStaging staging;
+    staging.attach(staging_storage.data(), staging_storage.size());
+    uint64_t staged_frames = 0;
+    BenchTimer timer;
+    for (time_t now = start; now < start + 3600; now++)
+    {
+        const PomodoroState state = now < start + 1500 ? WORK : (now < start + 1800 ? BREAK : IDLE);
+        const time_t remaining = state == WORK ? start + 1500 - now : (state == BREAK ? start + 1800 - now : 0);
+        char time_buffer[sizeof("HH:MM:SS")];
+        char date_buffer[sizeof("DD MM YYYY")];
+        char remaining_buffer[16];
+        struct tm timeinfo;
+        gmtime_r(&now, &timeinfo);
+        strftime(time_buffer, sizeof(time_buffer), "%H:%M:%S", &timeinfo);
+        strftime(date_buffer, sizeof(date_buffer), "%d %m %Y", &timeinfo);
+        snprintf(remaining_buffer, sizeof(remaining_buffer), "%02d:%02d", static_cast<int>(remaining / 60),
+                 static_cast<int>(remaining % 60));
+        const ClockFrameText text = {state, 0, clock_colors::kDarkGreen, time_buffer, date_buffer, "Monday",
+                                     remaining_buffer, "work", "Today: 3 pomodoros, 75 min",
+                                     "work 3/75m  leisure 0/0m  chores 0/0m"};
+        layoutClockFrame(text, metrics, kWidth, kHeight, &layout);
+
+        const uint64_t before = framebuffer.bytesPushed();
+        const DirtyRegion& dirty = renderer.render(layout, framebuffer);
+        staged_frames += staging.stage(framebuffer.canvas().data(), kWidth, kHeight, dirty);
+        framebuffer.push(dirty);
+        const uint32_t bytes = static_cast<uint32_t>(framebuffer.bytesPushed() - before);
+        worst = renderer.lastFrameWasFull() || bytes < worst ? worst : bytes;
+        full_frames += renderer.lastFrameWasFull();
+        frames++;
+    }
+    const double seconds = timer.seconds();
+
+    const uint64_t full_bytes = static_cast<uint64_t>(kWidth) * kHeight * 2;
+    printf("%llu frames, %llu full repaints\n", static_cast<unsigned long long>(frames),
+           static_cast<unsigned long long>(full_frames));
+    printf("full-screen push:  %8llu bytes/frame\n", static_cast<unsigned long long>(full_bytes));
+    printf("dirty rectangles:  %8llu bytes/frame average, %u worst partial frame\n",
+           static_cast<unsigned long long>(framebuffer.bytesPushed() / frames), worst);
+    printf("frames fitting a %zu-pixel DMA front buffer: %llu\n", staging_storage.size(),
+           static_cast<unsigned long long>(staged_frames));
+    printf("host layout+diff+render: %.1f us/frame\n", seconds * 1e6 / static_cast<double>(frames));
+    return 0;
+}
@@ -0,0 +1,40 @@
+//
+// FastLED.show() calls per hour: one per ClockUpdate before, only changed frames with LedAnimator.
+//
+
+#include <cstdio>
+
+#include "Bench.h"
+#include "LedEffects.h"
+
+// bench leds: one simulated hour (25 min work, 5 min break, 30 min idle) at 50 LED frames per second.
+int benchLeds(int, char**)
+{
+    constexpr uint32_t kFrameMs = 20;
+    constexpr uint32_t kHourMs = 3600 * 1000;
+    LedAnimator animator;
+    LedFrame frame;
+    uint64_t frames = 0;
+    uint64_t shows = 0;
+    BenchTimer timer;
+    for (uint32_t ms = 0; ms < kHourMs; ms += kFrameMs)
+    {
+        if (ms % 1000 == 0)
+        {
+            const time_t second = ms / 1000;
+            const PomodoroState state = second < 1500 ? WORK : (second < 1800 ? BREAK : IDLE);
+            const time_t remaining = state == WORK ? 1500 - second : (state == BREAK ? 1800 - second : 0);
+            animator.update({1738569600 + second, state, 0, remaining}, ms);
+        }
+        shows += animator.render(ms, &frame);
+        frames++;
+    }
+    const double seconds = timer.seconds();
+
+    printf("%llu frames at %u ms\n", static_cast<unsigned long long>(frames), kFrameMs);
+    printf("show() per ClockUpdate (before): %6u per hour, no animation\n", 3600u);
+    printf("show() on changed frames:        %6llu per hour (%.1f%% of frames)\n",
+           static_cast<unsigned long long>(shows), 100.0 * static_cast<double>(shows) / static_cast<double>(frames));
+    printf("host render: %.1f ns/frame\n", seconds * 1e9 / static_cast<double>(frames));
+    return 0;
+}
@@ -0,0 +1,70 @@
+//
+// Cost per record of the metrics registry.
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "Bench.h"
+#include "Metrics.h"
+
+namespace
+{
+template <typename Record>
+double nsPerRecord(const unsigned threads, const uint32_t records, Record record)
+{
+    std::vector<std::thread> workers;
+    BenchTimer timer;
+    for (unsigned t = 0; t < threads; t++)
+    {
+        workers.emplace_back([records, &record]() {
+            for (uint32_t i = 0; i < records; i++)
+            {
+                record(i);
+            }
+        });
+    }
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+    // Wall time over all records, so with several threads on several cores it includes the cost
+    // of cache lines bouncing between them.
+    return timer.seconds() * 1e9 / (static_cast<double>(threads) * records);
+}
+}
+
+// bench metrics [records]: ns per record for each metric kind, alone and with 4 threads recording.
+int benchMetrics(int argc, char** argv)
+{
+    const uint32_t records = argc > 0 ? static_cast<uint32_t>(strtoul(argv[0], nullptr, 10)) : 10000000;
+    Counter counter("bench.counter");
+    Gauge gauge("bench.gauge");
+    Histogram histogram("bench.histogram");
+
+    printf("%-34s %10s %10s\n", "ns per record", "1 thread", "4 threads");
+    const auto row = [records](const char* name, auto record) {
+        const double single = nsPerRecord(1, records, record);
+        const double contended = nsPerRecord(4, records / 4, record);
+        printf("%-34s %10.1f %10.1f\n", name, single, contended);
+    };
+    row("Counter::add", [&counter](uint32_t) { counter.add(); });
+    row("Gauge::set", [&gauge](const uint32_t i) { gauge.set(static_cast<int32_t>(i & 63)); });
+    row("Histogram::record", [&histogram](const uint32_t i) { histogram.record(i & 4095); });
+    row("ScopedMetric (2 clock reads)", [&histogram](uint32_t) { ScopedMetric timing(histogram); });
+
+    char json[4096];
+    constexpr int kFormats = 10000;
+    size_t length = 0;
+    BenchTimer timer;
+    for (int i = 0; i < kFormats; i++)
+    {
+        length = metrics().formatJson(json, sizeof(json));
+        benchKeep(json[0]);
+    }
+    printf("\nformatJson, %zu metrics, %zu bytes: %.2f us\n", metrics().size(), length,
+           timer.seconds() * 1e6 / kFormats);
+    return 0;
+}
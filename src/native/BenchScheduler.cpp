@@ -0,0 +1,172 @@
+//
+// Coroutine scheduler against one thread per job: switch cost, timer wakeup lateness and memory.
+//
+
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Bench.h"
+#include "FrameTiming.h"
+#include "Metrics.h"
+#include "Scheduler.h"
+
+namespace
+{
+// The periodic jobs of the firmware that would move onto the scheduler: UI tick, LED frame,
+// watchdog check, log flush and HTTP queue drain.
+struct Job
+{
+    const char* name;
+    uint32_t period_us;
+    // Stack of the FreeRTOS task it runs on today, 0 if it shares the main loop.
+    uint32_t task_stack;
+};
+
+const Job kJobs[] = {
+    {"ui tick", 1000000, 0},
+    {"leds", 20000, 3072},
+    {"watchdog", 1000000, 2048},
+    {"log flush", 250000, 4096},
+    {"http drain", 500000, 8192},
+};
+
+constexpr size_t kJobCount = sizeof(kJobs) / sizeof(kJobs[0]);
+
+Task pinger(Channel<int, 1>& out, Channel<int, 1>& in, const int rounds)
+{
+    for (int i = 0; i < rounds; i++)
+    {
+        out.send(i);
+        benchKeep(co_await in.receive());
+    }
+}
+
+Task ponger(Channel<int, 1>& out, Channel<int, 1>& in, const int rounds)
+{
+    for (int i = 0; i < rounds; i++)
+    {
+        out.send(co_await in.receive());
+    }
+}
+
+Task periodic(Scheduler& scheduler, const Job& job, const uint64_t start_us, const uint64_t duration_us,
+              Histogram& lateness)
+{
+    for (uint64_t deadline = start_us + job.period_us; deadline <= start_us + duration_us; deadline += job.period_us)
+    {
+        co_await scheduler.sleepUntil(deadline);
+        lateness.record(static_cast<uint32_t>(scheduler.now() - deadline));
+    }
+}
+
+double coroutineSwitchNs(const int rounds)
+{
+    Scheduler scheduler;
+    Channel<int, 1> a(scheduler);
+    Channel<int, 1> b(scheduler);
+    scheduler.spawn(pinger(a, b, rounds));
+    scheduler.spawn(ponger(b, a, rounds));
+    BenchTimer timer;
+    scheduler.run();
+    // Two resumes per round trip.
+    return timer.seconds() * 1e9 / (2.0 * rounds);
+}
+
+double threadSwitchNs(const int rounds)
+{
+    std::mutex mutex;
+    std::condition_variable changed;
+    int turn = 0;
+    BenchTimer timer;
+    std::thread other([&]() {
+        for (int i = 0; i < rounds; i++)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&] { return turn == 1; });
+            turn = 0;
+            changed.notify_one();
+        }
+    });
+    for (int i = 0; i < rounds; i++)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        turn = 1;
+        changed.notify_one();
+        changed.wait(lock, [&] { return turn == 0; });
+    }
+    other.join();
+    return timer.seconds() * 1e9 / (2.0 * rounds);
+}
+
+void printLateness(const Histogram& histogram)
+{
+    char line[160];
+    formatLatencySummary(histogram.sample(), line, sizeof(line));
+    printf("%s\n", line);
+}
+}
+
+// bench sched [seconds]: runs the firmware's periodic jobs for `seconds` (default 2) as coroutines
+// on one thread and as one thread each, and compares switch cost, lateness and memory.
+int benchScheduler(int argc, char** argv)
+{
+    const double seconds = argc > 0 ? atof(argv[0]) : 2.0;
+    const uint64_t duration_us = static_cast<uint64_t>((seconds > 0 ? seconds : 2.0) * 1e6);
+
+    printf("switch, coroutine channel ping-pong: %.1f ns\n", coroutineSwitchNs(1000000));
+    printf("switch, thread condvar ping-pong:    %.1f ns\n", threadSwitchNs(100000));
+
+    Histogram coroutine_lateness("coroutines");
+    size_t frame_bytes = 0;
+    {
+        Scheduler scheduler;
+        const uint64_t start_us = scheduler.now();
+        for (const Job& job : kJobs)
+        {
+            scheduler.spawn(periodic(scheduler, job, start_us, duration_us, coroutine_lateness));
+        }
+        frame_bytes = coroutineFrameBytes();
+        scheduler.run();
+    }
+
+    Histogram thread_lateness("threads");
+    {
+        std::vector<std::thread> threads;
+        const uint64_t start_us = monotonicMicros();
+        for (const Job& job : kJobs)
+        {
+            threads.emplace_back([&job, start_us, duration_us, &thread_lateness]() {
+                for (uint64_t deadline = start_us + job.period_us; deadline <= start_us + duration_us;
+                     deadline += job.period_us)
+                {
+                    const uint64_t now = monotonicMicros();
+                    if (deadline > now)
+                    {
+                        std::this_thread::sleep_for(std::chrono::microseconds(deadline - now));
+                    }
+                    thread_lateness.record(static_cast<uint32_t>(monotonicMicros() - deadline));
+                }
+            });
+        }
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+    }
+    printf("\nwakeup lateness over %.1f s, %zu periodic jobs:\n", duration_us / 1e6, kJobCount);
+    printLateness(coroutine_lateness);
+    printLateness(thread_lateness);
+
+    uint32_t stacks = 0;
+    for (const Job& job : kJobs)
+    {
+        stacks += job.task_stack;
+    }
+    printf("\nmemory: %zu coroutine frames, %zu bytes (%zu per job) vs %u bytes of task stacks\n", kJobCount,
+           frame_bytes, frame_bytes / kJobCount, stacks);
+    return 0;
+}
@@ -0,0 +1,167 @@
+//
+// LAN sync traffic: a room of clocks mirroring one pomodoro over real multicast on loopback.
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "Bench.h"
+#include "LanSync.h"
+
+namespace
+{
+constexpr const char* kGroup = "239.255.42.99";
+constexpr uint16_t kPort = 42999;
+constexpr const char* kInterface = "127.0.0.1";
+constexpr time_t kWorkSeconds = 25 * 60;
+constexpr time_t kBreakSeconds = 5 * 60;
+constexpr int kSimulatedSeconds = 8 * 3600;
+
+struct Peer
+{
+    PomodoroClock clock;
+    MulticastLink link;
+    LanSync sync;
+
+    explicit Peer(const uint32_t writer) : link(kGroup, kPort, kInterface), sync(clock, link, writer)
+    {
+        clock.add_observer(sync);
+    }
+};
+
+// Hands every waiting datagram to its peer, dropping `loss_percent` of them, until a pass finds
+// none: loopback delivers at sendto(), so replies are waiting by the next pass.
+size_t drain(std::vector<std::unique_ptr<Peer>>& peers, const time_t now, std::mt19937& random,
+             const unsigned loss_percent)
+{
+    size_t delivered = 0;
+    bool any = true;
+    while (any)
+    {
+        any = false;
+        for (auto& peer : peers)
+        {
+            uint8_t datagram[64];
+            int length;
+            while ((length = peer->link.receive(datagram, sizeof(datagram), 0)) > 0)
+            {
+                any = true;
+                if (random() % 100 >= loss_percent)
+                {
+                    peer->sync.receive(datagram, static_cast<size_t>(length), now);
+                    delivered++;
+                }
+            }
+        }
+    }
+    return delivered;
+}
+
+bool converged(const std::vector<std::unique_ptr<Peer>>& peers)
+{
+    const PomodoroSnapshot first = peers[0]->clock.Snapshot();
+    for (const auto& peer : peers)
+    {
+        const PomodoroSnapshot snapshot = peer->clock.Snapshot();
+        if (snapshot.state != first.state || snapshot.work_flavor != first.work_flavor
+            || snapshot.state_ends_at != first.state_ends_at)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+}
+
+// bench sync [peers] [loss%]: a simulated working day in a room of clocks joined over loopback
+// multicast, someone pressing a button on a random clock now and then. Counts what goes on the
+// wire against sending the state every second, and seconds some clock spent out of step.
+int benchSync(int argc, char** argv)
+{
+    const size_t count = argc > 0 ? strtoul(argv[0], nullptr, 10) : 24;
+    const unsigned loss_percent = argc > 1 ? static_cast<unsigned>(strtoul(argv[1], nullptr, 10)) : 0;
+    if (count < 2 || loss_percent >= 100)
+    {
+        fprintf(stderr, "pomostat: sync needs at least 2 peers and a loss under 100%%\n");
+        return 2;
+    }
+    std::vector<std::unique_ptr<Peer>> peers;
+    for (size_t i = 0; i < count; i++)
+    {
+        peers.push_back(std::make_unique<Peer>(static_cast<uint32_t>(0x1000 + i)));
+        if (!peers.back()->link.open())
+        {
+            fprintf(stderr, "pomostat: cannot join %s:%u on %s\n", kGroup, kPort, kInterface);
+            return 1;
+        }
+    }
+
+    std::mt19937 random(42);
+    time_t now = 1738569600;
+    for (auto& peer : peers)
+    {
+        peer->sync.begin();
+    }
+    size_t delivered = drain(peers, now, random, loss_percent);
+    size_t actions = 0;
+    size_t diverged_seconds = 0;
+    BenchTimer timer;
+    for (int second = 0; second < kSimulatedSeconds; second++, now++)
+    {
+        // A press somewhere about every two minutes.
+        if (random() % 120 == 0)
+        {
+            PomodoroClock& clock = peers[random() % peers.size()]->clock;
+            switch (clock.State())
+            {
+            case IDLE:
+                clock.StartWork(static_cast<uint8_t>(random() % DEFAULT_WORK_FLAVORS), kWorkSeconds, kBreakSeconds,
+                                now);
+                break;
+            case WORK:
+                random() % 2 ? clock.ExtendWork(0, now) : clock.Cancel(now);
+                break;
+            default:
+                clock.Cancel(now);
+            }
+            actions++;
+        }
+        for (auto& peer : peers)
+        {
+            peer->clock.PassageOfTime(now);
+        }
+        delivered += drain(peers, now, random, loss_percent);
+        diverged_seconds += !converged(peers);
+    }
+    const double seconds = timer.seconds();
+
+    SyncStats total = {};
+    for (const auto& peer : peers)
+    {
+        const SyncStats& stats = peer->sync.stats();
+        total.sent += stats.sent;
+        total.sent_bytes += stats.sent_bytes;
+        total.applied += stats.applied;
+        total.stale += stats.stale;
+        total.requests += stats.requests;
+        total.malformed += stats.malformed;
+    }
+    uint8_t full[kSyncMessageMaxBytes];
+    const size_t full_size = encodeSyncMessage(peers[0]->sync.replica().full(), full, sizeof(full));
+    const double per_tick = static_cast<double>(full_size) * kSimulatedSeconds;
+    printf("%zu peers, %d simulated hours, %zu presses, %u%% loss\n", count, kSimulatedSeconds / 3600, actions,
+           loss_percent);
+    printf("sent: %u datagrams, %u bytes (%.1f per press, %.1f bytes each); %u requests\n", total.sent,
+           total.sent_bytes, static_cast<double>(total.sent) / actions, static_cast<double>(total.sent_bytes) / total.sent,
+           total.requests);
+    printf("received: %zu delivered, %u applied, %u stale, %u malformed\n", delivered, total.applied, total.stale,
+           total.malformed);
+    printf("vs one %zu-byte state per second: %.2f%% of the bytes\n", full_size,
+           100.0 * total.sent_bytes / per_tick);
+    printf("seconds with a clock out of step: %zu; converged at the end: %s; %.0f us per simulated second\n",
+           diverged_seconds, converged(peers) ? "yes" : "NO", seconds * 1e6 / kSimulatedSeconds);
+    return converged(peers) && total.malformed == 0 ? 0 : 1;
+}
@@ -0,0 +1,112 @@
+//
+// Per-frame clock formatting: localtime/strftime as ClockFace used to do it versus LocalTimeCache.
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#include "Bench.h"
+#include "History.h"
+#include "TimeFormat.h"
+
+namespace
+{
+struct FrameStrings
+{
+    char time[sizeof("HH:MM:SS")];
+    char date[sizeof("DD MM YYYY")];
+    char remaining[sizeof("MM:SS")];
+    int weekday;
+};
+
+// What ClockFace::notification did before: three localtime, one gmtime, three strftime.
+void formatLegacy(const time_t now, const time_t remaining, FrameStrings* out)
+{
+    strftime(out->time, sizeof(out->time), "%H:%M:%S", localtime(&now));
+    strftime(out->date, sizeof(out->date), "%d %m %Y", localtime(&now));
+    out->weekday = localtime(&now)->tm_wday % 7;
+    strftime(out->remaining, sizeof(out->remaining), "%M:%S", gmtime(&remaining));
+}
+
+void formatCached(LocalTimeCache& calendar, const time_t now, const time_t remaining, FrameStrings* out)
+{
+    calendar.update(now);
+    memcpy(out->time, calendar.hms(), sizeof(out->time));
+    memcpy(out->date, calendar.date(), sizeof(out->date));
+    out->weekday = calendar.weekday() % 7;
+    formatMinSec(remaining, out->remaining);
+}
+}
+
+// bench time [seconds]: one frame per simulated second, starting a day before the autumn DST change.
+int benchTime(int argc, char** argv)
+{
+    const long frames = argc > 0 ? atol(argv[0]) : 3 * 86400;
+    setenv("TZ", "CET-1CEST,M3.5.0,M10.5.0/3", 1);
+    tzset();
+    const time_t start = 1761354000;
+
+    FrameStrings legacy;
+    FrameStrings cached;
+    LocalTimeCache calendar;
+    for (long i = 0; i < frames; i++)
+    {
+        const time_t now = start + i;
+        formatLegacy(now, i % 1500, &legacy);
+        formatCached(calendar, now, i % 1500, &cached);
+        if (strcmp(legacy.time, cached.time) != 0 || strcmp(legacy.date, cached.date) != 0
+            || strcmp(legacy.remaining, cached.remaining) != 0 || legacy.weekday != cached.weekday)
+        {
+            fprintf(stderr, "mismatch at %ld: %s %s %s vs %s %s %s\n", static_cast<long>(now), legacy.time,
+                    legacy.date, legacy.remaining, cached.time, cached.date, cached.remaining);
+            return 1;
+        }
+    }
+
+    BenchTimer legacy_timer;
+    for (long i = 0; i < frames; i++)
+    {
+        formatLegacy(start + i, i % 1500, &legacy);
+        benchKeep(legacy);
+    }
+    const double legacy_seconds = legacy_timer.seconds();
+
+    LocalTimeCache timed;
+    BenchTimer cached_timer;
+    for (long i = 0; i < frames; i++)
+    {
+        formatCached(timed, start + i, i % 1500, &cached);
+        benchKeep(cached);
+    }
+    const double cached_seconds = cached_timer.seconds();
+
+    const HistoryRecord record = {static_cast<uint32_t>(start), static_cast<uint32_t>(start + 1500), 1,
+                                  HistoryOutcome::COMPLETED, 0};
+    char line[64];
+    BenchTimer csv_legacy_timer;
+    for (long i = 0; i < frames / 10; i++)
+    {
+        benchKeep(formatHistoryCsvLine(record, line, sizeof(line)));
+    }
+    const double csv_legacy_seconds = csv_legacy_timer.seconds();
+    LocalTimeCache csv_calendar;
+    BenchTimer csv_cached_timer;
+    for (long i = 0; i < frames / 10; i++)
+    {
+        benchKeep(formatHistoryCsvLine(record, csv_calendar, line, sizeof(line)));
+    }
+    const double csv_cached_seconds = csv_cached_timer.seconds();
+
+    const double per_frame = 1e9 / static_cast<double>(frames);
+    const double per_line = 1e9 / static_cast<double>(frames / 10);
+    printf("%ld frames, outputs identical, %u calendar recomputations\n", frames, timed.recomputations());
+    printf("clock frame, localtime+strftime: %8.1f ns\n", legacy_seconds * per_frame);
+    printf("clock frame, LocalTimeCache:     %8.1f ns (%.1fx)\n", cached_seconds * per_frame,
+           cached_seconds > 0 ? legacy_seconds / cached_seconds : 0.0);
+    printf("csv line, localtime_r+snprintf:  %8.1f ns\n", csv_legacy_seconds * per_line);
+    printf("csv line, shared LocalTimeCache: %8.1f ns (%.1fx)\n", csv_cached_seconds * per_line,
+           csv_cached_seconds > 0 ? csv_legacy_seconds / csv_cached_seconds : 0.0);
+    return 0;
+}
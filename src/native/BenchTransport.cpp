@@ -0,0 +1,333 @@
+//
+// Bytes on the air per transition: one HTTP POST each, against MQTT over a loopback broker stand-in.
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "Bench.h"
+#include "Mqtt.h"
+#include "Transport.h"
+
+namespace
+{
+constexpr const char* kHttpHost = "192.168.1.2";
+constexpr uint16_t kHttpPort = 8080;
+constexpr const char* kClientId = "pomodoro-bench";
+constexpr const char* kStateTopic = "pomodoro/pomodoro-bench/state";
+constexpr uint16_t kKeepAliveSeconds = 20 * 60;
+constexpr uint32_t kWorkSeconds = 25 * 60;
+constexpr uint32_t kBreakSeconds = 5 * 60;
+constexpr uint32_t kIdleSeconds = 10 * 60;
+constexpr const char* kFlavors[] = {"work", "leisure", "chores"};
+
+// Accepts one client at a time and answers it like a broker keeping sessions: CONNACK (with
+// session present for a client id it has seen), PUBACK, PINGRESP. Closes the connection after
+// `drop_after` publishes, once, to make the client reconnect.
+class BrokerStandIn
+{
+public:
+    explicit BrokerStandIn(const size_t drop_after) : drop_after_(drop_after), listener_(-1), port_(0)
+    {
+        listener_ = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(address);
+        if (bind(listener_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0 && listen(listener_, 1) == 0
+            && getsockname(listener_, reinterpret_cast<sockaddr*>(&address), &length) == 0)
+        {
+            port_ = ntohs(address.sin_port);
+            thread_ = std::thread([this]() { serve(); });
+        }
+    }
+
+    ~BrokerStandIn()
+    {
+        stop();
+    }
+
+    // Waits for the current client to hang up, then stops accepting. The results below are only
+    // read after this.
+    void stop()
+    {
+        if (listener_ >= 0)
+        {
+            shutdown(listener_, SHUT_RDWR);
+        }
+        if (thread_.joinable())
+        {
+            thread_.join();
+        }
+        if (listener_ >= 0)
+        {
+            close(listener_);
+            listener_ = -1;
+        }
+    }
+
+    uint16_t port() const
+    {
+        return port_;
+    }
+
+    std::vector<TransitionRecord> received;
+    std::vector<uint8_t> retained;
+    std::vector<std::string> sessions;
+    size_t connects = 0;
+    size_t resumed = 0;
+
+private:
+    size_t drop_after_;
+    int listener_;
+    uint16_t port_;
+    std::thread thread_;
+
+    void serve()
+    {
+        int fd;
+        while ((fd = accept(listener_, nullptr, nullptr)) >= 0)
+        {
+            connects++;
+            session(fd);
+            close(fd);
+        }
+    }
+
+    void session(const int fd)
+    {
+        MqttReader reader;
+        uint8_t chunk[256];
+        ssize_t received_bytes;
+        while ((received_bytes = recv(fd, chunk, sizeof(chunk), 0)) > 0)
+        {
+            size_t offset = 0;
+            while (offset < static_cast<size_t>(received_bytes))
+            {
+                offset += reader.feed(chunk + offset, static_cast<size_t>(received_bytes) - offset);
+                if (reader.failed())
+                {
+                    return;
+                }
+                if (!reader.ready())
+                {
+                    continue;
+                }
+                if (!answer(fd, reader))
+                {
+                    return;
+                }
+                reader.next();
+            }
+        }
+    }
+
+    bool answer(const int fd, const MqttReader& reader)
+    {
+        uint8_t packet[8];
+        size_t size = 0;
+        switch (reader.type())
+        {
+        case MqttPacketType::CONNECT:
+        {
+            MqttConnectOptions options;
+            char id[24];
+            if (!mqttParseConnect(reader.body(), reader.bodyLength(), &options, id, sizeof(id)))
+            {
+                return false;
+            }
+            bool known = false;
+            for (const std::string& session : sessions)
+            {
+                known = known || session == id;
+            }
+            if (!known && !options.clean_session)
+            {
+                sessions.emplace_back(id);
+            }
+            resumed += known && !options.clean_session;
+            size = mqttEncodeConnAck(known && !options.clean_session, 0, packet, sizeof(packet));
+            break;
+        }
+        case MqttPacketType::PUBLISH:
+        {
+            MqttMessage message;
+            TransitionRecord record;
+            if (!mqttParsePublish(reader.flags(), reader.body(), reader.bodyLength(), &message)
+                || !decodeTransition(message.payload, message.payload_length, &record))
+            {
+                return false;
+            }
+            // A DUP the broker already acknowledged would not be counted twice by a real backend.
+            received.push_back(record);
+            if (message.retain)
+            {
+                retained.assign(message.payload, message.payload + message.payload_length);
+            }
+            if (message.qos > 0)
+            {
+                size = mqttEncodePubAck(message.packet_id, packet, sizeof(packet));
+            }
+            if (received.size() == drop_after_)
+            {
+                send(fd, packet, size, MSG_NOSIGNAL);
+                return false;
+            }
+            break;
+        }
+        case MqttPacketType::PINGREQ:
+            size = mqttEncodeEmpty(MqttPacketType::PINGRESP, packet, sizeof(packet));
+            break;
+        case MqttPacketType::DISCONNECT:
+            return false;
+        default:
+            break;
+        }
+        return size == 0 || send(fd, packet, size, MSG_NOSIGNAL) == static_cast<ssize_t>(size);
+    }
+};
+
+// The JSON HttpNotifier queues for `record`, key for key.
+std::string queuedJson(const TransitionRecord& record)
+{
+    char json[192];
+    const char* duration_key = record.kind == TransitionKind::WORK_TO_BREAK ? "work_duration"
+        : record.kind == TransitionKind::BREAK_TO_IDLE                     ? "break_duration"
+                                                                           : "cancelled_work_duration";
+    if (record.kind == TransitionKind::IDLE_TO_WORK)
+    {
+        snprintf(json, sizeof(json), "{\"transition\":\"%s\",\"start_time\":%u,\"event_time\":%u,\"work_flavor\":\"%s\"}",
+                 transitionName(record.kind), record.start_time, record.event_time, record.flavor);
+    }
+    else if (record.kind == TransitionKind::BREAK_TO_IDLE)
+    {
+        snprintf(json, sizeof(json), "{\"transition\":\"%s\",\"start_time\":%u,\"event_time\":%u,\"%s\":%u}",
+                 transitionName(record.kind), record.start_time, record.event_time, duration_key, record.duration);
+    }
+    else
+    {
+        snprintf(json, sizeof(json),
+                 "{\"transition\":\"%s\",\"start_time\":%u,\"event_time\":%u,\"%s\":%u,\"work_flavor\":\"%s\"}",
+                 transitionName(record.kind), record.start_time, record.event_time, duration_key, record.duration,
+                 record.flavor);
+    }
+    return json;
+}
+
+void printRow(const char* name, const TransportStats& stats, const size_t transitions)
+{
+    printf("%-6s %9u %12u %11u %15u %10u %14.1f\n", name, stats.connects, stats.round_trips, stats.bytes_sent,
+           stats.bytes_received, airBytes(stats), static_cast<double>(airBytes(stats)) / transitions);
+}
+}
+
+// bench transport [pomodoros]: a day of pomodoros (three transitions each, ten idle minutes
+// between them) sent over HTTP (modelled, as the firmware counts it) and over MQTT to a loopback
+// broker stand-in that drops the connection once halfway.
+int benchTransport(int argc, char** argv)
+{
+    const size_t pomodoros = argc > 0 ? strtoul(argv[0], nullptr, 10) : 12;
+    if (pomodoros == 0)
+    {
+        fprintf(stderr, "pomostat: transport needs a positive number of pomodoros\n");
+        return 2;
+    }
+
+    std::vector<TransitionRecord> records;
+    // Gaps between consecutive transitions, for the keep-alive pings they would need.
+    std::vector<uint32_t> gaps;
+    uint32_t now = 1738569600;
+    for (size_t i = 0; i < pomodoros; i++)
+    {
+        TransitionRecord start = {TransitionKind::IDLE_TO_WORK, now, now, 0, ""};
+        snprintf(start.flavor, sizeof(start.flavor), "%s", kFlavors[i % 3]);
+        TransitionRecord work = start;
+        work.kind = TransitionKind::WORK_TO_BREAK;
+        work.event_time = now + kWorkSeconds;
+        work.duration = kWorkSeconds;
+        TransitionRecord rest = {TransitionKind::BREAK_TO_IDLE, now, work.event_time + kBreakSeconds, kBreakSeconds, ""};
+        records.insert(records.end(), {start, work, rest});
+        gaps.insert(gaps.end(), {i == 0 ? 0 : kIdleSeconds, kWorkSeconds, kBreakSeconds});
+        now = rest.event_time + kIdleSeconds;
+    }
+
+    TransportStats http = {};
+    size_t json_bytes = 0;
+    for (const TransitionRecord& record : records)
+    {
+        const std::string json = queuedJson(record);
+        char path[48];
+        snprintf(path, sizeof(path), "/pomodoros/%u/transitions", record.start_time);
+        json_bytes += json.size();
+        http.connects++;
+        http.round_trips++;
+        http.bytes_sent += httpPostBytes(kHttpHost, kHttpPort, path, json.size());
+        http.bytes_received += kHttpResponseHeaderBytes + strlen("{\"status\":\"ok\"}");
+    }
+
+    BrokerStandIn broker(records.size() / 2);
+    if (broker.port() == 0)
+    {
+        fprintf(stderr, "pomostat: cannot listen on loopback\n");
+        return 1;
+    }
+    SocketLink link("127.0.0.1", broker.port());
+    MqttClient client(link, kClientId, kKeepAliveSeconds);
+    size_t binary_bytes = 0;
+    size_t retries = 0;
+    uint32_t pings = 0;
+    const uint32_t ping_after = kKeepAliveSeconds - kKeepAliveSeconds / 4;
+    BenchTimer timer;
+    for (size_t i = 0; i < records.size(); i++)
+    {
+        uint8_t payload[kTransitionRecordMaxBytes];
+        const size_t length = encodeTransition(records[i], payload, sizeof(payload));
+        binary_bytes += length;
+        // The queue keeps an event until it is acknowledged; HttpNotifier retries like this.
+        while (!client.publish(kStateTopic, payload, length, 1, true))
+        {
+            if (++retries > 3)
+            {
+                fprintf(stderr, "pomostat: broker stand-in stopped answering\n");
+                return 1;
+            }
+        }
+        // Connection kept through the gap: a ping every 3/4 keep-alive, in simulated time.
+        pings += client.connected() ? gaps[i] / ping_after : 0;
+    }
+    const double seconds = timer.seconds();
+    client.disconnect();
+    broker.stop();
+    TransportStats mqtt = client.stats();
+    // PINGREQ and PINGRESP are two bytes each.
+    mqtt.round_trips += pings;
+    mqtt.bytes_sent += 2 * pings;
+    mqtt.bytes_received += 2 * pings;
+
+    TransitionRecord latest;
+    const bool retained = decodeTransition(broker.retained.data(), broker.retained.size(), &latest)
+        && latest.event_time == records.back().event_time;
+    printf("%zu transitions; payloads: %zu bytes of JSON, %zu bytes binary\n\n", records.size(), json_bytes,
+           binary_bytes);
+    printf("%-6s %9s %12s %11s %15s %10s %14s\n", "", "connects", "round trips", "bytes sent", "bytes received",
+           "air bytes", "per transition");
+    printRow("http", http, records.size());
+    printRow("mqtt", mqtt, records.size());
+    printf("\nmqtt: %.1f%% of http's air bytes, %u keep-alive pings (modelled), %zu retried after the broker "
+           "dropped the connection\n",
+           100.0 * airBytes(mqtt) / airBytes(http), pings, retries);
+    printf("broker stand-in: %zu publishes received, %zu connects, %zu resumed sessions, retained state %s; "
+           "%.0f us per publish on loopback\n",
+           broker.received.size(), broker.connects, broker.resumed, retained ? "current" : "WRONG",
+           seconds * 1e6 / records.size());
+    return broker.received.size() >= records.size() && retained ? 0 : 1;
+}
@@ -0,0 +1,122 @@
+//
+// Aggregates pomodoro.csv rows per flavor, per day and per hour of week.
+//
+
+#include "CsvStats.h"
+
+#include <cstring>
+#include <thread>
+
+PomodoroTotals& CsvStats::day(const int32_t day)
+{
+    if (days_.empty())
+    {
+        first_day_ = day;
+    }
+    else if (day < first_day_)
+    {
+        days_.insert(days_.begin(), static_cast<size_t>(first_day_ - day), PomodoroTotals());
+        first_day_ = day;
+    }
+    const size_t index = static_cast<size_t>(day - first_day_);
+    if (index >= days_.size())
+    {
+        days_.resize(index + 1);
+    }
+    return days_[index];
+}
+
+void CsvStats::add(const PomodoroCsvRow& row)
+{
+    const int64_t duration = csvDuration(row.start, row.end);
+    const uint64_t seconds = duration > 0 ? static_cast<uint64_t>(duration) : 0;
+    rows_++;
+    flavors_[row.flavor].add(seconds);
+    hour_of_week_[csvWeekday(row.start.day) * 24 + row.start.seconds / 3600].add(seconds);
+    day(row.start.day).add(seconds);
+}
+
+void CsvStats::merge(const CsvStats& other)
+{
+    rows_ += other.rows_;
+    malformed_ += other.malformed_;
+    for (size_t i = 0; i < flavors_.size(); i++)
+    {
+        flavors_[i].merge(other.flavors_[i]);
+    }
+    for (size_t i = 0; i < hour_of_week_.size(); i++)
+    {
+        hour_of_week_[i].merge(other.hour_of_week_[i]);
+    }
+    if (!other.days_.empty())
+    {
+        day(other.first_day_);
+        day(other.first_day_ + static_cast<int32_t>(other.days_.size()) - 1);
+        const size_t offset = static_cast<size_t>(other.first_day_ - first_day_);
+        for (size_t i = 0; i < other.days_.size(); i++)
+        {
+            days_[offset + i].merge(other.days_[i]);
+        }
+    }
+}
+
+void CsvStats::parse(const char* begin, const char* end)
+{
+    PomodoroCsvParser parser(begin, end);
+    PomodoroCsvRow row;
+    while (parser.next(&row))
+    {
+        add(row);
+    }
+    malformed_ += parser.malformed();
+}
+
+CsvStats CsvStats::parseParallel(const char* begin, const char* end, unsigned threads)
+{
+    const size_t size = static_cast<size_t>(end - begin);
+    if (threads < 1)
+    {
+        threads = 1;
+    }
+    if (size < threads * 4096u)
+    {
+        threads = 1;
+    }
+
+    // Piece i starts right after the first newline at or past i * size / threads.
+    std::vector<const char*> bounds(threads + 1, end);
+    bounds[0] = begin;
+    for (unsigned i = 1; i < threads; i++)
+    {
+        const char* guess = begin + size / threads * i - 1;
+        if (guess < bounds[i - 1])
+        {
+            guess = bounds[i - 1];
+        }
+        const void* newline = memchr(guess, '\n', static_cast<size_t>(end - guess));
+        bounds[i] = newline ? static_cast<const char*>(newline) + 1 : end;
+    }
+
+    std::vector<CsvStats> partials(threads);
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for (unsigned i = 1; i < threads; i++)
+    {
+        workers.emplace_back([&partials, &bounds, i]()
+        {
+            partials[i].parse(bounds[i], bounds[i + 1]);
+        });
+    }
+    partials[0].parse(bounds[0], bounds[1]);
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+
+    CsvStats result = std::move(partials[0]);
+    for (unsigned i = 1; i < threads; i++)
+    {
+        result.merge(partials[i]);
+    }
+    return result;
+}
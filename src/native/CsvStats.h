@@ -0,0 +1,90 @@
+//
+// Aggregates pomodoro.csv rows per flavor, per day and per hour of week.
+//
+
+#ifndef CSVSTATS_H
+#define CSVSTATS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "PomodoroCsv.h"
+
+struct PomodoroTotals
+{
+    uint64_t pomodoros = 0;
+    uint64_t seconds = 0;
+
+    void add(const uint64_t duration)
+    {
+        pomodoros++;
+        seconds += duration;
+    }
+
+    void merge(const PomodoroTotals& other)
+    {
+        pomodoros += other.pomodoros;
+        seconds += other.seconds;
+    }
+};
+
+class CsvStats
+{
+public:
+    static constexpr int kHoursPerWeek = 7 * 24;
+
+    void add(const PomodoroCsvRow& row);
+    void merge(const CsvStats& other);
+
+    // Parses [begin, end) on the calling thread.
+    void parse(const char* begin, const char* end);
+
+    // Splits [begin, end) at line boundaries and parses the pieces on `threads` threads.
+    static CsvStats parseParallel(const char* begin, const char* end, unsigned threads);
+
+    uint64_t rows() const
+    {
+        return rows_;
+    }
+
+    uint64_t malformed() const
+    {
+        return malformed_;
+    }
+
+    const std::array<PomodoroTotals, 256>& flavors() const
+    {
+        return flavors_;
+    }
+
+    // Starting hour of each pomodoro, indexed by weekday * 24 + hour (weekday 0 = Sunday).
+    const std::array<PomodoroTotals, kHoursPerWeek>& hourOfWeek() const
+    {
+        return hour_of_week_;
+    }
+
+    // Totals for days [firstDay(), firstDay() + days().size()), indexed from firstDay().
+    int32_t firstDay() const
+    {
+        return first_day_;
+    }
+
+    const std::vector<PomodoroTotals>& days() const
+    {
+        return days_;
+    }
+
+private:
+    uint64_t rows_ = 0;
+    uint64_t malformed_ = 0;
+    std::array<PomodoroTotals, 256> flavors_{};
+    std::array<PomodoroTotals, kHoursPerWeek> hour_of_week_{};
+    int32_t first_day_ = 0;
+    std::vector<PomodoroTotals> days_;
+
+    PomodoroTotals& day(int32_t day);
+};
+
+#endif //CSVSTATS_H
@@ -0,0 +1,311 @@
+//
+// `pomostat record` and `pomostat replay`: input journals captured on the device, fed back on the host.
+//
+
+#include "JournalRun.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#include "AudioCues.h"
+#include "Bench.h"
+#include "ClockLayout.h"
+#include "DailyStats.h"
+#include "DirtyRegion.h"
+#include "HostFramebuffer.h"
+#include "Journal.h"
+#include "LanSync.h"
+#include "LedEffects.h"
+#include "MappedFile.h"
+#include "StatusPublisher.h"
+#include "StatusServer.h"
+
+namespace
+{
+constexpr time_t kWorkSeconds = 25 * 60;
+constexpr time_t kBreakSeconds = 5 * 60;
+constexpr int16_t kWidth = 320;
+constexpr int16_t kHeight = 240;
+
+class CountingCues final : public CueSink
+{
+public:
+    size_t played = 0;
+
+    void play(AudioCue) override
+    {
+        played++;
+    }
+};
+
+class NullLink final : public SyncLink
+{
+public:
+    bool send(const uint8_t*, size_t) override
+    {
+        return true;
+    }
+};
+
+// ClockFace stand-in: lays out, diffs and pushes the frame inline, without the panel's wire time.
+class ReplayDisplay final : public PomodoroObserver
+{
+public:
+    ReplayDisplay() : framebuffer_(kWidth, kHeight), renderer_(kWidth, kHeight)
+    {
+    }
+
+    void notification(const ClockUpdate update) override
+    {
+        char time_buffer[sizeof("HH:MM:SS")];
+        char date_buffer[sizeof("DD MM YYYY")];
+        char remaining_buffer[16];
+        struct tm timeinfo;
+        gmtime_r(&update.now, &timeinfo);
+        strftime(time_buffer, sizeof(time_buffer), "%H:%M:%S", &timeinfo);
+        strftime(date_buffer, sizeof(date_buffer), "%d %m %Y", &timeinfo);
+        snprintf(remaining_buffer, sizeof(remaining_buffer), "%02d:%02d",
+                 static_cast<int>(update.remaining_time_in_state / 60),
+                 static_cast<int>(update.remaining_time_in_state % 60));
+        const ClockFrameText text = {update.state, update.work_flavor, clock_colors::kDarkGreen, time_buffer,
+                                     date_buffer, "Monday", remaining_buffer, "work", "Today: 3 pomodoros, 75 min",
+                                     "work 3/75m  leisure 0/0m  chores 0/0m"};
+        layoutClockFrame(text, metrics_, kWidth, kHeight, &layout_);
+        framebuffer_.push(renderer_.render(layout_, framebuffer_));
+    }
+
+    void notification(IdleToWork) override {}
+    void notification(WorkToBreak) override {}
+    void notification(BreakToIdle) override {}
+    void notification(WorkToIdle) override {}
+    void notification(AdditionalWork) override {}
+
+    uint64_t bytesPushed() const
+    {
+        return framebuffer_.bytesPushed();
+    }
+
+private:
+    FixedFontMetrics metrics_;
+    HostFramebuffer framebuffer_;
+    DirtyRenderer renderer_;
+    FrameLayout layout_;
+};
+
+// Leds stand-in: every update renders the frame for the update's second.
+class ReplayLeds final : public PomodoroObserver
+{
+public:
+    void notification(const ClockUpdate update) override
+    {
+        const uint32_t now_ms = static_cast<uint32_t>(update.now * 1000);
+        animator_.update(update, now_ms);
+        LedFrame frame;
+        animator_.render(now_ms, &frame);
+    }
+
+    void notification(IdleToWork) override {}
+    void notification(WorkToBreak) override {}
+    void notification(BreakToIdle) override {}
+    void notification(WorkToIdle) override {}
+    void notification(AdditionalWork) override {}
+
+private:
+    LedAnimator animator_;
+};
+
+// ObserverProbe in nanoseconds: on the host most notifications take well under a microsecond.
+class StageTimer final : public PomodoroObserver
+{
+public:
+    StageTimer(const char* name, PomodoroObserver& target) : name(name), target_(target)
+    {
+    }
+
+    const char* name;
+    uint64_t count = 0;
+    uint64_t total_ns = 0;
+    uint64_t max_ns = 0;
+
+    void notification(const ClockUpdate update) override
+    {
+        time(update);
+    }
+
+    void notification(const IdleToWork update) override
+    {
+        time(update);
+    }
+
+    void notification(const WorkToBreak update) override
+    {
+        time(update);
+    }
+
+    void notification(const BreakToIdle update) override
+    {
+        time(update);
+    }
+
+    void notification(const WorkToIdle update) override
+    {
+        time(update);
+    }
+
+    void notification(const AdditionalWork update) override
+    {
+        time(update);
+    }
+
+private:
+    PomodoroObserver& target_;
+
+    template <typename Update>
+    void time(const Update& update)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        target_.notification(update);
+        const uint64_t ns = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        count++;
+        total_ns += ns;
+        max_ns = ns > max_ns ? ns : max_ns;
+    }
+};
+
+void writeToFile(const uint8_t* data, const size_t size, void* context)
+{
+    fwrite(data, 1, size, static_cast<FILE*>(context));
+}
+}
+
+int runRecord(int argc, char** argv)
+{
+    const int hours = argc > 0 ? atoi(argv[0]) : 8;
+    const char* path = argc > 1 ? argv[1] : "journal.bin";
+    if (hours <= 0)
+    {
+        fprintf(stderr, "pomostat: record needs a positive number of hours\n");
+        return 2;
+    }
+
+    PomodoroClock clock;
+    static Journal journal(clock);
+    clock.add_observer(journal);
+    clock.SetRecorder(&journal);
+    std::mt19937 random(42);
+    time_t now = 1738569600;
+    for (int second = 0; second < hours * 3600; second++, now++)
+    {
+        // A press about every ten minutes, and now and then a peer's change over LAN sync.
+        if (random() % 600 == 0)
+        {
+            switch (clock.State())
+            {
+            case IDLE:
+                clock.StartWork(static_cast<uint8_t>(random() % DEFAULT_WORK_FLAVORS), kWorkSeconds, kBreakSeconds,
+                                now);
+                break;
+            case WORK:
+                random() % 3 == 0 ? clock.Cancel(now) : random() % 2 ? clock.ExtendWork(0, now)
+                                                                     : clock.CycleFlavor(now);
+                break;
+            default:
+                clock.Cancel(now);
+            }
+        }
+        else if (random() % 7200 == 0)
+        {
+            clock.Adopt(
+                {WORK, static_cast<uint8_t>(random() % DEFAULT_WORK_FLAVORS), now + kWorkSeconds, kBreakSeconds}, now);
+        }
+        clock.PassageOfTime(now);
+    }
+
+    FILE* out = fopen(path, "wb");
+    if (!out)
+    {
+        fprintf(stderr, "pomostat: cannot write %s\n", path);
+        return 1;
+    }
+    const size_t size = journal.write(writeToFile, out);
+    fclose(out);
+    printf("%u inputs over %d hours in %zu bytes (%zu blocks kept, %u dropped) written to %s\n", journal.inputs(),
+           hours, size, journal.blocks(), journal.droppedBlocks(), path);
+    return 0;
+}
+
+int runReplay(int argc, char** argv)
+{
+    const int repeats = argc > 1 ? atoi(argv[1]) : 10;
+    if (argc < 1 || repeats <= 0)
+    {
+        fprintf(stderr, "pomostat: replay needs a journal and a positive number of repeats\n");
+        return 2;
+    }
+    MappedFile file;
+    if (!file.open(argv[0]))
+    {
+        fprintf(stderr, "pomostat: cannot open %s\n", argv[0]);
+        return 1;
+    }
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(file.data());
+
+    CountingCues cues;
+    AudioCues audio(cues, 2 * 60);
+    DailyStats stats;
+    ReplayDisplay display;
+    ReplayLeds leds;
+    StatusServer server;
+    StatusPublisher publisher(server);
+    NullLink link;
+    // Every run starts over from the first block's state, so one clock serves them all.
+    PomodoroClock clock;
+    LanSync sync(clock, link, 1);
+    StageTimer stages[] = {
+        {"daily_stats", stats}, {"display", display}, {"audio", audio},
+        {"leds", leds},         {"status", publisher}, {"sync", sync},
+    };
+    for (StageTimer& stage : stages)
+    {
+        clock.add_observer(stage);
+    }
+
+    JournalReplay result = {};
+    BenchTimer timer;
+    for (int run = 0; run < repeats; run++)
+    {
+        result = replayJournal(data, file.size(), clock);
+    }
+    const double seconds = timer.seconds();
+
+    printf("%s: %zu blocks, %zu inputs, %zu notifications per run, %d runs in %.3f s (%.0f inputs/s)\n", argv[0],
+           result.blocks, result.inputs, result.notifications, repeats, seconds,
+           static_cast<double>(result.inputs) * repeats / seconds);
+    printf("\n%-12s %12s %12s %12s %10s\n", "Stage", "Calls", "ns/call", "max ns", "total ms");
+    uint64_t observers_ns = 0;
+    for (const StageTimer& stage : stages)
+    {
+        printf("%-12s %12llu %12.0f %12llu %10.1f\n", stage.name, static_cast<unsigned long long>(stage.count),
+               stage.count ? static_cast<double>(stage.total_ns) / stage.count : 0.0,
+               static_cast<unsigned long long>(stage.max_ns), stage.total_ns / 1e6);
+        observers_ns += stage.total_ns;
+    }
+    printf("%-12s %12s %12s %12s %10.1f\n", "clock+rest", "", "", "", seconds * 1e3 - observers_ns / 1e6);
+    printf("\n%zu cues, %llu display bytes pushed\n", cues.played, static_cast<unsigned long long>(display.bytesPushed()));
+    if (result.malformed)
+    {
+        printf("journal malformed after block %zu\n", result.blocks);
+        return 1;
+    }
+    if (result.mismatched > 0)
+    {
+        printf("MISMATCH: %zu of %zu blocks notified differently, the first at block %ld\n", result.mismatched,
+               result.blocks, result.first_mismatch);
+        return 1;
+    }
+    printf("every block notified as recorded\n");
+    return 0;
+}
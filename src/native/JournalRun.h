@@ -0,0 +1,16 @@
+//
+// `pomostat record` and `pomostat replay`: input journals captured on the device, fed back on the host.
+//
+
+#ifndef JOURNALRUN_H
+#define JOURNALRUN_H
+
+// record [hours] [out.bin]: a synthetic capture of `hours` of presses and ticks, written like the
+// device's 'j' command writes /journal.bin.
+int runRecord(int argc, char** argv);
+
+// replay journal.bin [repeats]: feeds the journal through the clock and the portable observers as
+// fast as they go, checks the notifications against the recorded digests and times each observer.
+int runReplay(int argc, char** argv);
+
+#endif //JOURNALRUN_H
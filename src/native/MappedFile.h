@@ -0,0 +1,40 @@
+//
+// Read-only memory mapping of a whole file.
+//
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+
+class MappedFile
+{
+public:
+    MappedFile() : data_(nullptr), size_(0)
+    {
+    }
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const char* path);
+    void close();
+
+    const char* data() const
+    {
+        return data_;
+    }
+
+    size_t size() const
+    {
+        return size_;
+    }
+
+private:
+    const char* data_;
+    size_t size_;
+};
+
+#endif //MAPPEDFILE_H
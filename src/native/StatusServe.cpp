@@ -0,0 +1,73 @@
+//
+// `pomostat serve`: runs the firmware's status server against a simulated clock on the host.
+//
+
+#include "StatusServe.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include "FlavorTable.h"
+#include "Pomodoro.h"
+#include "StatusPublisher.h"
+#include "StatusServer.h"
+
+namespace
+{
+constexpr time_t kWorkSeconds = 20;
+constexpr time_t kBreakSeconds = 10;
+}
+
+int runServe(int argc, char** argv)
+{
+    const int port = argc > 0 ? atoi(argv[0]) : 8080;
+    const int seconds = argc > 1 ? atoi(argv[1]) : 60;
+    if (port < 0 || port > 65535 || seconds <= 0)
+    {
+        fprintf(stderr, "pomostat: serve needs a port and a positive number of seconds\n");
+        return 2;
+    }
+
+    StatusServer server;
+    if (!server.begin(static_cast<uint16_t>(port)))
+    {
+        fprintf(stderr, "pomostat: cannot listen on port %d\n", port);
+        return 1;
+    }
+    StatusPublisher publisher(server);
+    const FlavorTable flavors;
+    publisher.setFlavors(&flavors);
+    PomodoroClock clock;
+    clock.add_observer(publisher);
+    printf("serving http://localhost:%u/state and /events for %d s\n", static_cast<unsigned>(server.port()), seconds);
+    fflush(stdout);
+
+    // The socket loop gets its own thread, as it gets its own task on the device.
+    std::atomic<bool> running(true);
+    std::thread poller([&server, &running]() {
+        while (running)
+        {
+            server.poll(100);
+        }
+    });
+
+    const time_t start = time(nullptr);
+    auto next = std::chrono::steady_clock::now();
+    for (int second = 0; second < seconds; second++)
+    {
+        if (clock.State() == IDLE)
+        {
+            clock.StartWork(static_cast<uint8_t>(second % flavors.size()), kWorkSeconds, kBreakSeconds, start + second);
+        }
+        clock.PassageOfTime(start + second);
+        next += std::chrono::seconds(1);
+        std::this_thread::sleep_until(next);
+    }
+    running = false;
+    poller.join();
+    printf("%u subscribers dropped for falling behind\n", static_cast<unsigned>(server.dropped()));
+    return 0;
+}
@@ -0,0 +1,12 @@
+//
+// `pomostat serve`: runs the firmware's status server against a simulated clock on the host.
+//
+
+#ifndef STATUSSERVE_H
+#define STATUSSERVE_H
+
+// serve [port] [seconds]: serves /state and /events on `port` (default 8080) while a clock with
+// short work and break periods runs in real time for `seconds` (default 60).
+int runServe(int argc, char** argv);
+
+#endif //STATUSSERVE_H
@@ -0,0 +1,256 @@
+//
+// `pomostat trace`: runs the firmware's main loop against host stand-ins and saves a Chrome trace.
+//
+
+#include "TraceRun.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+
+#include "AudioCues.h"
+#include "ClockLayout.h"
+#include "DailyStats.h"
+#include "DirtyRegion.h"
+#include "FrameTiming.h"
+#include "HostFramebuffer.h"
+#include "LedEffects.h"
+#include "ObserverProbe.h"
+#include "Trace.h"
+
+namespace
+{
+// Short enough that a run of a few seconds crosses every transition.
+constexpr time_t kWorkSeconds = 6;
+constexpr time_t kBreakSeconds = 3;
+constexpr int16_t kWidth = 320;
+constexpr int16_t kHeight = 240;
+// The panel's SPI clock: the host pushes instantly, so pushes sleep for the time the wire would take.
+constexpr double kPushBytesPerMicro = 40.0 / 8.0;
+constexpr auto kLedFrame = std::chrono::milliseconds(20);
+
+class TraceCues final : public CueSink
+{
+public:
+    void play(const AudioCue cue) override
+    {
+        tracer().instant("audio.cue", static_cast<uint32_t>(cue));
+    }
+};
+
+// ClockFace stand-in: notifications hand the update to a render thread, which lays out, diffs and
+// pushes the frame like the device's render task.
+class TraceDisplay final : public PomodoroObserver
+{
+public:
+    TraceDisplay() : framebuffer_(kWidth, kHeight), renderer_(kWidth, kHeight), pending_(false), stopping_(false)
+    {
+        thread_ = std::thread([this]() { renderLoop(); });
+    }
+
+    ~TraceDisplay() override
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_one();
+        thread_.join();
+    }
+
+    void notification(const ClockUpdate update) override
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            update_ = update;
+            pending_ = true;
+        }
+        wake_.notify_one();
+    }
+
+    void notification(IdleToWork) override {}
+    void notification(WorkToBreak) override {}
+    void notification(BreakToIdle) override {}
+    void notification(WorkToIdle) override {}
+    void notification(AdditionalWork) override {}
+
+private:
+    FixedFontMetrics metrics_;
+    HostFramebuffer framebuffer_;
+    DirtyRenderer renderer_;
+    FrameLayout layout_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    ClockUpdate update_;
+    bool pending_;
+    bool stopping_;
+    std::thread thread_;
+
+    void renderLoop()
+    {
+        tracer().nameTask("render");
+        while (true)
+        {
+            ClockUpdate update;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait(lock, [this]() { return pending_ || stopping_; });
+                if (stopping_)
+                {
+                    return;
+                }
+                update = update_;
+                pending_ = false;
+            }
+            render(update);
+        }
+    }
+
+    void render(const ClockUpdate& update)
+    {
+        const DirtyRegion* dirty;
+        {
+            TRACE_SCOPE("display.render");
+            char time_buffer[sizeof("HH:MM:SS")];
+            char date_buffer[sizeof("DD MM YYYY")];
+            char remaining_buffer[16];
+            struct tm timeinfo;
+            gmtime_r(&update.now, &timeinfo);
+            strftime(time_buffer, sizeof(time_buffer), "%H:%M:%S", &timeinfo);
+            strftime(date_buffer, sizeof(date_buffer), "%d %m %Y", &timeinfo);
+            snprintf(remaining_buffer, sizeof(remaining_buffer), "%02d:%02d",
+                     static_cast<int>(update.remaining_time_in_state / 60),
+                     static_cast<int>(update.remaining_time_in_state % 60));
+            const ClockFrameText text = {update.state, update.work_flavor, clock_colors::kDarkGreen, time_buffer,
+                                         date_buffer, "Monday", remaining_buffer, "work", "Today: 3 pomodoros, 75 min",
+                                         "work 3/75m  leisure 0/0m  chores 0/0m"};
+            layoutClockFrame(text, metrics_, kWidth, kHeight, &layout_);
+            dirty = &renderer_.render(layout_, framebuffer_);
+        }
+        TRACE_SCOPE("display.push");
+        const uint64_t before = framebuffer_.bytesPushed();
+        framebuffer_.push(*dirty);
+        const double bytes = static_cast<double>(framebuffer_.bytesPushed() - before);
+        std::this_thread::sleep_for(std::chrono::microseconds(static_cast<int64_t>(bytes / kPushBytesPerMicro)));
+    }
+};
+
+// Leds stand-in: the animator is fed from notifications and rendered every 20 ms on its own thread.
+class TraceLeds final : public PomodoroObserver
+{
+public:
+    TraceLeds() : stopping_(false)
+    {
+        thread_ = std::thread([this]() { frameLoop(); });
+    }
+
+    ~TraceLeds() override
+    {
+        stopping_ = true;
+        thread_.join();
+    }
+
+    void notification(const ClockUpdate update) override
+    {
+        animator_.update(update, nowMs());
+    }
+
+    void notification(IdleToWork) override {}
+    void notification(WorkToBreak) override {}
+    void notification(BreakToIdle) override {}
+    void notification(WorkToIdle) override {}
+    void notification(AdditionalWork) override {}
+
+private:
+    LedAnimator animator_;
+    std::atomic<bool> stopping_;
+    std::thread thread_;
+
+    static uint32_t nowMs()
+    {
+        return static_cast<uint32_t>(monotonicMicros() / 1000);
+    }
+
+    void frameLoop()
+    {
+        tracer().nameTask("leds");
+        LedFrame frame;
+        auto next = std::chrono::steady_clock::now();
+        while (!stopping_)
+        {
+            next += kLedFrame;
+            std::this_thread::sleep_until(next);
+            if (animator_.render(nowMs(), &frame))
+            {
+                // Where the device would call FastLED.show().
+                tracer().instant("leds.show");
+            }
+        }
+    }
+};
+
+void writeToFile(const char* data, const size_t size, void* context)
+{
+    fwrite(data, 1, size, static_cast<FILE*>(context));
+}
+}
+
+int runTrace(int argc, char** argv)
+{
+    const int seconds = argc > 0 ? atoi(argv[0]) : 12;
+    const char* path = argc > 1 ? argv[1] : "trace.json";
+    if (seconds <= 0)
+    {
+        fprintf(stderr, "pomostat: trace needs a positive number of seconds\n");
+        return 2;
+    }
+
+    tracer().clear();
+    tracer().nameTask("main");
+    TraceCues cues;
+    AudioCues audio(cues, 2);
+    DailyStats stats;
+    TraceDisplay display;
+    TraceLeds leds;
+    ObserverProbe display_probe("notify_us.display", display);
+    ObserverProbe leds_probe("notify_us.leds", leds);
+    ObserverProbe audio_probe("notify_us.audio", audio);
+    ObserverProbe stats_probe("notify_us.stats", stats);
+    PomodoroClock clock;
+    clock.add_observer(display_probe);
+    clock.add_observer(leds_probe);
+    clock.add_observer(audio_probe);
+    clock.add_observer(stats_probe);
+
+    // One iteration per wall-clock second, like the firmware's loop.
+    const time_t start = 1738569600;
+    auto next = std::chrono::steady_clock::now();
+    clock.StartWork(0, kWorkSeconds, kBreakSeconds, start);
+    for (int second = 0; second < seconds; second++)
+    {
+        clock.PassageOfTime(start + second);
+        if (clock.State() == IDLE)
+        {
+            clock.StartWork(static_cast<uint8_t>(second % DEFAULT_WORK_FLAVORS), kWorkSeconds, kBreakSeconds,
+                            start + second);
+        }
+        next += std::chrono::seconds(1);
+        std::this_thread::sleep_until(next);
+    }
+
+    FILE* out = fopen(path, "w");
+    if (!out)
+    {
+        fprintf(stderr, "pomostat: cannot write %s\n", path);
+        return 1;
+    }
+    const size_t events = exportChromeTrace(tracer(), writeToFile, out);
+    fclose(out);
+    printf("%zu events from %zu tasks written to %s (the ring keeps the last %zu)\n", events,
+           tracer().taskCount(), path, TraceBuffer::kCapacity);
+    return 0;
+}
@@ -0,0 +1,12 @@
+//
+// `pomostat trace`: runs the firmware's main loop against host stand-ins and saves a Chrome trace.
+//
+
+#ifndef TRACERUN_H
+#define TRACERUN_H
+
+// trace [seconds] [out.json]: `seconds` real-time iterations of the main loop, written to
+// out.json (default trace.json) for chrome://tracing or ui.perfetto.dev.
+int runTrace(int argc, char** argv);
+
+#endif //TRACERUN_H
@@ -1,9 +1,251 @@
-#include <iostream>
+//
+// pomostat: offline analytics for pomodoro.csv files pulled from device SD cards.
+//
 
-#include "Pomodoro.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Bench.h"
+#include "CsvStats.h"
+#include "JournalRun.h"
+#include "MappedFile.h"
+#include "StatusServe.h"
+#include "TraceRun.h"
+
+namespace
+{
+const Benchmark benchmarks[] = {
+    {"csv", "pomodoro.csv parse throughput on a synthetic file ([rows] [path] [--keep])", benchCsv},
+    {"frame", "ClockFace bytes pushed per frame over a simulated hour", benchFrame},
+    {"time", "clock/date formatting per frame, strftime vs LocalTimeCache ([seconds])", benchTime},
+    {"leds", "LED frames needing FastLED.show() over a simulated hour", benchLeds},
+    {"audio", "cue decode/resample and mixer throughput ([gong.wav])", benchAudio},
+    {"config", "config.ini load time: old loader, ConfigParser, NVS cache blob ([iterations])", benchConfig},
+    {"sched", "coroutine scheduler vs a thread per job: switch cost, timer lateness, memory ([seconds])",
+     benchScheduler},
+    {"metrics", "ns per counter/gauge/histogram record, alone and contended ([records])", benchMetrics},
+    {"transport", "air bytes per transition, HTTP POST vs MQTT to a loopback broker ([pomodoros])", benchTransport},
+    {"sync", "LAN sync traffic and convergence, clocks over loopback multicast ([peers] [loss%])", benchSync},
+};
+
+struct StatsOptions
+{
+    unsigned threads = std::thread::hardware_concurrency();
+    int days = 14;
+    std::vector<std::string> flavor_labels = {"work", "leisure", "chores"};
+    const char* path = nullptr;
+};
+
+void formatDay(const int32_t day, char* out, const size_t size)
+{
+    // Howard Hinnant's civil_from_days.
+    const int32_t z = day + 719468;
+    const int32_t era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    const unsigned mday = doy - (153 * mp + 2) / 5 + 1;
+    const unsigned month = mp < 10 ? mp + 3 : mp - 9;
+    const int year = static_cast<int>(yoe) + era * 400 + (month <= 2);
+    static const char* weekdays[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+    snprintf(out, size, "%04d-%02u-%02u %s", year, month, mday, weekdays[csvWeekday(day)]);
+}
+
+double hours(const uint64_t seconds)
+{
+    return static_cast<double>(seconds) / 3600.0;
+}
+
+void printStats(const CsvStats& stats, const StatsOptions& options)
+{
+    printf("\n%-16s %10s %10s\n", "Flavor", "Pomodoros", "Focus h");
+    for (size_t flavor = 0; flavor < stats.flavors().size(); flavor++)
+    {
+        const PomodoroTotals& totals = stats.flavors()[flavor];
+        if (totals.pomodoros == 0)
+        {
+            continue;
+        }
+        const std::string label = flavor < options.flavor_labels.size()
+            ? options.flavor_labels[flavor] : std::to_string(flavor);
+        printf("%-16s %10llu %10.1f\n", label.c_str(), static_cast<unsigned long long>(totals.pomodoros),
+               hours(totals.seconds));
+    }
+
+    const std::vector<PomodoroTotals>& days = stats.days();
+    if (!days.empty() && options.days != 0)
+    {
+        const size_t shown = options.days < 0 || static_cast<size_t>(options.days) > days.size()
+            ? days.size() : static_cast<size_t>(options.days);
+        printf("\n%-16s %10s %10s\n", "Day", "Pomodoros", "Focus h");
+        for (size_t i = days.size() - shown; i < days.size(); i++)
+        {
+            char label[32];
+            formatDay(stats.firstDay() + static_cast<int32_t>(i), label, sizeof(label));
+            printf("%-16s %10llu %10.1f\n", label, static_cast<unsigned long long>(days[i].pomodoros),
+                   hours(days[i].seconds));
+        }
+    }
+
+    printf("\nPomodoros started per hour of week\n    ");
+    for (int hour = 0; hour < 24; hour++)
+    {
+        printf(" %4d", hour);
+    }
+    static const char* weekdays[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+    for (int weekday = 0; weekday < 7; weekday++)
+    {
+        printf("\n%s ", weekdays[weekday]);
+        for (int hour = 0; hour < 24; hour++)
+        {
+            printf(" %4llu", static_cast<unsigned long long>(stats.hourOfWeek()[weekday * 24 + hour].pomodoros));
+        }
+    }
+    printf("\n");
+}
+
+int runStats(const StatsOptions& options)
+{
+    MappedFile file;
+    if (!file.open(options.path))
+    {
+        fprintf(stderr, "pomostat: cannot open %s\n", options.path);
+        return 1;
+    }
+    BenchTimer timer;
+    const CsvStats stats = CsvStats::parseParallel(file.data(), file.data() + file.size(), options.threads);
+    const double seconds = timer.seconds();
+    printf("%s: %llu pomodoros, %llu malformed lines, %.1f MB in %.3f s (%.2f GB/s, %u threads)\n",
+           options.path, static_cast<unsigned long long>(stats.rows()),
+           static_cast<unsigned long long>(stats.malformed()), static_cast<double>(file.size()) / 1e6, seconds,
+           seconds > 0 ? static_cast<double>(file.size()) / seconds / 1e9 : 0.0, options.threads);
+    printStats(stats, options);
+    return 0;
+}
+
+int runBench(int argc, char** argv)
+{
+    for (const Benchmark& benchmark : benchmarks)
+    {
+        if (argc == 0 || strcmp(argv[0], benchmark.name) == 0)
+        {
+            printf("== %s: %s\n", benchmark.name, benchmark.description);
+            const int result = benchmark.run(argc > 0 ? argc - 1 : 0, argc > 0 ? argv + 1 : argv);
+            if (result != 0 || argc > 0)
+            {
+                return result;
+            }
+        }
+    }
+    if (argc > 0)
+    {
+        fprintf(stderr, "pomostat: unknown benchmark %s\n", argv[0]);
+        return 1;
+    }
+    return 0;
+}
+
+void usage()
+{
+    fprintf(stderr,
+            "usage: pomostat [stats] [--threads N] [--days N|all] [--flavors a,b,c] pomodoro.csv\n"
+            "       pomostat bench [name] [args...]\n"
+            "       pomostat trace [seconds] [out.json]\n"
+            "       pomostat serve [port] [seconds]\n"
+            "       pomostat record [hours] [out.bin]\n"
+            "       pomostat replay journal.bin [repeats]\n\nbenchmarks:\n");
+    for (const Benchmark& benchmark : benchmarks)
+    {
+        fprintf(stderr, "  %-10s %s\n", benchmark.name, benchmark.description);
+    }
+}
+
+std::vector<std::string> split(const char* list)
+{
+    std::vector<std::string> items;
+    const char* start = list;
+    for (const char* p = list;; p++)
+    {
+        if (*p == ',' || *p == '\0')
+        {
+            items.emplace_back(start, p);
+            start = p + 1;
+        }
+        if (*p == '\0')
+        {
+            break;
+        }
+    }
+    return items;
+}
+}
 
 int main(int argc, char **argv) {
-    PomodoroClock pomodoro;
+    int arg = 1;
+    if (arg < argc && strcmp(argv[arg], "bench") == 0)
+    {
+        return runBench(argc - arg - 1, argv + arg + 1);
+    }
+    if (arg < argc && strcmp(argv[arg], "trace") == 0)
+    {
+        return runTrace(argc - arg - 1, argv + arg + 1);
+    }
+    if (arg < argc && strcmp(argv[arg], "serve") == 0)
+    {
+        return runServe(argc - arg - 1, argv + arg + 1);
+    }
+    if (arg < argc && strcmp(argv[arg], "record") == 0)
+    {
+        return runRecord(argc - arg - 1, argv + arg + 1);
+    }
+    if (arg < argc && strcmp(argv[arg], "replay") == 0)
+    {
+        return runReplay(argc - arg - 1, argv + arg + 1);
+    }
+    if (arg < argc && strcmp(argv[arg], "stats") == 0)
+    {
+        arg++;
+    }
 
-    std::cout << "Hello world!" << std::endl;
-}
\ No newline at end of file
+    StatsOptions options;
+    for (; arg < argc; arg++)
+    {
+        if (strcmp(argv[arg], "--threads") == 0 && arg + 1 < argc)
+        {
+            options.threads = static_cast<unsigned>(strtoul(argv[++arg], nullptr, 10));
+        }
+        else if (strcmp(argv[arg], "--days") == 0 && arg + 1 < argc)
+        {
+            arg++;
+            options.days = strcmp(argv[arg], "all") == 0 ? -1 : atoi(argv[arg]);
+        }
+        else if (strcmp(argv[arg], "--flavors") == 0 && arg + 1 < argc)
+        {
+            options.flavor_labels = split(argv[++arg]);
+        }
+        else if (argv[arg][0] == '-' || options.path)
+        {
+            usage();
+            return 2;
+        }
+        else
+        {
+            options.path = argv[arg];
+        }
+    }
+    if (!options.path)
+    {
+        usage();
+        return 2;
+    }
+    if (options.threads == 0)
+    {
+        options.threads = 1;
+    }
+    return runStats(options);
+}
@@ -0,0 +1,225 @@
+#include <unity.h>
+#include <vector>
+#include "AudioCues.h"
+#include "Pcm.h"
+
+void put16(std::vector<uint8_t>& out, uint16_t value) {
+    out.push_back(static_cast<uint8_t>(value));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+void put32(std::vector<uint8_t>& out, uint32_t value) {
+    put16(out, static_cast<uint16_t>(value));
+    put16(out, static_cast<uint16_t>(value >> 16));
+}
+
+std::vector<uint8_t> makeWav(uint16_t channels, uint32_t rate, uint16_t bits, const std::vector<uint8_t>& data,
+                             bool with_list_chunk = false) {
+    std::vector<uint8_t> out = {'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E'};
+    out.insert(out.end(), {'f', 'm', 't', ' '});
+    put32(out, 16);
+    put16(out, 1);
+    put16(out, channels);
+    put32(out, rate);
+    put32(out, rate * channels * bits / 8);
+    put16(out, static_cast<uint16_t>(channels * bits / 8));
+    put16(out, bits);
+    if (with_list_chunk) {
+        out.insert(out.end(), {'L', 'I', 'S', 'T', 3, 0, 0, 0, 'a', 'b', 'c', 0});
+    }
+    out.insert(out.end(), {'d', 'a', 't', 'a'});
+    put32(out, static_cast<uint32_t>(data.size()));
+    out.insert(out.end(), data.begin(), data.end());
+    return out;
+}
+
+std::vector<uint8_t> samples16(const std::vector<int16_t>& samples) {
+    std::vector<uint8_t> out;
+    for (int16_t sample : samples) {
+        put16(out, static_cast<uint16_t>(sample));
+    }
+    return out;
+}
+
+class RecordingSink : public CueSink {
+public:
+    void play(AudioCue cue) override {
+        played.push_back(cue);
+    }
+
+    std::vector<AudioCue> played;
+};
+
+ClockUpdate work(time_t remaining) {
+    return {1738569600, WORK, 0, remaining};
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_parses_pcm_and_skips_unknown_chunks(void) {
+    const std::vector<uint8_t> file = makeWav(1, 11025, 16, samples16({1, -2, 3}), true);
+    WavInfo info;
+    TEST_ASSERT_TRUE(parseWav(file.data(), file.size(), &info));
+    TEST_ASSERT_EQUAL_UINT32(11025, info.sample_rate);
+    TEST_ASSERT_EQUAL(3, info.frames);
+
+    // Cut in the middle of the last sample.
+    TEST_ASSERT_TRUE(parseWav(file.data(), file.size() - 1, &info));
+    TEST_ASSERT_EQUAL(2, info.frames);
+}
+
+void test_rejects_unsupported_files(void) {
+    std::vector<uint8_t> file = makeWav(1, 8000, 24, std::vector<uint8_t>(6));
+    WavInfo info;
+    TEST_ASSERT_FALSE(parseWav(file.data(), file.size(), &info));
+    file = makeWav(1, 8000, 16, samples16({1}));
+    file[20] = 3;  // IEEE float
+    TEST_ASSERT_FALSE(parseWav(file.data(), file.size(), &info));
+    TEST_ASSERT_FALSE(parseWav(file.data(), 10, &info));
+    file[0] = 'X';
+    TEST_ASSERT_FALSE(parseWav(file.data(), file.size(), &info));
+}
+
+void test_resamples_to_mono16(void) {
+    // 8-bit stereo: channels are averaged and widened.
+    const std::vector<uint8_t> stereo = makeWav(2, 8000, 8, {128, 128, 192, 64, 255, 255});
+    WavInfo info;
+    TEST_ASSERT_TRUE(parseWav(stereo.data(), stereo.size(), &info));
+    int16_t out[8];
+    TEST_ASSERT_EQUAL(3, resampleToMono16(info, 8000, out, 8));
+    TEST_ASSERT_EQUAL_INT16(0, out[0]);
+    TEST_ASSERT_EQUAL_INT16(0, out[1]);
+    TEST_ASSERT_EQUAL_INT16(127 << 8, out[2]);
+
+    // Doubling the rate interpolates halfway between samples.
+    const std::vector<uint8_t> mono = makeWav(1, 8000, 16, samples16({0, 1000, 2000, 3000}));
+    TEST_ASSERT_TRUE(parseWav(mono.data(), mono.size(), &info));
+    TEST_ASSERT_EQUAL(8, resampledFrames(info, 16000));
+    TEST_ASSERT_EQUAL(8, resampleToMono16(info, 16000, out, 8));
+    TEST_ASSERT_EQUAL_INT16(500, out[1]);
+    TEST_ASSERT_EQUAL_INT16(2500, out[5]);
+    TEST_ASSERT_EQUAL_INT16(3000, out[7]);
+    TEST_ASSERT_EQUAL(3, resampleToMono16(info, 16000, out, 3));
+    TEST_ASSERT_EQUAL(2, resampleToMono16(info, 4000, out, 8));
+    TEST_ASSERT_EQUAL_INT16(2000, out[1]);
+}
+
+void test_tone_decays(void) {
+    int16_t tone[1600];
+    synthesizeTone(tone, 1600, 16000, 1000, 10000, 50);
+    int16_t first = 0;
+    int16_t last = 0;
+    for (int i = 0; i < 16; i++) {
+        first = tone[i] > first ? tone[i] : first;
+        last = tone[1584 + i] > last ? tone[1584 + i] : last;
+    }
+    // 100 ms at a 50 ms half-life: a quarter of the start.
+    TEST_ASSERT_INT_WITHIN(200, 10000, first);
+    TEST_ASSERT_INT_WITHIN(200, 2500, last);
+}
+
+void test_mixer_sums_and_saturates(void) {
+    const int16_t loud[4] = {30000, 30000, 30000, 30000};
+    const int16_t quiet[2] = {-1000, -1000};
+    CueMixer mixer;
+    mixer.setCue(0, {loud, 4, 256});
+    mixer.setCue(1, {quiet, 2, 128});
+    int16_t out[6];
+    TEST_ASSERT_FALSE(mixer.trigger(2));
+    TEST_ASSERT_FALSE(mixer.mix(out, 6));
+    TEST_ASSERT_EQUAL_INT16(0, out[0]);
+
+    TEST_ASSERT_TRUE(mixer.trigger(0));
+    TEST_ASSERT_TRUE(mixer.trigger(0));
+    TEST_ASSERT_TRUE(mixer.trigger(1));
+    TEST_ASSERT_TRUE(mixer.active());
+    TEST_ASSERT_TRUE(mixer.mix(out, 6));
+    TEST_ASSERT_EQUAL_INT16(INT16_MAX, out[0]);
+    TEST_ASSERT_EQUAL_INT16(INT16_MAX, out[3]);
+    TEST_ASSERT_EQUAL_INT16(0, out[4]);
+    TEST_ASSERT_FALSE(mixer.active());
+
+    mixer.trigger(1);
+    mixer.mix(out, 1);
+    TEST_ASSERT_EQUAL_INT16(-500, out[0]);
+}
+
+void test_mixer_replaces_voice_closest_to_end(void) {
+    int16_t long_cue[100];
+    int16_t short_cue[10];
+    for (int i = 0; i < 100; i++) {
+        long_cue[i] = 100;
+    }
+    for (int i = 0; i < 10; i++) {
+        short_cue[i] = 1;
+    }
+    CueMixer mixer;
+    mixer.setCue(0, {long_cue, 100, 256});
+    mixer.setCue(1, {short_cue, 10, 256});
+    int16_t out[4];
+    mixer.trigger(1);
+    for (size_t i = 1; i < CueMixer::kVoices; i++) {
+        mixer.trigger(0);
+    }
+    mixer.mix(out, 4);
+    TEST_ASSERT_EQUAL_INT16(301, out[0]);
+    // The short cue has 6 frames left and is the one replaced.
+    mixer.trigger(0);
+    mixer.mix(out, 4);
+    TEST_ASSERT_EQUAL_INT16(400, out[0]);
+}
+
+void test_transitions_play_cues(void) {
+    RecordingSink sink;
+    AudioCues cues(sink);
+    cues.notification(IdleToWork{});
+    cues.notification(WorkToBreak{});
+    cues.notification(BreakToIdle{});
+    cues.notification(WorkToIdle{});
+    TEST_ASSERT_EQUAL(3, sink.played.size());
+    TEST_ASSERT_TRUE(sink.played[0] == AudioCue::START_WORK);
+    TEST_ASSERT_TRUE(sink.played[1] == AudioCue::END_WORK);
+    TEST_ASSERT_TRUE(sink.played[2] == AudioCue::END_BREAK);
+}
+
+void test_warning_plays_once_per_period(void) {
+    RecordingSink sink;
+    AudioCues cues(sink, 120);
+    for (time_t remaining = 1500; remaining > 0; remaining--) {
+        cues.notification(work(remaining));
+    }
+    TEST_ASSERT_EQUAL(1, sink.played.size());
+    TEST_ASSERT_TRUE(sink.played[0] == AudioCue::WARNING);
+
+    // Extending work past the threshold re-arms it.
+    cues.notification(work(100));
+    cues.notification(work(400));
+    cues.notification(work(120));
+    TEST_ASSERT_EQUAL(2, sink.played.size());
+
+    // A period that starts below the threshold does not warn.
+    cues.notification(ClockUpdate{1738569600, IDLE, 0, 0});
+    cues.notification(work(60));
+    cues.notification(work(59));
+    TEST_ASSERT_EQUAL(2, sink.played.size());
+
+    AudioCues disabled(sink, 0);
+    disabled.notification(work(1500));
+    disabled.notification(work(1));
+    TEST_ASSERT_EQUAL(2, sink.played.size());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_parses_pcm_and_skips_unknown_chunks);
+    RUN_TEST(test_rejects_unsupported_files);
+    RUN_TEST(test_resamples_to_mono16);
+    RUN_TEST(test_tone_decays);
+    RUN_TEST(test_mixer_sums_and_saturates);
+    RUN_TEST(test_mixer_replaces_voice_closest_to_end);
+    RUN_TEST(test_transitions_play_cues);
+    RUN_TEST(test_warning_plays_once_per_period);
+    return UNITY_END();
+}
@@ -0,0 +1,61 @@
+#include <unity.h>
+#include <cstring>
+#include <thread>
+#include "BootTimeline.h"
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_formats_phases_by_start(void) {
+    BootTimeline timeline(1000);
+    timeline.record("wifi", 51000, 2551000, false);
+    timeline.record("config", 1000, 1500);
+    timeline.record("clock", 2000, 41000);
+    TEST_ASSERT_EQUAL(3, timeline.size());
+
+    char report[256];
+    const size_t length = timeline.format(report, sizeof(report));
+    TEST_ASSERT_EQUAL(strlen(report), length);
+    TEST_ASSERT_EQUAL_STRING(
+        "boot      0.0 ms  +     0.5 ms  config\n"
+        "boot      1.0 ms  +    39.0 ms  clock\n"
+        "boot     50.0 ms  +  2500.0 ms  wifi (failed)\n",
+        report);
+}
+
+void test_truncates_report(void) {
+    BootTimeline timeline;
+    timeline.record("config", 0, 500);
+    timeline.record("clock", 1000, 2000);
+    char report[40];
+    const size_t length = timeline.format(report, sizeof(report));
+    TEST_ASSERT_EQUAL(39, length);
+    TEST_ASSERT_EQUAL(39, strlen(report));
+}
+
+void test_records_from_several_tasks(void) {
+    BootTimeline timeline;
+    std::thread network([&timeline]() {
+        for (int i = 0; i < 10; i++) {
+            timeline.record("network", i, i + 1);
+        }
+    });
+    for (int i = 0; i < 10; i++) {
+        timeline.record("clock", i, i + 1);
+    }
+    network.join();
+    TEST_ASSERT_EQUAL(BootTimeline::kMaxPhases, timeline.size());
+    // An end before the start is clamped to a zero-length phase.
+    BootTimeline clamped;
+    clamped.record("rtc", 10, 5);
+    TEST_ASSERT_EQUAL_UINT64(10, clamped.phase(0).end_us);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_formats_phases_by_start);
+    RUN_TEST(test_truncates_report);
+    RUN_TEST(test_records_from_several_tasks);
+    return UNITY_END();
+}
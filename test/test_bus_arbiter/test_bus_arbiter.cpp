@@ -0,0 +1,119 @@
+#include <unity.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "BusArbiter.h"
+
+void sleepMs(int ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_nested_holds_count_once(void) {
+    BusArbiter bus;
+    BusClient logger(bus, "logger", BusPriority::BACKGROUND);
+    BusClient mount(bus, "mount", BusPriority::BACKGROUND);
+    {
+        BusLock outer(logger);
+        BusLock inner(mount);
+        TEST_ASSERT_FALSE(inner.yield());
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, bus.stats(logger).acquisitions);
+    TEST_ASSERT_EQUAL_UINT32(0, bus.stats(mount).acquisitions);
+    // The bus is free again.
+    std::thread other([&mount]() { BusLock lock(mount); });
+    other.join();
+    TEST_ASSERT_EQUAL_UINT32(1, bus.stats(mount).acquisitions);
+}
+
+void test_interactive_goes_before_background(void) {
+    BusArbiter bus;
+    BusClient display(bus, "display", BusPriority::INTERACTIVE);
+    BusClient logger(bus, "logger", BusPriority::BACKGROUND);
+    BusClient http(bus, "http", BusPriority::BACKGROUND);
+    std::vector<const char*> order;
+    std::mutex order_mutex;
+    auto take = [&](BusClient& client) {
+        BusLock lock(client);
+        std::lock_guard<std::mutex> guard(order_mutex);
+        order.push_back(client.name());
+    };
+
+    std::thread background;
+    std::thread interactive;
+    {
+        BusLock held(logger);
+        background = std::thread(take, std::ref(http));
+        sleepMs(20);
+        interactive = std::thread(take, std::ref(display));
+        sleepMs(20);
+    }
+    background.join();
+    interactive.join();
+    TEST_ASSERT_EQUAL(2, order.size());
+    TEST_ASSERT_EQUAL_STRING("display", order[0]);
+    TEST_ASSERT_EQUAL_STRING("http", order[1]);
+
+    // The logger held the bus while the display waited about 20 ms.
+    const BusClientStats stats = bus.stats(logger);
+    TEST_ASSERT_TRUE(stats.blocked_interactive_us >= 15000);
+    TEST_ASSERT_TRUE(stats.hold_us >= stats.blocked_interactive_us);
+    TEST_ASSERT_TRUE(bus.stats(display).wait_us >= 15000);
+    TEST_ASSERT_EQUAL_UINT64(0, bus.stats(http).blocked_interactive_us);
+}
+
+void test_long_job_yields_to_display(void) {
+    BusArbiter bus;
+    BusClient display(bus, "display", BusPriority::INTERACTIVE);
+    BusClient scan(bus, "scan", BusPriority::BACKGROUND);
+    std::atomic<bool> pushed(false);
+    std::atomic<bool> started(false);
+    std::thread job([&]() {
+        BusLock lock(scan);
+        started = true;
+        for (int step = 0; step < 50 && !pushed; step++) {
+            sleepMs(1);
+            lock.yield();
+        }
+    });
+    while (!started) {
+        sleepMs(1);
+    }
+    {
+        BusLock lock(display);
+        pushed = true;
+    }
+    job.join();
+    TEST_ASSERT_EQUAL_UINT32(1, bus.stats(scan).yields);
+    TEST_ASSERT_EQUAL_UINT32(1, bus.stats(scan).acquisitions);
+    // Waited at most one step, not the whole 50 ms job.
+    TEST_ASSERT_TRUE(bus.stats(display).max_wait_us < 20000);
+}
+
+void test_report(void) {
+    BusArbiter bus;
+    BusClient display(bus, "display", BusPriority::INTERACTIVE);
+    BusClient logger(bus, "logger", BusPriority::BACKGROUND);
+    { BusLock lock(display); }
+    char report[512];
+    const size_t length = bus.format(report, sizeof(report));
+    TEST_ASSERT_EQUAL(strlen(report), length);
+    TEST_ASSERT_NOT_NULL(strstr(report, "bus display         1 holds"));
+    TEST_ASSERT_NOT_NULL(strstr(report, "bus logger          0 holds"));
+    char small[16];
+    TEST_ASSERT_EQUAL(15, bus.format(small, sizeof(small)));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_nested_holds_count_once);
+    RUN_TEST(test_interactive_goes_before_background);
+    RUN_TEST(test_long_job_yields_to_display);
+    RUN_TEST(test_report);
+    return UNITY_END();
+}
@@ -0,0 +1,84 @@
+#include <unity.h>
+#include <cstring>
+#include "ByteCodec.h"
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_little_endian(void) {
+    uint8_t data[8];
+    putUint16(data, 0x1234);
+    TEST_ASSERT_EQUAL_HEX8(0x34, data[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x12, data[1]);
+    TEST_ASSERT_EQUAL_HEX16(0x1234, getUint16(data));
+
+    putUint32(data, 0xDEADBEEF);
+    const uint8_t expected[4] = {0xEF, 0xBE, 0xAD, 0xDE};
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, data, 4);
+    TEST_ASSERT_EQUAL_HEX32(0xDEADBEEF, getUint32(data));
+
+    putUint64(data, 0x0102030405060708ull);
+    TEST_ASSERT_EQUAL_HEX32(0x05060708, getUint32(data));
+    TEST_ASSERT_EQUAL_HEX32(0x01020304, getUint32(data + 4));
+}
+
+void test_varint_round_trip(void) {
+    const uint64_t values[] = {0, 1, 127, 128, 300, 16384, 0xFFFFFFFFull, UINT64_MAX};
+    const size_t sizes[] = {1, 1, 1, 2, 2, 3, 5, kMaxVarintBytes};
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        uint8_t data[kMaxVarintBytes];
+        const size_t size = putVarint(values[i], data);
+        TEST_ASSERT_EQUAL(sizes[i], size);
+        uint64_t value = 0;
+        TEST_ASSERT_EQUAL(size, getVarint(data, size, &value));
+        TEST_ASSERT_TRUE(value == values[i]);
+    }
+    uint8_t data[2];
+    putVarint(300, data);
+    TEST_ASSERT_EQUAL_HEX8(0xAC, data[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x02, data[1]);
+}
+
+void test_varint_rejects_truncated_and_overlong(void) {
+    uint64_t value = 7;
+    const uint8_t truncated[2] = {0x80, 0x80};
+    TEST_ASSERT_EQUAL(0, getVarint(truncated, sizeof(truncated), &value));
+    uint8_t overlong[kMaxVarintBytes + 1];
+    memset(overlong, 0x80, sizeof(overlong));
+    overlong[kMaxVarintBytes] = 0x01;
+    TEST_ASSERT_EQUAL(0, getVarint(overlong, sizeof(overlong), &value));
+    TEST_ASSERT_EQUAL(0, getVarint(truncated, 0, &value));
+    TEST_ASSERT_TRUE(value == 7);
+}
+
+void test_zigzag(void) {
+    TEST_ASSERT_TRUE(zigzag(0) == 0);
+    TEST_ASSERT_TRUE(zigzag(-1) == 1);
+    TEST_ASSERT_TRUE(zigzag(1) == 2);
+    TEST_ASSERT_TRUE(zigzag(-2) == 3);
+    TEST_ASSERT_TRUE(zigzag(INT64_MIN) == UINT64_MAX);
+    const int64_t values[] = {0, -1500, 86400, INT64_MAX, INT64_MIN};
+    for (const int64_t value : values) {
+        TEST_ASSERT_TRUE(unzigzag(zigzag(value)) == value);
+    }
+}
+
+void test_fnv1a(void) {
+    // Published FNV-1a 32-bit test vectors.
+    TEST_ASSERT_EQUAL_HEX32(kFnv1aBasis, fnv1a(kFnv1aBasis, "", 0));
+    TEST_ASSERT_EQUAL_HEX32(0xE40C292C, fnv1a(kFnv1aBasis, "a", 1));
+    TEST_ASSERT_EQUAL_HEX32(0xBF9CF968, fnv1a(kFnv1aBasis, "foobar", 6));
+    // Chained calls hash the concatenation.
+    TEST_ASSERT_EQUAL_HEX32(fnv1a(kFnv1aBasis, "foobar", 6), fnv1a(fnv1a(kFnv1aBasis, "foo", 3), "bar", 3));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_little_endian);
+    RUN_TEST(test_varint_round_trip);
+    RUN_TEST(test_varint_rejects_truncated_and_overlong);
+    RUN_TEST(test_zigzag);
+    RUN_TEST(test_fnv1a);
+    return UNITY_END();
+}
@@ -0,0 +1,113 @@
+#include <unity.h>
+#include <cstring>
+#include "ConfigCache.h"
+
+class MemoryStore : public CheckpointStore {
+public:
+    size_t load(uint8_t* data, size_t capacity) override {
+        if (size == 0 || size > capacity) {
+            return 0;
+        }
+        memcpy(data, buffer, size);
+        return size;
+    }
+
+    bool save(const uint8_t* data, size_t length) override {
+        memcpy(buffer, data, length);
+        size = length;
+        saves++;
+        return true;
+    }
+
+    uint8_t buffer[ConfigCache::kMaxSize] = {};
+    size_t size = 0;
+    int saves = 0;
+};
+
+Settings makeSettings() {
+    Settings settings;
+    strcpy(settings.wifi_ssid, "my network");
+    strcpy(settings.wifi_pass, "secret");
+    strcpy(settings.http_host, "192.168.1.2");
+    settings.http_port = 8080;
+    strcpy(settings.flavors[2].label, "errands");
+    settings.flavors[2].color = 0xF800;
+    settings.work_minutes = 50;
+    return settings;
+}
+
+// Field by field: padding between the members is not part of the value.
+bool sameSettings(const Settings& a, const Settings& b) {
+    for (const ConfigField& field : kConfigSchema) {
+        if (memcmp(reinterpret_cast<const char*>(&a) + field.offset, reinterpret_cast<const char*>(&b) + field.offset,
+                   field.size) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_round_trip(void) {
+    MemoryStore store;
+    ConfigCache cache(&store);
+    const Settings settings = makeSettings();
+    const uint32_t fingerprint = configFingerprint(269, 1738569600);
+    TEST_ASSERT_TRUE(cache.save(fingerprint, settings));
+    // Compact: the strings' lengths, not their buffers.
+    TEST_ASSERT_TRUE(store.size < 200);
+
+    Settings loaded;
+    TEST_ASSERT_TRUE(cache.load(fingerprint, &loaded));
+    TEST_ASSERT_TRUE(sameSettings(settings, loaded));
+}
+
+void test_changed_file_misses(void) {
+    MemoryStore store;
+    ConfigCache cache(&store);
+    TEST_ASSERT_TRUE(cache.save(configFingerprint(269, 1738569600), makeSettings()));
+    Settings loaded;
+    TEST_ASSERT_FALSE(cache.load(configFingerprint(270, 1738569600), &loaded));
+    TEST_ASSERT_FALSE(cache.load(configFingerprint(269, 1738569602), &loaded));
+    TEST_ASSERT_EQUAL_STRING("", loaded.wifi_ssid);
+
+    MemoryStore empty;
+    ConfigCache empty_cache(&empty);
+    TEST_ASSERT_FALSE(empty_cache.load(configFingerprint(269, 1738569600), &loaded));
+}
+
+void test_damaged_blob_leaves_settings_alone(void) {
+    const uint32_t fingerprint = configFingerprint(1, 2);
+    uint8_t blob[ConfigCache::kMaxSize];
+    const size_t size = ConfigCache::serialize(fingerprint, makeSettings(), blob, sizeof(blob));
+    TEST_ASSERT_TRUE(size > 9);
+
+    Settings loaded;
+    TEST_ASSERT_FALSE(ConfigCache::restore(blob, size - 1, fingerprint, &loaded));
+    TEST_ASSERT_FALSE(ConfigCache::restore(blob, 5, fingerprint, &loaded));
+    blob[9] = 40;  // ssid length past its buffer
+    TEST_ASSERT_FALSE(ConfigCache::restore(blob, size, fingerprint, &loaded));
+    blob[9] = 10;
+    blob[0] = 0;  // version
+    TEST_ASSERT_FALSE(ConfigCache::restore(blob, size, fingerprint, &loaded));
+    blob[0] = 1;
+    blob[1] ^= 1;  // schema hash
+    TEST_ASSERT_FALSE(ConfigCache::restore(blob, size, fingerprint, &loaded));
+    TEST_ASSERT_EQUAL_STRING("", loaded.wifi_ssid);
+    blob[1] ^= 1;
+    TEST_ASSERT_TRUE(ConfigCache::restore(blob, size, fingerprint, &loaded));
+    TEST_ASSERT_EQUAL_STRING("my network", loaded.wifi_ssid);
+
+    TEST_ASSERT_EQUAL(0, ConfigCache::serialize(fingerprint, makeSettings(), blob, 20));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip);
+    RUN_TEST(test_changed_file_misses);
+    RUN_TEST(test_damaged_blob_leaves_settings_alone);
+    return UNITY_END();
+}
@@ -0,0 +1,197 @@
+#include <unity.h>
+#include <cstring>
+#include <string>
+#include "ConfigSchema.h"
+
+const char* EXAMPLE =
+    "[wifi]\n"
+    "ssid=my network\n"
+    "pass = secret \r\n"
+    "\n"
+    "; comment\n"
+    "[ntp]\n"
+    "host=pool.ntp.org\n"
+    "tz=CET-1CEST,M3.5.0,M10.5.0/3\n"
+    "[http]\n"
+    "host=192.168.1.2\n"
+    "port=8080\n"
+    "[flavors]\n"
+    "flavor1=study\n"
+    "[durations]\n"
+    "work_minutes=50\n"
+    "[audio]\n"
+    "warning_minutes=0";
+
+bool parse(const std::string& text, ConfigParser* parser, size_t chunk) {
+    for (size_t offset = 0; offset < text.size(); offset += chunk) {
+        parser->feed(text.data() + offset, std::min(chunk, text.size() - offset));
+    }
+    return parser->finish();
+}
+
+// Field by field: padding between the members is not part of the value.
+bool sameSettings(const Settings& a, const Settings& b) {
+    for (const ConfigField& field : kConfigSchema) {
+        if (memcmp(reinterpret_cast<const char*>(&a) + field.offset, reinterpret_cast<const char*>(&b) + field.offset,
+                   field.size) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_parses_example(void) {
+    Settings settings;
+    ConfigParser parser(&settings);
+    TEST_ASSERT_TRUE(parse(EXAMPLE, &parser, strlen(EXAMPLE)));
+    TEST_ASSERT_EQUAL_STRING("my network", settings.wifi_ssid);
+    TEST_ASSERT_EQUAL_STRING("secret", settings.wifi_pass);
+    TEST_ASSERT_EQUAL_STRING("192.168.1.2", settings.http_host);
+    TEST_ASSERT_EQUAL_UINT16(8080, settings.http_port);
+    TEST_ASSERT_EQUAL_STRING("work", settings.flavors[0].label);
+    TEST_ASSERT_EQUAL_STRING("study", settings.flavors[1].label);
+    TEST_ASSERT_EQUAL_UINT16(DEFAULT_WORK_FLAVORS, settings.flavor_count);
+    TEST_ASSERT_EQUAL_UINT16(50, settings.work_minutes);
+    TEST_ASSERT_EQUAL_UINT16(5, settings.break_minutes);
+    TEST_ASSERT_EQUAL_UINT16(0, settings.warning_minutes);
+    TEST_ASSERT_EQUAL(17, parser.lines());
+}
+
+void test_chunking_does_not_matter(void) {
+    Settings whole;
+    ConfigParser whole_parser(&whole);
+    parse(EXAMPLE, &whole_parser, strlen(EXAMPLE));
+    for (size_t chunk = 1; chunk < 40; chunk++) {
+        Settings settings;
+        ConfigParser parser(&settings);
+        TEST_ASSERT_TRUE(parse(EXAMPLE, &parser, chunk));
+        TEST_ASSERT_TRUE(sameSettings(whole, settings));
+    }
+}
+
+void test_reports_errors_with_line_numbers(void) {
+    Settings settings;
+    ConfigParser parser(&settings);
+    const std::string text =
+        "[wifi]\n"
+        "ssid=a\n"
+        "colour=blue\n"
+        "ssid=b\n"
+        "[http]\n"
+        "port=http\n"
+        "port=70000\n"
+        "[extra]\n"
+        "anything=goes\n"
+        "garbage\n"
+        "[durations]\n"
+        "work_minutes=0\n";
+    TEST_ASSERT_FALSE(parse(text, &parser, 5));
+    TEST_ASSERT_EQUAL(9, parser.errorCount());
+    TEST_ASSERT_EQUAL(7, parser.fatalErrorCount());
+
+    const struct {
+        uint16_t line;
+        ConfigErrorCode code;
+        const char* name;
+    } expected[] = {
+        {3, ConfigErrorCode::UNKNOWN_KEY, "colour"},
+        {4, ConfigErrorCode::DUPLICATE_KEY, "ssid"},
+        {6, ConfigErrorCode::NOT_A_NUMBER, "port"},
+        {7, ConfigErrorCode::OUT_OF_RANGE, "port"},
+        {8, ConfigErrorCode::UNKNOWN_SECTION, "extra"},
+        {10, ConfigErrorCode::SYNTAX, "garbage"},
+        {12, ConfigErrorCode::OUT_OF_RANGE, "work_minutes"},
+        {0, ConfigErrorCode::MISSING_KEY, "wifi.pass"},
+    };
+    for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++) {
+        TEST_ASSERT_EQUAL_UINT16(expected[i].line, parser.error(i).line);
+        TEST_ASSERT_TRUE(expected[i].code == parser.error(i).code);
+        TEST_ASSERT_EQUAL_STRING(expected[i].name, parser.error(i).name);
+    }
+    // The ninth error (ntp.host missing) is counted but not kept.
+    TEST_ASSERT_EQUAL_STRING("a", settings.wifi_ssid);
+    TEST_ASSERT_EQUAL_UINT16(0, settings.http_port);
+    TEST_ASSERT_EQUAL_UINT16(25, settings.work_minutes);
+
+    char message[96];
+    ConfigParser::formatError(parser.error(0), message, sizeof(message));
+    TEST_ASSERT_EQUAL_STRING("config.ini line 3: unknown key 'colour'", message);
+    ConfigParser::formatError(parser.error(7), message, sizeof(message));
+    TEST_ASSERT_EQUAL_STRING("config.ini: missing required key 'wifi.pass'", message);
+}
+
+void test_parses_flavors(void) {
+    Settings settings;
+    ConfigParser parser(&settings);
+    const std::string text =
+        "[wifi]\nssid=a\npass=b\n[ntp]\nhost=c\n"
+        "[flavors]\n"
+        "count=8\n"
+        "flavor7=reading\n"
+        "color7=#FF8000\n"
+        "work_minutes7=50\n"
+        "color1=red\n"
+        "break_minutes0=61\n";
+    TEST_ASSERT_FALSE(parse(text, &parser, 9));
+    TEST_ASSERT_EQUAL(2, parser.errorCount());
+    TEST_ASSERT_TRUE(ConfigErrorCode::NOT_A_COLOR == parser.error(0).code);
+    TEST_ASSERT_EQUAL_STRING("color1", parser.error(0).name);
+    TEST_ASSERT_TRUE(ConfigErrorCode::OUT_OF_RANGE == parser.error(1).code);
+    TEST_ASSERT_EQUAL_UINT16(8, settings.flavor_count);
+    TEST_ASSERT_EQUAL_STRING("reading", settings.flavors[7].label);
+    TEST_ASSERT_EQUAL_HEX16(0xFC00, settings.flavors[7].color);
+    TEST_ASSERT_EQUAL_UINT16(50, settings.flavors[7].work_minutes);
+    TEST_ASSERT_EQUAL_UINT16(0, settings.flavors[7].break_minutes);
+    TEST_ASSERT_EQUAL_HEX16(DEFAULT_FLAVOR_COLOR, settings.flavors[1].color);
+
+    char message[96];
+    ConfigParser::formatError(parser.error(0), message, sizeof(message));
+    TEST_ASSERT_EQUAL_STRING("config.ini line 11: expected #rrggbb for 'color1'", message);
+}
+
+void test_unknown_keys_are_warnings(void) {
+    Settings settings;
+    ConfigParser parser(&settings);
+    const std::string text =
+        "[wifi]\nssid=a\npass=b\n[ntp]\nhost=c\n"
+        "[future]\n"
+        "feature=on\n"
+        "[audio]\n"
+        "volume=3\n"
+        "warning_minutes=4\n";
+    TEST_ASSERT_TRUE(parse(text, &parser, text.size()));
+    TEST_ASSERT_EQUAL(2, parser.errorCount());
+    TEST_ASSERT_EQUAL(0, parser.fatalErrorCount());
+    TEST_ASSERT_FALSE(configErrorIsFatal(parser.error(1).code));
+    TEST_ASSERT_EQUAL_UINT16(4, settings.warning_minutes);
+}
+
+void test_rejects_long_lines_and_values(void) {
+    const std::string text = "[wifi]\nssid=" + std::string(40, 'x') + "\npass=" + std::string(200, 'y') +
+                             "\n[ntp]\nhost=" + std::string(63, 'z');
+    for (size_t chunk : {text.size(), size_t(7)}) {
+        Settings chunked;
+        ConfigParser chunked_parser(&chunked);
+        TEST_ASSERT_FALSE(parse(text, &chunked_parser, chunk));
+        TEST_ASSERT_EQUAL(4, chunked_parser.errorCount());
+        TEST_ASSERT_TRUE(ConfigErrorCode::VALUE_TOO_LONG == chunked_parser.error(0).code);
+        TEST_ASSERT_EQUAL_UINT16(3, chunked_parser.error(1).line);
+        TEST_ASSERT_TRUE(ConfigErrorCode::LINE_TOO_LONG == chunked_parser.error(1).code);
+        TEST_ASSERT_EQUAL(63, strlen(chunked.ntp_host));
+    }
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_parses_example);
+    RUN_TEST(test_chunking_does_not_matter);
+    RUN_TEST(test_reports_errors_with_line_numbers);
+    RUN_TEST(test_parses_flavors);
+    RUN_TEST(test_unknown_keys_are_warnings);
+    RUN_TEST(test_rejects_long_lines_and_values);
+    return UNITY_END();
+}
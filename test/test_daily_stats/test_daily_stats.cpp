@@ -0,0 +1,199 @@
+#include <unity.h>
+#include <cstdlib>
+#include <cstring>
+#include "DailyStats.h"
+
+class MemoryStore : public CheckpointStore {
+public:
+    size_t load(uint8_t* data, size_t capacity) override {
+        if (size == 0 || size > capacity) {
+            return 0;
+        }
+        memcpy(data, buffer, size);
+        return size;
+    }
+
+    bool save(const uint8_t* data, size_t length) override {
+        memcpy(buffer, data, length);
+        size = length;
+        saves++;
+        return true;
+    }
+
+    uint8_t buffer[64] = {};
+    size_t size = 0;
+    int saves = 0;
+};
+
+// 2025-02-03 09:00 CET, a Monday.
+const time_t MORNING = 1738569600;
+
+PomodoroClock pomodoro;
+
+void setUp(void) {
+    setenv("TZ", "CET-1CEST,M3.5.0,M10.5.0/3", 1);
+    tzset();
+    pomodoro = PomodoroClock();
+}
+
+void tearDown(void) {}
+
+void test_counts_completed_and_cancelled(void) {
+    DailyStats stats;
+    pomodoro.add_observer(stats);
+
+    pomodoro.StartWork(1, 1500, 300, MORNING);
+    pomodoro.PassageOfTime(MORNING + 1500);
+    pomodoro.PassageOfTime(MORNING + 1800);
+    pomodoro.StartWork(2, 1500, 300, MORNING + 2000);
+    pomodoro.Cancel(MORNING + 2600);
+
+    const DailyStatsSnapshot snapshot = stats.snapshot();
+    TEST_ASSERT_EQUAL(1, snapshot.completed);
+    TEST_ASSERT_EQUAL(2100, snapshot.focus_seconds);
+    TEST_ASSERT_EQUAL(1, snapshot.flavors[1].completed);
+    TEST_ASSERT_EQUAL(1500, snapshot.flavors[1].focus_seconds);
+    TEST_ASSERT_EQUAL(0, snapshot.flavors[2].completed);
+    TEST_ASSERT_EQUAL(600, snapshot.flavors[2].focus_seconds);
+}
+
+void test_follows_flavor_changes(void) {
+    DailyStats stats;
+    pomodoro.add_observer(stats);
+
+    pomodoro.StartWork(0, 1500, 300, MORNING);
+    pomodoro.CycleFlavor(MORNING + 10);
+    pomodoro.PassageOfTime(MORNING + 1500);
+
+    const DailyStatsSnapshot snapshot = stats.snapshot();
+    TEST_ASSERT_EQUAL(0, snapshot.flavors[0].completed);
+    TEST_ASSERT_EQUAL(1, snapshot.flavors[1].completed);
+}
+
+void test_rolls_over_at_local_midnight(void) {
+    DailyStats stats;
+    pomodoro.add_observer(stats);
+
+    pomodoro.StartWork(0, 1500, 300, MORNING);
+    pomodoro.PassageOfTime(MORNING + 1500);
+    pomodoro.PassageOfTime(MORNING + 1800);
+    TEST_ASSERT_EQUAL(1, stats.snapshot().completed);
+
+    // 23:59:59 local is still the same day; 00:00:00 is not.
+    pomodoro.PassageOfTime(MORNING + 15 * 3600 - 1);
+    TEST_ASSERT_EQUAL(1, stats.snapshot().completed);
+    pomodoro.PassageOfTime(MORNING + 15 * 3600);
+    TEST_ASSERT_EQUAL(0, stats.snapshot().completed);
+    TEST_ASSERT_EQUAL(0, stats.snapshot().focus_seconds);
+}
+
+void test_checkpoint_survives_restart(void) {
+    MemoryStore store;
+    {
+        DailyStats stats(&store);
+        pomodoro.add_observer(stats);
+        pomodoro.StartWork(2, 1500, 300, MORNING);
+        pomodoro.PassageOfTime(MORNING + 1500);
+        pomodoro.remove_observer(stats);
+    }
+    TEST_ASSERT_EQUAL(1, store.saves);
+    TEST_ASSERT_EQUAL(DailyStats::CHECKPOINT_SIZE, store.size);
+
+    DailyStats restored(&store);
+    pomodoro.add_observer(restored);
+    pomodoro.PassageOfTime(MORNING + 1600);
+    TEST_ASSERT_EQUAL(1, restored.snapshot().completed);
+    TEST_ASSERT_EQUAL(1500, restored.snapshot().flavors[2].focus_seconds);
+}
+
+void test_stale_checkpoint_is_discarded(void) {
+    MemoryStore store;
+    {
+        DailyStats stats(&store);
+        pomodoro.add_observer(stats);
+        pomodoro.StartWork(2, 1500, 300, MORNING);
+        pomodoro.PassageOfTime(MORNING + 1500);
+        pomodoro.remove_observer(stats);
+    }
+
+    DailyStats restored(&store);
+    pomodoro.add_observer(restored);
+    pomodoro.PassageOfTime(MORNING + 86400);
+    TEST_ASSERT_EQUAL(0, restored.snapshot().completed);
+}
+
+void test_rejects_corrupt_checkpoint(void) {
+    DailyStats stats;
+    uint8_t buffer[DailyStats::CHECKPOINT_SIZE] = {0xff};
+    TEST_ASSERT_FALSE(stats.restore(buffer, sizeof(buffer)));
+    TEST_ASSERT_FALSE(stats.restore(buffer, 3));
+}
+
+void test_restores_checkpoint_with_fewer_flavors(void) {
+    DailyStats stats;
+    // Day 100, then three flavors: 2 pomodoros and 3000 s, nothing, 1 and 60 s.
+    const uint8_t three[3 + 3 * 6] = {1, 100, 0, 2, 0, 0xB8, 0x0B, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 60, 0, 0, 0};
+    TEST_ASSERT_TRUE(stats.restore(three, sizeof(three)));
+    const DailyStatsSnapshot snapshot = stats.snapshot();
+    TEST_ASSERT_EQUAL(3, snapshot.completed);
+    TEST_ASSERT_EQUAL(3060, snapshot.focus_seconds);
+    TEST_ASSERT_EQUAL(1, snapshot.flavors[2].completed);
+    TEST_ASSERT_EQUAL(0, snapshot.flavors[3].completed);
+    TEST_ASSERT_FALSE(stats.restore(three, sizeof(three) - 1));
+}
+
+void test_json(void) {
+    DailyStatsSnapshot snapshot = {};
+    snapshot.completed = 2;
+    snapshot.focus_seconds = 3000;
+    snapshot.flavors[0] = {2, 3000};
+    Settings settings;
+    strcpy(settings.flavors[1].label, "lei\"sure");
+    settings.flavors[2].label[0] = '\0';
+    FlavorTable flavors;
+    flavors.build(settings);
+    char json[256];
+
+    const size_t length = formatDailyStatsJson(snapshot, flavors, json, sizeof(json));
+    TEST_ASSERT_EQUAL_STRING("{\"completed\":2,\"focus_seconds\":3000,\"flavors\":["
+                             "{\"flavor\":0,\"label\":\"work\",\"completed\":2,\"focus_seconds\":3000},"
+                             "{\"flavor\":1,\"label\":\"lei\\\"sure\",\"completed\":0,\"focus_seconds\":0},"
+                             "{\"flavor\":2,\"label\":\"2\",\"completed\":0,\"focus_seconds\":0}]}", json);
+    TEST_ASSERT_EQUAL(strlen(json), length);
+    TEST_ASSERT_EQUAL(0, formatDailyStatsJson(snapshot, flavors, json, 20));
+}
+
+void test_json_worst_case_fits(void) {
+    DailyStatsSnapshot snapshot = {};
+    snapshot.completed = UINT16_MAX;
+    snapshot.focus_seconds = UINT32_MAX;
+    Settings settings;
+    settings.flavor_count = MAX_WORK_FLAVORS;
+    for (uint8_t i = 0; i < MAX_WORK_FLAVORS; i++) {
+        snapshot.flavors[i] = {UINT16_MAX, UINT32_MAX};
+        memset(settings.flavors[i].label, 1, sizeof(settings.flavors[i].label) - 1);
+        settings.flavors[i].label[14] = static_cast<char>(2 + i);
+        settings.flavors[i].label[15] = '\0';
+    }
+    FlavorTable flavors;
+    flavors.build(settings);
+    char json[kDailyStatsJsonBytes];
+
+    const size_t length = formatDailyStatsJson(snapshot, flavors, json, sizeof(json));
+    TEST_ASSERT_TRUE(length > 0);
+    TEST_ASSERT_EQUAL(strlen(json), length);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_counts_completed_and_cancelled);
+    RUN_TEST(test_follows_flavor_changes);
+    RUN_TEST(test_rolls_over_at_local_midnight);
+    RUN_TEST(test_checkpoint_survives_restart);
+    RUN_TEST(test_stale_checkpoint_is_discarded);
+    RUN_TEST(test_rejects_corrupt_checkpoint);
+    RUN_TEST(test_restores_checkpoint_with_fewer_flavors);
+    RUN_TEST(test_json);
+    RUN_TEST(test_json_worst_case_fits);
+    return UNITY_END();
+}
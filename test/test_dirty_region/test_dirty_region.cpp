@@ -0,0 +1,188 @@
+#include <unity.h>
+#include <cstdio>
+#include <ctime>
+#include "ClockLayout.h"
+#include "DirtyRegion.h"
+#include "HostFramebuffer.h"
+#include "NumeralAtlas.h"
+
+const int16_t WIDTH = 320;
+const int16_t HEIGHT = 240;
+const uint64_t FULL_FRAME_BYTES = WIDTH * HEIGHT * 2;
+
+FixedFontMetrics metrics;
+
+// `text` points into the frame's own buffers, so a frame is filled in place and never copied.
+struct Frame {
+    char time[16];
+    char date[16];
+    char remaining[16];
+    ClockFrameText text;
+
+    Frame() = default;
+    Frame(const Frame&) = delete;
+    Frame& operator=(const Frame&) = delete;
+};
+
+void fillFrame(Frame* frame, time_t now, PomodoroState state, uint8_t flavor, time_t remaining) {
+    struct tm timeinfo;
+    gmtime_r(&now, &timeinfo);
+    strftime(frame->time, sizeof(frame->time), "%H:%M:%S", &timeinfo);
+    strftime(frame->date, sizeof(frame->date), "%d %m %Y", &timeinfo);
+    snprintf(frame->remaining, sizeof(frame->remaining), "%02d:%02d", static_cast<int>(remaining / 60),
+             static_cast<int>(remaining % 60));
+    frame->text = {state, flavor, clock_colors::kDarkGreen, frame->time, frame->date, "Monday", frame->remaining,
+                   "work", "Today: 3 pomodoros, 75 min", "work 3/75m  leisure 0/0m  chores 0/0m"};
+}
+
+// Renders `layout` into a fresh framebuffer from scratch.
+bool matchesFullRender(const HostFramebuffer& framebuffer, const FrameLayout& layout) {
+    HostFramebuffer reference(WIDTH, HEIGHT);
+    DirtyRenderer renderer(WIDTH, HEIGHT);
+    reference.push(renderer.render(layout, reference));
+    return reference.panel() == framebuffer.panel();
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_rect_operations(void) {
+    const Rect a = {0, 0, 10, 10};
+    const Rect b = {10, 0, 10, 10};
+    const Rect c = {5, 5, 10, 10};
+
+    TEST_ASSERT_TRUE(a.touches(b));
+    TEST_ASSERT_FALSE(a.intersects(b));
+    TEST_ASSERT_TRUE(a.intersects(c));
+    TEST_ASSERT_TRUE((a.united(b) == Rect{0, 0, 20, 10}));
+    TEST_ASSERT_TRUE((a.intersected(c) == Rect{5, 5, 5, 5}));
+    TEST_ASSERT_TRUE(a.intersected(Rect{20, 20, 5, 5}).empty());
+    TEST_ASSERT_FALSE(a.touches(Rect{10, 5, 10, 10}));
+}
+
+void test_region_merges_touching_rects(void) {
+    DirtyRegion region({0, 0, WIDTH, HEIGHT});
+    region.add({0, 0, 10, 10});
+    region.add({100, 100, 10, 10});
+    region.add({10, 0, 10, 10});
+    region.add({-5, 230, 20, 20});
+
+    TEST_ASSERT_EQUAL(3, region.size());
+    TEST_ASSERT_EQUAL(200 + 100 + 150, region.pixels());
+}
+
+void test_region_collapses_on_overflow(void) {
+    DirtyRegion region({0, 0, WIDTH, HEIGHT});
+    for (size_t i = 0; i <= DirtyRegion::kMaxRects; i++) {
+        region.add({static_cast<int16_t>(i * 20), 0, 5, 5});
+    }
+
+    TEST_ASSERT_EQUAL(1, region.size());
+    TEST_ASSERT_TRUE((region[0] == Rect{0, 0, DirtyRegion::kMaxRects * 20 + 5, 5}));
+}
+
+void test_seconds_tick_pushes_one_cell(void) {
+    HostFramebuffer framebuffer(WIDTH, HEIGHT);
+    DirtyRenderer renderer(WIDTH, HEIGHT);
+    FrameLayout layout;
+
+    Frame frame;
+    fillFrame(&frame, 1738569600, IDLE, 0, 0);
+    layoutClockFrame(frame.text, metrics, WIDTH, HEIGHT, &layout);
+    framebuffer.push(renderer.render(layout, framebuffer));
+    TEST_ASSERT_TRUE(renderer.lastFrameWasFull());
+    TEST_ASSERT_EQUAL(FULL_FRAME_BYTES, framebuffer.bytesPushed());
+
+    framebuffer.resetCounters();
+    fillFrame(&frame, 1738569601, IDLE, 0, 0);
+    layoutClockFrame(frame.text, metrics, WIDTH, HEIGHT, &layout);
+    framebuffer.push(renderer.render(layout, framebuffer));
+    TEST_ASSERT_FALSE(renderer.lastFrameWasFull());
+    TEST_ASSERT_EQUAL(32 * 48 * 2, framebuffer.bytesPushed());
+    TEST_ASSERT_TRUE(matchesFullRender(framebuffer, layout));
+}
+
+void test_an_hour_of_frames(void) {
+    HostFramebuffer framebuffer(WIDTH, HEIGHT);
+    DirtyRenderer renderer(WIDTH, HEIGHT);
+    FrameLayout layout;
+    const time_t start = 1738569600;
+
+    for (time_t now = start; now < start + 3600; now++) {
+        const PomodoroState state = now < start + 1500 ? WORK : (now < start + 1800 ? BREAK : IDLE);
+        const time_t ends = state == WORK ? start + 1500 : start + 1800;
+        Frame frame;
+        fillFrame(&frame, now, state, 1, state == IDLE ? 0 : ends - now);
+        layoutClockFrame(frame.text, metrics, WIDTH, HEIGHT, &layout);
+        framebuffer.push(renderer.render(layout, framebuffer));
+        if (now % 97 == 0) {
+            TEST_ASSERT_TRUE(matchesFullRender(framebuffer, layout));
+        }
+    }
+
+    // Three full repaints (start, work->break, break->idle); everything else is a few cells.
+    const uint64_t average = framebuffer.bytesPushed() / 3600;
+    TEST_ASSERT_LESS_THAN(FULL_FRAME_BYTES / 20, average);
+    TEST_ASSERT_TRUE(matchesFullRender(framebuffer, layout));
+}
+
+void test_flavor_change_repaints_everything(void) {
+    HostFramebuffer framebuffer(WIDTH, HEIGHT);
+    DirtyRenderer renderer(WIDTH, HEIGHT);
+    FrameLayout layout;
+
+    Frame frame;
+    fillFrame(&frame, 1738569600, WORK, 0, 1500);
+    layoutClockFrame(frame.text, metrics, WIDTH, HEIGHT, &layout);
+    renderer.render(layout, framebuffer);
+    fillFrame(&frame, 1738569601, WORK, 1, 1499);
+    layoutClockFrame(frame.text, metrics, WIDTH, HEIGHT, &layout);
+    const DirtyRegion& dirty = renderer.render(layout, framebuffer);
+
+    TEST_ASSERT_TRUE(renderer.lastFrameWasFull());
+    TEST_ASSERT_EQUAL(WIDTH * HEIGHT, dirty.pixels());
+}
+
+void test_numeral_lines_use_fixed_cells(void) {
+    FrameLayout layout;
+    Frame frame;
+    fillFrame(&frame, 1738569600, WORK, 0, 1500);
+    layoutClockFrame(frame.text, metrics, WIDTH, HEIGHT, &layout);
+
+    // Flavor label, clock, countdown.
+    TEST_ASSERT_EQUAL(3, layout.runs);
+    const TextRun& clock = layout.run[1];
+    const TextRun& countdown = layout.run[2];
+    TEST_ASSERT_EQUAL(numeral_atlas::kFont, clock.font);
+    TEST_ASSERT_EQUAL(8, clock.length);
+    TEST_ASSERT_EQUAL(WIDTH / 2 - 108, clock.cell_x[0]);
+    TEST_ASSERT_EQUAL(WIDTH / 2 - 108 + 2 * 32 + 12, clock.cell_x[3]);
+    TEST_ASSERT_EQUAL(WIDTH / 2 + 108, clock.cell_x[8]);
+    TEST_ASSERT_EQUAL(HEIGHT / 2 - 60, clock.y);
+    TEST_ASSERT_EQUAL(5, countdown.length);
+    TEST_ASSERT_EQUAL(WIDTH / 2 - 70, countdown.cell_x[0]);
+    TEST_ASSERT_EQUAL(HEIGHT / 2, countdown.y);
+}
+
+void test_numeral_pattern_matching(void) {
+    TEST_ASSERT_TRUE(numeral_atlas::matches("12:34:56", numeral_atlas::kClockPattern));
+    TEST_ASSERT_FALSE(numeral_atlas::matches("12:34", numeral_atlas::kClockPattern));
+    TEST_ASSERT_TRUE(numeral_atlas::matches("25:00", numeral_atlas::kCountdownPattern));
+    TEST_ASSERT_FALSE(numeral_atlas::matches("25:000", numeral_atlas::kCountdownPattern));
+    TEST_ASSERT_FALSE(numeral_atlas::matches("--:--", numeral_atlas::kCountdownPattern));
+    TEST_ASSERT_EQUAL(10 * 32, numeral_atlas::atlasX(':'));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_rect_operations);
+    RUN_TEST(test_region_merges_touching_rects);
+    RUN_TEST(test_region_collapses_on_overflow);
+    RUN_TEST(test_seconds_tick_pushes_one_cell);
+    RUN_TEST(test_an_hour_of_frames);
+    RUN_TEST(test_flavor_change_repaints_everything);
+    RUN_TEST(test_numeral_lines_use_fixed_cells);
+    RUN_TEST(test_numeral_pattern_matching);
+    return UNITY_END();
+}
@@ -0,0 +1,96 @@
+#include <unity.h>
+#include <cstring>
+#include "FlavorTable.h"
+
+// Every character as wide as its font id, so widths are easy to check.
+class FixedMetrics final : public FontMetrics {
+public:
+    int16_t charWidth(uint8_t font, char) const override { return font; }
+    int16_t height(uint8_t font) const override { return static_cast<int16_t>(font * 2); }
+};
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_defaults(void) {
+    const FlavorTable flavors;
+    TEST_ASSERT_EQUAL(DEFAULT_WORK_FLAVORS, flavors.size());
+    TEST_ASSERT_EQUAL_STRING("work", flavors.label(0));
+    TEST_ASSERT_EQUAL_STRING("chores", flavors.label(2));
+    TEST_ASSERT_EQUAL(WORK_DEFAULT_DURATION_SECONDS, flavors.workSeconds(1));
+    TEST_ASSERT_EQUAL(BREAK_DEFAULT_DURATION_SECONDS, flavors.breakSeconds(1));
+    TEST_ASSERT_EQUAL_HEX16(DEFAULT_FLAVOR_COLOR, flavors.color(2));
+    // Past the count: flavor 0.
+    TEST_ASSERT_EQUAL_STRING("work", flavors.label(5));
+}
+
+void test_builds_from_settings(void) {
+    Settings settings;
+    settings.flavor_count = 5;
+    settings.work_minutes = 40;
+    strcpy(settings.flavors[1].label, "say \"hi\"\\");
+    settings.flavors[3].label[0] = '\0';
+    strcpy(settings.flavors[4].label, "tab\there");
+    settings.flavors[4].color = 0xF800;
+    settings.flavors[4].work_minutes = 90;
+    settings.flavors[4].break_minutes = 15;
+    FlavorTable flavors;
+    flavors.build(settings);
+
+    TEST_ASSERT_EQUAL(5, flavors.size());
+    TEST_ASSERT_EQUAL_STRING("say \"hi\"\\", flavors.label(1));
+    TEST_ASSERT_EQUAL_STRING("say \\\"hi\\\"\\\\", flavors.jsonLabel(1));
+    TEST_ASSERT_EQUAL_STRING("3", flavors.label(3));
+    TEST_ASSERT_EQUAL_STRING("tab\\u0009here", flavors.jsonLabel(4));
+    TEST_ASSERT_EQUAL_HEX16(0xF800, flavors.color(4));
+    TEST_ASSERT_EQUAL(40 * 60, flavors.workSeconds(0));
+    TEST_ASSERT_EQUAL(90 * 60, flavors.workSeconds(4));
+    TEST_ASSERT_EQUAL(15 * 60, flavors.breakSeconds(4));
+    TEST_ASSERT_EQUAL_STRING("work", flavors.label(5));
+}
+
+void test_interns_equal_labels(void) {
+    Settings settings;
+    settings.flavor_count = 4;
+    strcpy(settings.flavors[2].label, "work");
+    strcpy(settings.flavors[3].label, "work");
+    FlavorTable flavors;
+    flavors.build(settings);
+
+    // "work" and "leisure" once each; nothing to escape, so the JSON label is the same string.
+    TEST_ASSERT_EQUAL(strlen("work") + 1 + strlen("leisure") + 1, flavors.poolUsed());
+    TEST_ASSERT_TRUE(flavors.label(0) == flavors.label(3));
+    TEST_ASSERT_TRUE(flavors.label(0) == flavors.jsonLabel(2));
+}
+
+void test_worst_case_fits(void) {
+    Settings settings;
+    settings.flavor_count = MAX_WORK_FLAVORS;
+    for (uint8_t flavor = 0; flavor < MAX_WORK_FLAVORS; flavor++) {
+        memset(settings.flavors[flavor].label, 1 + flavor, sizeof(settings.flavors[flavor].label) - 1);
+        settings.flavors[flavor].label[sizeof(settings.flavors[flavor].label) - 1] = '\0';
+    }
+    FlavorTable flavors;
+    flavors.build(settings);
+    TEST_ASSERT_EQUAL(FlavorTable::kPoolBytes, flavors.poolUsed());
+    TEST_ASSERT_EQUAL(15 * 6, strlen(flavors.jsonLabel(MAX_WORK_FLAVORS - 1)));
+}
+
+void test_measures_labels(void) {
+    FlavorTable flavors;
+    const FixedMetrics metrics;
+    flavors.measure(metrics, 2);
+    TEST_ASSERT_EQUAL(2 * 4, flavors.labelWidth(0));
+    TEST_ASSERT_EQUAL(2 * 7, flavors.labelWidth(1));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_defaults);
+    RUN_TEST(test_builds_from_settings);
+    RUN_TEST(test_interns_equal_labels);
+    RUN_TEST(test_worst_case_fits);
+    RUN_TEST(test_measures_labels);
+    return UNITY_END();
+}
@@ -0,0 +1,116 @@
+#include <unity.h>
+#include <thread>
+#include <vector>
+#include "FrameStaging.h"
+#include "Mailbox.h"
+
+const int16_t WIDTH = 32;
+const int16_t HEIGHT = 16;
+
+std::vector<uint16_t> makeFrame() {
+    std::vector<uint16_t> frame(WIDTH * HEIGHT);
+    for (int16_t y = 0; y < HEIGHT; y++) {
+        for (int16_t x = 0; x < WIDTH; x++) {
+            frame[y * WIDTH + x] = static_cast<uint16_t>(y << 8 | x);
+        }
+    }
+    return frame;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_stages_rects_contiguously(void) {
+    const std::vector<uint16_t> frame = makeFrame();
+    uint16_t storage[64];
+    FrameStaging staging;
+    staging.attach(storage, 64);
+    DirtyRegion region({0, 0, WIDTH, HEIGHT});
+    region.add({2, 3, 4, 2});
+    region.add({20, 10, 3, 3});
+
+    TEST_ASSERT_TRUE(staging.stage(frame.data(), WIDTH, HEIGHT, region));
+    TEST_ASSERT_EQUAL(2, staging.size());
+    TEST_ASSERT_EQUAL(8 + 9, staging.pixelCount());
+    TEST_ASSERT_EQUAL_HEX16(3 << 8 | 2, staging.pixels(0)[0]);
+    TEST_ASSERT_EQUAL_HEX16(4 << 8 | 5, staging.pixels(0)[7]);
+    TEST_ASSERT_TRUE(staging.pixels(1) == storage + 8);
+    TEST_ASSERT_EQUAL_HEX16(12 << 8 | 22, staging.pixels(1)[8]);
+}
+
+void test_clips_to_frame(void) {
+    const std::vector<uint16_t> frame = makeFrame();
+    uint16_t storage[64];
+    FrameStaging staging;
+    staging.attach(storage, 64);
+    DirtyRegion region;
+    region.add({30, 14, 4, 4});
+
+    TEST_ASSERT_TRUE(staging.stage(frame.data(), WIDTH, HEIGHT, region));
+    TEST_ASSERT_EQUAL(1, staging.size());
+    TEST_ASSERT_TRUE((staging.rect(0) == Rect{30, 14, 2, 2}));
+    TEST_ASSERT_EQUAL_HEX16(15 << 8 | 31, staging.pixels(0)[3]);
+}
+
+void test_rejects_regions_that_do_not_fit(void) {
+    const std::vector<uint16_t> frame = makeFrame();
+    uint16_t storage[16];
+    FrameStaging staging;
+    staging.attach(storage, 16);
+    DirtyRegion region({0, 0, WIDTH, HEIGHT});
+    region.add({0, 0, 4, 4});
+    TEST_ASSERT_TRUE(staging.stage(frame.data(), WIDTH, HEIGHT, region));
+    region.add({10, 10, 1, 1});
+
+    TEST_ASSERT_FALSE(staging.stage(frame.data(), WIDTH, HEIGHT, region));
+    TEST_ASSERT_EQUAL(0, staging.size());
+
+    FrameStaging detached;
+    TEST_ASSERT_FALSE(detached.stage(frame.data(), WIDTH, HEIGHT, region));
+}
+
+void test_mailbox_keeps_newest(void) {
+    Mailbox<int> mailbox;
+    int value = 0;
+    TEST_ASSERT_FALSE(mailbox.take(&value));
+    TEST_ASSERT_FALSE(mailbox.post(1));
+    TEST_ASSERT_TRUE(mailbox.post(2));
+    TEST_ASSERT_TRUE(mailbox.post(3));
+    TEST_ASSERT_TRUE(mailbox.take(&value));
+    TEST_ASSERT_EQUAL(3, value);
+    TEST_ASSERT_FALSE(mailbox.take(&value));
+    TEST_ASSERT_EQUAL_UINT32(2, mailbox.replaced());
+}
+
+void test_mailbox_across_threads(void) {
+    Mailbox<int> mailbox;
+    const int posts = 100000;
+    std::thread producer([&mailbox]() {
+        for (int i = 1; i <= posts; i++) {
+            mailbox.post(i);
+        }
+    });
+    int last = 0;
+    uint32_t taken = 0;
+    while (last != posts) {
+        int value;
+        if (mailbox.take(&value)) {
+            TEST_ASSERT_TRUE(value > last);
+            last = value;
+            taken++;
+        }
+    }
+    producer.join();
+    TEST_ASSERT_EQUAL_UINT32(posts, taken + mailbox.replaced());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_stages_rects_contiguously);
+    RUN_TEST(test_clips_to_frame);
+    RUN_TEST(test_rejects_regions_that_do_not_fit);
+    RUN_TEST(test_mailbox_keeps_newest);
+    RUN_TEST(test_mailbox_across_threads);
+    return UNITY_END();
+}
@@ -0,0 +1,65 @@
+#include <unity.h>
+#include <cstring>
+#include "FrameTiming.h"
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_monotonic_micros(void) {
+    const uint64_t start = monotonicMicros();
+    while (monotonicMicros() - start < 2000) {
+    }
+    TEST_ASSERT_TRUE(monotonicMicros() >= start + 2000);
+}
+
+void test_summary_of_a_histogram(void) {
+    Histogram histogram("display.render_us");
+    for (uint32_t i = 0; i < 98; i++) {
+        histogram.record(1000);
+    }
+    histogram.record(40000);
+    histogram.record(1200);
+
+    char line[128];
+    TEST_ASSERT_GREATER_THAN(0, formatLatencySummary(histogram.sample(), line, sizeof(line)));
+    // 1000 falls in [512, 1024) and 1200 in [1024, 2048); percentiles report the bucket's upper bound.
+    TEST_ASSERT_EQUAL_STRING("display.render_us: n=100 p50<=1023us p90<=1023us p99<=2047us max=40000us", line);
+}
+
+void test_scoped_metric(void) {
+    Histogram histogram("scoped");
+    const uint64_t start = monotonicMicros();
+    {
+        ScopedMetric timing(histogram);
+        while (monotonicMicros() - start < 2000) {
+        }
+    }
+    const MetricSample sample = histogram.sample();
+    TEST_ASSERT_EQUAL_UINT32(1, sample.value);
+    TEST_ASSERT_TRUE(sample.hmax >= 1900);
+}
+
+void test_format(void) {
+    MetricSample sample = {};
+    sample.name = "render";
+    sample.kind = MetricKind::HISTOGRAM;
+    sample.value = 3;
+    sample.p50 = 15;
+    sample.p90 = 15;
+    sample.p99 = 31;
+    sample.hmax = 20;
+    char line[128];
+    TEST_ASSERT_GREATER_THAN(0, formatLatencySummary(sample, line, sizeof(line)));
+    TEST_ASSERT_EQUAL_STRING("render: n=3 p50<=15us p90<=15us p99<=31us max=20us", line);
+    TEST_ASSERT_EQUAL(0, formatLatencySummary(sample, line, 10));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_monotonic_micros);
+    RUN_TEST(test_summary_of_a_histogram);
+    RUN_TEST(test_scoped_metric);
+    RUN_TEST(test_format);
+    return UNITY_END();
+}
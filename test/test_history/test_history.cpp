@@ -0,0 +1,103 @@
+#include <unity.h>
+#include <cstdlib>
+#include <cstring>
+#include "History.h"
+
+void setUp(void) {
+    setenv("TZ", "CET-1CEST,M3.5.0,M10.5.0/3", 1);
+    tzset();
+}
+
+void tearDown(void) {}
+
+void test_record_round_trip(void) {
+    const HistoryRecord record = {1738490400, 1738491900, 2, HistoryOutcome::CANCELLED, 20121};
+    uint8_t buffer[HISTORY_RECORD_SIZE];
+    encodeHistoryRecord(record, buffer);
+
+    TEST_ASSERT_EQUAL_HEX8(0x20, buffer[0]);
+    const HistoryRecord decoded = decodeHistoryRecord(buffer);
+    TEST_ASSERT_EQUAL_UINT32(record.start, decoded.start);
+    TEST_ASSERT_EQUAL_UINT32(record.end, decoded.end);
+    TEST_ASSERT_EQUAL_UINT8(2, decoded.flavor);
+    TEST_ASSERT_TRUE(decoded.outcome == HistoryOutcome::CANCELLED);
+    TEST_ASSERT_EQUAL_UINT16(20121, decoded.day);
+}
+
+void test_index_entry_round_trip(void) {
+    const HistoryIndexEntry entry = {20121, 123456};
+    uint8_t buffer[HISTORY_INDEX_ENTRY_SIZE];
+    encodeHistoryIndexEntry(entry, buffer);
+
+    const HistoryIndexEntry decoded = decodeHistoryIndexEntry(buffer);
+    TEST_ASSERT_EQUAL_UINT16(20121, decoded.day);
+    TEST_ASSERT_EQUAL_UINT32(123456, decoded.first_record);
+}
+
+void test_days_from_civil(void) {
+    TEST_ASSERT_EQUAL_INT32(0, daysFromCivil(1970, 1, 1));
+    TEST_ASSERT_EQUAL_INT32(20121, daysFromCivil(2025, 2, 2));
+    TEST_ASSERT_EQUAL_INT32(-1, daysFromCivil(1969, 12, 31));
+}
+
+void test_local_day_uses_local_midnight(void) {
+    // 2025-02-02 23:30 UTC is already 2025-02-03 in CET.
+    TEST_ASSERT_EQUAL_UINT16(20122, localDay(1738539000));
+    TEST_ASSERT_EQUAL_UINT16(20121, localDay(1738535000));
+}
+
+void test_index_counts_today(void) {
+    HistoryIndex index;
+    HistoryIndexEntry entry;
+
+    TEST_ASSERT_TRUE(index.append({0, 0, 0, HistoryOutcome::COMPLETED, 10}, &entry));
+    TEST_ASSERT_EQUAL_UINT32(0, entry.first_record);
+    TEST_ASSERT_FALSE(index.append({0, 0, 0, HistoryOutcome::COMPLETED, 10}, &entry));
+    TEST_ASSERT_TRUE(index.append({0, 0, 0, HistoryOutcome::COMPLETED, 11}, &entry));
+    TEST_ASSERT_EQUAL_UINT16(11, entry.day);
+    TEST_ASSERT_EQUAL_UINT32(2, entry.first_record);
+    TEST_ASSERT_FALSE(index.append({0, 0, 0, HistoryOutcome::CANCELLED, 11}, &entry));
+
+    TEST_ASSERT_EQUAL_UINT32(4, index.records());
+    TEST_ASSERT_EQUAL_UINT32(2, index.recordsOnDay(11));
+    TEST_ASSERT_EQUAL_UINT32(0, index.recordsOnDay(10));
+    TEST_ASSERT_EQUAL_UINT32(0, index.recordsOnDay(12));
+}
+
+void test_index_reset_from_disk(void) {
+    HistoryIndex index;
+    const HistoryIndexEntry last = {42, 100};
+    index.reset(103, &last);
+
+    TEST_ASSERT_EQUAL_UINT32(3, index.recordsOnDay(42));
+    HistoryIndexEntry entry;
+    TEST_ASSERT_FALSE(index.append({0, 0, 0, HistoryOutcome::COMPLETED, 42}, &entry));
+    TEST_ASSERT_EQUAL_UINT32(4, index.recordsOnDay(42));
+
+    index.reset(5, nullptr);
+    TEST_ASSERT_EQUAL_UINT32(0, index.recordsOnDay(42));
+    TEST_ASSERT_TRUE(index.append({0, 0, 0, HistoryOutcome::COMPLETED, 42}, &entry));
+    TEST_ASSERT_EQUAL_UINT32(5, entry.first_record);
+}
+
+void test_csv_line(void) {
+    const HistoryRecord record = {1738490400, 1738491900, 1, HistoryOutcome::COMPLETED, 0};
+    char line[64];
+    const size_t length = formatHistoryCsvLine(record, line, sizeof(line));
+
+    TEST_ASSERT_EQUAL_STRING("2025-02-02 11:00:00,2025-02-02 11:25:00,1\n", line);
+    TEST_ASSERT_EQUAL(strlen(line), length);
+    TEST_ASSERT_EQUAL(0, formatHistoryCsvLine(record, line, 10));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_record_round_trip);
+    RUN_TEST(test_index_entry_round_trip);
+    RUN_TEST(test_days_from_civil);
+    RUN_TEST(test_local_day_uses_local_midnight);
+    RUN_TEST(test_index_counts_today);
+    RUN_TEST(test_index_reset_from_disk);
+    RUN_TEST(test_csv_line);
+    return UNITY_END();
+}
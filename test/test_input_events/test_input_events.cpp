@@ -0,0 +1,67 @@
+#include <unity.h>
+#include "InputEvents.h"
+
+const time_t NOW = 1738569600;
+
+// Feeds `raw` every 5 ms from `from_us` until `to_us`; returns the events seen.
+size_t run(ButtonDebouncer& debouncer, uint8_t raw, uint64_t from_us, uint64_t to_us, InputEvent* out) {
+    size_t events = 0;
+    for (uint64_t us = from_us; us < to_us; us += 5000) {
+        events += debouncer.sample(raw, us, NOW + static_cast<time_t>(us / 1000000), out + events);
+    }
+    return events;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_press_is_stamped_at_first_contact(void) {
+    ButtonDebouncer debouncer;
+    InputEvent events[16];
+    TEST_ASSERT_EQUAL(0, run(debouncer, 0, 0, 990000, events));
+    TEST_ASSERT_EQUAL(1, run(debouncer, 0b010, 995000, 1100000, events));
+    TEST_ASSERT_TRUE(events[0].button == Button::B);
+    TEST_ASSERT_EQUAL_UINT64(995000, events[0].pressed_us);
+    TEST_ASSERT_EQUAL(NOW, events[0].pressed_at);
+    // Holding and releasing produce nothing more.
+    TEST_ASSERT_EQUAL(0, run(debouncer, 0, 1100000, 1200000, events));
+}
+
+void test_glitches_are_dropped(void) {
+    ButtonDebouncer debouncer;
+    InputEvent events[16];
+    // 10 ms of contact is shorter than the debounce time.
+    TEST_ASSERT_EQUAL(0, run(debouncer, 0b001, 0, 10000, events));
+    TEST_ASSERT_EQUAL(0, run(debouncer, 0, 10000, 50000, events));
+    // Bouncing contact: the press is stamped at the last edge before it settled.
+    size_t count = 0;
+    for (int i = 0; i < 4; i++) {
+        count += run(debouncer, static_cast<uint8_t>(i % 2 == 0 ? 1 : 0), 50000 + i * 5000, 55000 + i * 5000, events);
+    }
+    count += run(debouncer, 1, 70000, 100000, events + count);
+    TEST_ASSERT_EQUAL(1, count);
+    TEST_ASSERT_EQUAL_UINT64(70000, events[0].pressed_us);
+}
+
+void test_buttons_are_independent(void) {
+    ButtonDebouncer debouncer;
+    InputEvent events[16];
+    size_t count = run(debouncer, 0b101, 0, 20000, events);
+    TEST_ASSERT_EQUAL(2, count);
+    TEST_ASSERT_TRUE(events[0].button == Button::A);
+    TEST_ASSERT_TRUE(events[1].button == Button::C);
+    // A released and pressed again while C is held.
+    count = run(debouncer, 0b100, 20000, 40000, events);
+    count += run(debouncer, 0b101, 40000, 60000, events + count);
+    TEST_ASSERT_EQUAL(1, count);
+    TEST_ASSERT_TRUE(events[0].button == Button::A);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_press_is_stamped_at_first_contact);
+    RUN_TEST(test_glitches_are_dropped);
+    RUN_TEST(test_buttons_are_independent);
+    return UNITY_END();
+}
@@ -0,0 +1,221 @@
+#include <unity.h>
+#include <vector>
+#include "Journal.h"
+
+// Digests a whole notification stream, to compare a live run with its replay.
+class StreamDigest final : public PomodoroObserver {
+public:
+    EventDigest digest;
+
+    void notification(ClockUpdate update) override { digest.add(update); }
+    void notification(IdleToWork update) override { digest.add(update); }
+    void notification(WorkToBreak update) override { digest.add(update); }
+    void notification(BreakToIdle update) override { digest.add(update); }
+    void notification(WorkToIdle update) override { digest.add(update); }
+    void notification(AdditionalWork update) override { digest.add(update); }
+};
+
+struct Recording {
+    PomodoroClock clock;
+    Journal journal;
+    StreamDigest stream;
+
+    Recording() : journal(clock) {
+        clock.add_observer(journal);
+        clock.add_observer(stream);
+        clock.SetRecorder(&journal);
+    }
+
+    std::vector<uint8_t> file() const {
+        std::vector<uint8_t> bytes;
+        journal.write(
+            [](const uint8_t* data, size_t size, void* context) {
+                auto* out = static_cast<std::vector<uint8_t>*>(context);
+                out->insert(out->end(), data, data + size);
+            },
+            &bytes);
+        return bytes;
+    }
+};
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// A few pomodoros with every kind of input, one tick a second.
+time_t playDay(PomodoroClock& clock, time_t now, int pomodoros) {
+    for (int i = 0; i < pomodoros; i++) {
+        clock.StartWork(static_cast<uint8_t>(i % DEFAULT_WORK_FLAVORS), 25 * 60, 5 * 60, now);
+        for (int second = 0; second < 40 * 60; second++, now++) {
+            if (second == 100) {
+                clock.CycleFlavor(now);
+            }
+            if (second == 600 && i % 2) {
+                clock.ExtendWork(5 * 60, now);
+            }
+            if (second == 700 && i % 3 == 2) {
+                clock.Cancel(now);
+            }
+            clock.PassageOfTime(now);
+        }
+    }
+    return now;
+}
+
+void test_replay_reproduces_the_notifications(void) {
+    Recording recording;
+    time_t now = playDay(recording.clock, 1738569600, 6);
+    recording.clock.Adopt({WORK, 2, now + 600, 120}, now);
+    for (int second = 0; second < 900; second++, now++) {
+        recording.clock.PassageOfTime(now);
+    }
+    const std::vector<uint8_t> file = recording.file();
+
+    PomodoroClock replayed;
+    StreamDigest stream;
+    replayed.add_observer(stream);
+    const JournalReplay result = replayJournal(file.data(), file.size(), replayed);
+    TEST_ASSERT_FALSE(result.malformed);
+    TEST_ASSERT_EQUAL(0, result.mismatched);
+    TEST_ASSERT_EQUAL(-1, result.first_mismatch);
+    TEST_ASSERT_EQUAL(recording.journal.inputs(), result.inputs);
+    TEST_ASSERT_EQUAL(recording.journal.blocks(), result.blocks);
+    TEST_ASSERT_EQUAL(recording.stream.digest.count(), stream.digest.count());
+    TEST_ASSERT_EQUAL_UINT32(recording.stream.digest.hash(), stream.digest.hash());
+    TEST_ASSERT_EQUAL(recording.clock.State(), replayed.State());
+    TEST_ASSERT_EQUAL(recording.clock.Snapshot().state_ends_at, replayed.Snapshot().state_ends_at);
+}
+
+void test_replay_uses_the_recorded_flavor_count(void) {
+    Recording recording;
+    recording.clock.SetFlavorCount(5);
+    time_t now = 1738569600;
+    recording.clock.StartWork(3, 25 * 60, 5 * 60, now);
+    recording.clock.CycleFlavor(++now);
+    recording.clock.CycleFlavor(++now);
+    const std::vector<uint8_t> file = recording.file();
+    TEST_ASSERT_EQUAL(5, file[5]);
+
+    PomodoroClock replayed;
+    const JournalReplay result = replayJournal(file.data(), file.size(), replayed);
+    TEST_ASSERT_EQUAL(0, result.mismatched);
+    TEST_ASSERT_EQUAL(5, replayed.FlavorCount());
+    TEST_ASSERT_EQUAL(0, replayed.Snapshot().work_flavor);
+
+    // Format 1 had no count byte; its clocks had the default flavors.
+    std::vector<uint8_t> old(file.begin(), file.begin() + 5);
+    old[4] = 1;
+    replayed.SetFlavorCount(5);
+    TEST_ASSERT_FALSE(replayJournal(old.data(), old.size(), replayed).malformed);
+    TEST_ASSERT_EQUAL(DEFAULT_WORK_FLAVORS, replayed.FlavorCount());
+}
+
+void test_ticks_take_almost_no_room(void) {
+    Recording recording;
+    time_t now = 1738569600;
+    for (int second = 0; second < 3600; second++, now++) {
+        recording.clock.PassageOfTime(now);
+    }
+    // Header, one block header, the first tick and a run of the rest.
+    TEST_ASSERT_TRUE(recording.file().size() <= kJournalFileHeaderBytes + kJournalBlockHeaderBytes + 4);
+    // A whole pomodoro with a press or two still fits a single block.
+    playDay(recording.clock, now, 1);
+    TEST_ASSERT_EQUAL(1, recording.journal.blocks());
+    TEST_ASSERT_EQUAL(3600 + 40 * 60 + 2, recording.journal.inputs());
+}
+
+void test_ring_keeps_the_newest_blocks_and_still_verifies(void) {
+    Recording recording;
+    time_t now = 1738569600;
+    // Presses every few seconds fill blocks quickly.
+    for (int i = 0; i < 20000; i++, now += 3) {
+        if (recording.clock.State() == IDLE) {
+            recording.clock.StartWork(static_cast<uint8_t>(i % DEFAULT_WORK_FLAVORS), 60 + i % 50, 30, now);
+        } else if (i % 7 == 0) {
+            recording.clock.Cancel(now);
+        } else {
+            recording.clock.PassageOfTime(now);
+        }
+    }
+    TEST_ASSERT_EQUAL(Journal::kBlocks, recording.journal.blocks());
+    TEST_ASSERT_TRUE(recording.journal.droppedBlocks() > 0);
+    const std::vector<uint8_t> file = recording.file();
+    TEST_ASSERT_TRUE(file.size() <= kJournalFileHeaderBytes
+                     + Journal::kBlocks * (kJournalBlockHeaderBytes + Journal::kBlockBytes));
+
+    // The replay starts mid-pomodoro, from the oldest block kept.
+    PomodoroClock replayed;
+    const JournalReplay result = replayJournal(file.data(), file.size(), replayed);
+    TEST_ASSERT_FALSE(result.malformed);
+    TEST_ASSERT_EQUAL(Journal::kBlocks, result.blocks);
+    TEST_ASSERT_EQUAL(0, result.mismatched);
+    TEST_ASSERT_EQUAL(recording.clock.Snapshot().state, replayed.Snapshot().state);
+    TEST_ASSERT_EQUAL(recording.clock.Snapshot().state_ends_at, replayed.Snapshot().state_ends_at);
+}
+
+void test_a_different_outcome_is_caught(void) {
+    Recording recording;
+    playDay(recording.clock, 1738569600, 2);
+    std::vector<uint8_t> file = recording.file();
+    // The first input is a start; lengthen its work period.
+    const size_t start = kJournalFileHeaderBytes + kJournalBlockHeaderBytes;
+    TEST_ASSERT_EQUAL_HEX8(2 << 5, file[start]);
+    file[start + 2]++;
+
+    PomodoroClock replayed;
+    const JournalReplay result = replayJournal(file.data(), file.size(), replayed);
+    TEST_ASSERT_FALSE(result.malformed);
+    TEST_ASSERT_EQUAL(1, result.mismatched);
+    TEST_ASSERT_EQUAL(0, result.first_mismatch);
+}
+
+void test_malformed_files_are_rejected(void) {
+    Recording recording;
+    playDay(recording.clock, 1738569600, 1);
+    const std::vector<uint8_t> file = recording.file();
+
+    PomodoroClock replayed;
+    std::vector<uint8_t> bad = file;
+    bad[0] = 'X';
+    JournalReplay result = replayJournal(bad.data(), bad.size(), replayed);
+    TEST_ASSERT_TRUE(result.malformed);
+    TEST_ASSERT_EQUAL(0, result.blocks);
+
+    // Cut inside the block: its length runs past the end.
+    bad.assign(file.begin(), file.end() - 1);
+    result = replayJournal(bad.data(), bad.size(), replayed);
+    TEST_ASSERT_TRUE(result.malformed);
+
+    // An unknown input kind.
+    bad = file;
+    bad[kJournalFileHeaderBytes + kJournalBlockHeaderBytes] = 7 << 5;
+    result = replayJournal(bad.data(), bad.size(), replayed);
+    TEST_ASSERT_TRUE(result.malformed);
+
+    result = replayJournal(file.data(), kJournalFileHeaderBytes, replayed);
+    TEST_ASSERT_FALSE(result.malformed);
+    TEST_ASSERT_EQUAL(0, result.blocks);
+}
+
+void test_clear_starts_over(void) {
+    Recording recording;
+    const time_t now = playDay(recording.clock, 1738569600, 1);
+    recording.journal.clear();
+    TEST_ASSERT_EQUAL(0, recording.journal.blocks());
+    TEST_ASSERT_EQUAL(kJournalFileHeaderBytes, recording.file().size());
+    recording.clock.StartWork(1, 60, 30, now);
+    TEST_ASSERT_EQUAL(1, recording.journal.blocks());
+    TEST_ASSERT_EQUAL(1, recording.journal.inputs());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_replay_reproduces_the_notifications);
+    RUN_TEST(test_replay_uses_the_recorded_flavor_count);
+    RUN_TEST(test_ticks_take_almost_no_room);
+    RUN_TEST(test_ring_keeps_the_newest_blocks_and_still_verifies);
+    RUN_TEST(test_a_different_outcome_is_caught);
+    RUN_TEST(test_malformed_files_are_rejected);
+    RUN_TEST(test_clear_starts_over);
+    return UNITY_END();
+}
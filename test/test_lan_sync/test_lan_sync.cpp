@@ -0,0 +1,340 @@
+#include <unity.h>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "LanSync.h"
+
+// Every peer's datagrams go to every other peer, one round per simulated second; the bus can
+// lose, duplicate and reorder them.
+struct Bus {
+    struct Datagram {
+        size_t from;
+        std::vector<uint8_t> bytes;
+    };
+
+    std::vector<Datagram> pending;
+    uint32_t loss_percent = 0;
+    uint32_t duplicate_percent = 0;
+    bool reorder = false;
+    size_t sent = 0;
+    size_t bytes = 0;
+    uint32_t seed = 12345;
+
+    uint32_t random(uint32_t bound) {
+        seed = seed * 1103515245 + 12345;
+        return (seed >> 16) % bound;
+    }
+};
+
+class BusLink final : public SyncLink {
+public:
+    BusLink(Bus& bus, size_t index) : bus_(bus), index_(index) {}
+
+    bool send(const uint8_t* data, size_t length) override {
+        bus_.pending.push_back({index_, std::vector<uint8_t>(data, data + length)});
+        bus_.sent++;
+        bus_.bytes += length;
+        return true;
+    }
+
+private:
+    Bus& bus_;
+    size_t index_;
+};
+
+struct Peer {
+    PomodoroClock clock;
+    BusLink link;
+    LanSync sync;
+
+    Peer(Bus& bus, size_t index) : link(bus, index), sync(clock, link, static_cast<uint32_t>(index + 1)) {
+        clock.add_observer(sync);
+    }
+};
+
+std::vector<std::unique_ptr<Peer>> makePeers(Bus& bus, size_t count) {
+    std::vector<std::unique_ptr<Peer>> peers;
+    for (size_t i = 0; i < count; i++) {
+        peers.push_back(std::make_unique<Peer>(bus, i));
+    }
+    return peers;
+}
+
+// Delivers what was sent before this call; replies wait for the next round.
+void deliver(Bus& bus, std::vector<std::unique_ptr<Peer>>& peers, time_t now) {
+    std::vector<Bus::Datagram> round;
+    round.swap(bus.pending);
+    if (bus.reorder) {
+        for (size_t i = round.size(); i > 1; i--) {
+            std::swap(round[i - 1], round[bus.random(static_cast<uint32_t>(i))]);
+        }
+    }
+    for (const Bus::Datagram& datagram : round) {
+        for (size_t to = 0; to < peers.size(); to++) {
+            if (to == datagram.from || bus.random(100) < bus.loss_percent) {
+                continue;
+            }
+            const int copies = bus.random(100) < bus.duplicate_percent ? 2 : 1;
+            for (int copy = 0; copy < copies; copy++) {
+                peers[to]->sync.receive(datagram.bytes.data(), datagram.bytes.size(), now);
+            }
+        }
+    }
+}
+
+void tick(Bus& bus, std::vector<std::unique_ptr<Peer>>& peers, time_t now) {
+    for (auto& peer : peers) {
+        peer->clock.PassageOfTime(now);
+    }
+    deliver(bus, peers, now);
+}
+
+bool converged(const std::vector<std::unique_ptr<Peer>>& peers) {
+    const PomodoroSnapshot first = peers[0]->clock.Snapshot();
+    for (const auto& peer : peers) {
+        const PomodoroSnapshot snapshot = peer->clock.Snapshot();
+        if (snapshot.state != first.state || snapshot.work_flavor != first.work_flavor
+            || snapshot.state_ends_at != first.state_ends_at
+            || peer->sync.replica().version().seq != peers[0]->sync.replica().version().seq
+            || peer->sync.replica().version().writer != peers[0]->sync.replica().version().writer) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_advance_plays_out_deadlines(void) {
+    const SyncState work = {WORK, 2, 1000, 300};
+    TEST_ASSERT_TRUE(advance(work, 999) == work);
+    const SyncState rest = advance(work, 1000);
+    TEST_ASSERT_EQUAL(BREAK, rest.state);
+    TEST_ASSERT_EQUAL_UINT32(1300, rest.deadline);
+    TEST_ASSERT_EQUAL(2, rest.flavor);
+    const SyncState idle = {IDLE, 0, 0, 0};
+    TEST_ASSERT_TRUE(advance(work, 1300) == idle);
+}
+
+void test_change_is_a_few_bytes(void) {
+    const SyncState base = {WORK, 1, 1738570000, 300};
+    SyncMessage change = {};
+    change.type = SyncMessageType::CHANGE;
+    change.sender = 7;
+    change.version = {5, 7};
+    change.base = {4, 7};
+    // Five more minutes: the deadline moves by 300, a two-byte varint.
+    change.delta = diff(base, {WORK, 1, 1738570300, 300});
+    uint8_t data[kSyncMessageMaxBytes];
+    const size_t size = encodeSyncMessage(change, data, sizeof(data));
+    TEST_ASSERT_EQUAL(2 + 4 + 1 + 1 + 1 + 2, size);
+    TEST_ASSERT_EQUAL_HEX8('P', data[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x11, data[1]);
+
+    SyncMessage decoded = {};
+    TEST_ASSERT_TRUE(decodeSyncMessage(data, size, &decoded));
+    TEST_ASSERT_TRUE(decoded.type == SyncMessageType::CHANGE);
+    TEST_ASSERT_EQUAL_UINT32(7, decoded.sender);
+    TEST_ASSERT_EQUAL_UINT32(5, decoded.version.seq);
+    TEST_ASSERT_EQUAL_UINT32(4, decoded.base.seq);
+    TEST_ASSERT_EQUAL_UINT32(7, decoded.base.writer);
+    TEST_ASSERT_TRUE(patch(base, decoded.delta) == (SyncState{WORK, 1, 1738570300, 300}));
+
+    // A cancel is the state alone; a base from another writer costs its id.
+    change.base = {4, 9};
+    change.delta = diff(base, {IDLE, 0, 0, 0});
+    const size_t cancel = encodeSyncMessage(change, data, sizeof(data));
+    TEST_ASSERT_EQUAL(2 + 4 + 1 + 1 + 1 + 4 + 1, cancel);
+    TEST_ASSERT_TRUE(decodeSyncMessage(data, cancel, &decoded));
+    TEST_ASSERT_EQUAL_UINT32(9, decoded.base.writer);
+    TEST_ASSERT_TRUE(patch(base, decoded.delta) == (SyncState{IDLE, 0, 0, 0}));
+}
+
+void test_full_and_request_round_trip(void) {
+    SyncReplica replica(3);
+    replica.write({BREAK, 2, 1738570000, 600});
+    uint8_t data[kSyncMessageMaxBytes];
+    const size_t size = encodeSyncMessage(replica.full(), data, sizeof(data));
+    TEST_ASSERT_EQUAL(2 + 4 + 1 + 1 + 4 + 2, size);
+    SyncMessage decoded = {};
+    TEST_ASSERT_TRUE(decodeSyncMessage(data, size, &decoded));
+    TEST_ASSERT_TRUE(decoded.type == SyncMessageType::FULL);
+    TEST_ASSERT_TRUE(decoded.state == replica.state());
+
+    SyncMessage request = replica.request();
+    request.sender = 8;
+    const size_t request_size = encodeSyncMessage(request, data, sizeof(data));
+    TEST_ASSERT_TRUE(decodeSyncMessage(data, request_size, &decoded));
+    TEST_ASSERT_TRUE(decoded.type == SyncMessageType::REQUEST);
+    TEST_ASSERT_EQUAL_UINT32(8, decoded.sender);
+    TEST_ASSERT_EQUAL_UINT32(3, decoded.version.writer);
+    TEST_ASSERT_EQUAL_UINT32(1, decoded.version.seq);
+}
+
+void test_malformed_messages_are_rejected(void) {
+    SyncReplica replica(3);
+    replica.write({WORK, 1, 1738570000, 300});
+    uint8_t data[kSyncMessageMaxBytes + 1];
+    const size_t size = encodeSyncMessage(replica.full(), data, sizeof(data));
+    SyncMessage decoded;
+    TEST_ASSERT_FALSE(decodeSyncMessage(data, size - 1, &decoded));
+    data[size] = 0;
+    TEST_ASSERT_FALSE(decodeSyncMessage(data, size + 1, &decoded));
+    data[7] = 3;
+    TEST_ASSERT_FALSE(decodeSyncMessage(data, size, &decoded));
+    data[7] = WORK;
+    data[1] = 0x21;
+    TEST_ASSERT_FALSE(decodeSyncMessage(data, size, &decoded));
+    data[1] = 0x12;
+    data[0] = 'Q';
+    TEST_ASSERT_FALSE(decodeSyncMessage(data, size, &decoded));
+    TEST_ASSERT_EQUAL(0, encodeSyncMessage(replica.full(), data, size - 1));
+}
+
+void test_last_writer_wins_in_any_order(void) {
+    SyncReplica a(1);
+    SyncReplica b(2);
+    const SyncMessage from_a = a.write({WORK, 0, 2000, 300});
+    const SyncMessage from_b = b.write({WORK, 1, 2100, 300});
+
+    SyncReplica first(3);
+    TEST_ASSERT_TRUE(first.apply(from_a) == SyncReplica::Result::APPLIED);
+    TEST_ASSERT_TRUE(first.apply(from_b) == SyncReplica::Result::APPLIED);
+    SyncReplica second(4);
+    TEST_ASSERT_TRUE(second.apply(from_b) == SyncReplica::Result::APPLIED);
+    TEST_ASSERT_TRUE(second.apply(from_a) == SyncReplica::Result::STALE);
+    TEST_ASSERT_TRUE(first.state() == second.state());
+    TEST_ASSERT_EQUAL(1, first.state().flavor);
+    TEST_ASSERT_TRUE(a.apply(from_b) == SyncReplica::Result::APPLIED);
+    TEST_ASSERT_TRUE(a.state() == second.state());
+
+    // The next write is ordered after everything the writer has seen.
+    TEST_ASSERT_EQUAL_UINT32(2, a.write({IDLE, 0, 0, 0}).version.seq);
+}
+
+void test_unknown_base_waits_for_full(void) {
+    SyncReplica writer(1);
+    writer.write({WORK, 0, 2000, 300});
+    const SyncMessage extend = writer.write({WORK, 0, 2300, 300});
+    SyncReplica late(2);
+    TEST_ASSERT_FALSE(late.has(extend.base));
+    TEST_ASSERT_TRUE(late.apply(extend) == SyncReplica::Result::UNKNOWN_BASE);
+    TEST_ASSERT_TRUE(late.apply(writer.full()) == SyncReplica::Result::APPLIED);
+    TEST_ASSERT_TRUE(late.state() == writer.state());
+}
+
+void test_ticks_and_deadlines_send_nothing(void) {
+    Bus bus;
+    auto peers = makePeers(bus, 2);
+    Peer& peer = *peers[0];
+    peer.clock.StartWork(1, 30, 20, 1000);
+    TEST_ASSERT_EQUAL(1, bus.sent);
+    // The start and its two repeats; the break and going idle are implied by the deadline.
+    for (time_t now = 1000; now < 1060; now++) {
+        tick(bus, peers, now);
+    }
+    TEST_ASSERT_EQUAL(IDLE, peer.clock.State());
+    TEST_ASSERT_EQUAL(3, bus.sent);
+    TEST_ASSERT_EQUAL(0, peers[1]->sync.stats().sent);
+    TEST_ASSERT_EQUAL(IDLE, peers[1]->clock.State());
+    // Then only the heartbeat.
+    for (time_t now = 1060; now <= 1000 + 4 + 60; now++) {
+        tick(bus, peers, now);
+    }
+    TEST_ASSERT_EQUAL(4, bus.sent);
+}
+
+void test_remote_changes_are_adopted_without_echo(void) {
+    Bus bus;
+    auto peers = makePeers(bus, 3);
+    peers[0]->clock.StartWork(2, 1500, 300, 1000);
+    deliver(bus, peers, 1000);
+    TEST_ASSERT_EQUAL(WORK, peers[2]->clock.State());
+    TEST_ASSERT_EQUAL(2, peers[2]->clock.Snapshot().work_flavor);
+    TEST_ASSERT_EQUAL(2500, peers[2]->clock.Snapshot().state_ends_at);
+    TEST_ASSERT_TRUE(bus.pending.empty());
+
+    peers[1]->clock.ExtendWork(600, 1100);
+    TEST_ASSERT_EQUAL(1, peers[1]->sync.stats().sent);
+    deliver(bus, peers, 1100);
+    TEST_ASSERT_EQUAL(3100, peers[0]->clock.Snapshot().state_ends_at);
+    TEST_ASSERT_EQUAL(3100, peers[2]->clock.Snapshot().state_ends_at);
+    peers[2]->clock.Cancel(1200);
+    deliver(bus, peers, 1200);
+    TEST_ASSERT_EQUAL(IDLE, peers[0]->clock.State());
+    TEST_ASSERT_EQUAL(IDLE, peers[1]->clock.State());
+    TEST_ASSERT_TRUE(converged(peers));
+    TEST_ASSERT_EQUAL(0, peers[0]->sync.stats().malformed);
+}
+
+void test_late_joiner_asks_for_state(void) {
+    Bus bus;
+    auto peers = makePeers(bus, 2);
+    peers[0]->clock.StartWork(1, 1500, 300, 1000);
+    bus.pending.clear();
+    peers[1]->sync.begin();
+    deliver(bus, peers, 1010);
+    deliver(bus, peers, 1010);
+    TEST_ASSERT_EQUAL(WORK, peers[1]->clock.State());
+    TEST_ASSERT_EQUAL(2500, peers[1]->clock.Snapshot().state_ends_at);
+}
+
+void test_dozens_of_peers_converge_over_a_lossy_network(void) {
+    Bus bus;
+    bus.loss_percent = 20;
+    bus.duplicate_percent = 10;
+    bus.reorder = true;
+    auto peers = makePeers(bus, 32);
+    for (auto& peer : peers) {
+        peer->sync.begin();
+    }
+    time_t now = 1738570000;
+    size_t actions = 0;
+    for (int second = 0; second < 3600; second++, now++) {
+        // Someone presses something about every 20 s; now and then two at once.
+        const int presses = bus.random(20) == 0 ? 1 + (bus.random(4) == 0) : 0;
+        for (int press = 0; press < presses; press++) {
+            PomodoroClock& clock = peers[bus.random(static_cast<uint32_t>(peers.size()))]->clock;
+            switch (clock.State()) {
+            case IDLE:
+                clock.StartWork(static_cast<uint8_t>(bus.random(DEFAULT_WORK_FLAVORS)), 90, 30, now);
+                break;
+            case WORK:
+                bus.random(3) == 0 ? clock.Cancel(now) : bus.random(2) ? clock.ExtendWork(20, now)
+                                                                       : clock.CycleFlavor(now);
+                break;
+            default:
+                clock.Cancel(now);
+            }
+            actions++;
+        }
+        tick(bus, peers, now);
+    }
+    // Quiet, but still lossy, for a few heartbeats.
+    for (int second = 0; second < 5 * 60; second++, now++) {
+        tick(bus, peers, now);
+    }
+    TEST_ASSERT_TRUE(actions > 100);
+    TEST_ASSERT_TRUE(converged(peers));
+    // Writes, their repeats and heartbeats, and the odd request: nothing per tick.
+    TEST_ASSERT_TRUE(bus.sent < actions * 6 + 3600 / 60 + peers.size() * 4);
+    TEST_ASSERT_TRUE(bus.bytes / bus.sent < 16);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_advance_plays_out_deadlines);
+    RUN_TEST(test_change_is_a_few_bytes);
+    RUN_TEST(test_full_and_request_round_trip);
+    RUN_TEST(test_malformed_messages_are_rejected);
+    RUN_TEST(test_last_writer_wins_in_any_order);
+    RUN_TEST(test_unknown_base_waits_for_full);
+    RUN_TEST(test_ticks_and_deadlines_send_nothing);
+    RUN_TEST(test_remote_changes_are_adopted_without_echo);
+    RUN_TEST(test_late_joiner_asks_for_state);
+    RUN_TEST(test_dozens_of_peers_converge_over_a_lossy_network);
+    return UNITY_END();
+}
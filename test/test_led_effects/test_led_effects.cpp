@@ -0,0 +1,133 @@
+#include <unity.h>
+#include "LedEffects.h"
+
+const Rgb GREEN = {0, 255, 0};
+
+ClockUpdate makeUpdate(PomodoroState state, time_t remaining) {
+    return {1738569600, state, 0, remaining};
+}
+
+size_t litPixels(const Rgb* pixels, size_t count) {
+    size_t lit = 0;
+    for (size_t i = 0; i < count; i++) {
+        lit += pixels[i] != Rgb{0, 0, 0};
+    }
+    return lit;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_tables(void) {
+    TEST_ASSERT_EQUAL_UINT8(0, led_effects::kGamma[0]);
+    TEST_ASSERT_EQUAL_UINT8(255, led_effects::kGamma[255]);
+    for (int i = 1; i < 256; i++) {
+        TEST_ASSERT_TRUE(led_effects::kGamma[i] >= led_effects::kGamma[i - 1]);
+    }
+    TEST_ASSERT_EQUAL_UINT8(0, led_effects::kBreath[0]);
+    TEST_ASSERT_EQUAL_UINT8(255, led_effects::kBreath[128]);
+    TEST_ASSERT_EQUAL_UINT8(255, led_effects::scale8(255, 255));
+    TEST_ASSERT_EQUAL_UINT8(0, led_effects::scale8(255, 0));
+    TEST_ASSERT_EQUAL_UINT8(127, led_effects::scale8(255, 127));
+}
+
+void test_progress_bar(void) {
+    Rgb pixels[EXTERNAL_LEDS];
+    led_effects::progressBar(pixels, EXTERNAL_LEDS, GREEN, 1500000, 1500000);
+    TEST_ASSERT_EQUAL(30, litPixels(pixels, EXTERNAL_LEDS));
+    TEST_ASSERT_TRUE(pixels[29] == GREEN);
+
+    led_effects::progressBar(pixels, EXTERNAL_LEDS, GREEN, 750000, 1500000);
+    TEST_ASSERT_EQUAL(15, litPixels(pixels, EXTERNAL_LEDS));
+    TEST_ASSERT_TRUE(pixels[14] == GREEN);
+
+    // Just under half a pixel past 10 (127/256): pixel 10 is at the 120/256 fade step.
+    led_effects::progressBar(pixels, EXTERNAL_LEDS, GREEN, 10500, 30000);
+    TEST_ASSERT_TRUE(pixels[9] == GREEN);
+    TEST_ASSERT_EQUAL_UINT8(led_effects::kGamma[120], pixels[10].g);
+    TEST_ASSERT_TRUE((pixels[11] == Rgb{0, 0, 0}));
+
+    led_effects::progressBar(pixels, EXTERNAL_LEDS, GREEN, 0, 1500000);
+    TEST_ASSERT_EQUAL(0, litPixels(pixels, EXTERNAL_LEDS));
+    led_effects::progressBar(pixels, EXTERNAL_LEDS, GREEN, 100, 0);
+    TEST_ASSERT_EQUAL(0, litPixels(pixels, EXTERNAL_LEDS));
+}
+
+void test_breath_stays_above_floor(void) {
+    uint8_t lowest = 255;
+    uint8_t highest = 0;
+    for (uint32_t ms = 0; ms < led_effects::kBreathPeriodMs; ms += 10) {
+        const uint8_t level = led_effects::breath(ms);
+        lowest = level < lowest ? level : lowest;
+        highest = level > highest ? level : highest;
+    }
+    TEST_ASSERT_EQUAL_UINT8(led_effects::kBreathFloor, lowest);
+    TEST_ASSERT_EQUAL_UINT8(255, highest);
+}
+
+void test_idle_frames_do_not_change(void) {
+    LedAnimator animator;
+    LedFrame frame;
+    animator.update(makeUpdate(IDLE, 0), 0);
+    TEST_ASSERT_TRUE(animator.render(0, &frame));
+    TEST_ASSERT_EQUAL(0, litPixels(frame.external, EXTERNAL_LEDS));
+    for (uint32_t ms = 20; ms < 5000; ms += 20) {
+        if (ms % 1000 == 0) {
+            animator.update(makeUpdate(IDLE, 0), ms);
+        }
+        TEST_ASSERT_FALSE(animator.render(ms, &frame));
+    }
+}
+
+void test_work_progress_is_interpolated(void) {
+    LedAnimator animator;
+    LedFrame frame;
+    animator.update(makeUpdate(WORK, 1500), 0);
+    animator.render(0, &frame);
+    TEST_ASSERT_TRUE(frame.internal[0] == GREEN);
+    TEST_ASSERT_EQUAL(30, litPixels(frame.external, EXTERNAL_LEDS));
+
+    animator.update(makeUpdate(WORK, 750), 750000);
+    animator.render(750000, &frame);
+    TEST_ASSERT_EQUAL(15, litPixels(frame.external, EXTERNAL_LEDS));
+    // 25 s later without an update the interpolation stops one second ahead of the last update.
+    animator.render(775000, &frame);
+    TEST_ASSERT_EQUAL(15, litPixels(frame.external, EXTERNAL_LEDS));
+    TEST_ASSERT_TRUE(frame.external[14] != GREEN);
+
+    // Extending the work period makes the bar span the longer period.
+    animator.update(makeUpdate(WORK, 3000), 776000);
+    animator.render(776000, &frame);
+    TEST_ASSERT_EQUAL(30, litPixels(frame.external, EXTERNAL_LEDS));
+}
+
+void test_last_minute_breathes(void) {
+    LedAnimator animator;
+    LedFrame frame;
+    animator.update(makeUpdate(BREAK, 300), 0);
+    animator.render(0, &frame);
+    TEST_ASSERT_TRUE((frame.internal[0] == Rgb{255, 0, 0}));
+
+    animator.update(makeUpdate(BREAK, 30), 270000);
+    int changed = 0;
+    uint8_t lowest = 255;
+    for (uint32_t ms = 270020; ms < 272020; ms += 20) {
+        changed += animator.render(ms, &frame);
+        lowest = frame.internal[0].r < lowest ? frame.internal[0].r : lowest;
+    }
+    // Only the flat top and bottom of the curve repeat a frame.
+    TEST_ASSERT_GREATER_THAN(90, changed);
+    TEST_ASSERT_TRUE(lowest < 64);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_tables);
+    RUN_TEST(test_progress_bar);
+    RUN_TEST(test_breath_stays_above_floor);
+    RUN_TEST(test_idle_frames_do_not_change);
+    RUN_TEST(test_work_progress_is_interpolated);
+    RUN_TEST(test_last_minute_breathes);
+    return UNITY_END();
+}
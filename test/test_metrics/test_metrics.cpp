@@ -0,0 +1,189 @@
+#include <unity.h>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "Metrics.h"
+#include "ObserverProbe.h"
+
+class SlowObserver final : public PomodoroObserver {
+public:
+    int calls = 0;
+    void notification(ClockUpdate) override { calls++; }
+    void notification(IdleToWork) override {
+        calls++;
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    void notification(WorkToBreak) override { calls++; }
+    void notification(BreakToIdle) override { calls++; }
+    void notification(WorkToIdle) override { calls++; }
+    void notification(AdditionalWork) override { calls++; }
+};
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_counter_and_gauge(void) {
+    Counter requests("test.requests");
+    Gauge depth("test.depth");
+    requests.add();
+    requests.add(4);
+    TEST_ASSERT_EQUAL_UINT32(5, requests.value());
+    TEST_ASSERT_EQUAL_UINT32(5, requests.sample().value);
+
+    // Never set: no extremes to report.
+    TEST_ASSERT_EQUAL_INT32(0, depth.sample().min);
+    TEST_ASSERT_EQUAL_INT32(0, depth.sample().max);
+    depth.set(3);
+    depth.set(-1);
+    depth.set(7);
+    depth.set(2);
+    const MetricSample sample = depth.sample();
+    TEST_ASSERT_EQUAL_INT32(2, static_cast<int32_t>(sample.value));
+    TEST_ASSERT_EQUAL_INT32(-1, sample.min);
+    TEST_ASSERT_EQUAL_INT32(7, sample.max);
+    depth.reset();
+    TEST_ASSERT_EQUAL_INT32(2, depth.sample().min);
+    TEST_ASSERT_EQUAL_INT32(2, depth.sample().max);
+}
+
+void test_histogram_percentiles(void) {
+    Histogram latency("test.latency_us");
+    for (uint32_t i = 0; i < 90; i++) {
+        latency.record(100);
+    }
+    for (uint32_t i = 0; i < 9; i++) {
+        latency.record(1000);
+    }
+    latency.record(50000);
+    latency.record(0);
+    const MetricSample sample = latency.sample();
+    TEST_ASSERT_EQUAL_UINT32(101, sample.value);
+    TEST_ASSERT_EQUAL_UINT32(127, sample.p50);
+    TEST_ASSERT_EQUAL_UINT32(127, sample.p90);
+    TEST_ASSERT_EQUAL_UINT32(1023, sample.p99);
+    TEST_ASSERT_EQUAL_UINT32(50000, sample.hmax);
+    latency.reset();
+    TEST_ASSERT_EQUAL_UINT32(0, latency.sample().value);
+    TEST_ASSERT_EQUAL_UINT32(0, latency.sample().p50);
+}
+
+void test_histogram_budget_counts_overruns(void) {
+    Histogram push("test.push_us", 1000);
+    push.record(999);
+    push.record(1000);
+    push.record(1001);
+    push.record(40000);
+    TEST_ASSERT_EQUAL_UINT32(2, push.overruns());
+    TEST_ASSERT_EQUAL_UINT32(1000, push.sample().budget);
+    TEST_ASSERT_EQUAL_UINT32(2, push.sample().overruns);
+
+    char text[4096];
+    metrics().format(text, sizeof(text));
+    TEST_ASSERT_NOT_NULL(strstr(text, "histogram test.push_us             n=4 p50<=1023 p90<=40000 p99<=40000 max=40000 over 1000: 2\n"));
+    char json[4096];
+    metrics().formatJson(json, sizeof(json));
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"test.push_us\":{\"count\":4,\"p50\":1023,\"p90\":40000,\"p99\":40000,\"max\":40000,"
+                                      "\"budget\":1000,\"overruns\":2}"));
+    push.reset();
+    TEST_ASSERT_EQUAL_UINT32(0, push.overruns());
+}
+
+void test_registry_tracks_lifetime(void) {
+    const size_t before = metrics().size();
+    {
+        Counter first("test.first");
+        Counter second("test.second");
+        TEST_ASSERT_EQUAL(before + 2, metrics().size());
+        TEST_ASSERT_TRUE(metrics().find("test.second") == &second);
+        std::vector<MetricSample> samples(metrics().size());
+        TEST_ASSERT_EQUAL(samples.size(), metrics().snapshot(samples.data(), samples.size()));
+        // Registration order.
+        TEST_ASSERT_EQUAL_STRING("test.first", samples[samples.size() - 2].name);
+        TEST_ASSERT_EQUAL_STRING("test.second", samples.back().name);
+    }
+    TEST_ASSERT_EQUAL(before, metrics().size());
+    TEST_ASSERT_NULL(metrics().find("test.second"));
+    // The tail was removed: new metrics still register.
+    Counter third("test.third");
+    TEST_ASSERT_TRUE(metrics().find("test.third") == &third);
+}
+
+void test_concurrent_records_are_not_lost(void) {
+    Counter events("test.events");
+    Histogram sizes("test.sizes");
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&events, &sizes, t]() {
+            for (uint32_t i = 0; i < 100000; i++) {
+                events.add();
+                sizes.record(i + t);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    TEST_ASSERT_EQUAL_UINT32(400000, events.value());
+    TEST_ASSERT_EQUAL_UINT32(400000, sizes.sample().value);
+    TEST_ASSERT_EQUAL_UINT32(100002, sizes.sample().hmax);
+}
+
+void test_format_text_and_json(void) {
+    Counter status("test.status_2xx");
+    Gauge queue("test.queue");
+    Histogram rtt("test.rtt_us");
+    status.add(3);
+    queue.set(4);
+    rtt.record(300);
+
+    char text[4096];
+    metrics().format(text, sizeof(text));
+    TEST_ASSERT_NOT_NULL(strstr(text, "counter   test.status_2xx                   3\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "gauge     test.queue                        4 (min 4, max 4)\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "histogram test.rtt_us              n=1 p50<=300 p90<=300 p99<=300 max=300\n"));
+
+    char json[4096];
+    const size_t length = metrics().formatJson(json, sizeof(json));
+    TEST_ASSERT_EQUAL(strlen(json), length);
+    TEST_ASSERT_EQUAL_INT('{', json[0]);
+    TEST_ASSERT_EQUAL_INT('}', json[length - 1]);
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"test.status_2xx\":3"));
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"test.queue\":{\"value\":4,\"min\":4,\"max\":4}"));
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"test.rtt_us\":{\"count\":1,\"p50\":300,\"p90\":300,\"p99\":300,\"max\":300}"));
+
+    // Too small for every metric: whole entries only, still closed.
+    char small[40];
+    const size_t small_length = metrics().formatJson(small, sizeof(small));
+    TEST_ASSERT_TRUE(small_length < sizeof(small));
+    TEST_ASSERT_EQUAL_INT('}', small[small_length - 1]);
+    TEST_ASSERT_NULL(strstr(small, "\"test.rtt_us\""));
+    char tiny[2];
+    TEST_ASSERT_EQUAL(0, metrics().formatJson(tiny, sizeof(tiny)));
+}
+
+void test_observer_probe_times_each_notification(void) {
+    SlowObserver slow;
+    ObserverProbe probe("test.notify_us.slow", slow, 1000);
+    PomodoroClock clock;
+    clock.add_observer(probe);
+    clock.StartWork(0, 1500, 300, 1738569600);
+    clock.PassageOfTime(1738569601);
+    TEST_ASSERT_EQUAL(slow.calls, static_cast<int>(probe.latency().sample().value));
+    TEST_ASSERT_TRUE(slow.calls >= 2);
+    TEST_ASSERT_TRUE(probe.latency().sample().hmax >= 2000);
+    // Only the IdleToWork notification sleeps past the budget.
+    TEST_ASSERT_EQUAL_UINT32(1, probe.latency().overruns());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_counter_and_gauge);
+    RUN_TEST(test_histogram_percentiles);
+    RUN_TEST(test_histogram_budget_counts_overruns);
+    RUN_TEST(test_registry_tracks_lifetime);
+    RUN_TEST(test_concurrent_records_are_not_lost);
+    RUN_TEST(test_format_text_and_json);
+    RUN_TEST(test_observer_probe_times_each_notification);
+    return UNITY_END();
+}
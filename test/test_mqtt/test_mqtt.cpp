@@ -0,0 +1,277 @@
+#include <unity.h>
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "Mqtt.h"
+
+// A broker stand-in behind the link: answers CONNECT, QoS 1 PUBLISH and PINGREQ, and remembers
+// sessions by client id.
+class BrokerLink final : public MqttLink {
+public:
+    std::vector<std::string> sessions;
+    std::vector<std::string> topics;
+    std::vector<std::string> payloads;
+    std::vector<bool> dups;
+    std::vector<bool> retains;
+    std::vector<uint16_t> packet_ids;
+    int opens = 0;
+    int pings = 0;
+    int acks_to_lose = 0;
+    bool refuse = false;
+
+    bool open() override {
+        opens++;
+        open_ = true;
+        reader_.next();
+        inbox_.clear();
+        return true;
+    }
+
+    void close() override {
+        open_ = false;
+    }
+
+    bool write(const uint8_t* data, size_t length) override {
+        if (!open_) {
+            return false;
+        }
+        while (length > 0) {
+            const size_t used = reader_.feed(data, length);
+            data += used;
+            length -= used;
+            if (reader_.ready()) {
+                answer();
+                reader_.next();
+            }
+        }
+        return true;
+    }
+
+    int read(uint8_t* data, size_t capacity, uint32_t) override {
+        if (!open_) {
+            return -1;
+        }
+        // One byte at a time, to exercise reassembly.
+        if (inbox_.empty() || capacity == 0) {
+            return 0;
+        }
+        data[0] = inbox_.front();
+        inbox_.erase(inbox_.begin());
+        return 1;
+    }
+
+private:
+    bool open_ = false;
+    MqttReader reader_;
+    std::vector<uint8_t> inbox_;
+
+    void reply(const uint8_t* packet, size_t size) {
+        inbox_.insert(inbox_.end(), packet, packet + size);
+    }
+
+    void answer() {
+        uint8_t packet[8];
+        if (reader_.type() == MqttPacketType::CONNECT) {
+            MqttConnectOptions options;
+            char id[24];
+            TEST_ASSERT_TRUE(mqttParseConnect(reader_.body(), reader_.bodyLength(), &options, id, sizeof(id)));
+            TEST_ASSERT_FALSE(options.clean_session);
+            bool known = false;
+            for (const std::string& session : sessions) {
+                known = known || session == id;
+            }
+            if (!known) {
+                sessions.push_back(id);
+            }
+            reply(packet, mqttEncodeConnAck(known, refuse ? 5 : 0, packet, sizeof(packet)));
+        } else if (reader_.type() == MqttPacketType::PUBLISH) {
+            MqttMessage message;
+            TEST_ASSERT_TRUE(mqttParsePublish(reader_.flags(), reader_.body(), reader_.bodyLength(), &message));
+            topics.emplace_back(message.topic, message.topic_length);
+            payloads.emplace_back(reinterpret_cast<const char*>(message.payload), message.payload_length);
+            dups.push_back(message.dup);
+            retains.push_back(message.retain);
+            packet_ids.push_back(message.packet_id);
+            if (message.qos == 1 && acks_to_lose-- <= 0) {
+                reply(packet, mqttEncodePubAck(message.packet_id, packet, sizeof(packet)));
+            }
+        } else if (reader_.type() == MqttPacketType::PINGREQ) {
+            pings++;
+            reply(packet, mqttEncodeEmpty(MqttPacketType::PINGRESP, packet, sizeof(packet)));
+        }
+    }
+};
+
+static bool publish(MqttClient& client, const char* topic, const char* payload, uint8_t qos, bool retain) {
+    return client.publish(topic, reinterpret_cast<const uint8_t*>(payload), strlen(payload), qos, retain);
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_encodes_connect(void) {
+    uint8_t packet[64];
+    const size_t size = mqttEncodeConnect({"dev", 60, false}, packet, sizeof(packet));
+    const uint8_t expected[] = {0x10, 15, 0, 4, 'M', 'Q', 'T', 'T', 4, 0, 0, 60, 0, 3, 'd', 'e', 'v'};
+    TEST_ASSERT_EQUAL(sizeof(expected), size);
+    TEST_ASSERT_EQUAL_MEMORY(expected, packet, sizeof(expected));
+    TEST_ASSERT_EQUAL(0, mqttEncodeConnect({"dev", 60, false}, packet, sizeof(expected) - 1));
+}
+
+void test_publish_round_trips_with_long_length(void) {
+    const std::string payload(200, 'p');
+    uint8_t packet[256];
+    const MqttMessage message = {"a/b", 3, reinterpret_cast<const uint8_t*>(payload.data()), payload.size(), 1, true, true, 513};
+    const size_t size = mqttEncodePublish(message, packet, sizeof(packet));
+    // 2 + 3 + 2 + 200 = 207 needs two length bytes.
+    TEST_ASSERT_EQUAL(3 + 207, size);
+    TEST_ASSERT_EQUAL_HEX8(0x3B, packet[0]);
+    TEST_ASSERT_EQUAL_HEX8(0xCF, packet[1]);
+    TEST_ASSERT_EQUAL_HEX8(0x01, packet[2]);
+
+    // Fed in awkward pieces, the reader gives back the same packet.
+    MqttReader reader;
+    size_t offset = 0;
+    for (size_t piece = 1; !reader.ready(); piece = piece * 2 + 1) {
+        offset += reader.feed(packet + offset, std::min(piece, size - offset));
+    }
+    TEST_ASSERT_EQUAL(size, offset);
+    TEST_ASSERT_TRUE(reader.type() == MqttPacketType::PUBLISH);
+    MqttMessage decoded;
+    TEST_ASSERT_TRUE(mqttParsePublish(reader.flags(), reader.body(), reader.bodyLength(), &decoded));
+    TEST_ASSERT_EQUAL(3, decoded.topic_length);
+    TEST_ASSERT_EQUAL(0, strncmp("a/b", decoded.topic, 3));
+    TEST_ASSERT_EQUAL(200, decoded.payload_length);
+    TEST_ASSERT_EQUAL(1, decoded.qos);
+    TEST_ASSERT_TRUE(decoded.retain);
+    TEST_ASSERT_TRUE(decoded.dup);
+    TEST_ASSERT_EQUAL(513, decoded.packet_id);
+}
+
+void test_reader_rejects_oversized_packets(void) {
+    MqttReader reader;
+    const uint8_t header[] = {0x30, 0xFF, 0x7F};
+    reader.feed(header, sizeof(header));
+    TEST_ASSERT_TRUE(reader.failed());
+    reader.next();
+    const uint8_t ping[] = {0xD0, 0x00};
+    TEST_ASSERT_EQUAL(2, reader.feed(ping, sizeof(ping)));
+    TEST_ASSERT_TRUE(reader.ready());
+    TEST_ASSERT_TRUE(reader.type() == MqttPacketType::PINGRESP);
+}
+
+void test_client_keeps_one_connection(void) {
+    BrokerLink link;
+    MqttClient client(link, "pomodoro-1", 600);
+    TEST_ASSERT_TRUE(publish(client, "p/1/state", "one", 1, true));
+    TEST_ASSERT_TRUE(publish(client, "p/1/state", "two", 1, true));
+    TEST_ASSERT_TRUE(publish(client, "p/1/metrics", "{}", 0, false));
+    TEST_ASSERT_EQUAL(1, link.opens);
+    TEST_ASSERT_FALSE(client.sessionPresent());
+    TEST_ASSERT_EQUAL(3, link.payloads.size());
+    TEST_ASSERT_EQUAL_STRING("two", link.payloads[1].c_str());
+    TEST_ASSERT_TRUE(link.retains[0]);
+    TEST_ASSERT_EQUAL(1, link.packet_ids[0]);
+    TEST_ASSERT_EQUAL(2, link.packet_ids[1]);
+    TEST_ASSERT_EQUAL(1, client.stats().connects);
+    // CONNECT plus three publishes.
+    TEST_ASSERT_EQUAL(4, client.stats().round_trips);
+    // CONNECT 24 bytes; PUBLISH 2 + 2 + 9 + 2 + 3 twice and 2 + 2 + 11 + 2 once.
+    TEST_ASSERT_EQUAL(24 + 18 + 18 + 17, client.stats().bytes_sent);
+    // CONNACK and two PUBACKs.
+    TEST_ASSERT_EQUAL(12, client.stats().bytes_received);
+}
+
+void test_unacknowledged_publish_is_resent_as_dup(void) {
+    BrokerLink link;
+    MqttClient client(link, "pomodoro-1", 600);
+    link.acks_to_lose = 1;
+    TEST_ASSERT_FALSE(publish(client, "p/1/state", "one", 1, true));
+    TEST_ASSERT_FALSE(client.connected());
+    TEST_ASSERT_TRUE(publish(client, "p/1/state", "one", 1, true));
+    TEST_ASSERT_EQUAL(2, link.opens);
+    // The broker kept the session across the reconnect.
+    TEST_ASSERT_TRUE(client.sessionPresent());
+    TEST_ASSERT_EQUAL(2, link.payloads.size());
+    TEST_ASSERT_FALSE(link.dups[0]);
+    TEST_ASSERT_TRUE(link.dups[1]);
+    TEST_ASSERT_EQUAL(link.packet_ids[0], link.packet_ids[1]);
+    // Something else is a new message.
+    TEST_ASSERT_TRUE(publish(client, "p/1/state", "two", 1, true));
+    TEST_ASSERT_FALSE(link.dups[2]);
+    TEST_ASSERT_EQUAL(link.packet_ids[0] + 1, link.packet_ids[2]);
+}
+
+void test_refused_connection_fails_publish(void) {
+    BrokerLink link;
+    link.refuse = true;
+    MqttClient client(link, "pomodoro-1", 600);
+    TEST_ASSERT_FALSE(publish(client, "p/1/state", "one", 1, true));
+    TEST_ASSERT_FALSE(client.connected());
+    TEST_ASSERT_EQUAL(0, link.payloads.size());
+}
+
+void test_keep_alive_pings_only_when_due(void) {
+    BrokerLink link;
+    MqttClient client(link, "pomodoro-1", 1);
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, client.keepAlive());
+    TEST_ASSERT_TRUE(publish(client, "p/1/state", "one", 1, true));
+    const uint32_t wait = client.keepAlive();
+    TEST_ASSERT_TRUE(wait > 0 && wait <= 750);
+    TEST_ASSERT_EQUAL(0, link.pings);
+    usleep((wait + 10) * 1000);
+    TEST_ASSERT_EQUAL_UINT32(750, client.keepAlive());
+    TEST_ASSERT_EQUAL(1, link.pings);
+    TEST_ASSERT_TRUE(client.connected());
+}
+
+void test_socket_link_over_loopback(void) {
+    const int listener = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    listen(listener, 1);
+    getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length);
+    std::thread echo([listener]() {
+        const int fd = accept(listener, nullptr, nullptr);
+        char buffer[16];
+        const ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+        send(fd, buffer, static_cast<size_t>(received), 0);
+        close(fd);
+    });
+
+    SocketLink link("127.0.0.1", ntohs(address.sin_port));
+    TEST_ASSERT_TRUE(link.open());
+    TEST_ASSERT_TRUE(link.write(reinterpret_cast<const uint8_t*>("ping"), 4));
+    uint8_t buffer[16];
+    TEST_ASSERT_EQUAL(4, link.read(buffer, sizeof(buffer), 1000));
+    TEST_ASSERT_EQUAL(0, memcmp("ping", buffer, 4));
+    TEST_ASSERT_EQUAL(-1, link.read(buffer, sizeof(buffer), 1000));
+    echo.join();
+    close(listener);
+
+    SocketLink refused("127.0.0.1", ntohs(address.sin_port));
+    TEST_ASSERT_FALSE(refused.open());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_encodes_connect);
+    RUN_TEST(test_publish_round_trips_with_long_length);
+    RUN_TEST(test_reader_rejects_oversized_packets);
+    RUN_TEST(test_client_keeps_one_connection);
+    RUN_TEST(test_unacknowledged_publish_is_resent_as_dup);
+    RUN_TEST(test_refused_connection_fails_publish);
+    RUN_TEST(test_keep_alive_pings_only_when_due);
+    RUN_TEST(test_socket_link_over_loopback);
+    return UNITY_END();
+}
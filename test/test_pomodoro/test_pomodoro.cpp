@@ -112,6 +112,20 @@ void test_extend_work_when_not_working(void) {
     TEST_ASSERT_EQUAL(0, observer.additional_work);
 }
 
+void test_cycle_flavor_wraps_at_flavor_count(void) {
+    pomodoro.SetFlavorCount(5);
+    pomodoro.StartWork(3, 1500, 300, 1000);
+    TEST_ASSERT_TRUE(pomodoro.CycleFlavor(1010));
+    TEST_ASSERT_EQUAL(4, observer.last_work_flavor);
+    pomodoro.CycleFlavor(1020);
+    TEST_ASSERT_EQUAL(0, observer.last_work_flavor);
+
+    pomodoro.SetFlavorCount(0);
+    TEST_ASSERT_EQUAL(1, pomodoro.FlavorCount());
+    pomodoro.SetFlavorCount(200);
+    TEST_ASSERT_EQUAL(MAX_WORK_FLAVORS, pomodoro.FlavorCount());
+}
+
 void test_cancel_work(void) {
     time_t now = 1000;
     pomodoro.StartWork(1, 1500, 300, now);
@@ -157,6 +171,52 @@ void test_break_to_idle_transition(void) {
     TEST_ASSERT_EQUAL(300, observer.last_break_duration);
 }
 
+void test_snapshot(void) {
+    pomodoro.StartWork(2, 1500, 300, 1000);
+    const PomodoroSnapshot snapshot = pomodoro.Snapshot();
+    TEST_ASSERT_EQUAL(WORK, snapshot.state);
+    TEST_ASSERT_EQUAL(2, snapshot.work_flavor);
+    TEST_ASSERT_EQUAL(2500, snapshot.state_ends_at);
+    TEST_ASSERT_EQUAL(300, snapshot.break_duration);
+    pomodoro.Cancel(1100);
+    TEST_ASSERT_EQUAL(0, pomodoro.Snapshot().state_ends_at);
+    TEST_ASSERT_EQUAL(0, pomodoro.Snapshot().work_flavor);
+}
+
+void test_adopt_start_and_extend(void) {
+    pomodoro.Adopt({WORK, 1, 2500, 300}, 1000);
+    TEST_ASSERT_EQUAL(WORK, pomodoro.State());
+    TEST_ASSERT_EQUAL(1, observer.idle_to_work);
+    TEST_ASSERT_EQUAL(1500, observer.last_remaining_time);
+    pomodoro.Adopt({WORK, 2, 2800, 300}, 1100);
+    TEST_ASSERT_EQUAL(1, observer.additional_work);
+    TEST_ASSERT_EQUAL(2, observer.last_work_flavor);
+    TEST_ASSERT_EQUAL(1700, observer.last_remaining_time);
+    // Shortened work is only a new countdown.
+    pomodoro.Adopt({WORK, 2, 2600, 300}, 1200);
+    TEST_ASSERT_EQUAL(1, observer.additional_work);
+    TEST_ASSERT_EQUAL(1400, observer.last_remaining_time);
+}
+
+void test_adopt_transitions(void) {
+    pomodoro.StartWork(1, 1500, 300, 1000);
+    pomodoro.Adopt({BREAK, 1, 1600, 300}, 1300);
+    TEST_ASSERT_EQUAL(BREAK, pomodoro.State());
+    TEST_ASSERT_EQUAL(1, observer.work_to_break);
+    TEST_ASSERT_EQUAL(300, observer.last_work_duration);
+    pomodoro.Adopt({WORK, 0, 3000, 300}, 1400);
+    TEST_ASSERT_EQUAL(1, observer.break_to_idle);
+    TEST_ASSERT_EQUAL(2, observer.idle_to_work);
+    pomodoro.Adopt({IDLE, 0, 0, 300}, 1500);
+    TEST_ASSERT_EQUAL(1, observer.work_to_idle);
+    TEST_ASSERT_EQUAL(IDLE, pomodoro.State());
+    // A deadline already past plays out like time passing.
+    pomodoro.Adopt({WORK, 0, 1550, 300}, 1600);
+    TEST_ASSERT_EQUAL(BREAK, pomodoro.State());
+    TEST_ASSERT_EQUAL(2, observer.work_to_break);
+    TEST_ASSERT_EQUAL(250, observer.last_remaining_time);
+}
+
 int main(int argc, char **argv) {
     UNITY_BEGIN();
     RUN_TEST(test_initial_state);
@@ -164,9 +224,13 @@ int main(int argc, char **argv) {
     RUN_TEST(test_start_work_when_not_idle);
     RUN_TEST(test_extend_work);
     RUN_TEST(test_extend_work_when_not_working);
+    RUN_TEST(test_cycle_flavor_wraps_at_flavor_count);
     RUN_TEST(test_cancel_work);
     RUN_TEST(test_cancel_break);
     RUN_TEST(test_work_to_break_transition);
     RUN_TEST(test_break_to_idle_transition);
+    RUN_TEST(test_snapshot);
+    RUN_TEST(test_adopt_start_and_extend);
+    RUN_TEST(test_adopt_transitions);
     return UNITY_END();
 }
\ No newline at end of file
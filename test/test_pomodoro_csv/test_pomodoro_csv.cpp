@@ -0,0 +1,78 @@
+#include <unity.h>
+#include <cstring>
+#include "PomodoroCsv.h"
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_parse_timestamp(void) {
+    CsvTimestamp ts;
+    TEST_ASSERT_TRUE(parseCsvTimestamp("2025-02-02 11:25:07", &ts));
+    TEST_ASSERT_EQUAL_INT32(20121, ts.day);
+    TEST_ASSERT_EQUAL_INT32(11 * 3600 + 25 * 60 + 7, ts.seconds);
+    TEST_ASSERT_EQUAL(0, csvWeekday(ts.day));
+}
+
+void test_parse_timestamp_rejects_garbage(void) {
+    CsvTimestamp ts;
+    TEST_ASSERT_FALSE(parseCsvTimestamp("2025-13-02 11:25:07", &ts));
+    TEST_ASSERT_FALSE(parseCsvTimestamp("2025-02-02 24:00:00", &ts));
+    TEST_ASSERT_FALSE(parseCsvTimestamp("2025/02/02 11:25:07", &ts));
+    TEST_ASSERT_FALSE(parseCsvTimestamp("2025-02-02T11:25:07", &ts));
+    TEST_ASSERT_FALSE(parseCsvTimestamp("2025-02-0a 11:25:07", &ts));
+}
+
+void test_parser_rows(void) {
+    const char* csv =
+        "2025-02-02 11:00:00,2025-02-02 11:25:00,1\n"
+        "2025-02-02 23:50:00,2025-02-03 00:15:00,12\r\n"
+        "2025-02-03 09:00:00,2025-02-03 09:10:00,0";
+    PomodoroCsvParser parser(csv, csv + strlen(csv));
+    PomodoroCsvRow row;
+
+    TEST_ASSERT_TRUE(parser.next(&row));
+    TEST_ASSERT_EQUAL_UINT8(1, row.flavor);
+    TEST_ASSERT_EQUAL(25 * 60, csvDuration(row.start, row.end));
+
+    TEST_ASSERT_TRUE(parser.next(&row));
+    TEST_ASSERT_EQUAL_UINT8(12, row.flavor);
+    TEST_ASSERT_EQUAL_INT32(20121, row.start.day);
+    TEST_ASSERT_EQUAL_INT32(20122, row.end.day);
+    TEST_ASSERT_EQUAL(25 * 60, csvDuration(row.start, row.end));
+
+    TEST_ASSERT_TRUE(parser.next(&row));
+    TEST_ASSERT_EQUAL_UINT8(0, row.flavor);
+    TEST_ASSERT_EQUAL(10 * 60, csvDuration(row.start, row.end));
+
+    TEST_ASSERT_FALSE(parser.next(&row));
+    TEST_ASSERT_EQUAL(0, parser.malformed());
+}
+
+void test_parser_skips_malformed_lines(void) {
+    const char* csv =
+        "start,end,flavor\n"
+        "\n"
+        "2025-02-02 11:00:00,2025-02-02 11:25:00,300\n"
+        "2025-02-02 11:00:00,2025-02-02 11:25:00,\n"
+        "2025-02-02 11:00:00,2025-02-02 11:25:00,2x\n"
+        "2025-02-02 12:00:00,2025-02-02 12:25:00,2\n"
+        "2025-02-02 13:00";
+    PomodoroCsvParser parser(csv, csv + strlen(csv));
+    PomodoroCsvRow row;
+
+    TEST_ASSERT_TRUE(parser.next(&row));
+    TEST_ASSERT_EQUAL_UINT8(2, row.flavor);
+    TEST_ASSERT_EQUAL_INT32(12 * 3600, row.start.seconds);
+    TEST_ASSERT_FALSE(parser.next(&row));
+    TEST_ASSERT_EQUAL(5, parser.malformed());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_parse_timestamp);
+    RUN_TEST(test_parse_timestamp_rejects_garbage);
+    RUN_TEST(test_parser_rows);
+    RUN_TEST(test_parser_skips_malformed_lines);
+    return UNITY_END();
+}
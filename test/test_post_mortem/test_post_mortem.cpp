@@ -0,0 +1,112 @@
+#include <unity.h>
+#include <cstring>
+#include <thread>
+#include "PostMortem.h"
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+static PostMortem stalledRecord(TraceBuffer& trace) {
+    trace.nameTask("main");
+    trace.begin("clock.tick");
+    trace.begin("notify_us.daily_stats");
+    trace.end("notify_us.daily_stats");
+    trace.begin("notify_us.http");
+    std::thread worker([&trace]() {
+        trace.nameTask("logger");
+        trace.begin("logger.write_batch");
+        trace.end("logger.write_batch");
+        trace.begin("logger.export");
+    });
+    worker.join();
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    PostMortem record;
+    capturePostMortem(trace, 1738569600, 17, &record);
+    return record;
+}
+
+void test_capture_finds_open_spans(void) {
+    TraceBuffer trace;
+    const PostMortem record = stalledRecord(trace);
+    TEST_ASSERT_EQUAL(17, record.silent_s);
+    TEST_ASSERT_EQUAL(2, record.span_count);
+    // Innermost open span per task, longest-running first.
+    TEST_ASSERT_EQUAL_STRING("main", record.spans[0].task);
+    TEST_ASSERT_EQUAL_STRING("notify_us.http", record.spans[0].name);
+    TEST_ASSERT_EQUAL_STRING("logger", record.spans[1].task);
+    TEST_ASSERT_EQUAL_STRING("logger.export", record.spans[1].name);
+    TEST_ASSERT_TRUE(record.spans[0].running_ms >= 5);
+    TEST_ASSERT_TRUE(record.spans[0].running_ms >= record.spans[1].running_ms);
+
+    TEST_ASSERT_EQUAL(7, record.event_count);
+    TEST_ASSERT_EQUAL_STRING("clock.tick", record.events[0].name);
+    TEST_ASSERT_EQUAL_STRING("logger.export", record.events[6].name);
+    TEST_ASSERT_EQUAL_STRING("logger", record.events[6].task);
+    TEST_ASSERT_TRUE(record.events[6].phase == TracePhase::BEGIN);
+    // Capturing does not stop the trace.
+    TEST_ASSERT_TRUE(trace.enabled());
+}
+
+void test_capture_keeps_last_events(void) {
+    TraceBuffer trace;
+    for (uint32_t i = 0; i < 40; i++) {
+        trace.instant("tick", i);
+    }
+    PostMortem record;
+    capturePostMortem(trace, 0, 20, &record);
+    TEST_ASSERT_EQUAL(0, record.span_count);
+    TEST_ASSERT_EQUAL(PostMortem::kMaxEvents, record.event_count);
+    TEST_ASSERT_TRUE(record.events[0].phase == TracePhase::INSTANT);
+}
+
+void test_save_and_take_once(void) {
+    TraceBuffer trace;
+    const PostMortem record = stalledRecord(trace);
+    PostMortem restored;
+    // Nothing saved yet in this process.
+    TEST_ASSERT_FALSE(takePostMortem(&restored));
+    savePostMortem(record);
+    TEST_ASSERT_TRUE(takePostMortem(&restored));
+    TEST_ASSERT_EQUAL_STRING("notify_us.http", restored.spans[0].name);
+    TEST_ASSERT_EQUAL(record.event_count, restored.event_count);
+    TEST_ASSERT_FALSE(takePostMortem(&restored));
+}
+
+void test_format_text_and_json(void) {
+    TraceBuffer trace;
+    const PostMortem record = stalledRecord(trace);
+    char text[2048];
+    const size_t length = formatPostMortem(record, text, sizeof(text));
+    TEST_ASSERT_EQUAL(strlen(text), length);
+    TEST_ASSERT_NOT_NULL(strstr(text, "Watchdog fired at 2025-02-03 08:00:00 UTC"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "no clock update for 17 s\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "  running: main             notify_us.http"));
+    TEST_ASSERT_NOT_NULL(strstr(text, " logger       B logger.export\n"));
+
+    // Whole lines only when the buffer is short.
+    char small[160];
+    const size_t small_length = formatPostMortem(record, small, sizeof(small));
+    TEST_ASSERT_TRUE(small_length < sizeof(small));
+    TEST_ASSERT_EQUAL_INT('\n', small[small_length - 1]);
+
+    char json[2048];
+    const size_t json_length = formatPostMortemJson(record, json, sizeof(json));
+    TEST_ASSERT_EQUAL(strlen(json), json_length);
+    TEST_ASSERT_EQUAL(0, strncmp(json, "{\"wall_time\":1738569600,", 24));
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"running\":[{\"task\":\"main\",\"span\":\"notify_us.http\",\"running_ms\":"));
+    TEST_ASSERT_NOT_NULL(strstr(json, "{\"age_ms\":"));
+    TEST_ASSERT_EQUAL_INT('}', json[json_length - 1]);
+    // All or nothing.
+    TEST_ASSERT_EQUAL(0, formatPostMortemJson(record, json, 100));
+    TEST_ASSERT_EQUAL_INT('\0', json[0]);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_capture_finds_open_spans);
+    RUN_TEST(test_capture_keeps_last_events);
+    RUN_TEST(test_save_and_take_once);
+    RUN_TEST(test_format_text_and_json);
+    return UNITY_END();
+}
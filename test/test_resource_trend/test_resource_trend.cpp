@@ -0,0 +1,102 @@
+#include <unity.h>
+#include <cstring>
+#include "ResourceTrend.h"
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_fragmentation_percent(void) {
+    TEST_ASSERT_EQUAL_UINT8(0, fragmentationPercent(0, 0));
+    TEST_ASSERT_EQUAL_UINT8(0, fragmentationPercent(100000, 100000));
+    TEST_ASSERT_EQUAL_UINT8(75, fragmentationPercent(100000, 25000));
+    TEST_ASSERT_EQUAL_UINT8(100, fragmentationPercent(100000, 0));
+}
+
+void test_alerts(void) {
+    const ResourceLimits limits = {16384, 60, 512};
+    TEST_ASSERT_EQUAL_UINT8(0, resourceAlerts({120000, 65536, 0, 900}, limits));
+    TEST_ASSERT_EQUAL_UINT8(HEAP_ALERT_SMALL_BLOCK | HEAP_ALERT_FRAGMENTED,
+                            resourceAlerts({120000, 12000, 0, 900}, limits));
+    // Plenty of contiguous room, but most of the free heap is in fragments.
+    TEST_ASSERT_EQUAL_UINT8(HEAP_ALERT_FRAGMENTED, resourceAlerts({200000, 40000, 0, 900}, limits));
+    TEST_ASSERT_EQUAL_UINT8(HEAP_ALERT_STACK, resourceAlerts({120000, 65536, 0, 300}, limits));
+}
+
+void test_trend_keeps_lows_per_bucket(void) {
+    ResourceTrend trend;
+    trend.add(0, {100000, 60000, 4000000, 800});
+    trend.add(10, {90000, 50000, 3900000, 700});
+    TEST_ASSERT_EQUAL(2, trend.size());
+    TEST_ASSERT_EQUAL_UINT32(1, trend.samplesPerBucket());
+    TEST_ASSERT_EQUAL_UINT32(10, trend.bucket(1).start_s);
+    TEST_ASSERT_EQUAL_UINT32(90000, trend.bucket(1).low.free_heap);
+}
+
+void test_trend_compresses_when_full(void) {
+    ResourceTrend trend;
+    // A slow leak: free heap drops by 100 bytes per sample.
+    const uint32_t samples = ResourceTrend::kBuckets * 4;
+    for (uint32_t i = 0; i < samples; i++) {
+        trend.add(i * 10, {200000 - i * 100, 50000, 0, 1000 - i});
+    }
+    TEST_ASSERT_EQUAL_UINT32(4, trend.samplesPerBucket());
+    TEST_ASSERT_EQUAL(ResourceTrend::kBuckets, trend.size());
+    TEST_ASSERT_EQUAL_UINT32(40, trend.bucket(1).start_s);
+    TEST_ASSERT_EQUAL_UINT32(200000 - 7 * 100, trend.bucket(1).low.free_heap);
+    TEST_ASSERT_EQUAL_UINT32(1000 - 7, trend.bucket(1).low.min_stack_free);
+    TEST_ASSERT_EQUAL_UINT32(200000 - 4 * 100, trend.bucket(1).high_free_heap);
+
+    // One more halves the resolution again.
+    trend.add(samples * 10, {100000, 50000, 0, 500});
+    TEST_ASSERT_EQUAL_UINT32(8, trend.samplesPerBucket());
+    TEST_ASSERT_EQUAL(ResourceTrend::kBuckets / 2 + 1, trend.size());
+}
+
+void test_trend_spans_whole_uptime(void) {
+    ResourceTrend trend;
+    const uint32_t samples = 1000;
+    for (uint32_t i = 0; i < samples; i++) {
+        trend.add(i * 10, {200000 - i * 100, 50000, 0, 1000 - i});
+    }
+    TEST_ASSERT_TRUE(trend.size() <= ResourceTrend::kBuckets);
+    uint32_t total = 0;
+    for (size_t i = 0; i < trend.size(); i++) {
+        total += trend.bucket(i).samples;
+        if (i > 0) {
+            TEST_ASSERT_TRUE(trend.bucket(i).start_s > trend.bucket(i - 1).start_s);
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(samples, total);
+    TEST_ASSERT_EQUAL_UINT32(0, trend.bucket(0).start_s);
+    const ResourceTrend::Bucket first = trend.bucket(0);
+    TEST_ASSERT_EQUAL_UINT32(200000, first.high_free_heap);
+    TEST_ASSERT_EQUAL_UINT32(200000 - (first.samples - 1) * 100, first.low.free_heap);
+    TEST_ASSERT_EQUAL_UINT32(200000 - (samples - 1) * 100, trend.bucket(trend.size() - 1).low.free_heap);
+}
+
+void test_format(void) {
+    ResourceTrend trend;
+    trend.add(0, {100000, 60000, 4000000, 800});
+    trend.add(10, {90000, 45000, 3900000, 700});
+    char text[512];
+    const size_t length = trend.format(text, sizeof(text));
+    TEST_ASSERT_EQUAL(strlen(text), length);
+    TEST_ASSERT_NOT_NULL(strstr(text, "       0  100000/100000     60000  40%    4000000    800\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "      10   90000/90000      45000  50%    3900000    700\n"));
+    char small[80];
+    const size_t small_length = trend.format(small, sizeof(small));
+    TEST_ASSERT_TRUE(small_length < sizeof(small));
+    TEST_ASSERT_EQUAL_INT('\n', small[small_length - 1]);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_fragmentation_percent);
+    RUN_TEST(test_alerts);
+    RUN_TEST(test_trend_keeps_lows_per_bucket);
+    RUN_TEST(test_trend_compresses_when_full);
+    RUN_TEST(test_trend_spans_whole_uptime);
+    RUN_TEST(test_format);
+    return UNITY_END();
+}
@@ -0,0 +1,183 @@
+#include <unity.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include "Scheduler.h"
+
+uint64_t fake_now = 0;
+
+uint64_t fakeClock() {
+    return fake_now;
+}
+
+void setUp(void) {
+    fake_now = 1000000;
+}
+
+void tearDown(void) {}
+
+Task counter(Scheduler& scheduler, std::string& log, char name, int steps) {
+    for (int i = 0; i < steps; i++) {
+        log += name;
+        co_await scheduler.yield();
+    }
+}
+
+Task sleeper(Scheduler& scheduler, std::string& log, char name, uint64_t micros) {
+    co_await scheduler.sleepFor(micros);
+    log += name;
+}
+
+Task producer(Scheduler& scheduler, Channel<int, 4>& channel, int count) {
+    for (int i = 1; i <= count; i++) {
+        channel.send(i);
+        co_await scheduler.yield();
+    }
+    channel.send(0);
+}
+
+Task consumer(Channel<int, 4>& channel, int& sum, int& received) {
+    for (;;) {
+        const int value = co_await channel.receive();
+        if (value == 0) {
+            co_return;
+        }
+        sum += value;
+        received++;
+    }
+}
+
+Task waiter(Completion<int>& completion, int& result) {
+    result = co_await completion;
+}
+
+Task forever(Scheduler& scheduler) {
+    for (;;) {
+        co_await scheduler.sleepFor(1000000);
+    }
+}
+
+void test_yield_interleaves(void) {
+    Scheduler scheduler(fakeClock);
+    std::string log;
+    scheduler.spawn(counter(scheduler, log, 'a', 3));
+    scheduler.spawn(counter(scheduler, log, 'b', 2));
+    TEST_ASSERT_EQUAL(2, scheduler.alive());
+    while (scheduler.runReady() > 0) {
+    }
+    TEST_ASSERT_EQUAL_STRING("ababa", log.c_str());
+    TEST_ASSERT_EQUAL(0, scheduler.alive());
+    TEST_ASSERT_EQUAL(0, coroutineFrames());
+}
+
+void test_timers_fire_in_deadline_order(void) {
+    Scheduler scheduler(fakeClock);
+    std::string log;
+    scheduler.spawn(sleeper(scheduler, log, 'c', 3000));
+    scheduler.spawn(sleeper(scheduler, log, 'a', 1000));
+    scheduler.spawn(sleeper(scheduler, log, 'b', 1000));
+    scheduler.runReady();
+    TEST_ASSERT_EQUAL_UINT64(fake_now + 1000, scheduler.nextDeadline());
+    fake_now += 999;
+    TEST_ASSERT_EQUAL(0, scheduler.runReady());
+    fake_now += 1;
+    TEST_ASSERT_EQUAL(2, scheduler.runReady());
+    // Equal deadlines fire in the order they were set.
+    TEST_ASSERT_EQUAL_STRING("ab", log.c_str());
+    fake_now += 2500;
+    TEST_ASSERT_EQUAL(1, scheduler.runReady());
+    TEST_ASSERT_EQUAL_STRING("abc", log.c_str());
+    TEST_ASSERT_EQUAL_UINT32(500, scheduler.maxLatenessMicros());
+    TEST_ASSERT_EQUAL_UINT64(UINT64_MAX, scheduler.nextDeadline());
+}
+
+void test_channel_wakes_receiver(void) {
+    Scheduler scheduler(fakeClock);
+    Channel<int, 4> channel(scheduler);
+    int sum = 0;
+    int received = 0;
+    // The consumer starts first and suspends on the empty channel.
+    scheduler.spawn(consumer(channel, sum, received));
+    scheduler.spawn(producer(scheduler, channel, 10));
+    while (scheduler.runReady() > 0) {
+    }
+    TEST_ASSERT_EQUAL(55, sum);
+    TEST_ASSERT_EQUAL(10, received);
+    TEST_ASSERT_EQUAL(0, scheduler.alive());
+}
+
+void test_full_channel_drops(void) {
+    Scheduler scheduler(fakeClock);
+    Channel<int, 4> channel(scheduler);
+    for (int i = 1; i <= 6; i++) {
+        channel.send(i);
+    }
+    TEST_ASSERT_EQUAL(4, channel.size());
+    TEST_ASSERT_EQUAL_UINT32(2, channel.dropped());
+}
+
+void test_completion_from_another_thread(void) {
+    Scheduler scheduler;
+    Completion<int> completion(scheduler);
+    int result = 0;
+    scheduler.spawn(waiter(completion, result));
+    std::thread io([&completion]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        completion.complete(42);
+    });
+    // run() sleeps with nothing ready and returns once the waiter has finished.
+    scheduler.run();
+    io.join();
+    TEST_ASSERT_EQUAL(42, result);
+}
+
+void test_completed_before_await(void) {
+    Scheduler scheduler(fakeClock);
+    Completion<int> completion(scheduler);
+    completion.complete(7);
+    int result = 0;
+    scheduler.spawn(waiter(completion, result));
+    TEST_ASSERT_EQUAL(1, scheduler.runReady());
+    TEST_ASSERT_EQUAL(7, result);
+    TEST_ASSERT_EQUAL(0, scheduler.alive());
+}
+
+void test_stop_and_destroy_unfinished(void) {
+    {
+        Scheduler scheduler;
+        scheduler.spawn(forever(scheduler));
+        std::thread stopper([&scheduler]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            scheduler.stop();
+        });
+        scheduler.run();
+        stopper.join();
+        TEST_ASSERT_EQUAL(1, scheduler.alive());
+        TEST_ASSERT_EQUAL(1, coroutineFrames());
+        TEST_ASSERT_TRUE(coroutineFrameBytes() > 0);
+    }
+    TEST_ASSERT_EQUAL(0, coroutineFrames());
+    TEST_ASSERT_EQUAL(0, coroutineFrameBytes());
+}
+
+void test_spawn_limit(void) {
+    Scheduler scheduler(fakeClock);
+    for (size_t i = 0; i < Scheduler::kMaxTasks; i++) {
+        TEST_ASSERT_TRUE(scheduler.spawn(forever(scheduler)));
+    }
+    TEST_ASSERT_FALSE(scheduler.spawn(forever(scheduler)));
+    TEST_ASSERT_EQUAL(Scheduler::kMaxTasks, coroutineFrames());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_yield_interleaves);
+    RUN_TEST(test_timers_fire_in_deadline_order);
+    RUN_TEST(test_channel_wakes_receiver);
+    RUN_TEST(test_full_channel_drops);
+    RUN_TEST(test_completion_from_another_thread);
+    RUN_TEST(test_completed_before_await);
+    RUN_TEST(test_stop_and_destroy_unfinished);
+    RUN_TEST(test_spawn_limit);
+    return UNITY_END();
+}
@@ -0,0 +1,172 @@
+#include <unity.h>
+#include <cstring>
+#include <string>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include "StatusPublisher.h"
+#include "StatusServer.h"
+
+static StatusServer* server;
+
+void setUp(void) {
+    server = new StatusServer();
+    TEST_ASSERT_TRUE(server->begin(0));
+}
+
+void tearDown(void) {
+    delete server;
+    server = nullptr;
+}
+
+static int connectClient() {
+    const int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(server->port());
+    connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    timeval timeout = {0, 20000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return fd;
+}
+
+static void sendRequest(const int fd, const char* request) {
+    TEST_ASSERT_EQUAL_INT(static_cast<int>(strlen(request)), send(fd, request, strlen(request), 0));
+}
+
+// Polls the server and collects whatever reaches the client until `expected` shows up.
+static std::string readUntil(const int fd, const char* expected) {
+    std::string received;
+    for (int i = 0; i < 50 && received.find(expected) == std::string::npos; i++) {
+        server->poll(10);
+        char buffer[1024];
+        const ssize_t length = recv(fd, buffer, sizeof(buffer), 0);
+        if (length > 0) {
+            received.append(buffer, static_cast<size_t>(length));
+        }
+    }
+    return received;
+}
+
+static std::string request(const char* text, const char* expected) {
+    const int fd = connectClient();
+    sendRequest(fd, text);
+    std::string response = readUntil(fd, expected);
+    close(fd);
+    return response;
+}
+
+void test_state_returns_json(void) {
+    TEST_ASSERT_TRUE(server->setState("{\"state\":\"work\"}"));
+    const std::string response = request("GET /state HTTP/1.1\r\nHost: x\r\n\r\n", "}");
+    TEST_ASSERT_TRUE(response.rfind("HTTP/1.1 200 OK\r\n", 0) == 0);
+    TEST_ASSERT_TRUE(response.find("Content-Type: application/json") != std::string::npos);
+    TEST_ASSERT_TRUE(response.find("Content-Length: 16\r\n") != std::string::npos);
+    TEST_ASSERT_TRUE(response.find("\r\n\r\n{\"state\":\"work\"}") != std::string::npos);
+}
+
+void test_state_rejects_oversized_json(void) {
+    std::string json(StatusServer::kStateBytes, 'x');
+    TEST_ASSERT_FALSE(server->setState(json.c_str()));
+}
+
+void test_unknown_path_and_method(void) {
+    TEST_ASSERT_TRUE(request("GET /nope HTTP/1.1\r\n\r\n", "\r\n\r\n").rfind("HTTP/1.1 404", 0) == 0);
+    TEST_ASSERT_TRUE(request("POST /state HTTP/1.1\r\n\r\n", "\r\n\r\n").rfind("HTTP/1.1 405", 0) == 0);
+}
+
+void test_events_stream_to_every_subscriber(void) {
+    server->setState("{\"state\":\"idle\"}");
+    int fds[2];
+    for (int& fd : fds) {
+        fd = connectClient();
+        sendRequest(fd, "GET /events HTTP/1.1\r\n\r\n");
+        const std::string opening = readUntil(fd, "}\n\n");
+        TEST_ASSERT_TRUE(opening.find("Content-Type: text/event-stream") != std::string::npos);
+        TEST_ASSERT_TRUE(opening.find("\r\n\r\nevent: state\ndata: {\"state\":\"idle\"}\n\n") != std::string::npos);
+    }
+    TEST_ASSERT_EQUAL(2, server->subscribers());
+    server->publish("transition", "{\"transition\":\"idle_to_work\"}");
+    for (const int fd : fds) {
+        const std::string event = readUntil(fd, "}\n\n");
+        TEST_ASSERT_EQUAL_STRING("event: transition\ndata: {\"transition\":\"idle_to_work\"}\n\n", event.c_str());
+        close(fd);
+    }
+    readUntil(fds[0], "never");
+    TEST_ASSERT_EQUAL(0, server->subscribers());
+}
+
+void test_clients_beyond_limit_get_503(void) {
+    int fds[StatusServer::kMaxClients];
+    for (int& fd : fds) {
+        fd = connectClient();
+        sendRequest(fd, "GET /events HTTP/1.1\r\n\r\n");
+        readUntil(fd, "}\n\n");
+    }
+    TEST_ASSERT_EQUAL(StatusServer::kMaxClients, server->subscribers());
+    TEST_ASSERT_TRUE(request("GET /state HTTP/1.1\r\n\r\n", "\r\n\r\n").rfind("HTTP/1.1 503", 0) == 0);
+    for (const int fd : fds) {
+        close(fd);
+    }
+}
+
+void test_slow_subscriber_is_dropped(void) {
+    const int fd = connectClient();
+    const int small = 1024;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &small, sizeof(small));
+    sendRequest(fd, "GET /events HTTP/1.1\r\n\r\n");
+    readUntil(fd, "}\n\n");
+    // The client stops reading: the socket buffers fill, then the server's output buffer.
+    const std::string data(200, 'x');
+    for (int i = 0; i < 100000 && server->subscribers() > 0; i++) {
+        server->publish("countdown", data.c_str());
+        server->poll(0);
+    }
+    TEST_ASSERT_EQUAL(0, server->subscribers());
+    TEST_ASSERT_EQUAL_UINT32(1, server->dropped());
+    close(fd);
+}
+
+void test_publisher_formats_state_and_throttles_countdown(void) {
+    StatusPublisher publisher(*server);
+    Settings settings;
+    strcpy(settings.flavors[0].label, "deep \"work\"");
+    strcpy(settings.flavors[1].label, "email");
+    FlavorTable flavors;
+    flavors.build(settings);
+    publisher.setFlavors(&flavors);
+    const int fd = connectClient();
+    sendRequest(fd, "GET /events HTTP/1.1\r\n\r\n");
+    readUntil(fd, "}\n\n");
+
+    publisher.notification(IdleToWork{1, 100});
+    publisher.notification(ClockUpdate{100, WORK, 1, 1500});
+    publisher.notification(ClockUpdate{101, WORK, 1, 1499});
+    publisher.notification(ClockUpdate{105, WORK, 1, 1495});
+    std::string events = readUntil(fd, "\"remaining\":1495}\n\n");
+    TEST_ASSERT_TRUE(events.find("event: transition\ndata: {\"transition\":\"idle_to_work\",\"now\":100,\"flavor\":1}\n\n") == 0);
+    TEST_ASSERT_TRUE(events.find("\"remaining\":1500}") != std::string::npos);
+    // Within kCountdownSeconds of the last countdown: only /state moves.
+    TEST_ASSERT_TRUE(events.find("\"remaining\":1499}") == std::string::npos);
+    TEST_ASSERT_TRUE(events.find("data: {\"state\":\"work\",\"flavor\":1,\"label\":\"email\",\"now\":105,\"remaining\":1495}") != std::string::npos);
+
+    publisher.notification(ClockUpdate{106, WORK, 0, 1494});
+    close(fd);
+    const std::string state = request("GET /state HTTP/1.1\r\n\r\n", "}");
+    TEST_ASSERT_TRUE(state.find("\"label\":\"deep \\\"work\\\"\",\"now\":106") != std::string::npos);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_state_returns_json);
+    RUN_TEST(test_state_rejects_oversized_json);
+    RUN_TEST(test_unknown_path_and_method);
+    RUN_TEST(test_events_stream_to_every_subscriber);
+    RUN_TEST(test_clients_beyond_limit_get_503);
+    RUN_TEST(test_slow_subscriber_is_dropped);
+    RUN_TEST(test_publisher_formats_state_and_throttles_countdown);
+    return UNITY_END();
+}
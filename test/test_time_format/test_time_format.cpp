@@ -0,0 +1,125 @@
+#include <unity.h>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include "History.h"
+#include "TimeFormat.h"
+
+// 2025-03-30 01:00:00 UTC, when CET switches to CEST.
+const time_t SPRING_FORWARD = 1743296400;
+// 2025-10-26 01:00:00 UTC, when CEST switches back to CET.
+const time_t FALL_BACK = 1761440400;
+
+void expectMatchesStrftime(LocalTimeCache& calendar, time_t now) {
+    calendar.update(now);
+    struct tm timeinfo;
+    localtime_r(&now, &timeinfo);
+    char expected[32];
+    strftime(expected, sizeof(expected), "%H:%M:%S", &timeinfo);
+    TEST_ASSERT_EQUAL_STRING(expected, calendar.hms());
+    strftime(expected, sizeof(expected), "%d %m %Y", &timeinfo);
+    TEST_ASSERT_EQUAL_STRING(expected, calendar.date());
+    TEST_ASSERT_EQUAL_INT(timeinfo.tm_wday, calendar.weekday());
+    TEST_ASSERT_EQUAL_UINT16(localDay(now), calendar.day());
+}
+
+void setUp(void) {
+    setenv("TZ", "CET-1CEST,M3.5.0,M10.5.0/3", 1);
+    tzset();
+}
+
+void tearDown(void) {}
+
+void test_ticking_across_midnight(void) {
+    LocalTimeCache calendar;
+    // 2025-02-02 23:00:00 CET onwards, for two hours.
+    const time_t start = 1738533600;
+    for (time_t now = start; now < start + 7200; now++) {
+        expectMatchesStrftime(calendar, now);
+    }
+    TEST_ASSERT_EQUAL_UINT32(2, calendar.recomputations());
+}
+
+void test_ticking_across_dst_transitions(void) {
+    const time_t transitions[] = {SPRING_FORWARD, FALL_BACK};
+    for (const time_t transition : transitions) {
+        LocalTimeCache calendar;
+        for (time_t now = transition - 3600; now < transition + 3600; now++) {
+            expectMatchesStrftime(calendar, now);
+        }
+        TEST_ASSERT_EQUAL_UINT32(2, calendar.recomputations());
+    }
+}
+
+void test_boundaries(void) {
+    LocalTimeCache calendar;
+    calendar.update(SPRING_FORWARD - 3600);
+    TEST_ASSERT_EQUAL(SPRING_FORWARD, calendar.boundary());
+    calendar.update(SPRING_FORWARD);
+    // Next local midnight, now at UTC+2.
+    TEST_ASSERT_EQUAL(SPRING_FORWARD + 21 * 3600, calendar.boundary());
+    calendar.update(FALL_BACK + 60);
+    TEST_ASSERT_EQUAL(FALL_BACK + 22 * 3600, calendar.boundary());
+}
+
+void test_jumps(void) {
+    LocalTimeCache calendar;
+    time_t now = 1738533600;
+    srand(42);
+    for (int i = 0; i < 2000; i++) {
+        now += rand() % 200000 - 50000;
+        expectMatchesStrftime(calendar, now);
+        expectMatchesStrftime(calendar, now + 1);
+    }
+}
+
+void test_format_iso(void) {
+    LocalTimeCache calendar;
+    const time_t times[] = {0, 1738533600, SPRING_FORWARD - 1, SPRING_FORWARD, FALL_BACK - 1, FALL_BACK,
+                            FALL_BACK + 86399, 1738569601, 1738569600};
+    for (const time_t t : times) {
+        char actual[20] = {};
+        char expected[20];
+        struct tm timeinfo;
+        localtime_r(&t, &timeinfo);
+        strftime(expected, sizeof(expected), "%Y-%m-%d %H:%M:%S", &timeinfo);
+        calendar.formatIso(t, actual);
+        TEST_ASSERT_EQUAL_STRING(expected, actual);
+        TEST_ASSERT_EQUAL_UINT16(localDay(t), calendar.dayOf(t));
+    }
+}
+
+void test_format_min_sec(void) {
+    char out[6];
+    formatMinSec(0, out);
+    TEST_ASSERT_EQUAL_STRING("00:00", out);
+    formatMinSec(25 * 60 - 1, out);
+    TEST_ASSERT_EQUAL_STRING("24:59", out);
+    // Minutes wrap at the hour, as strftime("%M:%S", gmtime(...)) did.
+    formatMinSec(3600 + 61, out);
+    TEST_ASSERT_EQUAL_STRING("01:01", out);
+}
+
+void test_csv_line_with_shared_calendar(void) {
+    LocalTimeCache calendar;
+    const HistoryRecord record = {1738569600, 1738571100, 1, HistoryOutcome::COMPLETED, 0};
+    char cached[64];
+    char uncached[64];
+    TEST_ASSERT_EQUAL(42, formatHistoryCsvLine(record, calendar, cached, sizeof(cached)));
+    TEST_ASSERT_EQUAL(42, formatHistoryCsvLine(record, uncached, sizeof(uncached)));
+    TEST_ASSERT_EQUAL_STRING("2025-02-03 09:00:00,2025-02-03 09:25:00,1\n", cached);
+    TEST_ASSERT_EQUAL_STRING(uncached, cached);
+    TEST_ASSERT_EQUAL(0, formatHistoryCsvLine(record, calendar, cached, 42));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_ticking_across_midnight);
+    RUN_TEST(test_ticking_across_dst_transitions);
+    RUN_TEST(test_boundaries);
+    RUN_TEST(test_jumps);
+    RUN_TEST(test_format_iso);
+    RUN_TEST(test_format_min_sec);
+    RUN_TEST(test_csv_line_with_shared_calendar);
+    return UNITY_END();
+}
@@ -0,0 +1,122 @@
+#include <unity.h>
+#include <cstring>
+#include <string>
+#include <thread>
+#include "Trace.h"
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+static void appendTo(const char* data, const size_t size, void* context) {
+    static_cast<std::string*>(context)->append(data, size);
+}
+
+void test_records_in_order(void) {
+    TraceBuffer buffer;
+    buffer.begin("outer");
+    buffer.instant("mark", 7);
+    {
+        TraceScope scope("inner", buffer);
+    }
+    buffer.end("outer");
+    TEST_ASSERT_EQUAL(5, buffer.size());
+    TEST_ASSERT_EQUAL_STRING("outer", buffer.event(0).name);
+    TEST_ASSERT_TRUE(buffer.event(0).phase == TracePhase::BEGIN);
+    TEST_ASSERT_EQUAL_UINT32(7, buffer.event(1).arg);
+    TEST_ASSERT_TRUE(buffer.event(2).phase == TracePhase::BEGIN);
+    TEST_ASSERT_TRUE(buffer.event(3).phase == TracePhase::END);
+    TEST_ASSERT_EQUAL_STRING("inner", buffer.event(3).name);
+    TEST_ASSERT_TRUE(buffer.event(4).ts_us >= buffer.event(0).ts_us);
+}
+
+void test_wraparound_keeps_newest(void) {
+    TraceBuffer buffer;
+    for (uint32_t i = 0; i < TraceBuffer::kCapacity + 10; i++) {
+        buffer.instant("tick", i);
+    }
+    TEST_ASSERT_EQUAL(TraceBuffer::kCapacity, buffer.size());
+    TEST_ASSERT_EQUAL_UINT32(10, buffer.event(0).arg);
+    TEST_ASSERT_EQUAL_UINT32(TraceBuffer::kCapacity + 9, buffer.event(TraceBuffer::kCapacity - 1).arg);
+}
+
+void test_disabled_records_nothing(void) {
+    TraceBuffer buffer;
+    buffer.setEnabled(false);
+    buffer.instant("ignored");
+    TEST_ASSERT_EQUAL(0, buffer.size());
+    buffer.setEnabled(true);
+    buffer.instant("kept");
+    TEST_ASSERT_EQUAL(1, buffer.size());
+    buffer.clear();
+    TEST_ASSERT_EQUAL(0, buffer.size());
+    TEST_ASSERT_EQUAL(0, buffer.taskCount());
+}
+
+void test_tasks_are_named_per_thread(void) {
+    TraceBuffer buffer;
+    TraceBuffer other;
+    buffer.nameTask("main");
+    buffer.instant("a");
+    // Recording into another buffer must not register this thread twice.
+    other.instant("b");
+    buffer.instant("c");
+    std::thread worker([&buffer]() {
+        buffer.nameTask("worker");
+        buffer.instant("d");
+    });
+    worker.join();
+    TEST_ASSERT_EQUAL(2, buffer.taskCount());
+    TEST_ASSERT_EQUAL_STRING("main", buffer.taskName(0));
+    TEST_ASSERT_EQUAL_STRING("worker", buffer.taskName(1));
+    TEST_ASSERT_EQUAL_INT(0, buffer.event(1).task);
+    TEST_ASSERT_EQUAL_INT(1, buffer.event(2).task);
+}
+
+void test_export_chrome_trace(void) {
+    TraceBuffer buffer;
+    buffer.nameTask("main");
+    buffer.end("orphan");
+    buffer.begin("display.render");
+    buffer.end("display.render");
+    buffer.instant("wifi.reconnect", 3);
+    buffer.record(TracePhase::COMPLETE, "m5.update", 1500, buffer.event(1).ts_us + 10);
+
+    std::string json;
+    TEST_ASSERT_EQUAL(4, exportChromeTrace(buffer, appendTo, &json));
+    TEST_ASSERT_TRUE(buffer.enabled());
+    TEST_ASSERT_EQUAL(0, json.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+    TEST_ASSERT_EQUAL(json.size() - 4, json.rfind("\n]}\n"));
+    TEST_ASSERT_TRUE(json.find("\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"main\"}") != std::string::npos);
+    TEST_ASSERT_TRUE(json.find("orphan") == std::string::npos);
+    TEST_ASSERT_TRUE(json.find("\"name\":\"display.render\",\"ph\":\"B\"") != std::string::npos);
+    TEST_ASSERT_TRUE(json.find("\"name\":\"display.render\",\"ph\":\"E\"") != std::string::npos);
+    TEST_ASSERT_TRUE(json.find("\"ph\":\"i\",\"s\":\"t\"") != std::string::npos);
+    TEST_ASSERT_TRUE(json.find("\"args\":{\"value\":3}") != std::string::npos);
+    TEST_ASSERT_TRUE(json.find("\"ph\":\"X\"") != std::string::npos);
+    TEST_ASSERT_TRUE(json.find("\"dur\":1500}") != std::string::npos);
+    // Every event line but the last is followed by a comma.
+    TEST_ASSERT_TRUE(json.find("}\n{") == std::string::npos);
+    TEST_ASSERT_TRUE(json.find("},\n]") == std::string::npos);
+}
+
+void test_export_unwraps_timestamps(void) {
+    TraceBuffer buffer;
+    buffer.record(TracePhase::INSTANT, "before", 0, 0xFFFFFF00u);
+    buffer.record(TracePhase::INSTANT, "after", 0, 0x00000100u);
+    std::string json;
+    exportChromeTrace(buffer, appendTo, &json);
+    TEST_ASSERT_TRUE(json.find("\"ts\":0,") != std::string::npos);
+    TEST_ASSERT_TRUE(json.find("\"ts\":512,") != std::string::npos);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_records_in_order);
+    RUN_TEST(test_wraparound_keeps_newest);
+    RUN_TEST(test_disabled_records_nothing);
+    RUN_TEST(test_tasks_are_named_per_thread);
+    RUN_TEST(test_export_chrome_trace);
+    RUN_TEST(test_export_unwraps_timestamps);
+    return UNITY_END();
+}
@@ -0,0 +1,73 @@
+#include <unity.h>
+#include <cstring>
+#include "Transport.h"
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_transition_names(void) {
+    TransitionKind kind;
+    TEST_ASSERT_TRUE(transitionKind("work_to_break", &kind));
+    TEST_ASSERT_TRUE(kind == TransitionKind::WORK_TO_BREAK);
+    TEST_ASSERT_EQUAL_STRING("work_to_idle", transitionName(TransitionKind::WORK_TO_IDLE));
+    TEST_ASSERT_FALSE(transitionKind("break_to_work", &kind));
+    TEST_ASSERT_EQUAL_STRING("unknown", transitionName(static_cast<TransitionKind>(9)));
+}
+
+void test_transition_round_trip(void) {
+    TransitionRecord record = {TransitionKind::WORK_TO_BREAK, 1738569600, 1738571100, 1500, "leisure"};
+    uint8_t data[kTransitionRecordMaxBytes];
+    const size_t size = encodeTransition(record, data, sizeof(data));
+    TEST_ASSERT_EQUAL(15 + 7, size);
+    TEST_ASSERT_EQUAL_HEX8(1, data[0]);
+    TEST_ASSERT_EQUAL_HEX8(2, data[1]);
+    // Little-endian 1500.
+    TEST_ASSERT_EQUAL_HEX8(0xDC, data[10]);
+    TEST_ASSERT_EQUAL_HEX8(0x05, data[11]);
+
+    TransitionRecord decoded = {};
+    TEST_ASSERT_TRUE(decodeTransition(data, size, &decoded));
+    TEST_ASSERT_TRUE(decoded.kind == TransitionKind::WORK_TO_BREAK);
+    TEST_ASSERT_EQUAL_UINT32(1738569600, decoded.start_time);
+    TEST_ASSERT_EQUAL_UINT32(1738571100, decoded.event_time);
+    TEST_ASSERT_EQUAL_UINT32(1500, decoded.duration);
+    TEST_ASSERT_EQUAL_STRING("leisure", decoded.flavor);
+
+    TEST_ASSERT_EQUAL(0, encodeTransition(record, data, size - 1));
+    TEST_ASSERT_FALSE(decodeTransition(data, size - 1, &decoded));
+    data[0] = 2;
+    TEST_ASSERT_FALSE(decodeTransition(data, size, &decoded));
+}
+
+void test_longest_label_fits(void) {
+    TransitionRecord record = {TransitionKind::IDLE_TO_WORK, 1, 1, 0, "fifteen chars.."};
+    uint8_t data[kTransitionRecordMaxBytes];
+    TEST_ASSERT_EQUAL(kTransitionRecordMaxBytes, encodeTransition(record, data, sizeof(data)));
+}
+
+void test_air_bytes_model(void) {
+    // One HTTP POST: a connection and one round trip.
+    TEST_ASSERT_EQUAL_UINT32(300 + 150 + (7 + 4) * 40, airBytes({1, 1, 300, 150}));
+    // Over a kept connection only the round trip costs segments.
+    TEST_ASSERT_EQUAL_UINT32(30 + 4 + 4 * 40, airBytes({0, 1, 30, 4}));
+}
+
+void test_http_post_bytes(void) {
+    const char expected[] =
+        "POST /metrics HTTP/1.1\r\nHost: backend:8080\r\nUser-Agent: ESP32HTTPClient\r\n"
+        "Connection: keep-alive\r\nAccept-Encoding: identity;q=1,chunked;q=0.1,*;q=0\r\n"
+        "Content-Type: application/json\r\nContent-Length: 2\r\n\r\n{}";
+    TEST_ASSERT_EQUAL_UINT32(sizeof(expected) - 1, httpPostBytes("backend", 8080, "/metrics", 2));
+    TEST_ASSERT_EQUAL_UINT32(sizeof(expected) - 1 - 5, httpPostBytes("backend", 80, "/metrics", 2));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_transition_names);
+    RUN_TEST(test_transition_round_trip);
+    RUN_TEST(test_longest_label_fits);
+    RUN_TEST(test_air_bytes_model);
+    RUN_TEST(test_http_post_bytes);
+    return UNITY_END();
+}
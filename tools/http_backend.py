@@ -38,11 +38,45 @@ def init_database():
             FOREIGN KEY (pomodoro_id) REFERENCES pomodoros(id)
         )
     ''')
+
+    # Create metrics table: one row per snapshot pushed by the device
+    cursor.execute('''
+        CREATE TABLE IF NOT EXISTS metrics (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            payload_json TEXT NOT NULL,
+            created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP
+        )
+    ''')
+    
+    # Create postmortems table: one row per watchdog restart reported by the device
+    cursor.execute('''
+        CREATE TABLE IF NOT EXISTS postmortems (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            payload_json TEXT NOT NULL,
+            created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP
+        )
+    ''')
     
     conn.commit()
     conn.close()
 
 
+def save_metrics(payload):
+    """Save a metrics snapshot to SQLite database."""
+    conn = sqlite3.connect('pomodoros.db')
+    conn.execute('INSERT INTO metrics (payload_json) VALUES (?)', (json.dumps(payload),))
+    conn.commit()
+    conn.close()
+
+
+def save_postmortem(payload):
+    """Save a watchdog post-mortem to SQLite database."""
+    conn = sqlite3.connect('pomodoros.db')
+    conn.execute('INSERT INTO postmortems (payload_json) VALUES (?)', (json.dumps(payload),))
+    conn.commit()
+    conn.close()
+
+
 def save_to_database(start_time, payload):
     """Save pomodoro data to SQLite database."""
     conn = sqlite3.connect('pomodoros.db')
@@ -132,6 +166,13 @@ def save_to_database(start_time, payload):
 
 class PomodoroHandler(BaseHTTPRequestHandler):
     def do_POST(self):
+        if re.match(r"^/metrics/?$", self.path):
+            self.handle_metrics()
+            return
+        if re.match(r"^/postmortem/?$", self.path):
+            self.handle_postmortem()
+            return
+
         match = re.match(r"^/pomodoros/(\d+)/transitions/?$", self.path)
         if not match:
             self.send_error(404, "Not Found")
@@ -171,6 +212,34 @@ class PomodoroHandler(BaseHTTPRequestHandler):
         self.end_headers()
         self.wfile.write(b'{"status":"ok"}')
 
+    def handle_metrics(self):
+        self.handle_snapshot(save_metrics, "metrics")
+
+    def handle_postmortem(self):
+        self.handle_snapshot(save_postmortem, "post-mortem")
+
+    def handle_snapshot(self, save, kind):
+        content_length = int(self.headers.get("Content-Length", "0"))
+        body = self.rfile.read(content_length)
+        try:
+            payload = json.loads(body.decode("utf-8"))
+        except json.JSONDecodeError:
+            self.send_error(400, "Invalid JSON")
+            return
+        if not isinstance(payload, dict):
+            self.send_error(400, "Expected a JSON object")
+            return
+
+        try:
+            save(payload)
+        except Exception as e:
+            print(f"Error saving {kind}: {e}")
+
+        self.send_response(201)
+        self.send_header("Content-Type", "application/json")
+        self.end_headers()
+        self.wfile.write(b'{"status":"ok"}')
+
     def log_message(self, format, *args):
         return
 